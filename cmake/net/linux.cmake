@@ -11,3 +11,11 @@ set(ETCPAL_NET_ADDITIONAL_SOURCES
   ${ETCPAL_ROOT}/src/os/linux/etcpal/os_socket.c
 )
 set(ETCPAL_NET_INCLUDE_DIR ${ETCPAL_ROOT}/include/os/linux)
+
+option(ETCPAL_LINUX_USE_IO_URING "Build the io_uring-based completion I/O module (etcpal/io_ring.h)" OFF)
+if(ETCPAL_LINUX_USE_IO_URING)
+  set(ETCPAL_NET_ADDITIONAL_SOURCES ${ETCPAL_NET_ADDITIONAL_SOURCES}
+    ${ETCPAL_ROOT}/include/etcpal/io_ring.h
+    ${ETCPAL_ROOT}/src/os/linux/etcpal/os_io_ring.c
+  )
+endif()
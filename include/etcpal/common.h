@@ -110,6 +110,17 @@ extern "C" {
 /** For etcpal_ functions that take a millisecond timeout, this means to wait indefinitely. */
 #define ETCPAL_WAIT_FOREVER -1
 
+/**
+ * @brief The size assumed for a CPU cache line, used to keep data written by different threads on
+ *        different cache lines.
+ *
+ * This affects the layout of some EtcPal structs, so it must be defined the same way for EtcPal and
+ * for any code which uses it.
+ */
+#ifndef ETCPAL_CACHE_LINE_SIZE
+#define ETCPAL_CACHE_LINE_SIZE 64
+#endif
+
 /** A mask of desired EtcPal features. See "EtcPal feature masks". */
 typedef uint32_t etcpal_features_t;
 
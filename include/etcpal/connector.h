@@ -0,0 +1,139 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+/* etcpal/connector.h: Asynchronous TCP connects and accepts driven by a single poll context. */
+
+#ifndef ETCPAL_CONNECTOR_H_
+#define ETCPAL_CONNECTOR_H_
+
+#include <stddef.h>
+#include "etcpal/error.h"
+#include "etcpal/inet.h"
+#include "etcpal/socket.h"
+
+/**
+ * @defgroup etcpal_connector connector (Asynchronous Connect and Accept)
+ * @ingroup etcpal_net
+ * @brief Run many non-blocking TCP connects and accepts at once from one thread.
+ *
+ * ```c
+ * #include "etcpal/connector.h"
+ * ```
+ *
+ * A non-blocking connect is started with etcpal_connect(), waited for with #ETCPAL_POLL_CONNECT,
+ * and its result read from the poll event's error field, with a timer running alongside in case
+ * the peer never answers. A connector does this for any number of connects at once, each with its
+ * own timeout, using a single EtcPalPollContext. It can also accept connections on listening
+ * sockets in the same context. Completions are reported through callbacks from
+ * etcpal_connector_process(), which the application calls from a thread of its choice.
+ *
+ * @code
+ * void connect_done(etcpal_socket_t socket, etcpal_error_t result, void* context)
+ * {
+ *   if (result == kEtcPalErrOk)
+ *   {
+ *     // socket is connected, in non-blocking mode, and now owned by the application.
+ *   }
+ *   else
+ *   {
+ *     // The socket has been closed. result is #kEtcPalErrTimedOut, #kEtcPalErrConnRefused, ...
+ *   }
+ * }
+ *
+ * EtcPalConnector* connector;
+ * etcpal_connector_create(&connector);
+ *
+ * for (size_t i = 0; i < num_peers; ++i)
+ * {
+ *   etcpal_socket_t sock;
+ *   etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_STREAM, &sock);
+ *   etcpal_connector_connect(connector, sock, &peers[i], 5000, connect_done, &peer_state[i]);
+ * }
+ *
+ * while (running)
+ *   etcpal_connector_process(connector, 100);
+ * @endcode
+ *
+ * The functions in this module are thread-safe, and can be called from within the connector's
+ * callbacks. Callbacks are only called from etcpal_connector_process(). The number of sockets a
+ * connector can track at once is limited by the poll API on the platform (see
+ * #ETCPAL_SOCKET_MAX_POLL_SIZE).
+ *
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** An opaque connector instance. */
+typedef struct EtcPalConnector EtcPalConnector;
+
+/**
+ * @brief A function which handles the completion of a connect started with
+ *        etcpal_connector_connect().
+ * @param socket On success, the connected socket, which is now owned by the application and is in
+ *               non-blocking mode. On failure, #ETCPAL_SOCKET_INVALID; the socket has been closed.
+ * @param result #kEtcPalErrOk if the connect succeeded, #kEtcPalErrTimedOut if it did not complete
+ *               in time, or the error with which it failed.
+ * @param context The context pointer passed to etcpal_connector_connect().
+ */
+typedef void (*EtcPalConnectCallback)(etcpal_socket_t socket, etcpal_error_t result, void* context);
+
+/**
+ * @brief A function which handles a connection accepted on a listening socket.
+ * @param listener The listening socket passed to etcpal_connector_add_listener().
+ * @param conn The new connection, which is owned by the application.
+ * @param remote_addr The address of the remote end of the connection.
+ * @param context The context pointer passed to etcpal_connector_add_listener().
+ */
+typedef void (*EtcPalAcceptCallback)(etcpal_socket_t       listener,
+                                     etcpal_socket_t       conn,
+                                     const EtcPalSockAddr* remote_addr,
+                                     void*                 context);
+
+etcpal_error_t etcpal_connector_create(EtcPalConnector** connector);
+void           etcpal_connector_destroy(EtcPalConnector* connector);
+
+etcpal_error_t etcpal_connector_connect(EtcPalConnector*      connector,
+                                        etcpal_socket_t       socket,
+                                        const EtcPalSockAddr* addr,
+                                        int                   timeout_ms,
+                                        EtcPalConnectCallback callback,
+                                        void*                 context);
+etcpal_error_t etcpal_connector_cancel(EtcPalConnector* connector, etcpal_socket_t socket);
+size_t         etcpal_connector_num_pending(EtcPalConnector* connector);
+
+etcpal_error_t etcpal_connector_add_listener(EtcPalConnector*     connector,
+                                             etcpal_socket_t      listener,
+                                             EtcPalAcceptCallback callback,
+                                             void*                context);
+etcpal_error_t etcpal_connector_remove_listener(EtcPalConnector* connector, etcpal_socket_t listener);
+
+etcpal_error_t etcpal_connector_process(EtcPalConnector* connector, int timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* ETCPAL_CONNECTOR_H_ */
@@ -27,7 +27,11 @@
 #include <chrono>
 #include <cstddef>
 #include <limits>
+#include <new>
+#include <type_traits>
+#include <utility>
 #include "etcpal/common.h"
+#include "etcpal/mpmc_queue.h"
 #include "etcpal/queue.h"
 #include "etcpal/cpp/common.h"
 
@@ -82,8 +86,62 @@ namespace etcpal
 /// In these cases, the Send() and Receive() functions will return false if the timeout was reached
 /// while waiting.
 ///
+/// Trivially copyable items are copied into and out of the queue byte-for-byte. Where
+/// #ETCPAL_QUEUE_HAS_IN_PLACE_FUNCTIONS is set, the queue can also hold other types, including
+/// move-only ones: they are constructed directly in the queue's storage, moved out by Receive(),
+/// and destroyed when received or when the queue is reset or destroyed. Emplace() and
+/// TimedEmplace() construct an item in the queue from constructor arguments, only once there is
+/// room for it. SendFromIsr() and ReceiveFromIsr() are only available for trivially copyable items.
+///
+/// @code
+/// etcpal::Queue<std::unique_ptr<Packet>> packets(16);
+/// packets.Send(std::unique_ptr<Packet>(new Packet));
+///
+/// etcpal::Queue<std::vector<uint8_t>> buffers(16);
+/// buffers.Emplace(512, 0); // A vector of 512 zero bytes, built in the queue
+///
+/// std::vector<uint8_t> buffer;
+/// buffers.Receive(buffer);
+/// @endcode
+///
+/// Where #ETCPAL_QUEUE_HAS_IN_PLACE_FUNCTIONS is set, large trivially copyable items can be built
+/// and read directly in the queue's storage with Reserve()/Commit() and Peek()/Release(), saving a
+/// copy on each side. Other senders and receivers carry on while a slot is held, but items are
+/// received in the order their slots were reserved, so commit or abort each reservation promptly.
+///
+/// @code
+/// Foo* slot = queue.Reserve();
+/// if (slot)
+/// {
+///   slot->value = 42;
+///   queue.Commit(slot);
+/// }
+///
+/// const Foo* next = queue.Peek(0);
+/// if (next)
+/// {
+///   Process(*next);
+///   queue.Release(next);
+/// }
+/// @endcode
+///
 /// OS queues are only available on RTOS platforms. See the @ref etcpal_queue module for details on
 /// what platforms this class is available on.
+///
+/// The template class MpmcQueue has the same Send() and Receive() interface, plus TrySend() and
+/// TryReceive(), and is backed by the lock-free @ref etcpal_mpmc_queue module instead. Use it when
+/// many threads send to the same queue, since they do not serialize on a lock. Its items are
+/// copied byte-for-byte, so they must be trivially copyable.
+///
+/// @code
+/// // A queue of at least 1000 packets, rounded up to 1024, fed by many network threads.
+/// etcpal::MpmcQueue<Packet> packets(1000);
+///
+/// if (!packets.TrySend(packet))
+/// {
+///   // The processing stage has fallen behind; drop the packet.
+/// }
+/// @endcode
 
 /// @ingroup etcpal_cpp_queue
 /// @brief An RTOS queue class.
@@ -93,6 +151,11 @@ template <class T>
 class Queue
 {
 public:
+  static_assert(std::is_trivially_copyable<T>::value || ETCPAL_QUEUE_HAS_IN_PLACE_FUNCTIONS,
+                "On this platform, etcpal::Queue items are copied with memcpy and must be trivially copyable");
+  static_assert(std::is_trivially_copyable<T>::value || alignof(T) <= alignof(std::max_align_t),
+                "etcpal::Queue cannot hold over-aligned items which are not trivially copyable");
+
   explicit Queue(size_t size);
   ~Queue();
 
@@ -102,12 +165,24 @@ public:
   Queue& operator=(Queue&& other) = delete;
 
   bool Send(const T& data, int timeout_ms = ETCPAL_WAIT_FOREVER);
+  bool Send(T&& data, int timeout_ms = ETCPAL_WAIT_FOREVER);
   bool SendFromIsr(const T& data);
+  template <class... Args>
+  bool Emplace(Args&&... args);
+  template <class... Args>
+  bool TimedEmplace(int timeout_ms, Args&&... args);
 
   bool Receive(T& data, int timeout_ms = ETCPAL_WAIT_FOREVER);
   template <class Rep, class Period>
   bool Receive(T& data, const std::chrono::duration<Rep, Period>& timeout);
   bool ReceiveFromIsr(T& data);
+
+  T*   Reserve(int timeout_ms = ETCPAL_WAIT_FOREVER);
+  void Commit(T* slot);
+  void Abort(T* slot);
+  T*   Peek(int timeout_ms = ETCPAL_WAIT_FOREVER);
+  void Release(const T* item);
+
   bool Reset();
   bool IsEmpty() const;
   bool IsEmptyFromIsr() const;
@@ -118,6 +193,22 @@ public:
   size_t SlotsAvailable() const;
 
 private:
+  using IsBitwise = std::integral_constant<bool, std::is_trivially_copyable<T>::value>;
+
+  template <class U>
+  bool SendImpl(U&& data, int timeout_ms, std::true_type);
+  template <class U>
+  bool SendImpl(U&& data, int timeout_ms, std::false_type);
+  template <class... Args>
+  bool ConstructInPlace(int timeout_ms, Args&&... args);
+
+  bool ReceiveImpl(T& data, int timeout_ms, std::true_type);
+  bool ReceiveImpl(T& data, int timeout_ms, std::false_type);
+
+  bool ResetImpl(std::true_type);
+  bool ResetImpl(std::false_type);
+  void DestroyItems();
+
   etcpal_queue_t queue_{};
 };
 
@@ -130,14 +221,16 @@ inline Queue<T>::Queue(size_t size)
   etcpal_queue_create(&queue_, size, sizeof(T));
 }
 
-/// @brief Destroy a queue.
+/// @brief Destroy a queue, along with any items still in it.
 template <class T>
 inline Queue<T>::~Queue()
 {
+  if (!IsBitwise::value)
+    DestroyItems();
   etcpal_queue_destroy(&queue_);
 }
 
-/// @brief Add some data to the queue.
+/// @brief Add a copy of some data to the queue.
 ///
 /// Returns when either the timeout expires or the add was attempted. It is still possible for the
 /// attempt to be made and the add to not work. Check the return value for confirmation.
@@ -148,26 +241,76 @@ inline Queue<T>::~Queue()
 template <class T>
 inline bool Queue<T>::Send(const T& data, int timeout_ms)
 {
-  return etcpal_queue_timed_send(&queue_, &data, timeout_ms);
+  return SendImpl(data, timeout_ms, IsBitwise{});
+}
+
+/// @brief Move some data into the queue.
+///
+/// The data is only moved from if there is room for it in the queue; if the timeout expires, it is
+/// left untouched.
+///
+/// @param data An rvalue reference to the data.
+/// @param timeout_ms How long to wait to add to the queue.
+/// @return The result of the attempt to add to the queue.
+template <class T>
+inline bool Queue<T>::Send(T&& data, int timeout_ms)
+{
+  return SendImpl(std::move(data), timeout_ms, IsBitwise{});
 }
 
 /// @brief Add to a queue from an interrupt service routine.
+///
+/// Only available for trivially copyable items, since constructing other items in the queue is not
+/// safe in interrupt context.
+///
 /// @param data A reference to the data to be added to the queue.
 /// @return The result of the attempt to add to the queue.
 template <class T>
 inline bool Queue<T>::SendFromIsr(const T& data)
 {
+  static_assert(IsBitwise::value, "SendFromIsr() requires trivially copyable items; use Send() for this type");
   return etcpal_queue_send_from_isr(&queue_, &data);
 }
 
+/// @brief Construct an item directly in the queue, waiting indefinitely for room.
+/// @param args Arguments to forward to the constructor of T.
+/// @return The result of the attempt to add to the queue.
+template <class T>
+template <class... Args>
+inline bool Queue<T>::Emplace(Args&&... args)
+{
+  return TimedEmplace(ETCPAL_WAIT_FOREVER, std::forward<Args>(args)...);
+}
+
+/// @brief Construct an item directly in the queue.
+///
+/// The item is constructed only once there is room for it. On platforms without
+/// #ETCPAL_QUEUE_HAS_IN_PLACE_FUNCTIONS, it is constructed on the stack and then copied in.
+///
+/// @param timeout_ms How long to wait to add to the queue.
+/// @param args Arguments to forward to the constructor of T.
+/// @return The result of the attempt to add to the queue.
+template <class T>
+template <class... Args>
+inline bool Queue<T>::TimedEmplace(int timeout_ms, Args&&... args)
+{
+#if ETCPAL_QUEUE_HAS_IN_PLACE_FUNCTIONS
+  return ConstructInPlace(timeout_ms, std::forward<Args>(args)...);
+#else
+  T data(std::forward<Args>(args)...);
+  return etcpal_queue_timed_send(&queue_, &data, timeout_ms);
+#endif
+}
+
 /// @brief Get an item from the queue.
-/// @param data A reference to the data that will receive the item from the queue.
+/// @param data A reference to the data that will receive the item from the queue. Items which are
+///             not trivially copyable are moved into it.
 /// @param timeout_ms Amount of time to wait for data.
 /// @return The result of the attempt to get an item from the queue.
 template <class T>
 inline bool Queue<T>::Receive(T& data, int timeout_ms)
 {
-  return etcpal_queue_timed_receive(&queue_, &data, timeout_ms);
+  return ReceiveImpl(data, timeout_ms, IsBitwise{});
 }
 
 /// @brief Get an item from the queue.
@@ -183,25 +326,83 @@ inline bool Queue<T>::Receive(T& data, const std::chrono::duration<Rep, Period>&
   int timeout_ms_clamped =
       static_cast<int>(std::min(std::chrono::milliseconds(timeout).count(),
                                 static_cast<std::chrono::milliseconds::rep>(std::numeric_limits<int>::max())));
-  return etcpal_queue_timed_receive(&queue_, &data, timeout_ms_clamped);
+  return ReceiveImpl(data, timeout_ms_clamped, IsBitwise{});
 }
 
 /// @brief Get an item from the queue from an interrupt context.
+///
+/// Only available for trivially copyable items, since moving other items out of the queue is not
+/// safe in interrupt context.
+///
 /// @param data A reference to the data that will receive the item from the queue.
 /// @return The result of the attempt to get an item from the queue.
 template <class T>
 inline bool Queue<T>::ReceiveFromIsr(T& data)
 {
+  static_assert(IsBitwise::value, "ReceiveFromIsr() requires trivially copyable items; use Receive() for this type");
   return etcpal_queue_receive_from_isr(&queue_, &data);
 }
 
-/// @brief Resets queue to empty state.
+/// @brief Reserve the next slot in the queue, to build an item in place.
+///
+/// Write the item through the returned pointer, then call Commit() to add it to the queue or
+/// Abort() to give the slot back. Only available for trivially copyable T; use Emplace() for other
+/// types.
+///
+/// @param timeout_ms How long to wait for room in the queue.
+/// @return Pointer to the slot, or nullptr if none could be reserved.
+template <class T>
+inline T* Queue<T>::Reserve(int timeout_ms)
+{
+  static_assert(IsBitwise::value, "Reserve() hands out raw storage; use Emplace() for this type");
+  return reinterpret_cast<T*>(etcpal_queue_reserve(&queue_, timeout_ms));
+}
+
+/// @brief Add the item built in a slot returned by Reserve() to the queue.
+/// @param slot The slot returned by Reserve().
+template <class T>
+inline void Queue<T>::Commit(T* slot)
+{
+  etcpal_queue_commit(&queue_, slot);
+}
+
+/// @brief Give back a slot returned by Reserve() without adding an item.
+/// @param slot The slot returned by Reserve().
+template <class T>
+inline void Queue<T>::Abort(T* slot)
+{
+  etcpal_queue_abort(&queue_, slot);
+}
+
+/// @brief Get a pointer to the first item in the queue, to read it in place.
+///
+/// Call Release() once done with the item to remove it from the queue. Only available for trivially
+/// copyable T; use Receive() for other types.
+///
+/// @param timeout_ms Amount of time to wait for data.
+/// @return Pointer to the item, or nullptr if none was available.
+template <class T>
+inline T* Queue<T>::Peek(int timeout_ms)
+{
+  static_assert(IsBitwise::value, "Release() does not destroy items; use Receive() for this type");
+  return reinterpret_cast<T*>(etcpal_queue_peek(&queue_, timeout_ms));
+}
+
+/// @brief Remove an item returned by Peek() from the queue.
+/// @param item The item returned by Peek().
+template <class T>
+inline void Queue<T>::Release(const T* item)
+{
+  etcpal_queue_release(&queue_, item);
+}
+
+/// @brief Resets queue to empty state, destroying any items in it.
 ///
 /// @return true on success, false otherwise.
 template <class T>
 inline bool Queue<T>::Reset()
 {
-  return etcpal_queue_reset(&queue_);
+  return ResetImpl(IsBitwise{});
 }
 
 /// @brief Check if a queue is empty.
@@ -267,6 +468,240 @@ inline size_t Queue<T>::SlotsAvailable() const
   return etcpal_queue_slots_available(&queue_);
 };
 
+/// @cond Private
+
+template <class T>
+template <class U>
+inline bool Queue<T>::SendImpl(U&& data, int timeout_ms, std::true_type)
+{
+  return etcpal_queue_timed_send(&queue_, &data, timeout_ms);
+}
+
+template <class T>
+template <class U>
+inline bool Queue<T>::SendImpl(U&& data, int timeout_ms, std::false_type)
+{
+  return ConstructInPlace(timeout_ms, std::forward<U>(data));
+}
+
+template <class T>
+template <class... Args>
+inline bool Queue<T>::ConstructInPlace(int timeout_ms, Args&&... args)
+{
+  void* slot = etcpal_queue_reserve(&queue_, timeout_ms);
+  if (!slot)
+    return false;
+
+#if ETCPAL_BUILDING_WITH_EXCEPTIONS
+  try
+  {
+    new (slot) T(std::forward<Args>(args)...);
+  }
+  catch (...)
+  {
+    etcpal_queue_abort(&queue_, slot);
+    throw;
+  }
+#else
+  new (slot) T(std::forward<Args>(args)...);
+#endif
+
+  etcpal_queue_commit(&queue_, slot);
+  return true;
+}
+
+template <class T>
+inline bool Queue<T>::ReceiveImpl(T& data, int timeout_ms, std::true_type)
+{
+  return etcpal_queue_timed_receive(&queue_, &data, timeout_ms);
+}
+
+// The item is destroyed and released even if moving it out throws, since the queue has no way to
+// put it back.
+template <class T>
+inline bool Queue<T>::ReceiveImpl(T& data, int timeout_ms, std::false_type)
+{
+  T* item = reinterpret_cast<T*>(etcpal_queue_peek(&queue_, timeout_ms));
+  if (!item)
+    return false;
+
+#if ETCPAL_BUILDING_WITH_EXCEPTIONS
+  try
+  {
+    data = std::move(*item);
+  }
+  catch (...)
+  {
+    item->~T();
+    etcpal_queue_release(&queue_, item);
+    throw;
+  }
+#else
+  data = std::move(*item);
+#endif
+
+  item->~T();
+  etcpal_queue_release(&queue_, item);
+  return true;
+}
+
+template <class T>
+inline bool Queue<T>::ResetImpl(std::true_type)
+{
+  return etcpal_queue_reset(&queue_);
+}
+
+template <class T>
+inline bool Queue<T>::ResetImpl(std::false_type)
+{
+  DestroyItems();
+  return true;
+}
+
+template <class T>
+inline void Queue<T>::DestroyItems()
+{
+  while (T* item = reinterpret_cast<T*>(etcpal_queue_peek(&queue_, 0)))
+  {
+    item->~T();
+    etcpal_queue_release(&queue_, item);
+  }
+}
+
+/// @endcond
+
+/// @ingroup etcpal_cpp_queue
+/// @brief A lock-free bounded multi-producer, multi-consumer queue class.
+///
+/// See the module description for @ref etcpal_cpp_queue for usage information.
+template <class T>
+class MpmcQueue
+{
+public:
+  static_assert(std::is_trivially_copyable<T>::value, "MpmcQueue items are copied with memcpy");
+
+  explicit MpmcQueue(size_t size, bool blocking = true);
+  ~MpmcQueue();
+
+  MpmcQueue(const MpmcQueue& other) = delete;
+  MpmcQueue& operator=(const MpmcQueue& other) = delete;
+  MpmcQueue(MpmcQueue&& other) = delete;
+  MpmcQueue& operator=(MpmcQueue&& other) = delete;
+
+  bool TrySend(const T& data);
+  bool Send(const T& data, int timeout_ms = ETCPAL_WAIT_FOREVER);
+
+  bool TryReceive(T& data);
+  bool Receive(T& data, int timeout_ms = ETCPAL_WAIT_FOREVER);
+  template <class Rep, class Period>
+  bool Receive(T& data, const std::chrono::duration<Rep, Period>& timeout);
+
+  bool   IsEmpty() const;
+  size_t SlotsUsed() const;
+  size_t Capacity() const;
+
+private:
+  EtcPalMpmcQueue queue_{};
+};
+
+/// @brief Create a new queue.
+///
+/// @param size The minimum number of items the queue must hold; rounded up to a power of two.
+/// @param blocking Whether Send() and Receive() can wait for room or items.
+template <class T>
+inline MpmcQueue<T>::MpmcQueue(size_t size, bool blocking)
+{
+  etcpal_mpmc_queue_create(&queue_, size, sizeof(T), blocking);
+}
+
+/// @brief Destroy a queue.
+template <class T>
+inline MpmcQueue<T>::~MpmcQueue()
+{
+  etcpal_mpmc_queue_destroy(&queue_);
+}
+
+/// @brief Add an item to the queue if there is room for it.
+/// @param data A reference to the data.
+/// @return Whether the item was added.
+template <class T>
+inline bool MpmcQueue<T>::TrySend(const T& data)
+{
+  return etcpal_mpmc_queue_try_send(&queue_, &data);
+}
+
+/// @brief Add an item to the queue, waiting for room if it is full.
+/// @param data A reference to the data.
+/// @param timeout_ms How long to wait for room in the queue.
+/// @return Whether the item was added.
+template <class T>
+inline bool MpmcQueue<T>::Send(const T& data, int timeout_ms)
+{
+  return etcpal_mpmc_queue_timed_send(&queue_, &data, timeout_ms);
+}
+
+/// @brief Get an item from the queue if there is one.
+/// @param data A reference to the data that will receive the item from the queue.
+/// @return Whether an item was received.
+template <class T>
+inline bool MpmcQueue<T>::TryReceive(T& data)
+{
+  return etcpal_mpmc_queue_try_receive(&queue_, &data);
+}
+
+/// @brief Get an item from the queue, waiting for one if it is empty.
+/// @param data A reference to the data that will receive the item from the queue.
+/// @param timeout_ms Amount of time to wait for data.
+/// @return Whether an item was received.
+template <class T>
+inline bool MpmcQueue<T>::Receive(T& data, int timeout_ms)
+{
+  return etcpal_mpmc_queue_timed_receive(&queue_, &data, timeout_ms);
+}
+
+/// @brief Get an item from the queue, waiting for one if it is empty.
+///
+/// @param data A reference to the data that will receive the item from the queue.
+/// @param timeout Amount of time to wait for data.
+///
+/// @return Whether an item was received.
+template <class T>
+template <class Rep, class Period>
+inline bool MpmcQueue<T>::Receive(T& data, const std::chrono::duration<Rep, Period>& timeout)
+{
+  int timeout_ms_clamped =
+      static_cast<int>(std::min(std::chrono::milliseconds(timeout).count(),
+                                static_cast<std::chrono::milliseconds::rep>(std::numeric_limits<int>::max())));
+  return etcpal_mpmc_queue_timed_receive(&queue_, &data, timeout_ms_clamped);
+}
+
+/// @brief Check if the queue is empty.
+///
+/// @return true if queue is empty, false otherwise.
+template <class T>
+inline bool MpmcQueue<T>::IsEmpty() const
+{
+  return etcpal_mpmc_queue_is_empty(&queue_);
+}
+
+/// @brief Get the number of items in the queue.
+///
+/// @return number of items in queue.
+template <class T>
+inline size_t MpmcQueue<T>::SlotsUsed() const
+{
+  return etcpal_mpmc_queue_slots_used(&queue_);
+}
+
+/// @brief Get the number of items the queue can hold.
+///
+/// @return The size the queue was created with, rounded up to a power of two.
+template <class T>
+inline size_t MpmcQueue<T>::Capacity() const
+{
+  return etcpal_mpmc_queue_capacity(&queue_);
+}
+
 };  // namespace etcpal
 
 #endif  // ETCPAL_CPP_RTOS_ERROR_H
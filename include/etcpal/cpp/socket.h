@@ -0,0 +1,815 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+/// @file etcpal/cpp/socket.h
+/// @brief C++ wrapper and utilities for etcpal/socket.h
+
+#ifndef ETCPAL_CPP_SOCKET_H_
+#define ETCPAL_CPP_SOCKET_H_
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include "etcpal/common.h"
+#include "etcpal/socket.h"
+#include "etcpal/cpp/common.h"
+#include "etcpal/cpp/error.h"
+#include "etcpal/cpp/inet.h"
+
+namespace etcpal
+{
+/// @defgroup etcpal_cpp_socket socket (Network Socket Interface)
+/// @ingroup etcpal_cpp
+/// @brief C++ utilities for the @ref etcpal_socket module.
+
+/// @cond detail
+
+namespace detail
+{
+// Whether a type is a contiguous container with data() and size() members, e.g. std::vector,
+// std::array or std::string.
+template <typename Container, typename = void>
+struct IsContiguousContainer : std::false_type
+{
+};
+
+template <typename Container>
+struct IsContiguousContainer<Container,
+                             decltype(void(std::declval<Container&>().data()),
+                                      void(std::declval<Container&>().size()))> : std::true_type
+{
+};
+
+// Whether a contiguous container's data() gives mutable access to its elements.
+template <typename Container, typename = void>
+struct IsMutableContainer : std::false_type
+{
+};
+
+template <typename Container>
+struct IsMutableContainer<
+    Container,
+    typename std::enable_if<std::is_convertible<decltype(std::declval<Container&>().data()), void*>::value>::type>
+    : std::true_type
+{
+};
+
+}  // namespace detail
+
+/// @endcond
+
+/// @ingroup etcpal_cpp_socket
+/// @brief A non-owning view of a contiguous block of memory to be written to a socket.
+///
+/// Converts implicitly from arrays and from contiguous containers such as std::vector, std::array
+/// and std::string, so that these can be passed directly to the Socket I/O functions. The size is
+/// always in bytes. Like a span, the buffer does not own the memory it refers to.
+class ConstBuffer
+{
+public:
+  /// @brief Construct an empty buffer.
+  constexpr ConstBuffer() noexcept = default;
+  constexpr ConstBuffer(const void* data, size_t size) noexcept;
+  template <typename T, size_t N>
+  constexpr ConstBuffer(const T (&array)[N]) noexcept;  // NOLINT(google-explicit-constructor)
+  template <typename Container, ETCPAL_ENABLE_IF_TEMPLATE(detail::IsContiguousContainer<const Container>::value)>
+  ConstBuffer(const Container& container) noexcept;  // NOLINT(google-explicit-constructor)
+
+  constexpr const void* data() const noexcept;
+  constexpr size_t      size() const noexcept;
+  constexpr bool        empty() const noexcept;
+
+private:
+  const void* data_{nullptr};
+  size_t      size_{0};
+};
+
+/// @brief Construct a buffer referring to size bytes at data.
+constexpr ConstBuffer::ConstBuffer(const void* data, size_t size) noexcept : data_(data), size_(size)
+{
+}
+
+/// @brief Construct a buffer referring to the contents of an array.
+template <typename T, size_t N>
+constexpr ConstBuffer::ConstBuffer(const T (&array)[N]) noexcept : data_(array), size_(sizeof array)
+{
+}
+
+/// @brief Construct a buffer referring to the contents of a contiguous container.
+template <typename Container, typename>
+ConstBuffer::ConstBuffer(const Container& container) noexcept
+    : data_(container.data()), size_(container.size() * sizeof(*container.data()))
+{
+}
+
+/// @brief Get a pointer to the start of the buffer.
+constexpr const void* ConstBuffer::data() const noexcept
+{
+  return data_;
+}
+
+/// @brief Get the size of the buffer in bytes.
+constexpr size_t ConstBuffer::size() const noexcept
+{
+  return size_;
+}
+
+/// @brief Whether the buffer is empty.
+constexpr bool ConstBuffer::empty() const noexcept
+{
+  return size_ == 0;
+}
+
+/// @ingroup etcpal_cpp_socket
+/// @brief A non-owning view of a contiguous block of memory to be filled from a socket.
+///
+/// The mutable counterpart of ConstBuffer. Converts implicitly from non-const arrays and from
+/// contiguous containers whose data() member gives mutable access, such as std::vector and
+/// std::array.
+class MutableBuffer
+{
+public:
+  /// @brief Construct an empty buffer.
+  constexpr MutableBuffer() noexcept = default;
+  constexpr MutableBuffer(void* data, size_t size) noexcept;
+  template <typename T, size_t N>
+  constexpr MutableBuffer(T (&array)[N]) noexcept;  // NOLINT(google-explicit-constructor)
+  template <typename Container,
+            ETCPAL_ENABLE_IF_TEMPLATE(detail::IsContiguousContainer<Container>::value &&
+                                      detail::IsMutableContainer<Container>::value)>
+  MutableBuffer(Container& container) noexcept;  // NOLINT(google-explicit-constructor)
+
+  constexpr void*  data() const noexcept;
+  constexpr size_t size() const noexcept;
+  constexpr bool   empty() const noexcept;
+
+  // NOLINTNEXTLINE(google-explicit-constructor)
+  constexpr operator ConstBuffer() const noexcept;
+
+private:
+  void*  data_{nullptr};
+  size_t size_{0};
+};
+
+/// @brief Construct a buffer referring to size bytes at data.
+constexpr MutableBuffer::MutableBuffer(void* data, size_t size) noexcept : data_(data), size_(size)
+{
+}
+
+/// @brief Construct a buffer referring to the contents of an array.
+template <typename T, size_t N>
+constexpr MutableBuffer::MutableBuffer(T (&array)[N]) noexcept : data_(array), size_(sizeof array)
+{
+}
+
+/// @brief Construct a buffer referring to the contents of a contiguous container.
+template <typename Container, typename>
+MutableBuffer::MutableBuffer(Container& container) noexcept
+    : data_(container.data()), size_(container.size() * sizeof(*container.data()))
+{
+}
+
+/// @brief Get a pointer to the start of the buffer.
+constexpr void* MutableBuffer::data() const noexcept
+{
+  return data_;
+}
+
+/// @brief Get the size of the buffer in bytes.
+constexpr size_t MutableBuffer::size() const noexcept
+{
+  return size_;
+}
+
+/// @brief Whether the buffer is empty.
+constexpr bool MutableBuffer::empty() const noexcept
+{
+  return size_ == 0;
+}
+
+/// @brief View the buffer as read-only.
+constexpr MutableBuffer::operator ConstBuffer() const noexcept
+{
+  return ConstBuffer(data_, size_);
+}
+
+/// @ingroup etcpal_cpp_socket
+/// @brief An owning wrapper for an EtcPal socket handle.
+///
+/// A Socket closes the socket it owns when it is destroyed. Sockets can be moved but not copied,
+/// so each socket handle has exactly one owner. A default-constructed or moved-from Socket does not
+/// own a socket; operations on it fail with #kEtcPalErrInvalid or #kEtcPalErrNotFound depending on
+/// the underlying function.
+///
+/// The I/O functions take ConstBuffer and MutableBuffer views, which convert implicitly from
+/// arrays and contiguous containers, and return the number of bytes transferred as an Expected.
+/// Addresses are passed by reference to the etcpal::SockAddr objects owned by the caller.
+///
+/// Example usage:
+/// @code
+/// auto sock = etcpal::Socket::Create(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM);
+/// if (sock && sock->Bind(etcpal::SockAddr(etcpal::IpAddr::WildcardV4(), 5568)))
+/// {
+///   std::array<uint8_t, 1500> buf;
+///   etcpal::SockAddr          from;
+///   auto                      length = sock->ReceiveFrom(buf, from);
+///   if (length)
+///   {
+///     // Handle *length bytes of data from the address from...
+///   }
+/// }
+/// // The socket is closed when sock goes out of scope.
+/// @endcode
+///
+/// See @ref etcpal_socket for more information.
+class Socket
+{
+public:
+  /// @brief Construct a Socket which does not own a socket.
+  Socket() = default;
+  explicit Socket(etcpal_socket_t socket) noexcept;
+  ~Socket();
+
+  Socket(Socket&& other) noexcept;
+  Socket& operator=(Socket&& other) noexcept;
+
+  /// Deleted copy constructor - sockets are not copyable
+  Socket(const Socket& other) = delete;
+  /// Deleted copy assignment operator - sockets are not copyable
+  Socket& operator=(const Socket& other) = delete;
+
+  static Expected<Socket> Create(unsigned int family, unsigned int type) noexcept;
+
+  etcpal_socket_t get() const noexcept;
+  bool            IsValid() const noexcept;
+  explicit operator bool() const noexcept;
+  etcpal_socket_t Release() noexcept;
+  Error           Close() noexcept;
+
+  Error              Bind(const SockAddr& address) noexcept;
+  Error              Connect(const SockAddr& address) noexcept;
+  Error              Listen(int backlog = 0) noexcept;
+  Expected<Socket>   Accept() noexcept;
+  Expected<Socket>   Accept(SockAddr& address) noexcept;
+  Error              Shutdown(int how) noexcept;
+  Expected<SockAddr> GetSockName() const noexcept;
+  Expected<SockAddr> GetPeerName() const noexcept;
+
+  Expected<size_t> Send(ConstBuffer buffer, int flags = 0) noexcept;
+  Expected<size_t> SendTo(ConstBuffer buffer, const SockAddr& address, int flags = 0) noexcept;
+  Expected<size_t> Receive(MutableBuffer buffer, int flags = 0) noexcept;
+  Expected<size_t> ReceiveFrom(MutableBuffer buffer, SockAddr& address, int flags = 0) noexcept;
+
+  template <typename T>
+  Error SetOption(int level, int option_name, const T& value) noexcept;
+  Error SetBlocking(bool blocking) noexcept;
+
+private:
+  static Expected<size_t> IoResult(int res) noexcept;
+
+  etcpal_socket_t socket_{ETCPAL_SOCKET_INVALID};
+};
+
+/// @brief Take ownership of an existing socket handle.
+inline Socket::Socket(etcpal_socket_t socket) noexcept : socket_(socket)
+{
+}
+
+/// @brief Close the owned socket, if any.
+inline Socket::~Socket()
+{
+  if (socket_ != ETCPAL_SOCKET_INVALID)
+    etcpal_close(socket_);
+}
+
+/// @brief Move another socket into this socket.
+/// @post other does not own a socket.
+inline Socket::Socket(Socket&& other) noexcept : socket_(other.Release())
+{
+}
+
+/// @brief Move another socket into this socket, closing the socket previously owned by *this.
+/// @post other does not own a socket.
+inline Socket& Socket::operator=(Socket&& other) noexcept
+{
+  if (this != &other)
+  {
+    Close();
+    socket_ = other.Release();
+  }
+  return *this;
+}
+
+/// @brief Create a new socket.
+/// @param family Address family of the socket (e.g. #ETCPAL_AF_INET).
+/// @param type Type of the socket (e.g. #ETCPAL_SOCK_DGRAM).
+/// @return The new socket, or the error returned by etcpal_socket().
+inline Expected<Socket> Socket::Create(unsigned int family, unsigned int type) noexcept
+{
+  etcpal_socket_t socket = ETCPAL_SOCKET_INVALID;
+  etcpal_error_t  res = etcpal_socket(family, type, &socket);
+  if (res == kEtcPalErrOk)
+    return Socket(socket);
+  return res;
+}
+
+/// @brief Get the underlying socket handle, which remains owned by this object.
+inline etcpal_socket_t Socket::get() const noexcept
+{
+  return socket_;
+}
+
+/// @brief Whether this object owns a socket.
+inline bool Socket::IsValid() const noexcept
+{
+  return socket_ != ETCPAL_SOCKET_INVALID;
+}
+
+/// @brief Whether this object owns a socket.
+inline Socket::operator bool() const noexcept
+{
+  return IsValid();
+}
+
+/// @brief Give up ownership of the socket without closing it.
+/// @return The socket handle, which the caller is now responsible for closing.
+inline etcpal_socket_t Socket::Release() noexcept
+{
+  etcpal_socket_t socket = socket_;
+  socket_ = ETCPAL_SOCKET_INVALID;
+  return socket;
+}
+
+/// @brief Close the owned socket, if any.
+/// @return The result of etcpal_close(), or #kEtcPalErrOk if no socket was owned.
+inline Error Socket::Close() noexcept
+{
+  if (socket_ == ETCPAL_SOCKET_INVALID)
+    return kEtcPalErrOk;
+  return etcpal_close(Release());
+}
+
+/// @brief Bind the socket to a local address.
+/// @return The result of etcpal_bind().
+inline Error Socket::Bind(const SockAddr& address) noexcept
+{
+  return etcpal_bind(socket_, &address.get());
+}
+
+/// @brief Connect the socket to a remote address.
+/// @return The result of etcpal_connect().
+inline Error Socket::Connect(const SockAddr& address) noexcept
+{
+  return etcpal_connect(socket_, &address.get());
+}
+
+/// @brief Listen for incoming connections.
+/// @return The result of etcpal_listen().
+inline Error Socket::Listen(int backlog) noexcept
+{
+  return etcpal_listen(socket_, backlog);
+}
+
+/// @brief Accept an incoming connection.
+/// @return The connected socket, or the error returned by etcpal_accept().
+inline Expected<Socket> Socket::Accept() noexcept
+{
+  etcpal_socket_t conn_sock = ETCPAL_SOCKET_INVALID;
+  etcpal_error_t  res = etcpal_accept(socket_, nullptr, &conn_sock);
+  if (res == kEtcPalErrOk)
+    return Socket(conn_sock);
+  return res;
+}
+
+/// @brief Accept an incoming connection, getting the address of the remote peer.
+/// @param address Filled in with the address of the remote peer on success.
+/// @return The connected socket, or the error returned by etcpal_accept().
+inline Expected<Socket> Socket::Accept(SockAddr& address) noexcept
+{
+  etcpal_socket_t conn_sock = ETCPAL_SOCKET_INVALID;
+  etcpal_error_t  res = etcpal_accept(socket_, &address.get(), &conn_sock);
+  if (res == kEtcPalErrOk)
+    return Socket(conn_sock);
+  return res;
+}
+
+/// @brief Shut down part of a full-duplex connection.
+/// @param how One of the ETCPAL_SHUT_* values.
+/// @return The result of etcpal_shutdown().
+inline Error Socket::Shutdown(int how) noexcept
+{
+  return etcpal_shutdown(socket_, how);
+}
+
+/// @brief Get the local address to which the socket is bound.
+/// @return The address, or the error returned by etcpal_getsockname().
+inline Expected<SockAddr> Socket::GetSockName() const noexcept
+{
+  SockAddr       address;
+  etcpal_error_t res = etcpal_getsockname(socket_, &address.get());
+  if (res == kEtcPalErrOk)
+    return address;
+  return res;
+}
+
+/// @brief Get the address of the remote peer to which the socket is connected.
+/// @return The address, or the error returned by etcpal_getpeername().
+inline Expected<SockAddr> Socket::GetPeerName() const noexcept
+{
+  SockAddr       address;
+  etcpal_error_t res = etcpal_getpeername(socket_, &address.get());
+  if (res == kEtcPalErrOk)
+    return address;
+  return res;
+}
+
+/// @brief Send data on a connected socket.
+/// @return The number of bytes sent, or the error returned by etcpal_send().
+inline Expected<size_t> Socket::Send(ConstBuffer buffer, int flags) noexcept
+{
+  return IoResult(etcpal_send(socket_, buffer.data(), buffer.size(), flags));
+}
+
+/// @brief Send data to a specific address.
+/// @return The number of bytes sent, or the error returned by etcpal_sendto().
+inline Expected<size_t> Socket::SendTo(ConstBuffer buffer, const SockAddr& address, int flags) noexcept
+{
+  return IoResult(etcpal_sendto(socket_, buffer.data(), buffer.size(), flags, &address.get()));
+}
+
+/// @brief Receive data on a connected socket.
+/// @return The number of bytes received, or the error returned by etcpal_recv().
+inline Expected<size_t> Socket::Receive(MutableBuffer buffer, int flags) noexcept
+{
+  return IoResult(etcpal_recv(socket_, buffer.data(), buffer.size(), flags));
+}
+
+/// @brief Receive data, getting the address from which it was sent.
+/// @param buffer Buffer to fill in with the data.
+/// @param address Filled in with the address from which the data was sent on success.
+/// @param flags Receive flags.
+/// @return The number of bytes received, or the error returned by etcpal_recvfrom().
+inline Expected<size_t> Socket::ReceiveFrom(MutableBuffer buffer, SockAddr& address, int flags) noexcept
+{
+  return IoResult(etcpal_recvfrom(socket_, buffer.data(), buffer.size(), flags, &address.get()));
+}
+
+/// @brief Set a socket option.
+/// @param level The option level (e.g. #ETCPAL_SOL_SOCKET).
+/// @param option_name The option name (e.g. #ETCPAL_SO_RCVBUF).
+/// @param value The option value, of the type documented for the option.
+/// @return The result of etcpal_setsockopt().
+template <typename T>
+Error Socket::SetOption(int level, int option_name, const T& value) noexcept
+{
+  return etcpal_setsockopt(socket_, level, option_name, &value, sizeof(T));
+}
+
+/// @brief Set the socket to blocking or non-blocking mode.
+/// @return The result of etcpal_setblocking().
+inline Error Socket::SetBlocking(bool blocking) noexcept
+{
+  return etcpal_setblocking(socket_, blocking);
+}
+
+inline Expected<size_t> Socket::IoResult(int res) noexcept
+{
+  if (res >= 0)
+    return static_cast<size_t>(res);
+  return static_cast<etcpal_error_t>(res);
+}
+
+/// @ingroup etcpal_cpp_socket
+/// @brief A fixed-capacity batch of poll events, filled in by PollContext::WaitMany().
+///
+/// The events are stored inline, so a PollEvents object can be reused for every wait in a receive
+/// loop without any allocation. Iterate over the events reported by the last wait with a
+/// range-based for loop:
+///
+/// @code
+/// etcpal::PollEvents<16> events;
+/// while (context.WaitMany(events, 100))
+/// {
+///   for (const EtcPalPollEvent& event : events)
+///   {
+///     // Handle event...
+///   }
+/// }
+/// @endcode
+///
+/// @tparam N The maximum number of events retrieved by one wait.
+template <size_t N>
+class PollEvents
+{
+public:
+  static_assert(N > 0, "A PollEvents batch must hold at least one event");
+
+  /// The type used to iterate over the events.
+  using const_iterator = const EtcPalPollEvent*;
+
+  const_iterator          begin() const noexcept;
+  const_iterator          end() const noexcept;
+  size_t                  size() const noexcept;
+  bool                    empty() const noexcept;
+  static constexpr size_t capacity() noexcept;
+  const EtcPalPollEvent&  operator[](size_t index) const noexcept;
+  void                    clear() noexcept;
+
+private:
+  friend class PollContext;
+
+  std::array<EtcPalPollEvent, N> events_{};
+  size_t                         size_{0};
+};
+
+/// @brief Get an iterator to the first event reported by the last wait.
+template <size_t N>
+typename PollEvents<N>::const_iterator PollEvents<N>::begin() const noexcept
+{
+  return events_.data();
+}
+
+/// @brief Get an iterator past the last event reported by the last wait.
+template <size_t N>
+typename PollEvents<N>::const_iterator PollEvents<N>::end() const noexcept
+{
+  return events_.data() + size_;
+}
+
+/// @brief Get the number of events reported by the last wait.
+template <size_t N>
+size_t PollEvents<N>::size() const noexcept
+{
+  return size_;
+}
+
+/// @brief Whether the last wait reported no events.
+template <size_t N>
+bool PollEvents<N>::empty() const noexcept
+{
+  return size_ == 0;
+}
+
+/// @brief Get the maximum number of events that can be retrieved by one wait.
+template <size_t N>
+constexpr size_t PollEvents<N>::capacity() noexcept
+{
+  return N;
+}
+
+/// @brief Get an event reported by the last wait. index must be less than size().
+template <size_t N>
+const EtcPalPollEvent& PollEvents<N>::operator[](size_t index) const noexcept
+{
+  return events_[index];
+}
+
+/// @brief Discard the events reported by the last wait.
+template <size_t N>
+void PollEvents<N>::clear() noexcept
+{
+  size_ = 0;
+}
+
+/// @ingroup etcpal_cpp_socket
+/// @brief A wrapper class for the EtcPal poll context type.
+///
+/// Manages the lifetime of an EtcPalPollContext: the context is initialized on construction and
+/// deinitialized on destruction. The etcpal_socket module must be initialized (see etcpal_init())
+/// for the lifetime of this object.
+///
+/// Poll contexts can be moved but not copied. The underlying context is allocated once on
+/// construction so that it stays at a fixed address when the PollContext is moved; a moved-from
+/// PollContext has no context, and operations on it fail with #kEtcPalErrInvalid.
+///
+/// Example usage:
+/// @code
+/// etcpal::PollContext context;
+/// context.AddSocket(my_socket, ETCPAL_POLL_IN);
+///
+/// etcpal::PollEvents<16> events;
+/// if (context.WaitMany(events, 100))
+/// {
+///   for (const EtcPalPollEvent& event : events)
+///   {
+///     // Handle event...
+///   }
+/// }
+/// @endcode
+///
+/// See @ref etcpal_socket for more information.
+class PollContext
+{
+public:
+  PollContext();
+  ~PollContext();
+
+  PollContext(PollContext&& other) noexcept = default;
+  PollContext& operator=(PollContext&& other) noexcept;
+
+  /// Deleted copy constructor - poll contexts are not copyable
+  PollContext(const PollContext& other) = delete;
+  /// Deleted copy assignment operator - poll contexts are not copyable
+  PollContext& operator=(const PollContext& other) = delete;
+
+  bool IsValid() const noexcept;
+
+  Error AddSocket(etcpal_socket_t socket, etcpal_poll_events_t events, void* user_data = nullptr);
+  Error AddSocket(const Socket& socket, etcpal_poll_events_t events, void* user_data = nullptr);
+  Error ModifySocket(etcpal_socket_t socket, etcpal_poll_events_t new_events, void* new_user_data = nullptr);
+  Error ModifySocket(const Socket& socket, etcpal_poll_events_t new_events, void* new_user_data = nullptr);
+  void  RemoveSocket(etcpal_socket_t socket);
+  void  RemoveSocket(const Socket& socket);
+  Error Wake();
+  Error SetSpinTime(unsigned int spin_us);
+
+  Error            Wait(EtcPalPollEvent& event, int timeout_ms = ETCPAL_WAIT_FOREVER);
+  Expected<size_t> WaitMany(EtcPalPollEvent* events, size_t max_events, int timeout_ms = ETCPAL_WAIT_FOREVER);
+  template <size_t N>
+  Expected<size_t> WaitMany(EtcPalPollEvent (&events)[N], int timeout_ms = ETCPAL_WAIT_FOREVER);
+  template <size_t N>
+  Error WaitMany(PollEvents<N>& events, int timeout_ms = ETCPAL_WAIT_FOREVER);
+
+  EtcPalPollContext& get();
+
+private:
+  void Deinit() noexcept;
+
+  std::unique_ptr<EtcPalPollContext> context_;
+};
+
+/// @brief Initialize a new poll context.
+inline PollContext::PollContext() : context_(new EtcPalPollContext{})
+{
+  (void)etcpal_poll_context_init(context_.get());
+}
+
+/// @brief Deinitialize the poll context.
+inline PollContext::~PollContext()
+{
+  Deinit();
+}
+
+/// @brief Move another poll context into this one, deinitializing the context previously owned by
+///        *this.
+///
+/// No thread may be waiting on either context during the move.
+/// @post other has no context.
+inline PollContext& PollContext::operator=(PollContext&& other) noexcept
+{
+  if (this != &other)
+  {
+    Deinit();
+    context_ = std::move(other.context_);
+  }
+  return *this;
+}
+
+/// @brief Whether this object has a successfully initialized poll context.
+inline bool PollContext::IsValid() const noexcept
+{
+  return context_ && context_->valid;
+}
+
+/// @brief Add a new socket to the poll context.
+/// @return The result of etcpal_poll_add_socket() on the underlying context.
+inline Error PollContext::AddSocket(etcpal_socket_t socket, etcpal_poll_events_t events, void* user_data)
+{
+  return etcpal_poll_add_socket(context_.get(), socket, events, user_data);
+}
+
+/// @brief Add a new socket to the poll context. The socket must be removed before it is closed.
+/// @return The result of etcpal_poll_add_socket() on the underlying context.
+inline Error PollContext::AddSocket(const Socket& socket, etcpal_poll_events_t events, void* user_data)
+{
+  return AddSocket(socket.get(), events, user_data);
+}
+
+/// @brief Change the set of events or user data associated with a monitored socket.
+/// @return The result of etcpal_poll_modify_socket() on the underlying context.
+inline Error PollContext::ModifySocket(etcpal_socket_t socket, etcpal_poll_events_t new_events, void* new_user_data)
+{
+  return etcpal_poll_modify_socket(context_.get(), socket, new_events, new_user_data);
+}
+
+/// @brief Change the set of events or user data associated with a monitored socket.
+/// @return The result of etcpal_poll_modify_socket() on the underlying context.
+inline Error PollContext::ModifySocket(const Socket& socket, etcpal_poll_events_t new_events, void* new_user_data)
+{
+  return ModifySocket(socket.get(), new_events, new_user_data);
+}
+
+/// @brief Remove a monitored socket from the poll context.
+inline void PollContext::RemoveSocket(etcpal_socket_t socket)
+{
+  etcpal_poll_remove_socket(context_.get(), socket);
+}
+
+/// @brief Remove a monitored socket from the poll context.
+inline void PollContext::RemoveSocket(const Socket& socket)
+{
+  RemoveSocket(socket.get());
+}
+
+/// @brief Interrupt a thread waiting on this poll context.
+///
+/// The waiting call returns #kEtcPalErrWoken. Safe to call from any thread. A wait on a context
+/// with no sockets returns #kEtcPalErrNoSockets without blocking, so it cannot be woken.
+/// @return The result of etcpal_poll_context_wake() on the underlying context.
+inline Error PollContext::Wake()
+{
+  return etcpal_poll_context_wake(context_.get());
+}
+
+/// @brief Make waits on this poll context spin for up to spin_us microseconds before blocking.
+/// @return The result of etcpal_poll_context_set_spin_time() on the underlying context.
+inline Error PollContext::SetSpinTime(unsigned int spin_us)
+{
+  return etcpal_poll_context_set_spin_time(context_.get(), spin_us);
+}
+
+/// @brief Wait for an event on the set of monitored sockets.
+/// @param event Filled in with information about the event on success.
+/// @param timeout_ms How long to wait for an event, in milliseconds.
+/// @return The result of etcpal_poll_wait() on the underlying context.
+inline Error PollContext::Wait(EtcPalPollEvent& event, int timeout_ms)
+{
+  return etcpal_poll_wait(context_.get(), &event, timeout_ms);
+}
+
+/// @brief Wait for events on the set of monitored sockets, retrieving as many as are available.
+/// @param events Array to fill in with information about the events that occurred.
+/// @param max_events Size of the events array.
+/// @param timeout_ms How long to wait for an event, in milliseconds.
+/// @return The number of events filled in, or the error returned by etcpal_poll_wait_many().
+inline Expected<size_t> PollContext::WaitMany(EtcPalPollEvent* events, size_t max_events, int timeout_ms)
+{
+  int res = etcpal_poll_wait_many(context_.get(), events, max_events, timeout_ms);
+  if (res > 0)
+    return static_cast<size_t>(res);
+  return static_cast<etcpal_error_t>(res);
+}
+
+/// @brief Wait for events on the set of monitored sockets, filling in a fixed-size array.
+/// @param events Array to fill in with information about the events that occurred.
+/// @param timeout_ms How long to wait for an event, in milliseconds.
+/// @return The number of events filled in, or the error returned by etcpal_poll_wait_many().
+template <size_t N>
+inline Expected<size_t> PollContext::WaitMany(EtcPalPollEvent (&events)[N], int timeout_ms)
+{
+  return WaitMany(events, N, timeout_ms);
+}
+
+/// @brief Wait for events on the set of monitored sockets, filling in a reusable event batch.
+/// @param events Filled in with the events that occurred. Empty if an error is returned.
+/// @param timeout_ms How long to wait for an event, in milliseconds.
+/// @return #kEtcPalErrOk if at least one event was retrieved, or the error returned by
+///         etcpal_poll_wait_many().
+template <size_t N>
+inline Error PollContext::WaitMany(PollEvents<N>& events, int timeout_ms)
+{
+  int res = etcpal_poll_wait_many(context_.get(), events.events_.data(), N, timeout_ms);
+  if (res > 0)
+  {
+    events.size_ = static_cast<size_t>(res);
+    return kEtcPalErrOk;
+  }
+  events.size_ = 0;
+  return static_cast<etcpal_error_t>(res);
+}
+
+/// @brief Get a reference to the underlying EtcPalPollContext type.
+/// @pre IsValid() is true or the context failed to initialize; a moved-from PollContext has no
+///      underlying context.
+inline EtcPalPollContext& PollContext::get()
+{
+  return *context_;
+}
+
+inline void PollContext::Deinit() noexcept
+{
+  if (context_)
+    etcpal_poll_context_deinit(context_.get());
+}
+
+};  // namespace etcpal
+
+#endif  // ETCPAL_CPP_SOCKET_H_
@@ -0,0 +1,207 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+/// \file etcpal/cpp/spsc_queue.h
+/// \brief C++ wrapper and utilities for etcpal/spsc_queue.h
+
+#ifndef ETCPAL_CPP_SPSC_QUEUE_H
+#define ETCPAL_CPP_SPSC_QUEUE_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include "etcpal/common.h"
+#include "etcpal/spsc_queue.h"
+#include "etcpal/cpp/common.h"
+
+namespace etcpal
+{
+/// @defgroup etcpal_cpp_spsc_queue spsc_queue (Single-Producer, Single-Consumer Queues)
+/// @ingroup etcpal_cpp
+/// @brief C++ utilities for the @ref etcpal_spsc_queue module.
+///
+/// Provides a template class SpscQueue which hands objects from one producer thread to one
+/// consumer thread without locks.
+///
+/// @code
+/// #include "etcpal/cpp/spsc_queue.h"
+///
+/// // A queue of at least 1000 packets, rounded up to 1024, which the consumer can wait on.
+/// etcpal::SpscQueue<Packet> queue(1000);
+///
+/// // On the receive thread...
+/// if (!queue.TrySend(packet))
+/// {
+///   // The merge thread has fallen behind; drop the packet.
+/// }
+///
+/// // On the merge thread...
+/// Packet received;
+/// if (queue.Receive(received, 100))
+/// {
+///   // Process the packet.
+/// }
+/// @endcode
+///
+/// Items are copied into and out of the queue byte-for-byte, so T must be trivially copyable.
+///
+/// Pass false for the blocking argument of the constructor if neither side will ever wait; this
+/// removes a memory fence from each send and receive. See the @ref etcpal_spsc_queue module for
+/// details on the waiting behavior and the platforms on which timeouts are honored.
+
+/// @ingroup etcpal_cpp_spsc_queue
+/// @brief A lock-free single-producer, single-consumer queue class.
+///
+/// See the module description for @ref etcpal_cpp_spsc_queue for usage information.
+template <class T>
+class SpscQueue
+{
+public:
+  static_assert(std::is_trivially_copyable<T>::value, "SpscQueue items are copied with memcpy");
+
+  explicit SpscQueue(size_t size, bool blocking = true);
+  ~SpscQueue();
+
+  SpscQueue(const SpscQueue& other) = delete;
+  SpscQueue& operator=(const SpscQueue& other) = delete;
+  SpscQueue(SpscQueue&& other) = delete;
+  SpscQueue& operator=(SpscQueue&& other) = delete;
+
+  bool TrySend(const T& data);
+  bool Send(const T& data, int timeout_ms = ETCPAL_WAIT_FOREVER);
+
+  bool TryReceive(T& data);
+  bool Receive(T& data, int timeout_ms = ETCPAL_WAIT_FOREVER);
+  template <class Rep, class Period>
+  bool Receive(T& data, const std::chrono::duration<Rep, Period>& timeout);
+
+  bool   IsEmpty() const;
+  size_t SlotsUsed() const;
+  size_t Capacity() const;
+
+private:
+  EtcPalSpscQueue queue_{};
+};
+
+/// @brief Create a new queue.
+///
+/// @param size The minimum number of items the queue must hold; rounded up to a power of two.
+/// @param blocking Whether Send() and Receive() can wait for room or items.
+template <class T>
+inline SpscQueue<T>::SpscQueue(size_t size, bool blocking)
+{
+  etcpal_spsc_queue_create(&queue_, size, sizeof(T), blocking);
+}
+
+/// @brief Destroy a queue.
+template <class T>
+inline SpscQueue<T>::~SpscQueue()
+{
+  etcpal_spsc_queue_destroy(&queue_);
+}
+
+/// @brief Add an item to the queue if there is room for it. Call only from the producer thread.
+/// @param data A reference to the data.
+/// @return Whether the item was added.
+template <class T>
+inline bool SpscQueue<T>::TrySend(const T& data)
+{
+  return etcpal_spsc_queue_try_send(&queue_, &data);
+}
+
+/// @brief Add an item to the queue, waiting for room if it is full. Call only from the producer
+///        thread.
+/// @param data A reference to the data.
+/// @param timeout_ms How long to wait for room in the queue.
+/// @return Whether the item was added.
+template <class T>
+inline bool SpscQueue<T>::Send(const T& data, int timeout_ms)
+{
+  return etcpal_spsc_queue_timed_send(&queue_, &data, timeout_ms);
+}
+
+/// @brief Get an item from the queue if there is one. Call only from the consumer thread.
+/// @param data A reference to the data that will receive the item from the queue.
+/// @return Whether an item was received.
+template <class T>
+inline bool SpscQueue<T>::TryReceive(T& data)
+{
+  return etcpal_spsc_queue_try_receive(&queue_, &data);
+}
+
+/// @brief Get an item from the queue, waiting for one if it is empty. Call only from the consumer
+///        thread.
+/// @param data A reference to the data that will receive the item from the queue.
+/// @param timeout_ms Amount of time to wait for data.
+/// @return Whether an item was received.
+template <class T>
+inline bool SpscQueue<T>::Receive(T& data, int timeout_ms)
+{
+  return etcpal_spsc_queue_timed_receive(&queue_, &data, timeout_ms);
+}
+
+/// @brief Get an item from the queue, waiting for one if it is empty. Call only from the consumer
+///        thread.
+///
+/// @param data A reference to the data that will receive the item from the queue.
+/// @param timeout Amount of time to wait for data.
+///
+/// @return Whether an item was received.
+template <class T>
+template <class Rep, class Period>
+inline bool SpscQueue<T>::Receive(T& data, const std::chrono::duration<Rep, Period>& timeout)
+{
+  int timeout_ms_clamped =
+      static_cast<int>(std::min(std::chrono::milliseconds(timeout).count(),
+                                static_cast<std::chrono::milliseconds::rep>(std::numeric_limits<int>::max())));
+  return etcpal_spsc_queue_timed_receive(&queue_, &data, timeout_ms_clamped);
+}
+
+/// @brief Check if the queue is empty.
+///
+/// @return true if queue is empty, false otherwise.
+template <class T>
+inline bool SpscQueue<T>::IsEmpty() const
+{
+  return etcpal_spsc_queue_is_empty(&queue_);
+}
+
+/// @brief Get the number of items in the queue.
+///
+/// @return number of items in queue.
+template <class T>
+inline size_t SpscQueue<T>::SlotsUsed() const
+{
+  return etcpal_spsc_queue_slots_used(&queue_);
+}
+
+/// @brief Get the number of items the queue can hold.
+///
+/// @return The size the queue was created with, rounded up to a power of two.
+template <class T>
+inline size_t SpscQueue<T>::Capacity() const
+{
+  return etcpal_spsc_queue_capacity(&queue_);
+}
+
+};  // namespace etcpal
+
+#endif  // ETCPAL_CPP_SPSC_QUEUE_H
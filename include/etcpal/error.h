@@ -114,10 +114,12 @@ typedef enum
   kEtcPalErrPerm = -29,
   /** A system call or C library call failed in a way not covered by other errors. */
   kEtcPalErrSys = -30,
+  /** A wait was interrupted by a call to a wake function (e.g. etcpal_poll_context_wake()). */
+  kEtcPalErrWoken = -31,
 } etcpal_error_t;
 
 /** The total number of error codes currently defined. */
-#define ETCPAL_NUM_ERROR_CODES 31
+#define ETCPAL_NUM_ERROR_CODES 32
 
 const char* etcpal_strerror(etcpal_error_t code);
 
@@ -0,0 +1,174 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+/* etcpal/io_ring.h: Completion-based socket I/O using Linux io_uring. */
+
+#ifndef ETCPAL_IO_RING_H_
+#define ETCPAL_IO_RING_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "etcpal/common.h"
+#include "etcpal/error.h"
+#include "etcpal/socket.h"
+
+/**
+ * @defgroup etcpal_io_ring io_ring (Completion-Based Socket I/O)
+ * @ingroup etcpal_net
+ * @brief Completion-based socket I/O using Linux io_uring.
+ *
+ * ```c
+ * #include "etcpal/io_ring.h"
+ * ```
+ *
+ * **NOTE:** This module is only available on Linux, when EtcPal is built with the CMake option
+ * `ETCPAL_LINUX_USE_IO_URING` enabled (which also defines the `ETCPAL_LINUX_USE_IO_URING`
+ * preprocessor symbol for consumers of the library). It requires Linux 5.6 or later.
+ *
+ * Where the etcpal_poll API reports that a socket is ready and leaves the application to make a
+ * system call for each receive or send, an io ring accepts receive and send requests up front and
+ * reports when they have completed. Many requests can be queued and their results collected with a
+ * single system call, or with none at all when submission queue polling is enabled (see
+ * EtcPalIoRingConfig::sq_poll_idle_ms) and completions are already available.
+ *
+ * Each ring can optionally own a set of buffers which are registered with the kernel up front.
+ * Operations on these buffers (etcpal_io_ring_recv_fixed() and etcpal_io_ring_send_fixed()) avoid
+ * mapping the buffer memory on every operation.
+ *
+ * @code
+ * EtcPalIoRingConfig config = ETCPAL_IO_RING_CONFIG_DEFAULT_INIT;
+ * config.num_buffers = 64;
+ * config.buffer_size = 1500;
+ *
+ * EtcPalIoRing* ring;
+ * etcpal_io_ring_create(&config, &ring);
+ *
+ * // Start a receive on each client socket
+ * for (size_t i = 0; i < num_clients; ++i)
+ *   etcpal_io_ring_recv_fixed(ring, clients[i].socket, i, 1500, &clients[i]);
+ *
+ * EtcPalIoCompletion completions[16];
+ * int num_completions = etcpal_io_ring_wait(ring, completions, 16, ETCPAL_WAIT_FOREVER);
+ * for (int i = 0; i < num_completions; ++i)
+ * {
+ *   if (completions[i].result > 0)
+ *   {
+ *     void* data = etcpal_io_ring_buffer(ring, completions[i].buffer_index);
+ *     // Handle completions[i].result bytes of data, then start the next receive...
+ *   }
+ * }
+ *
+ * etcpal_io_ring_destroy(ring);
+ * @endcode
+ *
+ * An io ring is not thread-safe; each ring should only be used from one thread at a time.
+ *
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** An opaque io ring instance. */
+typedef struct EtcPalIoRing EtcPalIoRing;
+
+/** Configuration for an io ring. */
+typedef struct EtcPalIoRingConfig
+{
+  /** The maximum number of operations which can be outstanding on the ring at once. Rounded up to
+   *  a power of two by the kernel. */
+  unsigned int queue_depth;
+  /** The number of buffers to allocate and register with the kernel, or 0 for none. */
+  size_t num_buffers;
+  /** The size in bytes of each registered buffer. */
+  size_t buffer_size;
+  /** If nonzero, the kernel polls the submission queue from a dedicated thread, so that submitting
+   *  operations does not require a system call. The thread sleeps after this many milliseconds
+   *  without work. Typically requires elevated privileges on kernels before 5.11. */
+  unsigned int sq_poll_idle_ms;
+} EtcPalIoRingConfig;
+
+/** A default-value initializer for an EtcPalIoRingConfig struct. */
+#define ETCPAL_IO_RING_CONFIG_DEFAULT_INIT \
+  {                                        \
+    64, 0, 0, 0                            \
+  }
+
+/**
+ * @name Io ring operations
+ * Reported in EtcPalIoCompletion::op.
+ * @{
+ */
+#define ETCPAL_IO_OP_RECV 0 /**< A receive started with etcpal_io_ring_recv() or etcpal_io_ring_recv_fixed(). */
+#define ETCPAL_IO_OP_SEND 1 /**< A send started with etcpal_io_ring_send() or etcpal_io_ring_send_fixed(). */
+/**
+ * @}
+ */
+
+/** A completed io ring operation. */
+typedef struct EtcPalIoCompletion
+{
+  /** The socket on which the operation was performed. */
+  etcpal_socket_t socket;
+  /** The operation which completed (ETCPAL_IO_OP_*). */
+  int op;
+  /** The number of bytes transferred (success), 0 (for receives: the peer closed the connection)
+   *  or an #etcpal_error_t code cast to int (error occurred). */
+  int result;
+  /** The registered buffer used by the operation, or -1 if it did not use one. */
+  int buffer_index;
+  /** The user data passed when the operation was started. */
+  void* user_data;
+} EtcPalIoCompletion;
+
+etcpal_error_t etcpal_io_ring_create(const EtcPalIoRingConfig* config, EtcPalIoRing** ring);
+void           etcpal_io_ring_destroy(EtcPalIoRing* ring);
+
+void* etcpal_io_ring_buffer(EtcPalIoRing* ring, int buffer_index);
+
+etcpal_error_t etcpal_io_ring_recv(EtcPalIoRing* ring, etcpal_socket_t socket, void* buf, size_t len, void* user_data);
+etcpal_error_t etcpal_io_ring_send(EtcPalIoRing*   ring,
+                                   etcpal_socket_t socket,
+                                   const void*     buf,
+                                   size_t          len,
+                                   void*           user_data);
+etcpal_error_t etcpal_io_ring_recv_fixed(EtcPalIoRing*   ring,
+                                         etcpal_socket_t socket,
+                                         int             buffer_index,
+                                         size_t          len,
+                                         void*           user_data);
+etcpal_error_t etcpal_io_ring_send_fixed(EtcPalIoRing*   ring,
+                                         etcpal_socket_t socket,
+                                         int             buffer_index,
+                                         size_t          len,
+                                         void*           user_data);
+
+int etcpal_io_ring_submit(EtcPalIoRing* ring);
+int etcpal_io_ring_wait(EtcPalIoRing* ring, EtcPalIoCompletion* completions, size_t max_completions, int timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* ETCPAL_IO_RING_H_ */
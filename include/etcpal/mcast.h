@@ -0,0 +1,151 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+/* etcpal/mcast.h: Reference-counted management of multicast group memberships. */
+
+#ifndef ETCPAL_MCAST_H_
+#define ETCPAL_MCAST_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "etcpal/error.h"
+#include "etcpal/inet.h"
+#include "etcpal/socket.h"
+
+/**
+ * @defgroup etcpal_mcast mcast (Multicast Membership Manager)
+ * @ingroup etcpal_net
+ * @brief Track multicast group memberships across sockets with reference counting.
+ *
+ * ```c
+ * #include "etcpal/mcast.h"
+ * ```
+ *
+ * Each join of a multicast group with #ETCPAL_MCAST_JOIN_GROUP adds state in the network stack,
+ * and operating systems limit how many memberships a socket can hold. Applications which subscribe
+ * to many streams often end up joining the same group on the same socket and interface more than
+ * once, and leaving and rejoining groups as subscriptions come and go.
+ *
+ * A multicast manager sits between the application and #ETCPAL_MCAST_JOIN_GROUP. It tracks each
+ * membership by socket, group and network interface index, with a reference count:
+ *
+ * - Only the first join of a membership is passed to the network stack; later joins of the same
+ *   membership just add a reference.
+ * - When the last reference to a membership is released, the leave is queued rather than passed to
+ *   the network stack immediately. Queued leaves are issued together by
+ *   etcpal_mcast_flush_leaves(), or automatically when one more than
+ *   EtcPalMcastManagerConfig::max_pending_leaves would be queued. A membership which is joined again
+ *   before its leave is issued is kept, without any network stack calls.
+ * - If the network stack refuses a new membership because it is out of resources, the queued
+ *   leaves are issued and the join is tried again.
+ *
+ * @code
+ * EtcPalMcastManagerConfig config = ETCPAL_MCAST_MANAGER_CONFIG_DEFAULT_INIT;
+ * EtcPalMcastManager*      manager;
+ * etcpal_mcast_manager_create(&config, &manager);
+ *
+ * // Subscribe to a universe: join its group on every network interface.
+ * EtcPalIpAddr group;
+ * ETCPAL_IP_SET_V4_ADDRESS(&group, 0xefff0001);  // 239.255.0.1
+ * etcpal_mcast_join_all_netints(manager, sock, &group, NULL);
+ *
+ * // Unsubscribe. The leaves are issued on the next flush.
+ * etcpal_mcast_leave_all_netints(manager, sock, &group);
+ * etcpal_mcast_flush_leaves(manager);
+ *
+ * // Forget the socket's memberships before closing it.
+ * etcpal_mcast_remove_socket(manager, sock);
+ * etcpal_close(sock);
+ * etcpal_mcast_manager_destroy(manager);
+ * @endcode
+ *
+ * All functions which take a manager are thread-safe. Sockets whose memberships are managed should
+ * not also be joined to groups directly with #ETCPAL_MCAST_JOIN_GROUP.
+ *
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** An opaque multicast manager instance. */
+typedef struct EtcPalMcastManager EtcPalMcastManager;
+
+/** Configuration for a multicast manager. */
+typedef struct EtcPalMcastManagerConfig
+{
+  /** How many leaves can be held in the queue. Queuing one more issues all of them. 0 means that
+   *  leaves are issued as soon as the last reference to a membership is released. */
+  size_t max_pending_leaves;
+} EtcPalMcastManagerConfig;
+
+/** A default-value initializer for an EtcPalMcastManagerConfig struct. */
+#define ETCPAL_MCAST_MANAGER_CONFIG_DEFAULT_INIT \
+  {                                              \
+    64                                           \
+  }
+
+/** Statistics about the memberships tracked by a multicast manager. */
+typedef struct EtcPalMcastStats
+{
+  /** Memberships currently held in the network stack, including those with a leave queued. */
+  size_t num_memberships;
+  /** Joins which have not yet been matched by a leave, across all memberships. */
+  size_t num_references;
+  /** Memberships with no references whose leave has not yet been issued. */
+  size_t num_pending_leaves;
+  /** Joins passed to the network stack. */
+  uint64_t kernel_joins;
+  /** Leaves passed to the network stack. */
+  uint64_t kernel_leaves;
+  /** Joins satisfied by a membership that was already held. */
+  uint64_t deduplicated_joins;
+  /** Queued leaves which were cancelled by a join of the same membership. */
+  uint64_t cancelled_leaves;
+  /** Joins and leaves which failed in the network stack. */
+  uint64_t failed_operations;
+} EtcPalMcastStats;
+
+etcpal_error_t etcpal_mcast_manager_create(const EtcPalMcastManagerConfig* config, EtcPalMcastManager** manager);
+void           etcpal_mcast_manager_destroy(EtcPalMcastManager* manager);
+
+etcpal_error_t etcpal_mcast_join(EtcPalMcastManager* manager, etcpal_socket_t socket, const EtcPalGroupReq* req);
+etcpal_error_t etcpal_mcast_leave(EtcPalMcastManager* manager, etcpal_socket_t socket, const EtcPalGroupReq* req);
+etcpal_error_t etcpal_mcast_join_all_netints(EtcPalMcastManager* manager,
+                                             etcpal_socket_t     socket,
+                                             const EtcPalIpAddr* group,
+                                             size_t*             num_joined);
+etcpal_error_t etcpal_mcast_leave_all_netints(EtcPalMcastManager* manager,
+                                              etcpal_socket_t     socket,
+                                              const EtcPalIpAddr* group);
+
+etcpal_error_t etcpal_mcast_flush_leaves(EtcPalMcastManager* manager);
+void           etcpal_mcast_remove_socket(EtcPalMcastManager* manager, etcpal_socket_t socket);
+etcpal_error_t etcpal_mcast_get_stats(EtcPalMcastManager* manager, EtcPalMcastStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* ETCPAL_MCAST_H_ */
@@ -0,0 +1,149 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+/* etcpal/mpmc_queue.h: A bounded lock-free multi-producer, multi-consumer queue. */
+
+#ifndef ETCPAL_MPMC_QUEUE_H_
+#define ETCPAL_MPMC_QUEUE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "etcpal/common.h"
+#include "etcpal/signal.h"
+
+/**
+ * @defgroup etcpal_mpmc_queue mpmc_queue (Multi-Producer, Multi-Consumer Queues)
+ * @ingroup etcpal_os
+ * @brief A bounded lock-free queue which any number of threads can send to and receive from.
+ *
+ * ```c
+ * #include "etcpal/mpmc_queue.h"
+ * ```
+ *
+ * An MPMC queue is a fixed-size ring of slots, each of which carries a sequence number alongside
+ * its item. A sender claims the next slot by advancing the queue's send position with a single
+ * compare-and-swap, copies its item in, and then publishes it by updating the slot's sequence
+ * number; receivers do the same with their own position. Senders only contend with other senders
+ * for a moment, and never with receivers, so many network threads can feed one processing stage
+ * without serializing on a lock as they do with the @ref etcpal_queue module.
+ *
+ * @code
+ * EtcPalMpmcQueue queue;
+ * etcpal_mpmc_queue_create(&queue, 1024, sizeof(Packet), true);
+ *
+ * // On any number of network threads...
+ * Packet packet;
+ * if (!etcpal_mpmc_queue_timed_send(&queue, &packet, 10))
+ * {
+ *   // The processing stage has fallen behind; drop the packet.
+ * }
+ *
+ * // On the processing thread(s)...
+ * while (etcpal_mpmc_queue_receive(&queue, &packet))
+ * {
+ *   // Process the packet.
+ * }
+ * @endcode
+ *
+ * The capacity of a queue is rounded up to the next power of two, and is at least 2.
+ *
+ * A queue created with blocking support can also be waited on with the blocking and timed
+ * functions. Threads wait on a @ref etcpal_signal "signal" only when the queue is empty (or full,
+ * for sends): the other side checks whether any threads are waiting after each operation, and only
+ * posts the signal if so. A queue created without blocking support skips this check, and its
+ * blocking functions return immediately like the try functions.
+ *
+ * For a queue with exactly one producer and one consumer, the @ref etcpal_spsc_queue module is
+ * cheaper.
+ *
+ * The timeouts of etcpal_mpmc_queue_timed_send() and etcpal_mpmc_queue_timed_receive() depend on
+ * the platform's support for timed signal waits, which is indicated by
+ * #ETCPAL_MPMC_QUEUE_HAS_TIMED_FUNCTIONS. Where timed waits are not available, a timeout of 0
+ * returns immediately and any other timeout waits indefinitely.
+ *
+ * @{
+ */
+
+/** Whether the timeouts given to the timed MPMC queue functions are honored on this platform. */
+#define ETCPAL_MPMC_QUEUE_HAS_TIMED_FUNCTIONS ETCPAL_SIGNAL_HAS_TIMED_WAIT
+
+/**
+ * @brief A bounded multi-producer, multi-consumer queue.
+ *
+ * The members of this struct are private; use the etcpal_mpmc_queue functions to access the queue.
+ */
+typedef struct EtcPalMpmcQueue
+{
+  /** @cond Private */
+  // Set on creation, read-only afterwards (apart from the signals, which are only used when a
+  // thread waits).
+  uint8_t*        slots;
+  size_t          slot_size;
+  size_t          capacity;
+  size_t          mask;
+  size_t          element_size;
+  bool            blocking;
+  etcpal_signal_t data_available;
+  etcpal_signal_t space_available;
+  uint8_t         pad0[ETCPAL_CACHE_LINE_SIZE];
+
+  // Claimed by senders.
+  size_t  send_pos;
+  uint8_t pad1[ETCPAL_CACHE_LINE_SIZE - sizeof(size_t)];
+
+  // Claimed by receivers.
+  size_t  receive_pos;
+  uint8_t pad2[ETCPAL_CACHE_LINE_SIZE - sizeof(size_t)];
+
+  // The number of threads waiting on each signal.
+  int     senders_waiting;
+  int     receivers_waiting;
+  uint8_t pad3[ETCPAL_CACHE_LINE_SIZE - 2 * sizeof(int)];
+  /** @endcond */
+} EtcPalMpmcQueue;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bool etcpal_mpmc_queue_create(EtcPalMpmcQueue* queue, size_t size, size_t element_size, bool blocking);
+void etcpal_mpmc_queue_destroy(EtcPalMpmcQueue* queue);
+
+bool etcpal_mpmc_queue_try_send(EtcPalMpmcQueue* queue, const void* data);
+bool etcpal_mpmc_queue_send(EtcPalMpmcQueue* queue, const void* data);
+bool etcpal_mpmc_queue_timed_send(EtcPalMpmcQueue* queue, const void* data, int timeout_ms);
+
+bool etcpal_mpmc_queue_try_receive(EtcPalMpmcQueue* queue, void* data);
+bool etcpal_mpmc_queue_receive(EtcPalMpmcQueue* queue, void* data);
+bool etcpal_mpmc_queue_timed_receive(EtcPalMpmcQueue* queue, void* data, int timeout_ms);
+
+size_t etcpal_mpmc_queue_capacity(const EtcPalMpmcQueue* queue);
+size_t etcpal_mpmc_queue_slots_used(const EtcPalMpmcQueue* queue);
+bool   etcpal_mpmc_queue_is_empty(const EtcPalMpmcQueue* queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* ETCPAL_MPMC_QUEUE_H_ */
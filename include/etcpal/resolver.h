@@ -0,0 +1,178 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+/* etcpal/resolver.h: A caching, asynchronous hostname resolver. */
+
+#ifndef ETCPAL_RESOLVER_H_
+#define ETCPAL_RESOLVER_H_
+
+#include <stddef.h>
+#include "etcpal/error.h"
+#include "etcpal/inet.h"
+#include "etcpal/thread.h"
+
+/**
+ * @defgroup etcpal_resolver resolver (Hostname Resolver)
+ * @ingroup etcpal_net
+ * @brief Resolve hostnames without blocking, and cache the results.
+ *
+ * ```c
+ * #include "etcpal/resolver.h"
+ * ```
+ *
+ * etcpal_getaddrinfo() blocks the calling thread for as long as the system resolver takes, which
+ * can be seconds when a name server is slow or unreachable, and every call goes back to the
+ * system resolver. A resolver adds two things on top of it:
+ *
+ * - A cache of results, keyed by hostname and address family. Successful results are kept for
+ *   EtcPalResolverConfig::ttl_ms and failures for EtcPalResolverConfig::negative_ttl_ms.
+ * - A worker thread which performs lookups requested with etcpal_resolver_lookup_async() and
+ *   passes the results to a callback, so that lookups never block the requesting thread.
+ *
+ * A typical I/O thread checks the cache first and falls back to an asynchronous lookup:
+ *
+ * @code
+ * void lookup_done(const char* hostname, etcpal_error_t result, const EtcPalResolvedAddrs* addrs, void* context)
+ * {
+ *   // Called from the resolver's worker thread.
+ * }
+ *
+ * EtcPalResolvedAddrs addrs;
+ * if (etcpal_resolver_lookup_cached(resolver, "broker.local", ETCPAL_AF_UNSPEC, &addrs) == kEtcPalErrOk)
+ * {
+ *   // Use addrs.addrs[0] right away.
+ * }
+ * else
+ * {
+ *   etcpal_resolver_lookup_async(resolver, "broker.local", ETCPAL_AF_UNSPEC, lookup_done, my_context);
+ * }
+ * @endcode
+ *
+ * Queued asynchronous lookups of a hostname which is already in the cache by the time the worker
+ * thread gets to them are answered from the cache, so a burst of requests for the same name
+ * results in one system lookup.
+ *
+ * By default, lookups are done with etcpal_getaddrinfo(). A different lookup function can be
+ * provided in EtcPalResolverConfig::lookup_fn, e.g. to resolve names from a local table.
+ *
+ * All functions are thread-safe.
+ *
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** The maximum number of addresses kept for one hostname. */
+#define ETCPAL_RESOLVER_MAX_ADDRS 8
+
+/** The maximum length of a hostname which can be resolved, including the null terminator. */
+#define ETCPAL_RESOLVER_MAX_HOSTNAME_LEN 256
+
+/** An opaque resolver instance. */
+typedef struct EtcPalResolver EtcPalResolver;
+
+/** The addresses a hostname resolved to. */
+typedef struct EtcPalResolvedAddrs
+{
+  /** The number of valid entries in addrs. */
+  size_t num_addrs;
+  /** The addresses, in the order returned by the lookup function. */
+  EtcPalIpAddr addrs[ETCPAL_RESOLVER_MAX_ADDRS];
+} EtcPalResolvedAddrs;
+
+/**
+ * @brief A function which resolves a hostname.
+ * @param hostname The hostname to resolve.
+ * @param family The address family to resolve for (ETCPAL_AF_xxx).
+ * @param[out] addrs Filled in with the addresses on success.
+ * @param context The EtcPalResolverConfig::lookup_context pointer.
+ * @return #kEtcPalErrOk if at least one address was found, otherwise the reason for the failure.
+ */
+typedef etcpal_error_t (*EtcPalResolverLookupFunc)(const char*          hostname,
+                                                   int                  family,
+                                                   EtcPalResolvedAddrs* addrs,
+                                                   void*                context);
+
+/**
+ * @brief A function which handles the result of an asynchronous lookup.
+ * @param hostname The hostname passed to etcpal_resolver_lookup_async().
+ * @param result #kEtcPalErrOk if the hostname was resolved, otherwise the reason for the failure.
+ * @param addrs The addresses on success. Only valid for the duration of the callback.
+ * @param context The context pointer passed to etcpal_resolver_lookup_async().
+ */
+typedef void (*EtcPalResolverCallback)(const char*                hostname,
+                                       etcpal_error_t             result,
+                                       const EtcPalResolvedAddrs* addrs,
+                                       void*                      context);
+
+/** Configuration for a resolver. */
+typedef struct EtcPalResolverConfig
+{
+  /** How long a successful result is cached, in milliseconds. 0 disables caching of results. */
+  unsigned int ttl_ms;
+  /** How long a failed result is cached, in milliseconds. 0 disables caching of failures. */
+  unsigned int negative_ttl_ms;
+  /** The maximum number of hostnames in the cache. When it is full, the entry closest to expiry is
+   *  replaced. */
+  size_t max_entries;
+  /** The function used to resolve hostnames, or NULL to use etcpal_getaddrinfo(). */
+  EtcPalResolverLookupFunc lookup_fn;
+  /** Passed back to lookup_fn. */
+  void* lookup_context;
+  /** The priority of the worker thread (see EtcPalThreadParams::priority). */
+  unsigned int thread_priority;
+  /** The stack size of the worker thread (see EtcPalThreadParams::stack_size). */
+  unsigned int thread_stack_size;
+} EtcPalResolverConfig;
+
+/** A default-value initializer for an EtcPalResolverConfig struct. */
+#define ETCPAL_RESOLVER_CONFIG_DEFAULT_INIT                                                   \
+  {                                                                                           \
+    60000, 5000, 256, NULL, NULL, ETCPAL_THREAD_DEFAULT_PRIORITY, ETCPAL_THREAD_DEFAULT_STACK \
+  }
+
+etcpal_error_t etcpal_resolver_create(const EtcPalResolverConfig* config, EtcPalResolver** resolver);
+void           etcpal_resolver_destroy(EtcPalResolver* resolver);
+
+etcpal_error_t etcpal_resolver_lookup(EtcPalResolver*      resolver,
+                                      const char*          hostname,
+                                      int                  family,
+                                      EtcPalResolvedAddrs* addrs);
+etcpal_error_t etcpal_resolver_lookup_cached(EtcPalResolver*      resolver,
+                                             const char*          hostname,
+                                             int                  family,
+                                             EtcPalResolvedAddrs* addrs);
+etcpal_error_t etcpal_resolver_lookup_async(EtcPalResolver*        resolver,
+                                            const char*            hostname,
+                                            int                    family,
+                                            EtcPalResolverCallback callback,
+                                            void*                  context);
+void           etcpal_resolver_flush(EtcPalResolver* resolver);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* ETCPAL_RESOLVER_H_ */
@@ -69,7 +69,41 @@ typedef uint32_t etcpal_poll_events_t;
  * @}
  */
 
-/* Note: no flags are currently implemented for etcpal_sendto() */
+/**
+ * @name Flags filled in by etcpal_recvmsg()
+ * @{
+ */
+#define ETCPAL_MSG_TRUNC  0x1 /**< The datagram was larger than the buffer space supplied and was truncated. */
+#define ETCPAL_MSG_CTRUNC 0x2 /**< Some control data was discarded due to lack of space in the control buffer. */
+/**
+ * @}
+ */
+
+/** The maximum number of buffer segments that can be used in a single EtcPalMsgHdr. */
+#define ETCPAL_MSG_MAX_IOV 16
+
+/** The size of control buffer needed to receive the control message enabled by #ETCPAL_IP_PKTINFO
+ *  (for either IPv4 or IPv6) on all supported platforms. */
+#define ETCPAL_CONTROL_SIZE_IP_PKTINFO 40
+
+/** The size of control buffer needed to receive the control message enabled by
+ *  #ETCPAL_SO_TIMESTAMP or #ETCPAL_SO_TIMESTAMP_HW on all supported platforms. */
+#define ETCPAL_CONTROL_SIZE_SO_TIMESTAMP 64
+
+/** The size of control buffer needed to receive the control message enabled by #ETCPAL_UDP_GRO. */
+#define ETCPAL_CONTROL_SIZE_UDP_GRO 24
+
+/**
+ * @name Flags for etcpal_send(), etcpal_sendto(), etcpal_sendmsg() and etcpal_sendmmsg()
+ * @{
+ */
+/** Send without copying the data into kernel memory, on sockets with #ETCPAL_SO_ZEROCOPY enabled.
+ *  The data must not be modified until its completion is read with
+ *  etcpal_read_zerocopy_completions(). Ignored (the data is copied) where not supported. */
+#define ETCPAL_MSG_ZEROCOPY 0x2
+/**
+ * @}
+ */
 
 /**
  * @name Level values for etcpal_setsockopt() and etcpal_getsockopt()
@@ -103,6 +137,23 @@ typedef uint32_t etcpal_poll_events_t;
 #define ETCPAL_SO_REUSEADDR 8  /**< Get/Set, value is boolean int */
 #define ETCPAL_SO_REUSEPORT 9  /**< Get/Set, value is boolean int */
 #define ETCPAL_SO_TYPE      10 /**< Get only, value is int */
+/** Set only, value is boolean int. Enables software receive timestamps on datagrams, reported
+ *  through etcpal_recvmsg() control data (see etcpal_cmsg_to_timestamp()). */
+#define ETCPAL_SO_TIMESTAMP 21
+/** Set only, value is boolean int. Like #ETCPAL_SO_TIMESTAMP, but also requests hardware receive
+ *  timestamps from network interfaces that support them. Linux only. */
+#define ETCPAL_SO_TIMESTAMP_HW 22
+/** Set only, value is int representing us. Enables busy polling of the device receive queue for up
+ *  to this long when a receive or poll on the socket would otherwise block. Linux only; raising the
+ *  value above the system default (net.core.busy_read) requires the CAP_NET_ADMIN capability. */
+#define ETCPAL_SO_BUSY_POLL 25
+/** Set only, value is boolean int. Prefers busy polling over interrupt-driven processing of the
+ *  device receive queue while #ETCPAL_SO_BUSY_POLL is in effect. Linux 5.11 and later only. */
+#define ETCPAL_SO_PREFER_BUSY_POLL 26
+/** Set only, value is boolean int. Allows #ETCPAL_MSG_ZEROCOPY sends on the socket, and enables the
+ *  completion notifications they generate (see etcpal_read_zerocopy_completions()). Linux 4.14 and
+ *  later only. */
+#define ETCPAL_SO_ZEROCOPY 27
 /**
  * @}
  */
@@ -130,6 +181,29 @@ typedef uint32_t etcpal_poll_events_t;
 #define ETCPAL_MCAST_JOIN_GROUP   17 /**< Set only, value is EtcPalGroupReq */
 #define ETCPAL_MCAST_LEAVE_GROUP  18 /**< Set only, value is EtcPalGroupReq */
 #define ETCPAL_IPV6_V6ONLY        19 /**< Get/Set, value is boolean int */
+/** Set only, value is boolean int. Enables reporting of the destination address and interface of
+ *  received datagrams through etcpal_recvmsg() control data (see etcpal_cmsg_to_pktinfo()). */
+#define ETCPAL_IP_PKTINFO         20
+
+/**
+ * @}
+ */
+
+/**
+ * @name Options for level ETCPAL_IPPROTO_UDP
+ * Used in the option parameter to etcpal_setsockopt() and etcpal_getsockopt().
+ * Refer to the similarly-named option on your favorite man page for more details.
+ * @{
+ */
+
+/** Set only, value is int representing a segment size in bytes, or 0 to disable. Datagrams sent
+ *  on the socket which are larger than the segment size are split into datagrams of that size by
+ *  the kernel or network interface. Linux only; see also etcpal_sendto_segmented(). */
+#define ETCPAL_UDP_SEGMENT 23
+/** Set only, value is boolean int. Allows the kernel to coalesce consecutive received datagrams
+ *  from the same sender into a single buffer; the segment size is reported through
+ *  etcpal_recvmsg() control data (see etcpal_cmsg_to_udp_gro()). Linux only. */
+#define ETCPAL_UDP_GRO     24
 
 /**
  * @}
@@ -165,6 +239,90 @@ typedef struct EtcPalGroupReq
   EtcPalIpAddr group;
 } EtcPalGroupReq;
 
+/** A single datagram, for use with etcpal_recvmmsg() and etcpal_sendmmsg(). */
+typedef struct EtcPalMmsgHdr
+{
+  /** Data to send, or buffer in which to place received data. */
+  void* buf;
+  /** Length in bytes of the data to send, or size in bytes of the receive buffer. */
+  size_t len;
+  /** For sends, the address to which to send the datagram (NULL for connected sockets). For
+   *  receives, filled in with the address from which the datagram was received (may be NULL). */
+  EtcPalSockAddr* addr;
+  /** Filled in with the number of bytes sent or received. */
+  size_t msg_len;
+} EtcPalMmsgHdr;
+
+/** A buffer segment, for use with etcpal_sendmsg() and etcpal_recvmsg(). */
+typedef struct EtcPalIovec
+{
+  void*  base; /**< Start of the buffer segment. */
+  size_t len;  /**< Length in bytes of the buffer segment. */
+} EtcPalIovec;
+
+/** A message made up of one or more buffer segments, for use with etcpal_sendmsg() and
+ *  etcpal_recvmsg(). */
+typedef struct EtcPalMsgHdr
+{
+  /** For sends, the address to which to send the message (NULL for connected sockets). For
+   *  receives, filled in with the address from which the message was received (may be NULL). */
+  EtcPalSockAddr* name;
+  /** Array of buffer segments containing the data to send, or in which to place received data. */
+  EtcPalIovec* iov;
+  /** Number of elements in the iov array. Must not be greater than #ETCPAL_MSG_MAX_IOV. */
+  size_t iovlen;
+  /** Buffer in which etcpal_recvmsg() places control messages (may be NULL). Not used for sends.
+   *  Must be aligned like the platform's control message header; see etcpal_cmsg_firsthdr(). */
+  void* control;
+  /** Size in bytes of the control buffer. Filled in by etcpal_recvmsg() with the number of bytes of
+   *  control data received. */
+  size_t controllen;
+  /** Filled in by etcpal_recvmsg() with flags (ETCPAL_MSG_*) describing the received message. */
+  int flags;
+} EtcPalMsgHdr;
+
+/** A control message received with etcpal_recvmsg(). See etcpal_cmsg_firsthdr(). */
+typedef struct EtcPalCMsgHdr
+{
+  size_t len;   /**< Length in bytes of the control message data. */
+  int    level; /**< Protocol level which generated the message (ETCPAL_SOL_SOCKET, etc.), or -1. */
+  int    type;  /**< Option which generated the message (e.g. #ETCPAL_IP_PKTINFO), or -1. */
+  void*  pd;    /**< Platform-specific data. */
+} EtcPalCMsgHdr;
+
+/** Destination address and interface of a received datagram. See etcpal_cmsg_to_pktinfo(). */
+typedef struct EtcPalPktInfo
+{
+  /** The destination address of the datagram (e.g. the multicast group it was sent to). */
+  EtcPalIpAddr addr;
+  /** Index of the network interface on which the datagram was received (see
+   *  @ref interface_indexes). */
+  unsigned int ifindex;
+} EtcPalPktInfo;
+
+/** The time at which a datagram was received. See etcpal_cmsg_to_timestamp(). */
+typedef struct EtcPalRecvTimestamp
+{
+  int64_t  seconds;     /**< Seconds since the Unix epoch. */
+  uint32_t nanoseconds; /**< Nanoseconds after the second. */
+  bool     hardware;    /**< The timestamp was generated by the network interface hardware. */
+} EtcPalRecvTimestamp;
+
+/**
+ * A range of completed #ETCPAL_MSG_ZEROCOPY sends. See etcpal_read_zerocopy_completions().
+ *
+ * Each zero-copy send call on a socket is numbered, starting at 0 for the first one. Once a send's
+ * completion has been read, its data buffers may be reused.
+ */
+typedef struct EtcPalZerocopyCompletion
+{
+  uint32_t first; /**< The number of the first completed send in the range. */
+  uint32_t last;  /**< The number of the last completed send in the range (inclusive). */
+  /** The network stack copied the data of at least one send in the range rather than sending it
+   *  in place. Zero-copy sends are not worthwhile for the destination if this is frequently true. */
+  bool copied;
+} EtcPalZerocopyCompletion;
+
 /**
  * @name 'how' values for etcpal_shutdown()
  * @{
@@ -217,10 +375,18 @@ etcpal_error_t etcpal_getsockopt(etcpal_socket_t id,
 etcpal_error_t etcpal_listen(etcpal_socket_t id, int backlog);
 int            etcpal_recv(etcpal_socket_t id, void* buffer, size_t length, int flags);
 int            etcpal_recvfrom(etcpal_socket_t id, void* buffer, size_t length, int flags, EtcPalSockAddr* address);
-/* recvmsg - not implemented */
-int etcpal_send(etcpal_socket_t id, const void* message, size_t length, int flags);
-/* sendmsg - not implemented */
+int            etcpal_recvmmsg(etcpal_socket_t id, EtcPalMmsgHdr* msgs, size_t num_msgs, int flags);
+int            etcpal_recvmsg(etcpal_socket_t id, EtcPalMsgHdr* msg, int flags);
+int            etcpal_send(etcpal_socket_t id, const void* message, size_t length, int flags);
+int            etcpal_sendmmsg(etcpal_socket_t id, EtcPalMmsgHdr* msgs, size_t num_msgs, int flags);
+int            etcpal_sendmsg(etcpal_socket_t id, const EtcPalMsgHdr* msg, int flags);
 int etcpal_sendto(etcpal_socket_t id, const void* message, size_t length, int flags, const EtcPalSockAddr* dest_addr);
+int etcpal_sendto_segmented(etcpal_socket_t       id,
+                            const void*           message,
+                            size_t                length,
+                            size_t                segment_size,
+                            int                   flags,
+                            const EtcPalSockAddr* dest_addr);
 etcpal_error_t etcpal_setsockopt(etcpal_socket_t id,
                                  int             level,
                                  int             option_name,
@@ -230,6 +396,20 @@ etcpal_error_t etcpal_shutdown(etcpal_socket_t id, int how);
 etcpal_error_t etcpal_socket(unsigned int family, unsigned int type, etcpal_socket_t* id);
 /* socketpair - not implemented */
 
+/************************* Control message helpers ***************************/
+
+bool etcpal_cmsg_firsthdr(EtcPalMsgHdr* msgh, EtcPalCMsgHdr* firsthdr);
+bool etcpal_cmsg_nxthdr(EtcPalMsgHdr* msgh, const EtcPalCMsgHdr* cmsg, EtcPalCMsgHdr* nxthdr);
+bool etcpal_cmsg_to_pktinfo(const EtcPalCMsgHdr* cmsg, EtcPalPktInfo* pktinfo);
+bool etcpal_cmsg_to_timestamp(const EtcPalCMsgHdr* cmsg, EtcPalRecvTimestamp* timestamp);
+bool etcpal_cmsg_to_udp_gro(const EtcPalCMsgHdr* cmsg, size_t* segment_size);
+
+/*********************** Zero-copy send completions **************************/
+
+int etcpal_read_zerocopy_completions(etcpal_socket_t           id,
+                                     EtcPalZerocopyCompletion* completions,
+                                     size_t                    max_completions);
+
 /**************************** Mimic fcntl() API ******************************/
 
 etcpal_error_t etcpal_setblocking(etcpal_socket_t id, bool blocking);
@@ -246,12 +426,24 @@ etcpal_error_t etcpal_getblocking(etcpal_socket_t id, bool* blocking);
 #define ETCPAL_POLL_CONNECT 0x4u /**< Notify when a non-blocking connect operation has completed. */
 #define ETCPAL_POLL_OOB 0x8u /**< Notify when there is out-of-band data on a TCP socket. */
 #define ETCPAL_POLL_ERR 0x10u /**< An error has occurred on the socket (output only). */
+/** Report events only when they newly occur, rather than for as long as the condition persists
+ *  (input only, edge-triggered mode). */
+#define ETCPAL_POLL_EDGE 0x20u
+/** Stop reporting events on the socket after one has been reported, until it is re-armed with
+ *  etcpal_poll_modify_socket() (input only). */
+#define ETCPAL_POLL_ONESHOT 0x40u
+/** Notify when #ETCPAL_MSG_ZEROCOPY send completions are available to be read with
+ *  etcpal_read_zerocopy_completions(). Linux only. */
+#define ETCPAL_POLL_ZEROCOPY 0x80u
 /**
  * @}
  */
 
 /** Mask of valid events for use with etcpal_poll_add_socket(). */
-#define ETCPAL_POLL_VALID_INPUT_EVENT_MASK 0x0fu
+#define ETCPAL_POLL_VALID_INPUT_EVENT_MASK 0x8fu
+
+/** Mask of the flags which change how events are reported, for use with etcpal_poll_add_socket(). */
+#define ETCPAL_POLL_MODE_MASK 0x60u
 
 /** A description of an event that occurred on a socket, for usage with etcpal_poll_wait(). */
 typedef struct EtcPalPollEvent
@@ -264,6 +456,8 @@ typedef struct EtcPalPollEvent
 
 etcpal_error_t etcpal_poll_context_init(EtcPalPollContext* context);
 void           etcpal_poll_context_deinit(EtcPalPollContext* context);
+etcpal_error_t etcpal_poll_context_wake(EtcPalPollContext* context);
+etcpal_error_t etcpal_poll_context_set_spin_time(EtcPalPollContext* context, unsigned int spin_us);
 etcpal_error_t etcpal_poll_add_socket(EtcPalPollContext*   context,
                                       etcpal_socket_t      socket,
                                       etcpal_poll_events_t events,
@@ -274,6 +468,10 @@ etcpal_error_t etcpal_poll_modify_socket(EtcPalPollContext*   context,
                                          void*                new_user_data);
 void           etcpal_poll_remove_socket(EtcPalPollContext* context, etcpal_socket_t socket);
 etcpal_error_t etcpal_poll_wait(EtcPalPollContext* context, EtcPalPollEvent* event, int timeout_ms);
+int            etcpal_poll_wait_many(EtcPalPollContext* context,
+                                     EtcPalPollEvent*   events,
+                                     size_t             max_events,
+                                     int                timeout_ms);
 
 /************************ Mimic getaddrinfo() API ****************************/
 
@@ -0,0 +1,145 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+/* etcpal/socket_stats.h: Counters of the traffic passing through the socket API. */
+
+#ifndef ETCPAL_SOCKET_STATS_H_
+#define ETCPAL_SOCKET_STATS_H_
+
+#include <stdint.h>
+#include "etcpal/error.h"
+#include "etcpal/socket.h"
+
+/**
+ * @defgroup etcpal_socket_stats socket_stats (Socket Statistics)
+ * @ingroup etcpal_net
+ * @brief Count the messages, bytes and errors passing through the socket API.
+ *
+ * ```c
+ * #include "etcpal/socket_stats.h"
+ * ```
+ *
+ * When EtcPal is built with socket statistics enabled, the receive, send and poll functions of
+ * the @ref etcpal_socket module update a set of counters as they go. The counters can be read at
+ * any time, e.g. from a diagnostic thread or a command handler, to find out where datagrams are
+ * being lost without attaching a debugger:
+ *
+ * - Global counters (EtcPalSocketStats) cover all sockets.
+ * - The same counters are kept separately for sockets registered with
+ *   etcpal_socket_stats_track(), up to the compile-time limit ETCPAL_SOCKET_STATS_MAX_TRACKED.
+ * - Poll statistics (EtcPalPollStats) count the waits done by etcpal_poll_wait() and
+ *   etcpal_poll_wait_many(), with a histogram of how long each wait took.
+ *
+ * @code
+ * EtcPalSocketStats stats;
+ * if (etcpal_socket_stats_snapshot(&stats) == kEtcPalErrOk)
+ * {
+ *   printf("%llu datagrams received, %llu truncated\n", (unsigned long long)stats.messages_received,
+ *          (unsigned long long)stats.recv_truncated);
+ * }
+ * @endcode
+ *
+ * Statistics are enabled by building EtcPal with the ETCPAL_SOCKET_STATS option (see
+ * @ref etcpal_opts) set to 1; the CMake option of the same name does this. Otherwise, the counting
+ * code is compiled out of the socket functions entirely, and the functions in this module return
+ * #kEtcPalErrNotImpl.
+ *
+ * Counters are updated with relaxed atomic operations, so each counter in a snapshot is exact, but
+ * a snapshot taken while other threads are doing socket I/O is not a consistent view across
+ * counters.
+ *
+ * The receive, send and poll wait functions are instrumented on the platforms below. On the
+ * others, socket statistics are not supported: the ETCPAL_SOCKET_STATS CMake option has no effect,
+ * and the functions in this module return #kEtcPalErrNotImpl.
+ *
+ * | Platform:         | Socket statistics supported: |
+ * |-------------------|------------------------------|
+ * | Linux             | Yes                          |
+ * | lwIP              | No                           |
+ * | macOS             | Yes                          |
+ * | MQX (RTCS)        | No                           |
+ * | Microsoft Windows | Yes                          |
+ *
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** The number of buckets in EtcPalPollStats::wait_time_hist. */
+#define ETCPAL_POLL_STATS_HIST_BUCKETS 24
+
+/** Counters of the messages passing through the socket receive and send functions. */
+typedef struct EtcPalSocketStats
+{
+  /** Datagrams received, or successful receive calls on stream sockets. */
+  uint64_t messages_received;
+  /** Bytes received. */
+  uint64_t bytes_received;
+  /** Receive calls which failed with #kEtcPalErrWouldBlock. */
+  uint64_t recv_would_block;
+  /** Datagrams truncated because the receive buffer was too small. Only detected by
+   *  etcpal_recvmsg() and etcpal_recvmmsg(). */
+  uint64_t recv_truncated;
+  /** Receive calls which failed with an error other than #kEtcPalErrWouldBlock. */
+  uint64_t recv_errors;
+  /** Datagrams sent, or successful send calls on stream sockets. */
+  uint64_t messages_sent;
+  /** Bytes sent. */
+  uint64_t bytes_sent;
+  /** Send calls which failed with #kEtcPalErrWouldBlock. */
+  uint64_t send_would_block;
+  /** Send calls which failed with an error other than #kEtcPalErrWouldBlock. */
+  uint64_t send_errors;
+} EtcPalSocketStats;
+
+/** Counters of the waits done by etcpal_poll_wait() and etcpal_poll_wait_many(). */
+typedef struct EtcPalPollStats
+{
+  /** Calls which waited on a poll context (invalid calls and empty contexts are not counted). */
+  uint64_t waits;
+  /** Socket events reported. */
+  uint64_t events;
+  /** Waits which timed out without any events. */
+  uint64_t timeouts;
+  /** A histogram of the time spent in each wait. Bucket 0 counts waits of less than 1 us; bucket i
+   *  counts waits of 2^(i-1) us up to (but not including) 2^i us. The last bucket also counts all
+   *  longer waits. */
+  uint64_t wait_time_hist[ETCPAL_POLL_STATS_HIST_BUCKETS];
+} EtcPalPollStats;
+
+etcpal_error_t etcpal_socket_stats_snapshot(EtcPalSocketStats* stats);
+etcpal_error_t etcpal_socket_stats_snapshot_socket(etcpal_socket_t id, EtcPalSocketStats* stats);
+etcpal_error_t etcpal_poll_stats_snapshot(EtcPalPollStats* stats);
+
+etcpal_error_t etcpal_socket_stats_track(etcpal_socket_t id);
+etcpal_error_t etcpal_socket_stats_untrack(etcpal_socket_t id);
+
+void etcpal_socket_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* ETCPAL_SOCKET_STATS_H_ */
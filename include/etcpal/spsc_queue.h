@@ -0,0 +1,148 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+/* etcpal/spsc_queue.h: A lock-free single-producer, single-consumer queue. */
+
+#ifndef ETCPAL_SPSC_QUEUE_H_
+#define ETCPAL_SPSC_QUEUE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "etcpal/common.h"
+#include "etcpal/signal.h"
+
+/**
+ * @defgroup etcpal_spsc_queue spsc_queue (Single-Producer, Single-Consumer Queues)
+ * @ingroup etcpal_os
+ * @brief A lock-free ring buffer for handing items from one thread to another.
+ *
+ * ```c
+ * #include "etcpal/spsc_queue.h"
+ * ```
+ *
+ * An SPSC queue is a fixed-size ring of items which is written by exactly one producer thread and
+ * read by exactly one consumer thread. Unlike the @ref etcpal_queue module, sending and receiving
+ * take no locks and make no system calls: each side copies the item and updates its own index with
+ * a single atomic store. The producer and consumer indices are kept on separate cache lines, so the
+ * two threads do not slow each other down by writing to the same line.
+ *
+ * @code
+ * EtcPalSpscQueue queue;
+ * etcpal_spsc_queue_create(&queue, 1024, sizeof(Packet), true);
+ *
+ * // On the receive thread...
+ * Packet packet;
+ * if (!etcpal_spsc_queue_try_send(&queue, &packet))
+ * {
+ *   // The merge thread has fallen behind; drop the packet.
+ * }
+ *
+ * // On the merge thread...
+ * while (etcpal_spsc_queue_receive(&queue, &packet))
+ * {
+ *   // Process the packet.
+ * }
+ * @endcode
+ *
+ * The capacity of a queue is rounded up to the next power of two.
+ *
+ * A queue created with blocking support can also be waited on with etcpal_spsc_queue_receive() and
+ * etcpal_spsc_queue_send(). These wait on a @ref etcpal_signal "signal" only when the queue is empty
+ * (or full, for sends): the other side checks whether anyone is waiting after each operation, and
+ * only posts the signal if so. While the queue is busy, neither side touches the kernel. A queue
+ * created without blocking support skips this check, and its blocking functions return
+ * immediately like the try functions.
+ *
+ * Using an SPSC queue from more than one producer thread or more than one consumer thread at a time
+ * corrupts it. Use the @ref etcpal_mpmc_queue module for queues with multiple producers or
+ * consumers.
+ *
+ * The timeouts of etcpal_spsc_queue_timed_send() and etcpal_spsc_queue_timed_receive() depend on
+ * the platform's support for timed signal waits, which is indicated by
+ * #ETCPAL_SPSC_QUEUE_HAS_TIMED_FUNCTIONS. Where timed waits are not available, a timeout of 0
+ * returns immediately and any other timeout waits indefinitely.
+ *
+ * @{
+ */
+
+/** Whether the timeouts given to the timed SPSC queue functions are honored on this platform. */
+#define ETCPAL_SPSC_QUEUE_HAS_TIMED_FUNCTIONS ETCPAL_SIGNAL_HAS_TIMED_WAIT
+
+/**
+ * @brief A single-producer, single-consumer queue.
+ *
+ * The members of this struct are private; use the etcpal_spsc_queue functions to access the queue.
+ */
+typedef struct EtcPalSpscQueue
+{
+  /** @cond Private */
+  // Set on creation, read-only afterwards (apart from the signals, which are only used when a
+  // thread waits).
+  uint8_t*        buf;
+  size_t          capacity;
+  size_t          mask;
+  size_t          element_size;
+  bool            blocking;
+  etcpal_signal_t data_available;
+  etcpal_signal_t space_available;
+  uint8_t         pad0[ETCPAL_CACHE_LINE_SIZE];
+
+  // Written only by the producer.
+  size_t  head;
+  size_t  cached_tail;
+  int     producer_waiting;
+  uint8_t pad1[ETCPAL_CACHE_LINE_SIZE - 2 * sizeof(size_t) - sizeof(int)];
+
+  // Written only by the consumer.
+  size_t  tail;
+  size_t  cached_head;
+  int     consumer_waiting;
+  uint8_t pad2[ETCPAL_CACHE_LINE_SIZE - 2 * sizeof(size_t) - sizeof(int)];
+  /** @endcond */
+} EtcPalSpscQueue;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bool etcpal_spsc_queue_create(EtcPalSpscQueue* queue, size_t size, size_t element_size, bool blocking);
+void etcpal_spsc_queue_destroy(EtcPalSpscQueue* queue);
+
+bool etcpal_spsc_queue_try_send(EtcPalSpscQueue* queue, const void* data);
+bool etcpal_spsc_queue_send(EtcPalSpscQueue* queue, const void* data);
+bool etcpal_spsc_queue_timed_send(EtcPalSpscQueue* queue, const void* data, int timeout_ms);
+
+bool etcpal_spsc_queue_try_receive(EtcPalSpscQueue* queue, void* data);
+bool etcpal_spsc_queue_receive(EtcPalSpscQueue* queue, void* data);
+bool etcpal_spsc_queue_timed_receive(EtcPalSpscQueue* queue, void* data, int timeout_ms);
+
+size_t etcpal_spsc_queue_capacity(const EtcPalSpscQueue* queue);
+size_t etcpal_spsc_queue_slots_used(const EtcPalSpscQueue* queue);
+bool   etcpal_spsc_queue_is_empty(const EtcPalSpscQueue* queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* ETCPAL_SPSC_QUEUE_H_ */
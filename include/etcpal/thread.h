@@ -197,6 +197,7 @@ etcpal_error_t            etcpal_thread_create(etcpal_thread_t*          id,
 etcpal_error_t            etcpal_thread_join(etcpal_thread_t* id);
 etcpal_error_t            etcpal_thread_timed_join(etcpal_thread_t* id, int timeout_ms);
 etcpal_error_t            etcpal_thread_terminate(etcpal_thread_t* id);
+etcpal_error_t            etcpal_thread_set_affinity(etcpal_thread_t* id, unsigned int cpu);
 etcpal_thread_os_handle_t etcpal_thread_get_os_handle(etcpal_thread_t* id);
 
 #if !defined(etcpal_thread_sleep) || DOXYGEN
@@ -0,0 +1,157 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+/* etcpal/udp_receiver.h: A multi-threaded UDP receiver which shards one port across sockets. */
+
+#ifndef ETCPAL_UDP_RECEIVER_H_
+#define ETCPAL_UDP_RECEIVER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "etcpal/error.h"
+#include "etcpal/inet.h"
+#include "etcpal/socket.h"
+#include "etcpal/thread.h"
+
+/**
+ * @defgroup etcpal_udp_receiver udp_receiver (Sharded UDP Receiver)
+ * @ingroup etcpal_net
+ * @brief Receive datagrams on one UDP port using multiple threads.
+ *
+ * ```c
+ * #include "etcpal/udp_receiver.h"
+ * ```
+ *
+ * A UDP receiver opens a number of sockets (shards) bound to the same address and port using
+ * #ETCPAL_SO_REUSEPORT. Each shard is serviced by its own thread with its own EtcPalPollContext,
+ * and every datagram received is passed to a callback function in the context of the thread that
+ * received it. The operating system distributes incoming datagrams between the shards, so that the
+ * receive work for a single busy port can be spread over multiple CPUs. Each thread can optionally
+ * be pinned to its own CPU.
+ *
+ * @code
+ * void handle_datagram(const uint8_t* data, size_t length, const EtcPalSockAddr* from, size_t shard,
+ *                      void* context)
+ * {
+ *   // Called concurrently from each shard's thread.
+ * }
+ *
+ * EtcPalUdpReceiverConfig config = ETCPAL_UDP_RECEIVER_CONFIG_DEFAULT_INIT;
+ * ETCPAL_IP_SET_V4_ADDRESS(&config.bind_addr.ip, 0);
+ * config.bind_addr.port = 5568;
+ * config.num_shards = 4;
+ * config.pin_threads = true;
+ * config.callback = handle_datagram;
+ *
+ * EtcPalUdpReceiver* receiver;
+ * if (etcpal_udp_receiver_create(&config, &receiver) == kEtcPalErrOk)
+ * {
+ *   // Datagrams are now being delivered to handle_datagram()...
+ *   etcpal_udp_receiver_destroy(receiver);
+ * }
+ * @endcode
+ *
+ * How datagrams are distributed depends on the operating system:
+ *
+ * - Linux: Unicast datagrams are distributed by a hash of the source and destination address and
+ *   port, so all datagrams from one sender go to the same shard. Multicast and broadcast datagrams
+ *   are delivered to every shard.
+ * - macOS: No load distribution: each unicast datagram is delivered to a single shard chosen by the
+ *   system (typically always the same one). Multicast and broadcast datagrams are delivered to
+ *   every shard.
+ * - Microsoft Windows: #ETCPAL_SO_REUSEPORT is not supported; only one shard can be created.
+ * - Others: Depends on the network stack's #ETCPAL_SO_REUSEPORT behavior.
+ *
+ * Because multicast datagrams are delivered to every shard, multicast groups should be joined
+ * through only one of the shards (see etcpal_udp_receiver_get_socket()) when the application
+ * should see each datagram once, or the receiver should be created with a single shard.
+ *
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** An opaque UDP receiver instance. */
+typedef struct EtcPalUdpReceiver EtcPalUdpReceiver;
+
+/**
+ * @brief A function which handles datagrams received by a UDP receiver.
+ * @param data The datagram's data. Only valid for the duration of the callback.
+ * @param length The length of the datagram in bytes.
+ * @param from The address from which the datagram was received.
+ * @param shard The index of the shard which received the datagram, from 0 to
+ *              EtcPalUdpReceiverConfig::num_shards - 1.
+ * @param context The EtcPalUdpReceiverConfig::context pointer.
+ */
+typedef void (*EtcPalUdpReceiverCallback)(const uint8_t*        data,
+                                          size_t                length,
+                                          const EtcPalSockAddr* from,
+                                          size_t                shard,
+                                          void*                 context);
+
+/** Configuration for a UDP receiver. */
+typedef struct EtcPalUdpReceiverConfig
+{
+  /** The address and port to which each shard's socket is bound. If the port is 0, a port is
+   *  chosen by the system; get it with etcpal_udp_receiver_get_port(). */
+  EtcPalSockAddr bind_addr;
+  /** The number of sockets and threads receiving on the port. Must be at least 1. */
+  size_t num_shards;
+  /** The largest datagram that can be received; longer datagrams are truncated. */
+  size_t max_datagram_size;
+  /** Called for each datagram received, from the thread of the shard which received it. */
+  EtcPalUdpReceiverCallback callback;
+  /** Passed back to the callback. */
+  void* context;
+  /** Whether to pin each shard's thread to its own CPU: shard N runs on CPU first_cpu + N. Ignored
+   *  on platforms which do not support thread affinity (see etcpal_thread_set_affinity()). */
+  bool pin_threads;
+  /** The CPU used by shard 0 when pin_threads is set. */
+  unsigned int first_cpu;
+  /** The priority of each shard's thread (see EtcPalThreadParams::priority). */
+  unsigned int thread_priority;
+  /** The stack size of each shard's thread (see EtcPalThreadParams::stack_size). */
+  unsigned int thread_stack_size;
+} EtcPalUdpReceiverConfig;
+
+/** A default-value initializer for an EtcPalUdpReceiverConfig struct. */
+#define ETCPAL_UDP_RECEIVER_CONFIG_DEFAULT_INIT                                                 \
+  {                                                                                             \
+    {0, ETCPAL_IP_INVALID_INIT}, 1, 1500, NULL, NULL, false, 0, ETCPAL_THREAD_DEFAULT_PRIORITY, \
+        ETCPAL_THREAD_DEFAULT_STACK                                                             \
+  }
+
+etcpal_error_t etcpal_udp_receiver_create(const EtcPalUdpReceiverConfig* config, EtcPalUdpReceiver** receiver);
+void           etcpal_udp_receiver_destroy(EtcPalUdpReceiver* receiver);
+
+uint16_t        etcpal_udp_receiver_get_port(const EtcPalUdpReceiver* receiver);
+etcpal_socket_t etcpal_udp_receiver_get_socket(const EtcPalUdpReceiver* receiver, size_t shard);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**
+ * @}
+ */
+
+#endif /* ETCPAL_UDP_RECEIVER_H_ */
@@ -45,16 +45,37 @@ DECLARE_FAKE_VALUE_FUNC(etcpal_error_t, etcpal_getsockopt, etcpal_socket_t, int,
 DECLARE_FAKE_VALUE_FUNC(etcpal_error_t, etcpal_listen, etcpal_socket_t, int);
 DECLARE_FAKE_VALUE_FUNC(int, etcpal_recv, etcpal_socket_t, void*, size_t, int);
 DECLARE_FAKE_VALUE_FUNC(int, etcpal_recvfrom, etcpal_socket_t, void*, size_t, int, EtcPalSockAddr*);
+DECLARE_FAKE_VALUE_FUNC(int, etcpal_recvmmsg, etcpal_socket_t, EtcPalMmsgHdr*, size_t, int);
+DECLARE_FAKE_VALUE_FUNC(int, etcpal_recvmsg, etcpal_socket_t, EtcPalMsgHdr*, int);
 DECLARE_FAKE_VALUE_FUNC(int, etcpal_send, etcpal_socket_t, const void*, size_t, int);
+DECLARE_FAKE_VALUE_FUNC(int, etcpal_sendmmsg, etcpal_socket_t, EtcPalMmsgHdr*, size_t, int);
+DECLARE_FAKE_VALUE_FUNC(int, etcpal_sendmsg, etcpal_socket_t, const EtcPalMsgHdr*, int);
 DECLARE_FAKE_VALUE_FUNC(int, etcpal_sendto, etcpal_socket_t, const void*, size_t, int, const EtcPalSockAddr*);
+DECLARE_FAKE_VALUE_FUNC(int,
+                        etcpal_sendto_segmented,
+                        etcpal_socket_t,
+                        const void*,
+                        size_t,
+                        size_t,
+                        int,
+                        const EtcPalSockAddr*);
 DECLARE_FAKE_VALUE_FUNC(etcpal_error_t, etcpal_setsockopt, etcpal_socket_t, int, int, const void*, size_t);
 DECLARE_FAKE_VALUE_FUNC(etcpal_error_t, etcpal_shutdown, etcpal_socket_t, int);
 DECLARE_FAKE_VALUE_FUNC(etcpal_error_t, etcpal_socket, unsigned int, unsigned int, etcpal_socket_t*);
 
+DECLARE_FAKE_VALUE_FUNC(bool, etcpal_cmsg_firsthdr, EtcPalMsgHdr*, EtcPalCMsgHdr*);
+DECLARE_FAKE_VALUE_FUNC(bool, etcpal_cmsg_nxthdr, EtcPalMsgHdr*, const EtcPalCMsgHdr*, EtcPalCMsgHdr*);
+DECLARE_FAKE_VALUE_FUNC(bool, etcpal_cmsg_to_pktinfo, const EtcPalCMsgHdr*, EtcPalPktInfo*);
+DECLARE_FAKE_VALUE_FUNC(bool, etcpal_cmsg_to_timestamp, const EtcPalCMsgHdr*, EtcPalRecvTimestamp*);
+DECLARE_FAKE_VALUE_FUNC(bool, etcpal_cmsg_to_udp_gro, const EtcPalCMsgHdr*, size_t*);
+DECLARE_FAKE_VALUE_FUNC(int, etcpal_read_zerocopy_completions, etcpal_socket_t, EtcPalZerocopyCompletion*, size_t);
+
 DECLARE_FAKE_VALUE_FUNC(etcpal_error_t, etcpal_setblocking, etcpal_socket_t, bool);
 
 DECLARE_FAKE_VALUE_FUNC(etcpal_error_t, etcpal_poll_context_init, EtcPalPollContext*);
 DECLARE_FAKE_VOID_FUNC(etcpal_poll_context_deinit, EtcPalPollContext*);
+DECLARE_FAKE_VALUE_FUNC(etcpal_error_t, etcpal_poll_context_wake, EtcPalPollContext*);
+DECLARE_FAKE_VALUE_FUNC(etcpal_error_t, etcpal_poll_context_set_spin_time, EtcPalPollContext*, unsigned int);
 DECLARE_FAKE_VALUE_FUNC(etcpal_error_t,
                         etcpal_poll_add_socket,
                         EtcPalPollContext*,
@@ -69,6 +90,7 @@ DECLARE_FAKE_VALUE_FUNC(etcpal_error_t,
                         void*);
 DECLARE_FAKE_VOID_FUNC(etcpal_poll_remove_socket, EtcPalPollContext*, etcpal_socket_t);
 DECLARE_FAKE_VALUE_FUNC(etcpal_error_t, etcpal_poll_wait, EtcPalPollContext*, EtcPalPollEvent*, int);
+DECLARE_FAKE_VALUE_FUNC(int, etcpal_poll_wait_many, EtcPalPollContext*, EtcPalPollEvent*, size_t, int);
 
 DECLARE_FAKE_VALUE_FUNC(etcpal_error_t,
                         etcpal_getaddrinfo,
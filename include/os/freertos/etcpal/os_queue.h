@@ -34,17 +34,26 @@ typedef QueueHandle_t etcpal_queue_t;
 
 #define ETCPAL_QUEUE_HAS_TIMED_FUNCTIONS 1
 #define ETCPAL_QUEUE_HAS_ISR_FUNCTIONS 1
+#define ETCPAL_QUEUE_HAS_IN_PLACE_FUNCTIONS 0
 
 bool etcpal_queue_create(etcpal_queue_t* id, size_t size, size_t item_size);
 void etcpal_queue_destroy(etcpal_queue_t* id);
 
-bool etcpal_queue_send(etcpal_queue_t* id, const void* data);
-bool etcpal_queue_timed_send(etcpal_queue_t* id, const void* data, int timeout_ms);
-bool etcpal_queue_send_from_isr(etcpal_queue_t* id, const void* data);
+bool   etcpal_queue_send(etcpal_queue_t* id, const void* data);
+bool   etcpal_queue_timed_send(etcpal_queue_t* id, const void* data, int timeout_ms);
+bool   etcpal_queue_send_from_isr(etcpal_queue_t* id, const void* data);
+size_t etcpal_queue_send_many(etcpal_queue_t* id, const void* data, size_t num_items, int timeout_ms);
 
-bool etcpal_queue_receive(etcpal_queue_t* id, void* data);
-bool etcpal_queue_timed_receive(etcpal_queue_t* id, void* data, int timeout_ms);
-bool etcpal_queue_receive_from_isr(etcpal_queue_t* id, void* data);
+bool   etcpal_queue_receive(etcpal_queue_t* id, void* data);
+bool   etcpal_queue_timed_receive(etcpal_queue_t* id, void* data, int timeout_ms);
+bool   etcpal_queue_receive_from_isr(etcpal_queue_t* id, void* data);
+size_t etcpal_queue_receive_many(etcpal_queue_t* id, void* data, size_t max_items, int timeout_ms);
+
+void* etcpal_queue_reserve(etcpal_queue_t* id, int timeout_ms);
+void  etcpal_queue_commit(etcpal_queue_t* id, void* slot);
+void  etcpal_queue_abort(etcpal_queue_t* id, void* slot);
+void* etcpal_queue_peek(etcpal_queue_t* id, int timeout_ms);
+void  etcpal_queue_release(etcpal_queue_t* id, const void* item);
 
 bool etcpal_queue_reset(etcpal_queue_t* id);
 
@@ -21,7 +21,7 @@
 #define ETCPAL_OS_SOCKET_H_
 
 #include "etcpal/inet.h"
-#include "etcpal/rbtree.h"
+#include "etcpal/mutex.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -39,11 +39,26 @@ typedef int etcpal_socket_t;
 
 /* Definitions for etcpal_poll API */
 
+typedef struct EtcPalPollSocket
+{
+  unsigned int         seq;  // Odd while the entry is being changed
+  etcpal_socket_t      sock;
+  etcpal_poll_events_t events;
+  void*                user_data;
+} EtcPalPollSocket;
+
 typedef struct EtcPalPollContext
 {
-  bool         valid;
-  int          epoll_fd;
-  EtcPalRbTree sockets;
+  bool           valid;
+  int            epoll_fd;
+  int            wake_fd;        // eventfd used by etcpal_poll_context_wake()
+  bool           wake_deferred;  // A wakeup consumed alongside socket events; reported by the next wait
+  etcpal_mutex_t lock;           // Serializes changes to the socket table; not taken by the wait functions
+  unsigned int   spin_us;        // Set by etcpal_poll_context_set_spin_time()
+
+  // Indexed by file descriptor; unused entries have sock set to ETCPAL_SOCKET_INVALID.
+  struct EtcPalPollSocketTable* socket_table;
+  size_t                        num_valid_sockets;
 } EtcPalPollContext;
 
 #ifdef __cplusplus
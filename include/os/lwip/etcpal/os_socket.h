@@ -37,6 +37,8 @@
 #define LWIP_COMPAT_SOCKETS 1
 #endif /* (LWIP_COMPAT_SOCKETS == 1) */
 
+#include "etcpal/mutex.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -68,7 +70,8 @@ typedef struct EtcPalPollFdSet
 
 typedef struct EtcPalPollContext
 {
-  bool valid;
+  bool           valid;
+  etcpal_mutex_t lock;  // Protects the members below; not held while waiting in select()
 
   EtcPalPollSocket sockets[ETCPAL_SOCKET_MAX_POLL_SIZE];
   size_t           num_valid_sockets;
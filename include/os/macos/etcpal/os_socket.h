@@ -23,7 +23,7 @@
 #include <netinet/in.h>
 #include <sys/select.h>
 #include "etcpal/inet.h"
-#include "etcpal/rbtree.h"
+#include "etcpal/mutex.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -43,9 +43,15 @@ typedef int etcpal_socket_t;
 
 typedef struct EtcPalPollContext
 {
-  bool         valid;
-  int          kq_fd;
-  EtcPalRbTree sockets;
+  bool           valid;
+  int            kq_fd;
+  bool           wake_deferred;  // A wakeup consumed alongside socket events; reported by the next wait
+  etcpal_mutex_t lock;           // Serializes changes to the socket table; not taken by the wait functions
+  unsigned int   spin_us;        // Set by etcpal_poll_context_set_spin_time()
+
+  // Indexed by file descriptor; unused entries have sock set to ETCPAL_SOCKET_INVALID.
+  struct EtcPalPollSocketTable* socket_table;
+  size_t                        num_valid_sockets;
 } EtcPalPollContext;
 
 #ifdef __cplusplus
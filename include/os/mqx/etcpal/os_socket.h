@@ -23,6 +23,7 @@
 #include <rtcs.h>
 #include <stdint.h>
 #include "etcpal/inet.h"
+#include "etcpal/mutex.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -57,7 +58,8 @@ typedef struct EtcPalPollFdSet
 
 typedef struct EtcPalPollContext
 {
-  bool valid;
+  bool           valid;
+  etcpal_mutex_t lock;  // Protects the members below; not held while waiting in select()
 
   EtcPalPollCtxSocket sockets[ETCPAL_SOCKET_MAX_POLL_SIZE];
   size_t              num_valid_sockets;
@@ -26,23 +26,24 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-typedef struct EtcPalQueueNode
-{
-  void* data;
-} EtcPalQueueNode;
-
 typedef struct
 {
-  unsigned         head;
-  unsigned         tail;
-  EtcPalQueueNode* node_list;
-  size_t           max_queue_size;
-  size_t           queue_size;
+  // Going around the ring: slots from tail to claim_pos are held by receivers, from claim_pos to
+  // head are waiting to be received, and from head to reserve_pos are held by senders.
+  unsigned head;
+  unsigned tail;
+  unsigned reserve_pos;
+  unsigned claim_pos;
+  uint8_t* buf;
+  uint8_t* slot_states;
+  size_t   max_queue_size;
+  size_t   queue_size;
 
   etcpal_sem_t lock;
   etcpal_sem_t spots_available;
@@ -52,17 +53,26 @@ typedef struct
 
 #define ETCPAL_QUEUE_HAS_TIMED_FUNCTIONS ETCPAL_SEM_HAS_TIMED_WAIT
 #define ETCPAL_QUEUE_HAS_ISR_FUNCTIONS ETCPAL_SEM_HAS_POST_FROM_ISR
+#define ETCPAL_QUEUE_HAS_IN_PLACE_FUNCTIONS 1
 
 bool etcpal_queue_create(etcpal_queue_t* id, size_t size, size_t item_size);
 void etcpal_queue_destroy(etcpal_queue_t* id);
 
-bool etcpal_queue_send(etcpal_queue_t* id, const void* data);
-bool etcpal_queue_timed_send(etcpal_queue_t* id, const void* data, int timeout_ms);
-bool etcpal_queue_send_from_isr(etcpal_queue_t* id, const void* data);
-
-bool etcpal_queue_receive(etcpal_queue_t* id, void* data);
-bool etcpal_queue_timed_receive(etcpal_queue_t* id, void* data, int timeout_ms);
-bool etcpal_queue_receive_from_isr(etcpal_queue_t* id, void* data);
+bool   etcpal_queue_send(etcpal_queue_t* id, const void* data);
+bool   etcpal_queue_timed_send(etcpal_queue_t* id, const void* data, int timeout_ms);
+bool   etcpal_queue_send_from_isr(etcpal_queue_t* id, const void* data);
+size_t etcpal_queue_send_many(etcpal_queue_t* id, const void* data, size_t num_items, int timeout_ms);
+
+bool   etcpal_queue_receive(etcpal_queue_t* id, void* data);
+bool   etcpal_queue_timed_receive(etcpal_queue_t* id, void* data, int timeout_ms);
+bool   etcpal_queue_receive_from_isr(etcpal_queue_t* id, void* data);
+size_t etcpal_queue_receive_many(etcpal_queue_t* id, void* data, size_t max_items, int timeout_ms);
+
+void* etcpal_queue_reserve(etcpal_queue_t* id, int timeout_ms);
+void  etcpal_queue_commit(etcpal_queue_t* id, void* slot);
+void  etcpal_queue_abort(etcpal_queue_t* id, void* slot);
+void* etcpal_queue_peek(etcpal_queue_t* id, int timeout_ms);
+void  etcpal_queue_release(etcpal_queue_t* id, const void* item);
 
 bool etcpal_queue_reset(etcpal_queue_t* id);
 
@@ -62,8 +62,11 @@ typedef struct EtcPalPollFdSet
 
 typedef struct EtcPalPollContext
 {
-  bool           valid;
-  etcpal_mutex_t lock;
+  bool            valid;
+  etcpal_mutex_t  lock;
+  etcpal_socket_t wake_sock;      // Loopback socket used by etcpal_poll_context_wake()
+  bool            wake_deferred;  // A wakeup consumed alongside socket events; reported by the next wait
+  unsigned int    generation;     // Incremented on every change to the socket set
 
   EtcPalRbTree sockets;
 
@@ -0,0 +1,619 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+#include "etcpal/connector.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "etcpal/common.h"
+#include "etcpal/mutex.h"
+#include "etcpal/rbtree.h"
+#include "etcpal/timer.h"
+
+/**************************** Private constants ******************************/
+
+#define CONNECTOR_MAX_EVENTS_PER_PROCESS 64
+#define CONNECTOR_MAX_ACCEPTS_PER_EVENT  16
+
+/****************************** Private types ********************************/
+
+typedef struct PendingConnect PendingConnect;
+
+struct PendingConnect
+{
+  EtcPalRbNode socket_node;
+  EtcPalRbNode deadline_node;
+
+  etcpal_socket_t       socket;
+  bool                  has_deadline;
+  uint32_t              deadline;
+  EtcPalConnectCallback callback;
+  void*                 context;
+
+  // Used to report the result once the connect has been detached from the connector.
+  etcpal_error_t  result;
+  PendingConnect* next_completed;
+};
+
+typedef struct ConnectorListener
+{
+  EtcPalRbNode         node;
+  etcpal_socket_t      socket;
+  EtcPalAcceptCallback callback;
+  void*                context;
+} ConnectorListener;
+
+struct EtcPalConnector
+{
+  etcpal_mutex_t    lock;
+  EtcPalPollContext poll_context;
+
+  EtcPalRbTree connects;   // PendingConnects by socket
+  EtcPalRbTree deadlines;  // PendingConnects with a timeout, by deadline and then by socket
+  EtcPalRbTree listeners;  // ConnectorListeners by socket
+
+  // The time at which the wait in progress in etcpal_connector_process() will time out, so that
+  // the wait can be cut short when a connect with an earlier deadline is added.
+  bool     waiting;
+  bool     wait_has_deadline;
+  uint32_t wait_deadline;
+};
+
+/*********************** Private function prototypes *************************/
+
+static int   connect_socket_cmp(const EtcPalRbTree* self, const void* value_a, const void* value_b);
+static int   connect_deadline_cmp(const EtcPalRbTree* self, const void* value_a, const void* value_b);
+static int   listener_cmp(const EtcPalRbTree* self, const void* value_a, const void* value_b);
+static int   compare_sockets(etcpal_socket_t a, etcpal_socket_t b);
+static int   compare_times(uint32_t a, uint32_t b);
+static void* first_value(EtcPalRbTree* tree);
+
+static int  get_wait_time_locked(EtcPalConnector* connector, int timeout_ms);
+static void detach_connect_locked(EtcPalConnector* connector, PendingConnect* pending);
+static void complete_connects(PendingConnect* completed);
+static void accept_connections(EtcPalConnector* connector, etcpal_socket_t listener);
+
+/*************************** Function definitions ****************************/
+
+/**
+ * @brief Create a new connector.
+ *
+ * @param[out] connector Filled in with the new connector on success.
+ * @return #kEtcPalErrOk: Connector created successfully.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return #kEtcPalErrNoMem: Couldn't allocate memory for the connector.
+ * @return #kEtcPalErrSys: Couldn't create the connector's lock.
+ * @return Other codes translated from system error codes are possible.
+ */
+etcpal_error_t etcpal_connector_create(EtcPalConnector** connector)
+{
+  if (!connector)
+    return kEtcPalErrInvalid;
+
+  EtcPalConnector* new_connector = (EtcPalConnector*)calloc(1, sizeof(EtcPalConnector));
+  if (!new_connector)
+    return kEtcPalErrNoMem;
+
+  if (!etcpal_mutex_create(&new_connector->lock))
+  {
+    free(new_connector);
+    return kEtcPalErrSys;
+  }
+
+  etcpal_error_t res = etcpal_poll_context_init(&new_connector->poll_context);
+  if (res != kEtcPalErrOk)
+  {
+    etcpal_mutex_destroy(&new_connector->lock);
+    free(new_connector);
+    return res;
+  }
+
+  etcpal_rbtree_init(&new_connector->connects, connect_socket_cmp, NULL, NULL);
+  etcpal_rbtree_init(&new_connector->deadlines, connect_deadline_cmp, NULL, NULL);
+  etcpal_rbtree_init(&new_connector->listeners, listener_cmp, NULL, NULL);
+  *connector = new_connector;
+  return kEtcPalErrOk;
+}
+
+/**
+ * @brief Destroy a connector.
+ *
+ * The sockets of connects which are still pending are closed, and their callbacks are not called.
+ * Listening sockets are removed from the connector but not closed. Must not be called while
+ * another thread is in etcpal_connector_process() on the same connector.
+ *
+ * @param[in] connector Connector to destroy.
+ */
+void etcpal_connector_destroy(EtcPalConnector* connector)
+{
+  if (!connector)
+    return;
+
+  PendingConnect* pending = (PendingConnect*)first_value(&connector->connects);
+  while (pending)
+  {
+    detach_connect_locked(connector, pending);
+    etcpal_close(pending->socket);
+    free(pending);
+    pending = (PendingConnect*)first_value(&connector->connects);
+  }
+
+  ConnectorListener* listener = (ConnectorListener*)first_value(&connector->listeners);
+  while (listener)
+  {
+    etcpal_rbtree_remove_with_cb(&connector->listeners, listener, NULL);
+    free(listener);
+    listener = (ConnectorListener*)first_value(&connector->listeners);
+  }
+
+  etcpal_poll_context_deinit(&connector->poll_context);
+  etcpal_mutex_destroy(&connector->lock);
+  free(connector);
+}
+
+/**
+ * @brief Start connecting a TCP socket.
+ *
+ * The socket is put into non-blocking mode and a connect to addr is started. The connector takes
+ * ownership of the socket until the connect completes, at which point the callback is called from
+ * etcpal_connector_process() with the result. If the connect fails, times out or is cancelled, the
+ * connector closes the socket.
+ *
+ * Options such as a local address to bind to can be set on the socket before calling this
+ * function.
+ *
+ * @param[in] connector Connector which will run the connect.
+ * @param[in] socket An unconnected TCP socket.
+ * @param[in] addr The address to connect to.
+ * @param[in] timeout_ms How long to wait for the connect to complete before it fails with
+ *                       #kEtcPalErrTimedOut, or #ETCPAL_WAIT_FOREVER to wait for as long as the
+ *                       network stack allows.
+ * @param[in] callback Called with the result of the connect.
+ * @param[in] context Passed back to the callback.
+ * @return #kEtcPalErrOk: Connect started; the result will be passed to the callback.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return #kEtcPalErrNoMem: Couldn't allocate memory for the connect.
+ * @return Other codes translated from system error codes are possible. If the connect could not be
+ *         started, the socket is still owned by the caller and the callback is not called.
+ */
+etcpal_error_t etcpal_connector_connect(EtcPalConnector*      connector,
+                                        etcpal_socket_t       socket,
+                                        const EtcPalSockAddr* addr,
+                                        int                   timeout_ms,
+                                        EtcPalConnectCallback callback,
+                                        void*                 context)
+{
+  if (!connector || socket == ETCPAL_SOCKET_INVALID || !addr || !callback ||
+      (timeout_ms < 0 && timeout_ms != ETCPAL_WAIT_FOREVER))
+  {
+    return kEtcPalErrInvalid;
+  }
+
+  PendingConnect* pending = (PendingConnect*)calloc(1, sizeof(PendingConnect));
+  if (!pending)
+    return kEtcPalErrNoMem;
+
+  pending->socket = socket;
+  pending->has_deadline = (timeout_ms != ETCPAL_WAIT_FOREVER);
+  pending->callback = callback;
+  pending->context = context;
+  etcpal_rbnode_init(&pending->socket_node, pending);
+  etcpal_rbnode_init(&pending->deadline_node, pending);
+
+  etcpal_error_t res = etcpal_setblocking(socket, false);
+  if (res == kEtcPalErrOk)
+  {
+    res = etcpal_connect(socket, addr);
+    // A connect to a local address can complete immediately; it is reported through the poll
+    // context like any other.
+    if (res == kEtcPalErrInProgress || res == kEtcPalErrWouldBlock)
+      res = kEtcPalErrOk;
+  }
+  if (res != kEtcPalErrOk)
+  {
+    free(pending);
+    return res;
+  }
+
+  if (!etcpal_mutex_lock(&connector->lock))
+  {
+    free(pending);
+    return kEtcPalErrSys;
+  }
+
+  bool wake = false;
+  if (pending->has_deadline)
+    pending->deadline = etcpal_getms() + (uint32_t)timeout_ms;
+
+  res = etcpal_rbtree_insert_node(&connector->connects, &pending->socket_node);
+  if (res == kEtcPalErrOk)
+  {
+    res = etcpal_poll_add_socket(&connector->poll_context, socket, ETCPAL_POLL_CONNECT, NULL);
+    if (res != kEtcPalErrOk)
+      etcpal_rbtree_remove_with_cb(&connector->connects, pending, NULL);
+  }
+  if (res == kEtcPalErrOk && pending->has_deadline)
+  {
+    etcpal_rbtree_insert_node(&connector->deadlines, &pending->deadline_node);
+    wake = connector->waiting &&
+           (!connector->wait_has_deadline || compare_times(pending->deadline, connector->wait_deadline) < 0);
+  }
+  etcpal_mutex_unlock(&connector->lock);
+
+  if (res != kEtcPalErrOk)
+    free(pending);
+  else if (wake)
+    etcpal_poll_context_wake(&connector->poll_context);
+  return res;
+}
+
+/**
+ * @brief Cancel a connect started with etcpal_connector_connect().
+ *
+ * The socket is closed and the connect's callback is not called.
+ *
+ * @param[in] connector Connector running the connect.
+ * @param[in] socket The socket passed to etcpal_connector_connect().
+ * @return #kEtcPalErrOk: Connect cancelled.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return #kEtcPalErrNotFound: No connect is pending on the socket; it may already have completed.
+ * @return #kEtcPalErrSys: An internal library or system call error occurred.
+ */
+etcpal_error_t etcpal_connector_cancel(EtcPalConnector* connector, etcpal_socket_t socket)
+{
+  if (!connector || socket == ETCPAL_SOCKET_INVALID)
+    return kEtcPalErrInvalid;
+
+  if (!etcpal_mutex_lock(&connector->lock))
+    return kEtcPalErrSys;
+
+  PendingConnect  key;
+  PendingConnect* pending;
+  key.socket = socket;
+  pending = (PendingConnect*)etcpal_rbtree_find(&connector->connects, &key);
+  if (pending)
+    detach_connect_locked(connector, pending);
+
+  etcpal_mutex_unlock(&connector->lock);
+
+  if (!pending)
+    return kEtcPalErrNotFound;
+
+  etcpal_close(pending->socket);
+  free(pending);
+  return kEtcPalErrOk;
+}
+
+/**
+ * @brief Get the number of connects which have been started and have not yet completed.
+ *
+ * @param[in] connector Connector to query.
+ * @return The number of pending connects.
+ */
+size_t etcpal_connector_num_pending(EtcPalConnector* connector)
+{
+  size_t num_pending = 0;
+  if (connector && etcpal_mutex_lock(&connector->lock))
+  {
+    num_pending = etcpal_rbtree_size(&connector->connects);
+    etcpal_mutex_unlock(&connector->lock);
+  }
+  return num_pending;
+}
+
+/**
+ * @brief Accept connections on a listening socket.
+ *
+ * The socket is put into non-blocking mode. Whenever connections are ready to be accepted on it,
+ * etcpal_connector_process() accepts them and passes each one to the callback. The socket remains
+ * owned by the caller, and must be removed with etcpal_connector_remove_listener() before it is
+ * closed.
+ *
+ * @param[in] connector Connector which will accept connections.
+ * @param[in] listener A TCP socket on which etcpal_listen() has been called.
+ * @param[in] callback Called with each connection accepted.
+ * @param[in] context Passed back to the callback.
+ * @return #kEtcPalErrOk: Listener added.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return #kEtcPalErrExists: The socket is already a listener in this connector.
+ * @return #kEtcPalErrNoMem: Couldn't allocate memory for the listener.
+ * @return Other codes translated from system error codes are possible.
+ */
+etcpal_error_t etcpal_connector_add_listener(EtcPalConnector*     connector,
+                                             etcpal_socket_t      listener,
+                                             EtcPalAcceptCallback callback,
+                                             void*                context)
+{
+  if (!connector || listener == ETCPAL_SOCKET_INVALID || !callback)
+    return kEtcPalErrInvalid;
+
+  ConnectorListener* new_listener = (ConnectorListener*)calloc(1, sizeof(ConnectorListener));
+  if (!new_listener)
+    return kEtcPalErrNoMem;
+
+  new_listener->socket = listener;
+  new_listener->callback = callback;
+  new_listener->context = context;
+  etcpal_rbnode_init(&new_listener->node, new_listener);
+
+  etcpal_error_t res = etcpal_setblocking(listener, false);
+  if (res == kEtcPalErrOk)
+  {
+    if (etcpal_mutex_lock(&connector->lock))
+    {
+      res = etcpal_rbtree_insert_node(&connector->listeners, &new_listener->node);
+      if (res == kEtcPalErrOk)
+      {
+        res = etcpal_poll_add_socket(&connector->poll_context, listener, ETCPAL_POLL_IN, NULL);
+        if (res != kEtcPalErrOk)
+          etcpal_rbtree_remove_with_cb(&connector->listeners, new_listener, NULL);
+      }
+      etcpal_mutex_unlock(&connector->lock);
+    }
+    else
+    {
+      res = kEtcPalErrSys;
+    }
+  }
+
+  if (res != kEtcPalErrOk)
+    free(new_listener);
+  return res;
+}
+
+/**
+ * @brief Stop accepting connections on a listening socket.
+ *
+ * @param[in] connector Connector accepting connections on the socket.
+ * @param[in] listener The socket passed to etcpal_connector_add_listener().
+ * @return #kEtcPalErrOk: Listener removed.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return #kEtcPalErrNotFound: The socket is not a listener in this connector.
+ * @return #kEtcPalErrSys: An internal library or system call error occurred.
+ */
+etcpal_error_t etcpal_connector_remove_listener(EtcPalConnector* connector, etcpal_socket_t listener)
+{
+  if (!connector || listener == ETCPAL_SOCKET_INVALID)
+    return kEtcPalErrInvalid;
+
+  if (!etcpal_mutex_lock(&connector->lock))
+    return kEtcPalErrSys;
+
+  ConnectorListener  key;
+  ConnectorListener* to_remove;
+  key.socket = listener;
+  to_remove = (ConnectorListener*)etcpal_rbtree_find(&connector->listeners, &key);
+  if (to_remove)
+  {
+    etcpal_poll_remove_socket(&connector->poll_context, listener);
+    etcpal_rbtree_remove_with_cb(&connector->listeners, to_remove, NULL);
+  }
+
+  etcpal_mutex_unlock(&connector->lock);
+
+  if (!to_remove)
+    return kEtcPalErrNotFound;
+  free(to_remove);
+  return kEtcPalErrOk;
+}
+
+/**
+ * @brief Wait for connects and accepts to complete, and call their callbacks.
+ *
+ * Waits for up to timeout_ms for socket activity, returning early if a connect reaches its
+ * timeout. Then calls the callback of each connect which has completed, failed or timed out, and
+ * the accept callback for each connection accepted on a listener. Callbacks are called from the
+ * calling thread, without any of the connector's internal locks held.
+ *
+ * Only one thread should call this function on a given connector at a time.
+ *
+ * @param[in] connector Connector to process.
+ * @param[in] timeout_ms How long to wait for activity, or #ETCPAL_WAIT_FOREVER.
+ * @return #kEtcPalErrOk: One or more callbacks were called.
+ * @return #kEtcPalErrTimedOut: Nothing happened before the timeout.
+ * @return #kEtcPalErrNoSockets: There are no connects pending and no listeners to wait on. This
+ *         function returns immediately in this case.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return #kEtcPalErrSys: An internal library or system call error occurred.
+ * @return Other codes translated from system error codes are possible.
+ */
+etcpal_error_t etcpal_connector_process(EtcPalConnector* connector, int timeout_ms)
+{
+  if (!connector)
+    return kEtcPalErrInvalid;
+
+  if (!etcpal_mutex_lock(&connector->lock))
+    return kEtcPalErrSys;
+  int wait_ms = get_wait_time_locked(connector, timeout_ms);
+  connector->waiting = true;
+  etcpal_mutex_unlock(&connector->lock);
+
+  EtcPalPollEvent events[CONNECTOR_MAX_EVENTS_PER_PROCESS];
+  int num_events = etcpal_poll_wait_many(&connector->poll_context, events, CONNECTOR_MAX_EVENTS_PER_PROCESS, wait_ms);
+
+  if (!etcpal_mutex_lock(&connector->lock))
+    return kEtcPalErrSys;
+  connector->waiting = false;
+
+  etcpal_socket_t ready_listeners[CONNECTOR_MAX_EVENTS_PER_PROCESS];
+  size_t          num_ready_listeners = 0;
+  PendingConnect* completed = NULL;
+
+  // Events are matched to connects and listeners by socket rather than through the poll context's
+  // user data, since a callback in this or another thread may have removed them in the meantime.
+  for (int i = 0; i < num_events; ++i)
+  {
+    PendingConnect key;
+    key.socket = events[i].socket;
+    PendingConnect* pending = (PendingConnect*)etcpal_rbtree_find(&connector->connects, &key);
+    if (pending)
+    {
+      detach_connect_locked(connector, pending);
+      pending->result = ((events[i].events & ETCPAL_POLL_ERR) ? events[i].err : kEtcPalErrOk);
+      pending->next_completed = completed;
+      completed = pending;
+    }
+    else
+    {
+      ready_listeners[num_ready_listeners++] = events[i].socket;
+    }
+  }
+
+  uint32_t        now = etcpal_getms();
+  PendingConnect* expired = (PendingConnect*)first_value(&connector->deadlines);
+  while (expired && compare_times(expired->deadline, now) <= 0)
+  {
+    detach_connect_locked(connector, expired);
+    expired->result = kEtcPalErrTimedOut;
+    expired->next_completed = completed;
+    completed = expired;
+    expired = (PendingConnect*)first_value(&connector->deadlines);
+  }
+
+  etcpal_mutex_unlock(&connector->lock);
+
+  bool processed = (completed != NULL || num_ready_listeners > 0);
+  complete_connects(completed);
+  for (size_t i = 0; i < num_ready_listeners; ++i)
+    accept_connections(connector, ready_listeners[i]);
+
+  if (processed)
+    return kEtcPalErrOk;
+  if (num_events < 0 && num_events != kEtcPalErrWoken)
+    return (etcpal_error_t)num_events;
+  return kEtcPalErrTimedOut;
+}
+
+/*************************** Private functions *******************************/
+
+int connect_socket_cmp(const EtcPalRbTree* self, const void* value_a, const void* value_b)
+{
+  ETCPAL_UNUSED_ARG(self);
+  return compare_sockets(((const PendingConnect*)value_a)->socket, ((const PendingConnect*)value_b)->socket);
+}
+
+int connect_deadline_cmp(const EtcPalRbTree* self, const void* value_a, const void* value_b)
+{
+  ETCPAL_UNUSED_ARG(self);
+  const PendingConnect* a = (const PendingConnect*)value_a;
+  const PendingConnect* b = (const PendingConnect*)value_b;
+
+  int res = compare_times(a->deadline, b->deadline);
+  return (res != 0 ? res : compare_sockets(a->socket, b->socket));
+}
+
+int listener_cmp(const EtcPalRbTree* self, const void* value_a, const void* value_b)
+{
+  ETCPAL_UNUSED_ARG(self);
+  return compare_sockets(((const ConnectorListener*)value_a)->socket, ((const ConnectorListener*)value_b)->socket);
+}
+
+int compare_sockets(etcpal_socket_t a, etcpal_socket_t b)
+{
+  return (a > b) - (a < b);
+}
+
+// Compare two etcpal_getms() values, allowing for the millisecond counter wrapping around.
+int compare_times(uint32_t a, uint32_t b)
+{
+  int32_t diff = (int32_t)(a - b);
+  return (diff > 0) - (diff < 0);
+}
+
+void* first_value(EtcPalRbTree* tree)
+{
+  EtcPalRbIter iter;
+  etcpal_rbiter_init(&iter);
+  return etcpal_rbiter_first(&iter, tree);
+}
+
+// Limit a wait to the earliest connect deadline.
+int get_wait_time_locked(EtcPalConnector* connector, int timeout_ms)
+{
+  PendingConnect* earliest = (PendingConnect*)first_value(&connector->deadlines);
+  uint32_t        now = etcpal_getms();
+
+  connector->wait_has_deadline = (timeout_ms != ETCPAL_WAIT_FOREVER);
+  connector->wait_deadline = now + (uint32_t)(timeout_ms < 0 ? 0 : timeout_ms);
+  if (earliest && (!connector->wait_has_deadline || compare_times(earliest->deadline, connector->wait_deadline) < 0))
+  {
+    connector->wait_has_deadline = true;
+    connector->wait_deadline = earliest->deadline;
+  }
+
+  if (!connector->wait_has_deadline)
+    return ETCPAL_WAIT_FOREVER;
+  return (compare_times(connector->wait_deadline, now) > 0 ? (int)(connector->wait_deadline - now) : 0);
+}
+
+void detach_connect_locked(EtcPalConnector* connector, PendingConnect* pending)
+{
+  etcpal_poll_remove_socket(&connector->poll_context, pending->socket);
+  if (pending->has_deadline)
+    etcpal_rbtree_remove_with_cb(&connector->deadlines, pending, NULL);
+  etcpal_rbtree_remove_with_cb(&connector->connects, pending, NULL);
+}
+
+void complete_connects(PendingConnect* completed)
+{
+  while (completed)
+  {
+    PendingConnect* next = completed->next_completed;
+    etcpal_socket_t socket = completed->socket;
+    if (completed->result != kEtcPalErrOk)
+    {
+      etcpal_close(socket);
+      socket = ETCPAL_SOCKET_INVALID;
+    }
+    completed->callback(socket, completed->result, completed->context);
+    free(completed);
+    completed = next;
+  }
+}
+
+void accept_connections(EtcPalConnector* connector, etcpal_socket_t listener)
+{
+  for (int i = 0; i < CONNECTOR_MAX_ACCEPTS_PER_EVENT; ++i)
+  {
+    // Look the listener up again each time, in case a callback has removed it.
+    EtcPalAcceptCallback callback = NULL;
+    void*                context = NULL;
+    if (etcpal_mutex_lock(&connector->lock))
+    {
+      ConnectorListener key;
+      key.socket = listener;
+      ConnectorListener* found = (ConnectorListener*)etcpal_rbtree_find(&connector->listeners, &key);
+      if (found)
+      {
+        callback = found->callback;
+        context = found->context;
+      }
+      etcpal_mutex_unlock(&connector->lock);
+    }
+    if (!callback)
+      return;
+
+    EtcPalSockAddr  remote_addr;
+    etcpal_socket_t conn;
+    if (etcpal_accept(listener, &remote_addr, &conn) != kEtcPalErrOk)
+      return;
+    callback(listener, conn, &remote_addr, context);
+  }
+}
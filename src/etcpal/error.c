@@ -57,6 +57,7 @@ static const char *etcpal_error_strings[ETCPAL_NUM_ERROR_CODES] =
   "Not implemented",                  /* kEtcPalErrNotImpl */
   "Operation not permitted",          /* kEtcPalErrPerm */
   "System or library call failed",    /* kEtcPalErrSys */
+  "Wait interrupted by wakeup",       /* kEtcPalErrWoken */
 };
 
 /*************************** Function definitions ****************************/
@@ -0,0 +1,562 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+#include "etcpal/mcast.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include "etcpal/common.h"
+#include "etcpal/mutex.h"
+#include "etcpal/netint.h"
+#include "etcpal/rbtree.h"
+
+/****************************** Private types ********************************/
+
+typedef struct McastMembership McastMembership;
+
+struct McastMembership
+{
+  EtcPalRbNode node;  // Must be first: the tree frees memberships through their node
+
+  etcpal_socket_t socket;
+  EtcPalGroupReq  req;
+  size_t          refcount;
+
+  // Links in the queue of pending leaves, valid while refcount is 0.
+  McastMembership* prev_pending;
+  McastMembership* next_pending;
+};
+
+struct EtcPalMcastManager
+{
+  EtcPalMcastManagerConfig config;
+  etcpal_mutex_t           lock;
+
+  EtcPalRbTree     memberships;
+  McastMembership* pending_head;
+  McastMembership* pending_tail;
+  EtcPalMcastStats stats;
+};
+
+/*********************** Private function prototypes *************************/
+
+static int  membership_cmp(const EtcPalRbTree* self, const void* value_a, const void* value_b);
+static void free_membership_node(EtcPalRbNode* node);
+
+static etcpal_error_t   join_locked(EtcPalMcastManager* manager, etcpal_socket_t socket, const EtcPalGroupReq* req);
+static etcpal_error_t   leave_locked(EtcPalMcastManager* manager, etcpal_socket_t socket, const EtcPalGroupReq* req);
+static etcpal_error_t   flush_leaves_locked(EtcPalMcastManager* manager);
+static McastMembership* find_membership(EtcPalMcastManager* manager, etcpal_socket_t socket, const EtcPalGroupReq* req);
+static void             queue_leave(EtcPalMcastManager* manager, McastMembership* membership);
+static void             dequeue_leave(EtcPalMcastManager* manager, McastMembership* membership);
+static etcpal_error_t   set_membership(etcpal_socket_t socket, const EtcPalGroupReq* req, bool join);
+
+/*************************** Function definitions ****************************/
+
+/**
+ * @brief Create a new multicast manager.
+ *
+ * @param[in] config Configuration for the new manager.
+ * @param[out] manager Filled in with the new manager on success.
+ * @return #kEtcPalErrOk: Manager created successfully.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return #kEtcPalErrNoMem: Couldn't allocate memory for the manager.
+ * @return #kEtcPalErrSys: Couldn't create the manager's lock.
+ */
+etcpal_error_t etcpal_mcast_manager_create(const EtcPalMcastManagerConfig* config, EtcPalMcastManager** manager)
+{
+  if (!config || !manager)
+    return kEtcPalErrInvalid;
+
+  EtcPalMcastManager* new_manager = (EtcPalMcastManager*)calloc(1, sizeof(EtcPalMcastManager));
+  if (!new_manager)
+    return kEtcPalErrNoMem;
+
+  if (!etcpal_mutex_create(&new_manager->lock))
+  {
+    free(new_manager);
+    return kEtcPalErrSys;
+  }
+
+  new_manager->config = *config;
+  etcpal_rbtree_init(&new_manager->memberships, membership_cmp, NULL, free_membership_node);
+  *manager = new_manager;
+  return kEtcPalErrOk;
+}
+
+/**
+ * @brief Destroy a multicast manager.
+ *
+ * Every membership still tracked by the manager is left, including those with a leave queued. The
+ * sockets must still be open.
+ *
+ * @param[in] manager Manager to destroy.
+ */
+void etcpal_mcast_manager_destroy(EtcPalMcastManager* manager)
+{
+  if (!manager)
+    return;
+
+  EtcPalRbIter iter;
+  etcpal_rbiter_init(&iter);
+  for (McastMembership* membership = (McastMembership*)etcpal_rbiter_first(&iter, &manager->memberships); membership;
+       membership = (McastMembership*)etcpal_rbiter_next(&iter))
+  {
+    set_membership(membership->socket, &membership->req, false);
+  }
+
+  etcpal_rbtree_clear(&manager->memberships);
+  etcpal_mutex_destroy(&manager->lock);
+  free(manager);
+}
+
+/**
+ * @brief Join a multicast group on a socket and network interface.
+ *
+ * If the socket is already a member of the group on the interface through this manager, a
+ * reference is added to the membership and no network stack call is made. Otherwise the group is
+ * joined with #ETCPAL_MCAST_JOIN_GROUP.
+ *
+ * @param[in] manager Manager through which to join the group.
+ * @param[in] socket Socket on which to join the group.
+ * @param[in] req The group and network interface index.
+ * @return #kEtcPalErrOk: Group joined, or a reference added to an existing membership.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return #kEtcPalErrNoMem: Couldn't allocate memory for the membership.
+ * @return Other codes translated from system error codes are possible.
+ */
+etcpal_error_t etcpal_mcast_join(EtcPalMcastManager* manager, etcpal_socket_t socket, const EtcPalGroupReq* req)
+{
+  if (!manager || socket == ETCPAL_SOCKET_INVALID || !req || !etcpal_ip_is_multicast(&req->group))
+    return kEtcPalErrInvalid;
+
+  etcpal_error_t res = kEtcPalErrSys;
+  if (etcpal_mutex_lock(&manager->lock))
+  {
+    res = join_locked(manager, socket, req);
+    etcpal_mutex_unlock(&manager->lock);
+  }
+  return res;
+}
+
+/**
+ * @brief Release a reference to a multicast group membership.
+ *
+ * When the last reference to the membership is released, its leave is queued to be issued by
+ * etcpal_mcast_flush_leaves(), or issued immediately if the manager was configured with a
+ * max_pending_leaves of 0 or the queue is full.
+ *
+ * @param[in] manager Manager through which the group was joined.
+ * @param[in] socket Socket on which the group was joined.
+ * @param[in] req The group and network interface index.
+ * @return #kEtcPalErrOk: Reference released.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return #kEtcPalErrNotFound: The socket is not a member of the group on the interface through
+ *         this manager.
+ * @return Other codes translated from system error codes are possible if queued leaves were issued
+ *         and one of them failed; the reference is released regardless.
+ */
+etcpal_error_t etcpal_mcast_leave(EtcPalMcastManager* manager, etcpal_socket_t socket, const EtcPalGroupReq* req)
+{
+  if (!manager || socket == ETCPAL_SOCKET_INVALID || !req)
+    return kEtcPalErrInvalid;
+
+  etcpal_error_t res = kEtcPalErrSys;
+  if (etcpal_mutex_lock(&manager->lock))
+  {
+    res = leave_locked(manager, socket, req);
+    etcpal_mutex_unlock(&manager->lock);
+  }
+  return res;
+}
+
+/**
+ * @brief Join a multicast group on every network interface of the group's IP type.
+ *
+ * Uses the interfaces reported by etcpal_netint_get_interfaces(). Each interface index is joined
+ * once, even if it has several addresses. Interfaces on which the join fails are skipped.
+ *
+ * @param[in] manager Manager through which to join the group.
+ * @param[in] socket Socket on which to join the group.
+ * @param[in] group The group to join.
+ * @param[out] num_joined Optional: filled in with the number of interfaces joined.
+ * @return #kEtcPalErrOk: The group was joined on at least one interface.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return #kEtcPalErrNoNetints: No network interfaces of the group's IP type were found.
+ * @return Otherwise, the error from the last interface on which the join failed.
+ */
+etcpal_error_t etcpal_mcast_join_all_netints(EtcPalMcastManager* manager,
+                                             etcpal_socket_t     socket,
+                                             const EtcPalIpAddr* group,
+                                             size_t*             num_joined)
+{
+  if (num_joined)
+    *num_joined = 0;
+  if (!manager || socket == ETCPAL_SOCKET_INVALID || !group || !etcpal_ip_is_multicast(group))
+    return kEtcPalErrInvalid;
+
+  const EtcPalNetintInfo* netints = etcpal_netint_get_interfaces();
+  size_t                  num_netints = etcpal_netint_get_num_interfaces();
+
+  if (!etcpal_mutex_lock(&manager->lock))
+    return kEtcPalErrSys;
+
+  etcpal_error_t res = kEtcPalErrNoNetints;
+  size_t         joined = 0;
+  for (size_t i = 0; i < num_netints; ++i)
+  {
+    const EtcPalNetintInfo* netint = &netints[i];
+    if (netint->addr.type != group->type)
+      continue;
+
+    // Interfaces with several addresses appear more than once; only join on the first entry.
+    bool seen = false;
+    for (size_t j = 0; j < i && !seen; ++j)
+      seen = (netints[j].index == netint->index && netints[j].addr.type == group->type);
+    if (seen)
+      continue;
+
+    EtcPalGroupReq req;
+    req.ifindex = netint->index;
+    req.group = *group;
+    etcpal_error_t join_res = join_locked(manager, socket, &req);
+    if (join_res == kEtcPalErrOk)
+      ++joined;
+    else
+      res = join_res;
+  }
+
+  etcpal_mutex_unlock(&manager->lock);
+
+  if (num_joined)
+    *num_joined = joined;
+  return (joined > 0 ? kEtcPalErrOk : res);
+}
+
+/**
+ * @brief Release the references added by etcpal_mcast_join_all_netints().
+ *
+ * Releases one reference to the socket's membership of the group on each network interface of the
+ * group's IP type which the manager tracks.
+ *
+ * @param[in] manager Manager through which the group was joined.
+ * @param[in] socket Socket on which the group was joined.
+ * @param[in] group The group to leave.
+ * @return #kEtcPalErrOk: References released.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return #kEtcPalErrNotFound: The socket is not a member of the group on any interface through
+ *         this manager.
+ * @return Other codes translated from system error codes are possible if queued leaves were issued
+ *         and one of them failed.
+ */
+etcpal_error_t etcpal_mcast_leave_all_netints(EtcPalMcastManager* manager,
+                                              etcpal_socket_t     socket,
+                                              const EtcPalIpAddr* group)
+{
+  if (!manager || socket == ETCPAL_SOCKET_INVALID || !group)
+    return kEtcPalErrInvalid;
+
+  const EtcPalNetintInfo* netints = etcpal_netint_get_interfaces();
+  size_t                  num_netints = etcpal_netint_get_num_interfaces();
+
+  if (!etcpal_mutex_lock(&manager->lock))
+    return kEtcPalErrSys;
+
+  etcpal_error_t res = kEtcPalErrNotFound;
+  for (size_t i = 0; i < num_netints; ++i)
+  {
+    if (netints[i].addr.type != group->type)
+      continue;
+
+    // Each membership holds one reference per etcpal_mcast_join_all_netints() call, so only
+    // release one for each interface index.
+    bool seen = false;
+    for (size_t j = 0; j < i && !seen; ++j)
+      seen = (netints[j].index == netints[i].index && netints[j].addr.type == group->type);
+    if (seen)
+      continue;
+
+    EtcPalGroupReq req;
+    req.ifindex = netints[i].index;
+    req.group = *group;
+    etcpal_error_t leave_res = leave_locked(manager, socket, &req);
+    if (leave_res == kEtcPalErrOk && res == kEtcPalErrNotFound)
+      res = kEtcPalErrOk;
+    else if (leave_res != kEtcPalErrOk && leave_res != kEtcPalErrNotFound)
+      res = leave_res;
+  }
+
+  etcpal_mutex_unlock(&manager->lock);
+  return res;
+}
+
+/**
+ * @brief Issue all queued leaves.
+ *
+ * @param[in] manager Manager for which to issue the queued leaves.
+ * @return #kEtcPalErrOk: All queued leaves issued.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return Otherwise, the error from the last leave which failed. The membership is forgotten
+ *         regardless.
+ */
+etcpal_error_t etcpal_mcast_flush_leaves(EtcPalMcastManager* manager)
+{
+  if (!manager)
+    return kEtcPalErrInvalid;
+
+  etcpal_error_t res = kEtcPalErrSys;
+  if (etcpal_mutex_lock(&manager->lock))
+  {
+    res = flush_leaves_locked(manager);
+    etcpal_mutex_unlock(&manager->lock);
+  }
+  return res;
+}
+
+/**
+ * @brief Forget all memberships of a socket, without leaving the groups.
+ *
+ * Call this before closing a socket whose memberships are managed; closing the socket drops its
+ * memberships in the network stack. Any leaves queued for the socket are discarded.
+ *
+ * @param[in] manager Manager through which the socket's groups were joined.
+ * @param[in] socket Socket to forget.
+ */
+void etcpal_mcast_remove_socket(EtcPalMcastManager* manager, etcpal_socket_t socket)
+{
+  if (!manager || socket == ETCPAL_SOCKET_INVALID)
+    return;
+
+  if (!etcpal_mutex_lock(&manager->lock))
+    return;
+
+  size_t num_memberships = etcpal_rbtree_size(&manager->memberships);
+  if (num_memberships == 0)
+  {
+    etcpal_mutex_unlock(&manager->lock);
+    return;
+  }
+
+  // Memberships are ordered by socket first, so the socket's memberships are contiguous. The tree
+  // can't be modified during iteration, so they are collected first.
+  size_t            num_found = 0;
+  McastMembership** found = (McastMembership**)malloc(num_memberships * sizeof(McastMembership*));
+  if (found)
+  {
+    EtcPalRbIter iter;
+    etcpal_rbiter_init(&iter);
+    for (McastMembership* membership = (McastMembership*)etcpal_rbiter_first(&iter, &manager->memberships);
+         membership; membership = (McastMembership*)etcpal_rbiter_next(&iter))
+    {
+      if (membership->socket == socket)
+        found[num_found++] = membership;
+      else if (num_found > 0)
+        break;
+    }
+
+    for (size_t i = 0; i < num_found; ++i)
+    {
+      McastMembership* membership = found[i];
+      if (membership->refcount == 0)
+        dequeue_leave(manager, membership);
+      else
+        manager->stats.num_references -= membership->refcount;
+      --manager->stats.num_memberships;
+      etcpal_rbtree_remove(&manager->memberships, membership);
+    }
+    free(found);
+  }
+
+  etcpal_mutex_unlock(&manager->lock);
+}
+
+/**
+ * @brief Get statistics about the memberships tracked by a multicast manager.
+ *
+ * @param[in] manager Manager for which to get statistics.
+ * @param[out] stats Filled in with the statistics.
+ * @return #kEtcPalErrOk: Statistics retrieved.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ */
+etcpal_error_t etcpal_mcast_get_stats(EtcPalMcastManager* manager, EtcPalMcastStats* stats)
+{
+  if (!manager || !stats)
+    return kEtcPalErrInvalid;
+
+  if (!etcpal_mutex_lock(&manager->lock))
+    return kEtcPalErrSys;
+  *stats = manager->stats;
+  etcpal_mutex_unlock(&manager->lock);
+  return kEtcPalErrOk;
+}
+
+etcpal_error_t join_locked(EtcPalMcastManager* manager, etcpal_socket_t socket, const EtcPalGroupReq* req)
+{
+  McastMembership* membership = find_membership(manager, socket, req);
+  if (membership)
+  {
+    if (membership->refcount == 0)
+    {
+      dequeue_leave(manager, membership);
+      ++manager->stats.cancelled_leaves;
+    }
+    else
+    {
+      ++manager->stats.deduplicated_joins;
+    }
+    ++membership->refcount;
+    ++manager->stats.num_references;
+    return kEtcPalErrOk;
+  }
+
+  membership = (McastMembership*)calloc(1, sizeof(McastMembership));
+  if (!membership)
+    return kEtcPalErrNoMem;
+  membership->socket = socket;
+  membership->req = *req;
+  membership->refcount = 1;
+
+  etcpal_error_t res = set_membership(socket, req, true);
+  if (res == kEtcPalErrNoMem && manager->pending_head)
+  {
+    // The network stack is out of membership resources; make room by issuing the queued leaves.
+    flush_leaves_locked(manager);
+    res = set_membership(socket, req, true);
+  }
+  if (res != kEtcPalErrOk)
+  {
+    ++manager->stats.failed_operations;
+    free(membership);
+    return res;
+  }
+  ++manager->stats.kernel_joins;
+
+  etcpal_rbnode_init(&membership->node, membership);
+  res = etcpal_rbtree_insert_node(&manager->memberships, &membership->node);
+  if (res != kEtcPalErrOk)
+  {
+    set_membership(socket, req, false);
+    free(membership);
+    return res;
+  }
+  ++manager->stats.num_memberships;
+  ++manager->stats.num_references;
+  return kEtcPalErrOk;
+}
+
+etcpal_error_t leave_locked(EtcPalMcastManager* manager, etcpal_socket_t socket, const EtcPalGroupReq* req)
+{
+  McastMembership* membership = find_membership(manager, socket, req);
+  if (!membership || membership->refcount == 0)
+    return kEtcPalErrNotFound;
+
+  --manager->stats.num_references;
+  if (--membership->refcount > 0)
+    return kEtcPalErrOk;
+
+  queue_leave(manager, membership);
+  if (manager->stats.num_pending_leaves > manager->config.max_pending_leaves)
+    return flush_leaves_locked(manager);
+  return kEtcPalErrOk;
+}
+
+etcpal_error_t flush_leaves_locked(EtcPalMcastManager* manager)
+{
+  etcpal_error_t res = kEtcPalErrOk;
+  while (manager->pending_head)
+  {
+    McastMembership* membership = manager->pending_head;
+    dequeue_leave(manager, membership);
+
+    etcpal_error_t leave_res = set_membership(membership->socket, &membership->req, false);
+    if (leave_res == kEtcPalErrOk)
+    {
+      ++manager->stats.kernel_leaves;
+    }
+    else
+    {
+      ++manager->stats.failed_operations;
+      res = leave_res;
+    }
+
+    --manager->stats.num_memberships;
+    etcpal_rbtree_remove(&manager->memberships, membership);
+  }
+  return res;
+}
+
+McastMembership* find_membership(EtcPalMcastManager* manager, etcpal_socket_t socket, const EtcPalGroupReq* req)
+{
+  McastMembership key;
+  key.socket = socket;
+  key.req = *req;
+  return (McastMembership*)etcpal_rbtree_find(&manager->memberships, &key);
+}
+
+void queue_leave(EtcPalMcastManager* manager, McastMembership* membership)
+{
+  membership->prev_pending = manager->pending_tail;
+  membership->next_pending = NULL;
+  if (manager->pending_tail)
+    manager->pending_tail->next_pending = membership;
+  else
+    manager->pending_head = membership;
+  manager->pending_tail = membership;
+  ++manager->stats.num_pending_leaves;
+}
+
+void dequeue_leave(EtcPalMcastManager* manager, McastMembership* membership)
+{
+  if (membership->prev_pending)
+    membership->prev_pending->next_pending = membership->next_pending;
+  else
+    manager->pending_head = membership->next_pending;
+  if (membership->next_pending)
+    membership->next_pending->prev_pending = membership->prev_pending;
+  else
+    manager->pending_tail = membership->prev_pending;
+  membership->prev_pending = NULL;
+  membership->next_pending = NULL;
+  --manager->stats.num_pending_leaves;
+}
+
+etcpal_error_t set_membership(etcpal_socket_t socket, const EtcPalGroupReq* req, bool join)
+{
+  int level = (ETCPAL_IP_IS_V6(&req->group) ? ETCPAL_IPPROTO_IPV6 : ETCPAL_IPPROTO_IP);
+  int option = (join ? ETCPAL_MCAST_JOIN_GROUP : ETCPAL_MCAST_LEAVE_GROUP);
+  return etcpal_setsockopt(socket, level, option, req, sizeof(EtcPalGroupReq));
+}
+
+int membership_cmp(const EtcPalRbTree* self, const void* value_a, const void* value_b)
+{
+  ETCPAL_UNUSED_ARG(self);
+  const McastMembership* a = (const McastMembership*)value_a;
+  const McastMembership* b = (const McastMembership*)value_b;
+
+  if (a->socket != b->socket)
+    return (a->socket < b->socket ? -1 : 1);
+  if (a->req.ifindex != b->req.ifindex)
+    return (a->req.ifindex < b->req.ifindex ? -1 : 1);
+  return etcpal_ip_cmp(&a->req.group, &b->req.group);
+}
+
+void free_membership_node(EtcPalRbNode* node)
+{
+  free(node);
+}
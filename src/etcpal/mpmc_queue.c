@@ -0,0 +1,483 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+#include "etcpal/mpmc_queue.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "etcpal/timer.h"
+
+#if defined(_MSC_VER)
+#include <windows.h>
+#endif
+
+/*************************** Private definitions *****************************/
+
+// This is Dmitry Vyukov's bounded MPMC queue. Each slot holds a sequence number followed by an
+// item. The send and receive positions are free-running counters, and a slot is at its position
+// masked by the capacity:
+//
+// - A slot whose sequence number equals the send position is free for that send. The sender claims
+//   it by advancing the send position with a compare-and-swap, copies its item in, and then stores
+//   position + 1 to the sequence number, which publishes the item.
+// - A slot whose sequence number equals the receive position + 1 holds the item for that receive.
+//   The receiver claims it the same way, copies the item out, and then stores position + capacity
+//   to the sequence number, which frees the slot for the send one lap later.
+//
+// A sequence number behind the position means that the queue is full (or empty, for receives).
+#if defined(_MSC_VER)
+#define POS_LOAD_RELAXED(pos_ptr) (*(volatile const size_t*)(pos_ptr))
+#define WAITERS_LOAD(waiters_ptr) (*(volatile const int*)(waiters_ptr))
+#define WAITERS_INCREMENT(waiters_ptr) (void)InterlockedIncrement((volatile long*)(waiters_ptr))
+#define WAITERS_DECREMENT(waiters_ptr) (void)InterlockedDecrement((volatile long*)(waiters_ptr))
+#define FULL_FENCE() MemoryBarrier()
+#else
+#define POS_LOAD_RELAXED(pos_ptr) __atomic_load_n((pos_ptr), __ATOMIC_RELAXED)
+#define WAITERS_LOAD(waiters_ptr) __atomic_load_n((waiters_ptr), __ATOMIC_RELAXED)
+#define WAITERS_INCREMENT(waiters_ptr) (void)__atomic_fetch_add((waiters_ptr), 1, __ATOMIC_SEQ_CST)
+#define WAITERS_DECREMENT(waiters_ptr) (void)__atomic_fetch_sub((waiters_ptr), 1, __ATOMIC_SEQ_CST)
+#define FULL_FENCE() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
+
+#define SLOT_SEQ(queue, pos) ((size_t*)&(queue)->slots[((pos) & (queue)->mask) * (queue)->slot_size])
+#define SLOT_DATA(seq_ptr) ((uint8_t*)(seq_ptr) + sizeof(size_t))
+
+/*********************** Private function prototypes *************************/
+
+static size_t seq_load_acquire(const size_t* seq);
+static void   seq_store_release(size_t* seq, size_t val);
+static bool   pos_compare_exchange(size_t* pos, size_t expected, size_t desired);
+
+static bool push(EtcPalMpmcQueue* queue, const void* data);
+static bool pop(EtcPalMpmcQueue* queue, void* data);
+static void wake_receivers(EtcPalMpmcQueue* queue, bool only_if_not_empty);
+static void wake_senders(EtcPalMpmcQueue* queue, bool only_if_not_full);
+static int  remaining_timeout(const EtcPalTimer* timer, int timeout_ms);
+
+/*************************** Function definitions ****************************/
+
+/**
+ * @brief Create a new MPMC queue.
+ *
+ * @param[out] queue Queue to initialize.
+ * @param[in] size The minimum number of items the queue must hold. Rounded up to the next power of
+ *                 two, with a minimum of 2.
+ * @param[in] element_size The size in bytes of each item.
+ * @param[in] blocking Whether the queue supports waiting with etcpal_mpmc_queue_send(),
+ *                     etcpal_mpmc_queue_receive() and their timed variants.
+ * @return true: The queue was created.
+ * @return false: Invalid argument, or a failure to allocate the queue's memory or signals.
+ */
+bool etcpal_mpmc_queue_create(EtcPalMpmcQueue* queue, size_t size, size_t element_size, bool blocking)
+{
+  if (!queue || size == 0 || element_size == 0 || size > (SIZE_MAX / 2) + 1 ||
+      element_size > SIZE_MAX - 2 * sizeof(size_t))
+  {
+    return false;
+  }
+
+  // Each slot's sequence number must be aligned.
+  size_t slot_size = ((sizeof(size_t) + element_size + sizeof(size_t) - 1) / sizeof(size_t)) * sizeof(size_t);
+
+  size_t capacity = 2;
+  while (capacity < size)
+    capacity <<= 1;
+  if (capacity > SIZE_MAX / slot_size)
+    return false;
+
+  memset(queue, 0, sizeof(EtcPalMpmcQueue));
+  queue->slots = (uint8_t*)malloc(capacity * slot_size);
+  if (!queue->slots)
+    return false;
+
+  if (blocking)
+  {
+    if (!etcpal_signal_create(&queue->data_available))
+    {
+      free(queue->slots);
+      queue->slots = NULL;
+      return false;
+    }
+    if (!etcpal_signal_create(&queue->space_available))
+    {
+      etcpal_signal_destroy(&queue->data_available);
+      free(queue->slots);
+      queue->slots = NULL;
+      return false;
+    }
+  }
+
+  queue->slot_size = slot_size;
+  queue->capacity = capacity;
+  queue->mask = capacity - 1;
+  queue->element_size = element_size;
+  queue->blocking = blocking;
+  for (size_t i = 0; i < capacity; ++i)
+    *SLOT_SEQ(queue, i) = i;
+  return true;
+}
+
+/**
+ * @brief Destroy an MPMC queue.
+ *
+ * Any items still in the queue are discarded. No other threads may be using the queue.
+ *
+ * @param[in] queue Queue to destroy.
+ */
+void etcpal_mpmc_queue_destroy(EtcPalMpmcQueue* queue)
+{
+  if (!queue || !queue->slots)
+    return;
+
+  if (queue->blocking)
+  {
+    etcpal_signal_destroy(&queue->data_available);
+    etcpal_signal_destroy(&queue->space_available);
+  }
+  free(queue->slots);
+  queue->slots = NULL;
+}
+
+/**
+ * @brief Add an item to an MPMC queue if there is room for it.
+ *
+ * @param[in] queue Queue to add to.
+ * @param[in] data The item to copy into the queue, which is element_size bytes long.
+ * @return true: The item was added.
+ * @return false: The queue is full, or invalid argument.
+ */
+bool etcpal_mpmc_queue_try_send(EtcPalMpmcQueue* queue, const void* data)
+{
+  if (!queue || !data)
+    return false;
+
+  if (!push(queue, data))
+    return false;
+  wake_receivers(queue, false);
+  return true;
+}
+
+/**
+ * @brief Add an item to an MPMC queue, waiting for room if it is full.
+ *
+ * See etcpal_mpmc_queue_timed_send().
+ *
+ * @param[in] queue Queue to add to.
+ * @param[in] data The item to copy into the queue, which is element_size bytes long.
+ * @return true: The item was added.
+ * @return false: The queue is full and was created without blocking support, or invalid argument.
+ */
+bool etcpal_mpmc_queue_send(EtcPalMpmcQueue* queue, const void* data)
+{
+  return etcpal_mpmc_queue_timed_send(queue, data, ETCPAL_WAIT_FOREVER);
+}
+
+/**
+ * @brief Add an item to an MPMC queue, waiting up to a timeout for room if it is full.
+ *
+ * If the queue was created without blocking support, this returns immediately like
+ * etcpal_mpmc_queue_try_send().
+ *
+ * The timeout is only honored on platforms where #ETCPAL_MPMC_QUEUE_HAS_TIMED_FUNCTIONS is 1; on
+ * other platforms any timeout other than 0 waits indefinitely.
+ *
+ * @param[in] queue Queue to add to.
+ * @param[in] data The item to copy into the queue, which is element_size bytes long.
+ * @param[in] timeout_ms How long to wait for room in the queue, in milliseconds. 0 means return
+ *                       immediately; #ETCPAL_WAIT_FOREVER means wait indefinitely.
+ * @return true: The item was added.
+ * @return false: The timeout expired, or invalid argument.
+ */
+bool etcpal_mpmc_queue_timed_send(EtcPalMpmcQueue* queue, const void* data, int timeout_ms)
+{
+  if (!queue || !data)
+    return false;
+
+  bool sent = push(queue, data);
+  if (!sent && queue->blocking && timeout_ms != 0)
+  {
+    EtcPalTimer timer = {0};
+    if (timeout_ms > 0)
+      etcpal_timer_start(&timer, (uint32_t)timeout_ms);
+
+    // Announce the wait before checking again. Either the check sees the latest receive, or the
+    // receiver sees the waiter count after that receive and posts the signal.
+    WAITERS_INCREMENT(&queue->senders_waiting);
+    FULL_FENCE();
+    while (!sent)
+    {
+      sent = push(queue, data);
+      if (!sent && !etcpal_signal_timed_wait(&queue->space_available, remaining_timeout(&timer, timeout_ms)))
+        break;
+    }
+    WAITERS_DECREMENT(&queue->senders_waiting);
+
+    // Posts of the signal can coalesce while several senders are waiting, so pass the wakeup on to
+    // the next one if there is still room.
+    if (sent)
+      wake_senders(queue, true);
+  }
+
+  if (sent)
+    wake_receivers(queue, false);
+  return sent;
+}
+
+/**
+ * @brief Remove the oldest item from an MPMC queue if there is one.
+ *
+ * @param[in] queue Queue to remove from.
+ * @param[out] data Filled in with the item, which is element_size bytes long.
+ * @return true: An item was removed.
+ * @return false: The queue is empty, or invalid argument.
+ */
+bool etcpal_mpmc_queue_try_receive(EtcPalMpmcQueue* queue, void* data)
+{
+  if (!queue || !data)
+    return false;
+
+  if (!pop(queue, data))
+    return false;
+  wake_senders(queue, false);
+  return true;
+}
+
+/**
+ * @brief Remove the oldest item from an MPMC queue, waiting for one if it is empty.
+ *
+ * See etcpal_mpmc_queue_timed_receive().
+ *
+ * @param[in] queue Queue to remove from.
+ * @param[out] data Filled in with the item, which is element_size bytes long.
+ * @return true: An item was removed.
+ * @return false: The queue is empty and was created without blocking support, or invalid argument.
+ */
+bool etcpal_mpmc_queue_receive(EtcPalMpmcQueue* queue, void* data)
+{
+  return etcpal_mpmc_queue_timed_receive(queue, data, ETCPAL_WAIT_FOREVER);
+}
+
+/**
+ * @brief Remove the oldest item from an MPMC queue, waiting up to a timeout for one if it is
+ *        empty.
+ *
+ * If the queue was created without blocking support, this returns immediately like
+ * etcpal_mpmc_queue_try_receive().
+ *
+ * The timeout is only honored on platforms where #ETCPAL_MPMC_QUEUE_HAS_TIMED_FUNCTIONS is 1; on
+ * other platforms any timeout other than 0 waits indefinitely.
+ *
+ * @param[in] queue Queue to remove from.
+ * @param[out] data Filled in with the item, which is element_size bytes long.
+ * @param[in] timeout_ms How long to wait for an item, in milliseconds. 0 means return immediately;
+ *                       #ETCPAL_WAIT_FOREVER means wait indefinitely.
+ * @return true: An item was removed.
+ * @return false: The timeout expired, or invalid argument.
+ */
+bool etcpal_mpmc_queue_timed_receive(EtcPalMpmcQueue* queue, void* data, int timeout_ms)
+{
+  if (!queue || !data)
+    return false;
+
+  bool received = pop(queue, data);
+  if (!received && queue->blocking && timeout_ms != 0)
+  {
+    EtcPalTimer timer = {0};
+    if (timeout_ms > 0)
+      etcpal_timer_start(&timer, (uint32_t)timeout_ms);
+
+    // The mirror image of the wait in etcpal_mpmc_queue_timed_send().
+    WAITERS_INCREMENT(&queue->receivers_waiting);
+    FULL_FENCE();
+    while (!received)
+    {
+      received = pop(queue, data);
+      if (!received && !etcpal_signal_timed_wait(&queue->data_available, remaining_timeout(&timer, timeout_ms)))
+        break;
+    }
+    WAITERS_DECREMENT(&queue->receivers_waiting);
+
+    if (received)
+      wake_receivers(queue, true);
+  }
+
+  if (received)
+    wake_senders(queue, false);
+  return received;
+}
+
+/**
+ * @brief Get the number of items an MPMC queue can hold.
+ *
+ * @param[in] queue Queue to check.
+ * @return The capacity of the queue, which is the size it was created with rounded up to a power of
+ *         two, or 0 if the queue is invalid.
+ */
+size_t etcpal_mpmc_queue_capacity(const EtcPalMpmcQueue* queue)
+{
+  return (queue ? queue->capacity : 0);
+}
+
+/**
+ * @brief Get the number of items in an MPMC queue.
+ *
+ * Items which are being copied in by a send or out by a receive at the time of the call are
+ * counted as well. When other threads are using the queue, the result may already be out of date by
+ * the time it is returned.
+ *
+ * @param[in] queue Queue to check.
+ * @return The number of items in the queue, or 0 if the queue is invalid.
+ */
+size_t etcpal_mpmc_queue_slots_used(const EtcPalMpmcQueue* queue)
+{
+  if (!queue)
+    return 0;
+
+  // Read the receive position first, so that concurrent receives can only make the result too
+  // large, and clamp it in case concurrent sends and receives leave it beyond the capacity.
+  size_t receive_pos = seq_load_acquire(&queue->receive_pos);
+  size_t send_pos = seq_load_acquire(&queue->send_pos);
+  size_t used = send_pos - receive_pos;
+  return (used > queue->capacity ? queue->capacity : used);
+}
+
+/**
+ * @brief Check whether an MPMC queue is empty.
+ *
+ * @param[in] queue Queue to check.
+ * @return Whether the queue holds no items. Invalid queues are considered empty.
+ */
+bool etcpal_mpmc_queue_is_empty(const EtcPalMpmcQueue* queue)
+{
+  return (etcpal_mpmc_queue_slots_used(queue) == 0);
+}
+
+size_t seq_load_acquire(const size_t* seq)
+{
+#if defined(_MSC_VER)
+  size_t val = *(volatile const size_t*)seq;
+  MemoryBarrier();
+  return val;
+#else
+  return __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+#endif
+}
+
+void seq_store_release(size_t* seq, size_t val)
+{
+#if defined(_MSC_VER)
+  MemoryBarrier();
+  *(volatile size_t*)seq = val;
+#else
+  __atomic_store_n(seq, val, __ATOMIC_RELEASE);
+#endif
+}
+
+bool pos_compare_exchange(size_t* pos, size_t expected, size_t desired)
+{
+#if defined(_MSC_VER)
+  return (InterlockedCompareExchangePointer((PVOID volatile*)pos, (PVOID)desired, (PVOID)expected) == (PVOID)expected);
+#else
+  return __atomic_compare_exchange_n(pos, &expected, desired, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+#endif
+}
+
+bool push(EtcPalMpmcQueue* queue, const void* data)
+{
+  size_t  pos = POS_LOAD_RELAXED(&queue->send_pos);
+  size_t* seq_ptr;
+  for (;;)
+  {
+    seq_ptr = SLOT_SEQ(queue, pos);
+    intptr_t diff = (intptr_t)seq_load_acquire(seq_ptr) - (intptr_t)pos;
+    if (diff == 0)
+    {
+      if (pos_compare_exchange(&queue->send_pos, pos, pos + 1))
+        break;
+    }
+    else if (diff < 0)
+    {
+      return false;
+    }
+    pos = POS_LOAD_RELAXED(&queue->send_pos);
+  }
+
+  memcpy(SLOT_DATA(seq_ptr), data, queue->element_size);
+  seq_store_release(seq_ptr, pos + 1);
+  return true;
+}
+
+bool pop(EtcPalMpmcQueue* queue, void* data)
+{
+  size_t  pos = POS_LOAD_RELAXED(&queue->receive_pos);
+  size_t* seq_ptr;
+  for (;;)
+  {
+    seq_ptr = SLOT_SEQ(queue, pos);
+    intptr_t diff = (intptr_t)seq_load_acquire(seq_ptr) - (intptr_t)(pos + 1);
+    if (diff == 0)
+    {
+      if (pos_compare_exchange(&queue->receive_pos, pos, pos + 1))
+        break;
+    }
+    else if (diff < 0)
+    {
+      return false;
+    }
+    pos = POS_LOAD_RELAXED(&queue->receive_pos);
+  }
+
+  memcpy(data, SLOT_DATA(seq_ptr), queue->element_size);
+  seq_store_release(seq_ptr, pos + queue->capacity);
+  return true;
+}
+
+// Called after a send. The fence orders the published item before the read of the waiter count,
+// pairing with the fence in etcpal_mpmc_queue_timed_receive().
+void wake_receivers(EtcPalMpmcQueue* queue, bool only_if_not_empty)
+{
+  if (queue->blocking)
+  {
+    FULL_FENCE();
+    if (WAITERS_LOAD(&queue->receivers_waiting) > 0 && (!only_if_not_empty || !etcpal_mpmc_queue_is_empty(queue)))
+      etcpal_signal_post(&queue->data_available);
+  }
+}
+
+// Called after a receive; the mirror image of wake_receivers().
+void wake_senders(EtcPalMpmcQueue* queue, bool only_if_not_full)
+{
+  if (queue->blocking)
+  {
+    FULL_FENCE();
+    if (WAITERS_LOAD(&queue->senders_waiting) > 0 &&
+        (!only_if_not_full || etcpal_mpmc_queue_slots_used(queue) < queue->capacity))
+    {
+      etcpal_signal_post(&queue->space_available);
+    }
+  }
+}
+
+int remaining_timeout(const EtcPalTimer* timer, int timeout_ms)
+{
+  if (timeout_ms < 0)
+    return ETCPAL_WAIT_FOREVER;
+  return (int)etcpal_timer_remaining(timer);
+}
@@ -69,6 +69,24 @@
 #define ETCPAL_EMBOS_MAX_NETINTS 5
 #endif
 
+/**
+ * @brief Whether the socket functions update the counters of the @ref etcpal_socket_stats module.
+ *
+ * When this is 0, the counting code is compiled out of the socket functions. Only supported on
+ * Linux, macOS and Windows; leave it at 0 on other platforms.
+ */
+#ifndef ETCPAL_SOCKET_STATS
+#define ETCPAL_SOCKET_STATS 0
+#endif
+
+/**
+ * @brief The maximum number of sockets which can be tracked with etcpal_socket_stats_track() at the
+ *        same time.
+ */
+#ifndef ETCPAL_SOCKET_STATS_MAX_TRACKED
+#define ETCPAL_SOCKET_STATS_MAX_TRACKED 64
+#endif
+
 /**
  * @}
  */
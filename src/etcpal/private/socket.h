@@ -20,9 +20,21 @@
 #ifndef ETCPAL_PRIVATE_SOCKET_H_
 #define ETCPAL_PRIVATE_SOCKET_H_
 
+#include <stddef.h>
+#include <stdint.h>
 #include "etcpal/error.h"
+#include "etcpal/socket.h"
 
 etcpal_error_t etcpal_socket_init(void);
 void           etcpal_socket_deinit(void);
 
+// Shared software fallback for etcpal_sendto_segmented(); see src/etcpal/socket_segments.c.
+int etcpal_sendto_segments_fallback(etcpal_socket_t       id,
+                                    const uint8_t*        buf,
+                                    size_t                length,
+                                    size_t                segment_size,
+                                    int                   flags,
+                                    const EtcPalSockAddr* dest_addr,
+                                    size_t                num_sent);
+
 #endif /* ETCPAL_PRIVATE_SOCKET_H_ */
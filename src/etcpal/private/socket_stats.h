@@ -0,0 +1,71 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+#ifndef ETCPAL_PRIVATE_SOCKET_STATS_H_
+#define ETCPAL_PRIVATE_SOCKET_STATS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "etcpal/socket.h"
+#include "etcpal/private/opts.h"
+
+/*
+ * Hooks through which the platform socket implementations update the counters of the
+ * etcpal/socket_stats.h module. Each of them compiles to nothing unless ETCPAL_SOCKET_STATS is
+ * enabled.
+ *
+ * The res arguments are the return values of the instrumented functions: a byte count (or, for the
+ * batch hooks, a message count) on success, or a negative etcpal_error_t on failure.
+ */
+
+#if ETCPAL_SOCKET_STATS
+
+void     etcpal_socket_stats_record_recv(etcpal_socket_t id, int res, size_t num_bytes, size_t num_truncated);
+void     etcpal_socket_stats_record_send(etcpal_socket_t id, int res, size_t num_bytes);
+void     etcpal_socket_stats_record_poll_wait(uint64_t start_us, int res);
+uint64_t etcpal_socket_stats_now_us(void);
+
+// A single receive call, which returned res bytes or an error.
+#define ETCPAL_SOCKET_STATS_RECV(id, res) \
+  etcpal_socket_stats_record_recv((id), ((res) >= 0 ? 1 : (res)), ((res) >= 0 ? (size_t)(res) : 0), 0)
+// A receive call of one or more messages; res is the number of messages or an error.
+#define ETCPAL_SOCKET_STATS_RECV_BATCH(id, res, num_bytes, num_truncated) \
+  etcpal_socket_stats_record_recv((id), (res), (num_bytes), (num_truncated))
+// A single send call, which returned res bytes or an error.
+#define ETCPAL_SOCKET_STATS_SEND(id, res) \
+  etcpal_socket_stats_record_send((id), ((res) >= 0 ? 1 : (res)), ((res) >= 0 ? (size_t)(res) : 0))
+// A send call of one or more messages; res is the number of messages or an error.
+#define ETCPAL_SOCKET_STATS_SEND_BATCH(id, res, num_bytes) etcpal_socket_stats_record_send((id), (res), (num_bytes))
+// Declares a variable holding the start time of a poll wait.
+#define ETCPAL_SOCKET_STATS_POLL_START(start_var) uint64_t start_var = etcpal_socket_stats_now_us()
+// A poll wait which began at start_var; res is the number of events or an error.
+#define ETCPAL_SOCKET_STATS_POLL_DONE(start_var, res) etcpal_socket_stats_record_poll_wait((start_var), (res))
+
+#else
+
+#define ETCPAL_SOCKET_STATS_RECV(id, res)
+#define ETCPAL_SOCKET_STATS_RECV_BATCH(id, res, num_bytes, num_truncated)
+#define ETCPAL_SOCKET_STATS_SEND(id, res)
+#define ETCPAL_SOCKET_STATS_SEND_BATCH(id, res, num_bytes)
+#define ETCPAL_SOCKET_STATS_POLL_START(start_var)
+#define ETCPAL_SOCKET_STATS_POLL_DONE(start_var, res)
+
+#endif
+
+#endif /* ETCPAL_PRIVATE_SOCKET_STATS_H_ */
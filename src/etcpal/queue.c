@@ -49,106 +49,264 @@ static inline void unlock_from_isr(const etcpal_queue_t* queue)
   (void)etcpal_sem_post_from_isr((etcpal_sem_t*)&queue->lock);
 }
 
-static inline bool push_data_timed(etcpal_queue_t* queue, const void* data, int timeout_ms)
+// The states of the slots in the ring. Slots are handed out to senders and receivers in order, but
+// those with in-place access may finish with them out of order; the head only moves past a slot
+// once its sender is done with it, and the tail once its receiver is.
+#define SLOT_FREE      0
+#define SLOT_RESERVED  1
+#define SLOT_COMMITTED 2
+#define SLOT_ABORTED   3
+#define SLOT_CLAIMED   4
+#define SLOT_RELEASED  5
+
+static inline uint8_t* slot(const etcpal_queue_t* queue, size_t index)
 {
-  bool true_if_success = false;
+  return &queue->buf[index * queue->element_size];
+}
 
-  if (wait_for_space_timed(queue, timeout_ms))
-  {
-    lock(queue);
+static inline size_t slot_index(const etcpal_queue_t* queue, const void* item)
+{
+  return (size_t)((const uint8_t*)item - queue->buf) / queue->element_size;
+}
 
-    memcpy(queue->node_list[queue->head].data, data, queue->element_size);
+static inline unsigned next_index(const etcpal_queue_t* queue, unsigned index)
+{
+  return (unsigned)((index + 1) % (queue->max_queue_size + 1));
+}
 
-    queue->head++;
-    queue->head %= (queue->max_queue_size + 1);
-    queue->queue_size++;
+// The number of slots not free for sending, including those still held by in-place senders and
+// receivers.
+static inline size_t slots_in_use(const etcpal_queue_t* queue)
+{
+  size_t ring_size = queue->max_queue_size + 1;
+  return (queue->reserve_pos + ring_size - queue->tail) % ring_size;
+}
 
-    true_if_success = true;
+// Posts a semaphore count times. Windows can do this in one call.
+static inline void post_many(etcpal_sem_t* sem, size_t count)
+{
+  if (count == 0)
+    return;
+
+#ifdef _WIN32
+  (void)ReleaseSemaphore(*sem, (LONG)count, NULL);
+#else
+  for (size_t i = 0; i < count; ++i)
+    (void)etcpal_sem_post(sem);
+#endif
+}
 
-    unlock(queue);
-    notify_data_available(queue);
-  }
+// Takes up to max_count from a semaphore, waiting up to timeout_ms for the first one only.
+static inline size_t wait_many(etcpal_sem_t* sem, size_t max_count, int timeout_ms)
+{
+  if (!etcpal_sem_timed_wait(sem, timeout_ms))
+    return 0;
 
-  return true_if_success;
+  size_t count = 1;
+  while (count < max_count && etcpal_sem_try_wait(sem))
+    ++count;
+  return count;
 }
 
-static inline bool push_data_from_isr(etcpal_queue_t* queue, const void* data)
+// Passes over aborted slots which have reached the front of the items waiting to be received.
+static inline void skip_aborted(etcpal_queue_t* queue)
 {
-  bool true_if_success = false;
+  while (queue->claim_pos != queue->head && queue->slot_states[queue->claim_pos] == SLOT_ABORTED)
+  {
+    queue->slot_states[queue->claim_pos] = SLOT_RELEASED;
+    queue->claim_pos = next_index(queue, queue->claim_pos);
+  }
+}
 
-  if (wait_for_space_timed(queue, 0))
+// Moves the head past the slots that senders are done with and the tail past the slots that
+// receivers are done with. Fills in the number of items made available to receivers and slots made
+// available to senders, which the caller posts once it has unlocked the queue.
+static void settle(etcpal_queue_t* queue, size_t* num_published, size_t* num_freed)
+{
+  size_t published = 0;
+  while (queue->head != queue->reserve_pos && queue->slot_states[queue->head] != SLOT_RESERVED)
   {
-    lock(queue);
+    if (queue->slot_states[queue->head] == SLOT_COMMITTED)
+      ++published;
+    queue->head = next_index(queue, queue->head);
+  }
+  queue->queue_size += published;
 
-    memcpy(queue->node_list[queue->head].data, data, queue->element_size);
+  skip_aborted(queue);
 
-    queue->head++;
-    queue->head %= (queue->max_queue_size + 1);
-    queue->queue_size++;
+  size_t freed = 0;
+  while (queue->tail != queue->claim_pos && queue->slot_states[queue->tail] == SLOT_RELEASED)
+  {
+    queue->slot_states[queue->tail] = SLOT_FREE;
+    queue->tail = next_index(queue, queue->tail);
+    ++freed;
+  }
 
-    true_if_success = true;
+  *num_published = published;
+  *num_freed = freed;
+}
 
-    unlock_from_isr(queue);
-    notify_data_available_from_isr(queue);
-  }
+static inline void notify(etcpal_queue_t* queue, size_t num_published, size_t num_freed)
+{
+  post_many(&queue->spots_filled, num_published);
+  post_many(&queue->spots_available, num_freed);
+}
 
-  return true_if_success;
+static inline void notify_from_isr(etcpal_queue_t* queue, size_t num_published, size_t num_freed)
+{
+  for (size_t i = 0; i < num_published; ++i)
+    (void)notify_data_available_from_isr(queue);
+  for (size_t i = 0; i < num_freed; ++i)
+    (void)notify_space_available_from_isr(queue);
 }
 
-static inline bool pop_data_timed(etcpal_queue_t* queue, void* data, int timeout_ms)
+// Copies count items into the ring at the reserve position, in at most two contiguous pieces. The
+// caller must hold the lock and have claimed count spots.
+static inline void copy_in(etcpal_queue_t* queue, const uint8_t* src, size_t count)
 {
-  bool true_if_success = false;
-  if (wait_for_data_timed(queue, timeout_ms))
+  size_t ring_size = queue->max_queue_size + 1;
+  size_t first_count = ring_size - queue->reserve_pos;
+  if (first_count > count)
+    first_count = count;
+
+  memcpy(slot(queue, queue->reserve_pos), src, first_count * queue->element_size);
+  memcpy(slot(queue, 0), &src[first_count * queue->element_size], (count - first_count) * queue->element_size);
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    queue->slot_states[queue->reserve_pos] = SLOT_COMMITTED;
+    queue->reserve_pos = next_index(queue, queue->reserve_pos);
+  }
+}
+
+// Copies count items out of the ring from the claim position, in contiguous runs between any
+// aborted slots and the end of the ring. The caller must hold the lock and have claimed count
+// items.
+static inline void copy_out(etcpal_queue_t* queue, uint8_t* dest, size_t count)
+{
+  size_t ring_size = queue->max_queue_size + 1;
+  while (count > 0)
   {
-    lock(queue);
-    memcpy(data, queue->node_list[queue->tail].data, queue->element_size);
+    skip_aborted(queue);
+
+    size_t run = 0;
+    while (run < count && queue->claim_pos + run < ring_size &&
+           queue->slot_states[queue->claim_pos + run] == SLOT_COMMITTED)
+    {
+      queue->slot_states[queue->claim_pos + run] = SLOT_RELEASED;
+      ++run;
+    }
 
-    queue->tail++;
-    queue->tail %= (queue->max_queue_size + 1);
+    memcpy(dest, slot(queue, queue->claim_pos), run * queue->element_size);
+    dest += run * queue->element_size;
+    queue->claim_pos = (unsigned)((queue->claim_pos + run) % ring_size);
+    queue->queue_size -= run;
+    count -= run;
+  }
+}
 
-    queue->queue_size--;
+static void send_items(etcpal_queue_t* queue, const void* data, size_t count, bool from_isr)
+{
+  size_t num_published = 0;
+  size_t num_freed = 0;
 
-    true_if_success = true;
+  lock(queue);
+  copy_in(queue, (const uint8_t*)data, count);
+  settle(queue, &num_published, &num_freed);
 
+  if (from_isr)
+  {
+    unlock_from_isr(queue);
+    notify_from_isr(queue, num_published, num_freed);
+  }
+  else
+  {
     unlock(queue);
-    notify_space_available(queue);
+    notify(queue, num_published, num_freed);
   }
-
-  return true_if_success;
 }
 
-static inline bool pop_data_from_isr(etcpal_queue_t* queue, void* data)
+static void receive_items(etcpal_queue_t* queue, void* data, size_t count, bool from_isr)
 {
-  bool true_if_success = false;
-  if (wait_for_data_timed(queue, 0))
+  size_t num_published = 0;
+  size_t num_freed = 0;
+
+  lock(queue);
+  copy_out(queue, (uint8_t*)data, count);
+  settle(queue, &num_published, &num_freed);
+
+  if (from_isr)
+  {
+    unlock_from_isr(queue);
+    notify_from_isr(queue, num_published, num_freed);
+  }
+  else
   {
-    lock(queue);
-    memcpy(data, queue->node_list[queue->tail].data, queue->element_size);
+    unlock(queue);
+    notify(queue, num_published, num_freed);
+  }
+}
 
-    queue->tail++;
-    queue->tail %= (queue->max_queue_size + 1);
+// Marks a slot obtained with etcpal_queue_reserve() or etcpal_queue_peek() as done with.
+static void finish_slot(etcpal_queue_t* queue, const void* item, uint8_t state)
+{
+  size_t num_published = 0;
+  size_t num_freed = 0;
 
-    queue->queue_size--;
+  lock(queue);
+  queue->slot_states[slot_index(queue, item)] = state;
+  settle(queue, &num_published, &num_freed);
+  unlock(queue);
 
-    true_if_success = true;
+  notify(queue, num_published, num_freed);
+}
 
-    unlock(queue);
-    notify_space_available_from_isr(queue);
-  }
+static inline bool push_data_timed(etcpal_queue_t* queue, const void* data, int timeout_ms)
+{
+  if (!wait_for_space_timed(queue, timeout_ms))
+    return false;
 
-  return true_if_success;
+  send_items(queue, data, 1, false);
+  return true;
 }
 
-bool etcpal_queue_create(etcpal_queue_t* id, size_t size, size_t item_size)
+static inline bool push_data_from_isr(etcpal_queue_t* queue, const void* data)
 {
-  // Initialize queue
-  memset(id, 0, sizeof(etcpal_queue_t));
+  if (!wait_for_space_timed(queue, 0))
+    return false;
+
+  send_items(queue, data, 1, true);
+  return true;
+}
+
+static inline bool pop_data_timed(etcpal_queue_t* queue, void* data, int timeout_ms)
+{
+  if (!wait_for_data_timed(queue, timeout_ms))
+    return false;
+
+  receive_items(queue, data, 1, false);
+  return true;
+}
+
+static inline bool pop_data_from_isr(etcpal_queue_t* queue, void* data)
+{
+  if (!wait_for_data_timed(queue, 0))
+    return false;
+
+  receive_items(queue, data, 1, true);
+  return true;
+}
 
+bool etcpal_queue_create(etcpal_queue_t* id, size_t size, size_t item_size)
+{
   if (!id)
   {
     return false;
   }
 
+  // Initialize queue
+  memset(id, 0, sizeof(etcpal_queue_t));
+
   id->element_size = item_size;
 
   // Initialize locks
@@ -162,21 +320,21 @@ bool etcpal_queue_create(etcpal_queue_t* id, size_t size, size_t item_size)
   if (!etcpal_sem_create(&id->spots_filled, 0, (unsigned)size))
   {
     etcpal_sem_destroy(&id->spots_available);
-    etcpal_sem_destroy(&id->spots_filled);
+    etcpal_sem_destroy(&id->lock);
     return false;
   }
 
-  // Circular buffers need space for an extra item
-  id->node_list = calloc(sizeof(EtcPalQueueNode), size + 1);
-  if (id->node_list)
-  {
-    for (unsigned item_index = 0; item_index < size + 1; item_index++)
-    {
-      id->node_list[item_index].data = calloc(item_size, 1);
-    }
-  }
-  else
+  // Circular buffers need space for an extra item. The items are stored contiguously so that
+  // batches of them can be copied at once.
+  id->buf = calloc(size + 1, item_size);
+  id->slot_states = calloc(size + 1, 1);
+  if (!id->buf || !id->slot_states)
   {
+    free(id->slot_states);
+    free(id->buf);
+    etcpal_sem_destroy(&id->spots_filled);
+    etcpal_sem_destroy(&id->spots_available);
+    etcpal_sem_destroy(&id->lock);
     return false;
   }
 
@@ -185,21 +343,16 @@ bool etcpal_queue_create(etcpal_queue_t* id, size_t size, size_t item_size)
 
   id->tail = 0;
   id->head = 0;
+  id->reserve_pos = 0;
+  id->claim_pos = 0;
   return true;
 }
 
 void etcpal_queue_destroy(etcpal_queue_t* id)
 {
   lock(id);
-  if (id->node_list)
-  {
-    for (unsigned item_index = 0; item_index < id->max_queue_size + 1; item_index++)
-    {
-      free(id->node_list[item_index].data);
-    }
-  }
-
-  free(id->node_list);
+  free(id->buf);
+  free(id->slot_states);
 
 #if ETCPAL_SEM_MUST_BE_BALANCED
   // Reset the semaphores to their initial counts before destroying
@@ -253,6 +406,17 @@ bool etcpal_queue_timed_receive(etcpal_queue_t* id, void* data, int timeout_ms)
   return true_if_success;
 }
 
+size_t etcpal_queue_send_many(etcpal_queue_t* id, const void* data, size_t num_items, int timeout_ms)
+{
+  if (!id || !data || num_items == 0)
+    return 0;
+
+  size_t num_sent = wait_many(&id->spots_available, num_items, timeout_ms);
+  if (num_sent > 0)
+    send_items(id, data, num_sent, false);
+  return num_sent;
+}
+
 bool etcpal_queue_send_from_isr(etcpal_queue_t* id, const void* data)
 {
   bool true_if_success = false;
@@ -262,6 +426,17 @@ bool etcpal_queue_send_from_isr(etcpal_queue_t* id, const void* data)
   return true_if_success;
 }
 
+size_t etcpal_queue_receive_many(etcpal_queue_t* id, void* data, size_t max_items, int timeout_ms)
+{
+  if (!id || !data || max_items == 0)
+    return 0;
+
+  size_t num_received = wait_many(&id->spots_filled, max_items, timeout_ms);
+  if (num_received > 0)
+    receive_items(id, data, num_received, false);
+  return num_received;
+}
+
 bool etcpal_queue_receive_from_isr(etcpal_queue_t* id, void* data)
 {
   bool true_if_success = false;
@@ -271,6 +446,62 @@ bool etcpal_queue_receive_from_isr(etcpal_queue_t* id, void* data)
   return true_if_success;
 }
 
+// The in-place functions only hold the queue's lock while handing out or taking back a slot, so
+// other senders and receivers carry on while the caller works on it.
+void* etcpal_queue_reserve(etcpal_queue_t* id, int timeout_ms)
+{
+  if (!id || !wait_for_space_timed(id, timeout_ms))
+    return NULL;
+
+  lock(id);
+  uint8_t* item = slot(id, id->reserve_pos);
+  id->slot_states[id->reserve_pos] = SLOT_RESERVED;
+  id->reserve_pos = next_index(id, id->reserve_pos);
+  unlock(id);
+
+  return item;
+}
+
+void etcpal_queue_commit(etcpal_queue_t* id, void* slot)
+{
+  if (!id || !slot)
+    return;
+
+  finish_slot(id, slot, SLOT_COMMITTED);
+}
+
+void etcpal_queue_abort(etcpal_queue_t* id, void* slot)
+{
+  if (!id || !slot)
+    return;
+
+  finish_slot(id, slot, SLOT_ABORTED);
+}
+
+void* etcpal_queue_peek(etcpal_queue_t* id, int timeout_ms)
+{
+  if (!id || !wait_for_data_timed(id, timeout_ms))
+    return NULL;
+
+  lock(id);
+  skip_aborted(id);
+  uint8_t* item = slot(id, id->claim_pos);
+  id->slot_states[id->claim_pos] = SLOT_CLAIMED;
+  id->claim_pos = next_index(id, id->claim_pos);
+  id->queue_size--;
+  unlock(id);
+
+  return item;
+}
+
+void etcpal_queue_release(etcpal_queue_t* id, const void* item)
+{
+  if (!id || !item)
+    return;
+
+  finish_slot(id, item, SLOT_RELEASED);
+}
+
 bool etcpal_queue_reset(etcpal_queue_t* id)
 {
   bool true_if_success = true;
@@ -281,6 +512,9 @@ bool etcpal_queue_reset(etcpal_queue_t* id)
 
   id->tail = 0;
   id->head = 0;
+  id->reserve_pos = 0;
+  id->claim_pos = 0;
+  memset(id->slot_states, SLOT_FREE, id->max_queue_size + 1);
 
   unlock(id);
   return true_if_success;
@@ -310,7 +544,7 @@ bool etcpal_queue_is_full(const etcpal_queue_t* id)
 {
   bool true_if_full = false;
   lock(id);
-  true_if_full = (id->queue_size == id->max_queue_size);
+  true_if_full = (slots_in_use(id) == id->max_queue_size);
   unlock(id);
   return true_if_full;
 }
@@ -320,7 +554,7 @@ bool etcpal_queue_is_full_from_isr(const etcpal_queue_t* id)
   bool true_if_full = true;
   if (lock(id))
   {
-    true_if_full = (id->queue_size == id->max_queue_size);
+    true_if_full = (slots_in_use(id) == id->max_queue_size);
     unlock_from_isr(id);
   }
   return true_if_full;
@@ -349,7 +583,7 @@ size_t etcpal_queue_slots_used_from_isr(const etcpal_queue_t* id)
 size_t etcpal_queue_slots_available(const etcpal_queue_t* id)
 {
   lock(id);
-  size_t elements = id->max_queue_size - id->queue_size;
+  size_t elements = id->max_queue_size - slots_in_use(id);
   unlock(id);
 
   return elements;
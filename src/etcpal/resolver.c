@@ -0,0 +1,531 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+#include "etcpal/resolver.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "etcpal/common.h"
+#include "etcpal/mutex.h"
+#include "etcpal/rbtree.h"
+#include "etcpal/signal.h"
+#include "etcpal/socket.h"
+#include "etcpal/timer.h"
+
+/****************************** Private types ********************************/
+
+typedef struct ResolverCacheEntry
+{
+  EtcPalRbNode node;  // Must be first: the tree frees entries through their node
+
+  char                hostname[ETCPAL_RESOLVER_MAX_HOSTNAME_LEN];
+  int                 family;
+  uint32_t            expiry;
+  etcpal_error_t      result;
+  EtcPalResolvedAddrs addrs;
+} ResolverCacheEntry;
+
+typedef struct ResolverRequest ResolverRequest;
+
+struct ResolverRequest
+{
+  char                   hostname[ETCPAL_RESOLVER_MAX_HOSTNAME_LEN];
+  int                    family;
+  EtcPalResolverCallback callback;
+  void*                  context;
+  ResolverRequest*       next;
+};
+
+struct EtcPalResolver
+{
+  EtcPalResolverConfig config;
+  etcpal_mutex_t       lock;
+  EtcPalRbTree         cache;
+
+  // Asynchronous lookups waiting for the worker thread, in the order they were requested.
+  ResolverRequest* queue_head;
+  ResolverRequest* queue_tail;
+  bool             running;
+  etcpal_signal_t  worker_signal;
+  etcpal_thread_t  worker_thread;
+};
+
+/*********************** Private function prototypes *************************/
+
+static int  cache_entry_cmp(const EtcPalRbTree* self, const void* value_a, const void* value_b);
+static void free_cache_entry_node(EtcPalRbNode* node);
+static int  compare_times(uint32_t a, uint32_t b);
+static bool hostname_is_valid(const char* hostname);
+static bool family_is_valid(int family);
+
+static bool           find_cached_locked(EtcPalResolver*      resolver,
+                                         const char*          hostname,
+                                         int                  family,
+                                         EtcPalResolvedAddrs* addrs,
+                                         etcpal_error_t*      result);
+static void           store_result_locked(EtcPalResolver*            resolver,
+                                          const char*                hostname,
+                                          int                        family,
+                                          etcpal_error_t             result,
+                                          const EtcPalResolvedAddrs* addrs);
+static void           evict_one_locked(EtcPalResolver* resolver);
+static etcpal_error_t resolve(EtcPalResolver* resolver, const char* hostname, int family, EtcPalResolvedAddrs* addrs);
+static etcpal_error_t getaddrinfo_lookup(const char* hostname, int family, EtcPalResolvedAddrs* addrs, void* context);
+static void           worker_thread(void* arg);
+
+/*************************** Function definitions ****************************/
+
+/**
+ * @brief Create a new resolver.
+ *
+ * Starts the resolver's worker thread.
+ *
+ * @param[in] config Configuration for the new resolver.
+ * @param[out] resolver Filled in with the new resolver on success.
+ * @return #kEtcPalErrOk: Resolver created successfully.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return #kEtcPalErrNoMem: Couldn't allocate memory for the resolver.
+ * @return #kEtcPalErrSys: Couldn't create the resolver's synchronization objects.
+ * @return Other codes from etcpal_thread_create() are possible.
+ */
+etcpal_error_t etcpal_resolver_create(const EtcPalResolverConfig* config, EtcPalResolver** resolver)
+{
+  if (!config || !resolver || config->max_entries == 0)
+    return kEtcPalErrInvalid;
+
+  EtcPalResolver* new_resolver = (EtcPalResolver*)calloc(1, sizeof(EtcPalResolver));
+  if (!new_resolver)
+    return kEtcPalErrNoMem;
+
+  new_resolver->config = *config;
+  if (!new_resolver->config.lookup_fn)
+    new_resolver->config.lookup_fn = getaddrinfo_lookup;
+
+  if (!etcpal_mutex_create(&new_resolver->lock))
+  {
+    free(new_resolver);
+    return kEtcPalErrSys;
+  }
+  if (!etcpal_signal_create(&new_resolver->worker_signal))
+  {
+    etcpal_mutex_destroy(&new_resolver->lock);
+    free(new_resolver);
+    return kEtcPalErrSys;
+  }
+
+  etcpal_rbtree_init(&new_resolver->cache, cache_entry_cmp, NULL, free_cache_entry_node);
+  new_resolver->running = true;
+
+  EtcPalThreadParams params = ETCPAL_THREAD_PARAMS_INIT;
+  params.priority = config->thread_priority;
+  params.stack_size = config->thread_stack_size;
+  params.thread_name = "etcpal_resolver";
+  etcpal_error_t res = etcpal_thread_create(&new_resolver->worker_thread, &params, worker_thread, new_resolver);
+  if (res != kEtcPalErrOk)
+  {
+    etcpal_signal_destroy(&new_resolver->worker_signal);
+    etcpal_mutex_destroy(&new_resolver->lock);
+    free(new_resolver);
+    return res;
+  }
+
+  *resolver = new_resolver;
+  return kEtcPalErrOk;
+}
+
+/**
+ * @brief Destroy a resolver.
+ *
+ * Waits for a lookup in progress on the worker thread to finish and stops the thread. Asynchronous
+ * lookups which have not been started are discarded without calling their callbacks. Must not be
+ * called from a resolver callback.
+ *
+ * @param[in] resolver Resolver to destroy.
+ */
+void etcpal_resolver_destroy(EtcPalResolver* resolver)
+{
+  if (!resolver)
+    return;
+
+  if (etcpal_mutex_lock(&resolver->lock))
+  {
+    resolver->running = false;
+    etcpal_mutex_unlock(&resolver->lock);
+  }
+  etcpal_signal_post(&resolver->worker_signal);
+  etcpal_thread_join(&resolver->worker_thread);
+
+  while (resolver->queue_head)
+  {
+    ResolverRequest* next = resolver->queue_head->next;
+    free(resolver->queue_head);
+    resolver->queue_head = next;
+  }
+
+  etcpal_rbtree_clear(&resolver->cache);
+  etcpal_signal_destroy(&resolver->worker_signal);
+  etcpal_mutex_destroy(&resolver->lock);
+  free(resolver);
+}
+
+/**
+ * @brief Resolve a hostname, blocking until the result is available.
+ *
+ * Returns the cached result if there is one. Otherwise, resolves the hostname in the calling
+ * thread and caches the result.
+ *
+ * @param[in] resolver Resolver to use.
+ * @param[in] hostname The hostname to resolve.
+ * @param[in] family The address family to resolve for: ETCPAL_AF_INET, ETCPAL_AF_INET6 or
+ *                   ETCPAL_AF_UNSPEC for both.
+ * @param[out] addrs Filled in with the addresses on success.
+ * @return #kEtcPalErrOk: The hostname was resolved.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return #kEtcPalErrSys: An internal library or system call error occurred.
+ * @return Other codes from the lookup function, or a cached failure, are possible.
+ */
+etcpal_error_t etcpal_resolver_lookup(EtcPalResolver*      resolver,
+                                      const char*          hostname,
+                                      int                  family,
+                                      EtcPalResolvedAddrs* addrs)
+{
+  if (!resolver || !hostname_is_valid(hostname) || !family_is_valid(family) || !addrs)
+    return kEtcPalErrInvalid;
+
+  if (!etcpal_mutex_lock(&resolver->lock))
+    return kEtcPalErrSys;
+  etcpal_error_t res = kEtcPalErrOk;
+  bool           found = find_cached_locked(resolver, hostname, family, addrs, &res);
+  etcpal_mutex_unlock(&resolver->lock);
+
+  if (!found)
+    res = resolve(resolver, hostname, family, addrs);
+  return res;
+}
+
+/**
+ * @brief Get the cached result for a hostname, without blocking.
+ *
+ * @param[in] resolver Resolver to use.
+ * @param[in] hostname The hostname to look up.
+ * @param[in] family The address family (see etcpal_resolver_lookup()).
+ * @param[out] addrs Filled in with the cached addresses on success.
+ * @return #kEtcPalErrOk: A cached result was found.
+ * @return #kEtcPalErrNotFound: The hostname is not in the cache, or its entry has expired, or the
+ *         cached result is that the hostname was not found.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return #kEtcPalErrSys: An internal library or system call error occurred.
+ * @return Other codes are possible when the cached result is a failure.
+ */
+etcpal_error_t etcpal_resolver_lookup_cached(EtcPalResolver*      resolver,
+                                             const char*          hostname,
+                                             int                  family,
+                                             EtcPalResolvedAddrs* addrs)
+{
+  if (!resolver || !hostname_is_valid(hostname) || !family_is_valid(family) || !addrs)
+    return kEtcPalErrInvalid;
+
+  if (!etcpal_mutex_lock(&resolver->lock))
+    return kEtcPalErrSys;
+  etcpal_error_t res = kEtcPalErrNotFound;
+  find_cached_locked(resolver, hostname, family, addrs, &res);
+  etcpal_mutex_unlock(&resolver->lock);
+  return res;
+}
+
+/**
+ * @brief Resolve a hostname on the resolver's worker thread.
+ *
+ * The lookup is queued, and the callback is called from the worker thread with the result. The
+ * result is answered from the cache if it is there by the time the worker thread gets to the
+ * lookup. Lookups are performed one at a time, in the order they were requested.
+ *
+ * @param[in] resolver Resolver to use.
+ * @param[in] hostname The hostname to resolve.
+ * @param[in] family The address family (see etcpal_resolver_lookup()).
+ * @param[in] callback Called with the result.
+ * @param[in] context Passed back to the callback.
+ * @return #kEtcPalErrOk: Lookup queued.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return #kEtcPalErrNoMem: Couldn't allocate memory for the lookup.
+ * @return #kEtcPalErrSys: An internal library or system call error occurred.
+ */
+etcpal_error_t etcpal_resolver_lookup_async(EtcPalResolver*        resolver,
+                                            const char*            hostname,
+                                            int                    family,
+                                            EtcPalResolverCallback callback,
+                                            void*                  context)
+{
+  if (!resolver || !hostname_is_valid(hostname) || !family_is_valid(family) || !callback)
+    return kEtcPalErrInvalid;
+
+  ResolverRequest* request = (ResolverRequest*)calloc(1, sizeof(ResolverRequest));
+  if (!request)
+    return kEtcPalErrNoMem;
+
+  ETCPAL_MSVC_NO_DEP_WRN strcpy(request->hostname, hostname);
+  request->family = family;
+  request->callback = callback;
+  request->context = context;
+
+  if (!etcpal_mutex_lock(&resolver->lock))
+  {
+    free(request);
+    return kEtcPalErrSys;
+  }
+
+  if (resolver->queue_tail)
+    resolver->queue_tail->next = request;
+  else
+    resolver->queue_head = request;
+  resolver->queue_tail = request;
+
+  etcpal_mutex_unlock(&resolver->lock);
+  etcpal_signal_post(&resolver->worker_signal);
+  return kEtcPalErrOk;
+}
+
+/**
+ * @brief Remove every entry from a resolver's cache.
+ *
+ * @param[in] resolver Resolver to flush.
+ */
+void etcpal_resolver_flush(EtcPalResolver* resolver)
+{
+  if (resolver && etcpal_mutex_lock(&resolver->lock))
+  {
+    etcpal_rbtree_clear(&resolver->cache);
+    etcpal_mutex_unlock(&resolver->lock);
+  }
+}
+
+/*************************** Private functions *******************************/
+
+int cache_entry_cmp(const EtcPalRbTree* self, const void* value_a, const void* value_b)
+{
+  ETCPAL_UNUSED_ARG(self);
+  const ResolverCacheEntry* a = (const ResolverCacheEntry*)value_a;
+  const ResolverCacheEntry* b = (const ResolverCacheEntry*)value_b;
+
+  if (a->family != b->family)
+    return (a->family > b->family) - (a->family < b->family);
+  return strcmp(a->hostname, b->hostname);
+}
+
+void free_cache_entry_node(EtcPalRbNode* node)
+{
+  free(node);
+}
+
+// Compare two etcpal_getms() values, allowing for the millisecond counter wrapping around.
+int compare_times(uint32_t a, uint32_t b)
+{
+  int32_t diff = (int32_t)(a - b);
+  return (diff > 0) - (diff < 0);
+}
+
+bool hostname_is_valid(const char* hostname)
+{
+  if (!hostname)
+    return false;
+  size_t len = strlen(hostname);
+  return (len > 0 && len < ETCPAL_RESOLVER_MAX_HOSTNAME_LEN);
+}
+
+bool family_is_valid(int family)
+{
+  return (family == ETCPAL_AF_UNSPEC || family == ETCPAL_AF_INET || family == ETCPAL_AF_INET6);
+}
+
+// Returns false if there is no unexpired entry. Expired entries are removed.
+bool find_cached_locked(EtcPalResolver*      resolver,
+                        const char*          hostname,
+                        int                  family,
+                        EtcPalResolvedAddrs* addrs,
+                        etcpal_error_t*      result)
+{
+  ResolverCacheEntry key;
+  ETCPAL_MSVC_NO_DEP_WRN strcpy(key.hostname, hostname);
+  key.family = family;
+
+  ResolverCacheEntry* entry = (ResolverCacheEntry*)etcpal_rbtree_find(&resolver->cache, &key);
+  if (!entry)
+    return false;
+
+  if (compare_times(entry->expiry, etcpal_getms()) <= 0)
+  {
+    etcpal_rbtree_remove(&resolver->cache, entry);
+    return false;
+  }
+
+  *addrs = entry->addrs;
+  *result = entry->result;
+  return true;
+}
+
+void store_result_locked(EtcPalResolver*            resolver,
+                         const char*                hostname,
+                         int                        family,
+                         etcpal_error_t             result,
+                         const EtcPalResolvedAddrs* addrs)
+{
+  unsigned int ttl_ms = (result == kEtcPalErrOk ? resolver->config.ttl_ms : resolver->config.negative_ttl_ms);
+
+  ResolverCacheEntry key;
+  memset(&key, 0, sizeof key);
+  ETCPAL_MSVC_NO_DEP_WRN strcpy(key.hostname, hostname);
+  key.family = family;
+
+  ResolverCacheEntry* entry = (ResolverCacheEntry*)etcpal_rbtree_find(&resolver->cache, &key);
+  if (ttl_ms == 0)
+  {
+    if (entry)
+      etcpal_rbtree_remove(&resolver->cache, entry);
+    return;
+  }
+
+  if (!entry)
+  {
+    if (etcpal_rbtree_size(&resolver->cache) >= resolver->config.max_entries)
+      evict_one_locked(resolver);
+
+    entry = (ResolverCacheEntry*)malloc(sizeof(ResolverCacheEntry));
+    if (!entry)
+      return;
+    *entry = key;
+    etcpal_rbnode_init(&entry->node, entry);
+    if (etcpal_rbtree_insert_node(&resolver->cache, &entry->node) != kEtcPalErrOk)
+    {
+      free(entry);
+      return;
+    }
+  }
+
+  entry->expiry = etcpal_getms() + ttl_ms;
+  entry->result = result;
+  if (result == kEtcPalErrOk)
+    entry->addrs = *addrs;
+  else
+    entry->addrs.num_addrs = 0;
+}
+
+// Make room in a full cache by removing the entry which will expire soonest.
+void evict_one_locked(EtcPalResolver* resolver)
+{
+  ResolverCacheEntry* oldest = NULL;
+
+  EtcPalRbIter iter;
+  etcpal_rbiter_init(&iter);
+  for (ResolverCacheEntry* entry = (ResolverCacheEntry*)etcpal_rbiter_first(&iter, &resolver->cache); entry;
+       entry = (ResolverCacheEntry*)etcpal_rbiter_next(&iter))
+  {
+    if (!oldest || compare_times(entry->expiry, oldest->expiry) < 0)
+      oldest = entry;
+  }
+
+  if (oldest)
+    etcpal_rbtree_remove(&resolver->cache, oldest);
+}
+
+// Resolve a hostname with the lookup function, outside the lock, and cache the result.
+etcpal_error_t resolve(EtcPalResolver* resolver, const char* hostname, int family, EtcPalResolvedAddrs* addrs)
+{
+  addrs->num_addrs = 0;
+  etcpal_error_t res = resolver->config.lookup_fn(hostname, family, addrs, resolver->config.lookup_context);
+  if (res == kEtcPalErrOk && addrs->num_addrs == 0)
+    res = kEtcPalErrNotFound;
+
+  if (etcpal_mutex_lock(&resolver->lock))
+  {
+    store_result_locked(resolver, hostname, family, res, addrs);
+    etcpal_mutex_unlock(&resolver->lock);
+  }
+  return res;
+}
+
+etcpal_error_t getaddrinfo_lookup(const char* hostname, int family, EtcPalResolvedAddrs* addrs, void* context)
+{
+  ETCPAL_UNUSED_ARG(context);
+
+  // Ask for one socket type, so that each address is only returned once per protocol.
+  EtcPalAddrinfo hints;
+  memset(&hints, 0, sizeof hints);
+  hints.ai_family = family;
+  hints.ai_socktype = ETCPAL_SOCK_STREAM;
+
+  EtcPalAddrinfo ai;
+  etcpal_error_t res = etcpal_getaddrinfo(hostname, NULL, &hints, &ai);
+  if (res != kEtcPalErrOk)
+    return res;
+
+  addrs->num_addrs = 0;
+  do
+  {
+    bool duplicate = false;
+    for (size_t i = 0; i < addrs->num_addrs; ++i)
+    {
+      if (etcpal_ip_cmp(&addrs->addrs[i], &ai.ai_addr.ip) == 0)
+        duplicate = true;
+    }
+    if (!duplicate)
+      addrs->addrs[addrs->num_addrs++] = ai.ai_addr.ip;
+  } while (addrs->num_addrs < ETCPAL_RESOLVER_MAX_ADDRS && etcpal_nextaddr(&ai));
+
+  etcpal_freeaddrinfo(&ai);
+  return kEtcPalErrOk;
+}
+
+void worker_thread(void* arg)
+{
+  EtcPalResolver* resolver = (EtcPalResolver*)arg;
+
+  while (true)
+  {
+    ResolverRequest* request = NULL;
+    bool             running = false;
+    if (etcpal_mutex_lock(&resolver->lock))
+    {
+      running = resolver->running;
+      if (running && resolver->queue_head)
+      {
+        request = resolver->queue_head;
+        resolver->queue_head = request->next;
+        if (!resolver->queue_head)
+          resolver->queue_tail = NULL;
+      }
+      etcpal_mutex_unlock(&resolver->lock);
+    }
+
+    if (!running)
+      break;
+    if (!request)
+    {
+      etcpal_signal_wait(&resolver->worker_signal);
+      continue;
+    }
+
+    EtcPalResolvedAddrs addrs;
+    addrs.num_addrs = 0;
+    etcpal_error_t res = etcpal_resolver_lookup(resolver, request->hostname, request->family, &addrs);
+    request->callback(request->hostname, res, &addrs, request->context);
+    free(request);
+  }
+}
@@ -0,0 +1,64 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+#include "etcpal/private/socket.h"
+
+/*************************** Private definitions *****************************/
+
+#define SEGMENTED_SEND_BATCH_SIZE 32
+
+/*************************** Function definitions ****************************/
+
+/*
+ * Software fallback for etcpal_sendto_segmented() on ports (or kernels) without segmentation
+ * offload: sends the remaining segments of buf starting at num_sent, in batches through
+ * etcpal_sendmmsg(). Returns the total number of bytes sent, or an error code if nothing was sent.
+ */
+int etcpal_sendto_segments_fallback(etcpal_socket_t       id,
+                                    const uint8_t*        buf,
+                                    size_t                length,
+                                    size_t                segment_size,
+                                    int                   flags,
+                                    const EtcPalSockAddr* dest_addr,
+                                    size_t                num_sent)
+{
+  EtcPalMmsgHdr msgs[SEGMENTED_SEND_BATCH_SIZE];
+
+  while (num_sent < length)
+  {
+    size_t num_msgs = 0;
+    for (size_t offset = num_sent; offset < length && num_msgs < SEGMENTED_SEND_BATCH_SIZE; offset += segment_size)
+    {
+      msgs[num_msgs].buf = (void*)&buf[offset];
+      msgs[num_msgs].len = (length - offset < segment_size ? length - offset : segment_size);
+      msgs[num_msgs].addr = (EtcPalSockAddr*)dest_addr;
+      ++num_msgs;
+    }
+
+    int res = etcpal_sendmmsg(id, msgs, num_msgs, flags);
+    if (res < 0)
+      return (num_sent > 0 ? (int)num_sent : res);
+
+    for (int i = 0; i < res; ++i)
+      num_sent += msgs[i].msg_len;
+    if ((size_t)res < num_msgs)
+      break;
+  }
+  return (int)num_sent;
+}
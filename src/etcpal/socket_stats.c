@@ -0,0 +1,463 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+#include "etcpal/socket_stats.h"
+#include "etcpal/private/socket_stats.h"
+
+#include <string.h>
+#include "etcpal/common.h"
+
+#if ETCPAL_SOCKET_STATS
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sched.h>
+#include <time.h>
+#include "etcpal/timer.h"
+#endif
+
+/*************************** Private definitions *****************************/
+
+// Counters are updated from any thread doing socket I/O, without a lock. Tracked socket slots are
+// claimed and released under a spinlock, since that is rare; lookups read them without it. A thread
+// waiting for the spinlock yields, in case the holder has been pre-empted.
+#if defined(_MSC_VER)
+#define COUNTER_ADD(counter_ptr, val) (void)InterlockedExchangeAdd64((volatile LONG64*)(counter_ptr), (LONG64)(val))
+#define COUNTER_LOAD(counter_ptr) (uint64_t) InterlockedCompareExchange64((volatile LONG64*)(counter_ptr), 0, 0)
+#define COUNTER_STORE(counter_ptr, val) (void)InterlockedExchange64((volatile LONG64*)(counter_ptr), (LONG64)(val))
+#define SLOT_LOAD(field_ptr) (*(volatile const long*)(field_ptr))
+#define SLOT_STORE(field_ptr, val) (*(volatile long*)(field_ptr) = (val))
+#define SPINLOCK_TRY_ACQUIRE(lock_ptr) (InterlockedExchange((volatile long*)(lock_ptr), 1) == 0)
+#define SPINLOCK_RELEASE(lock_ptr) (void)InterlockedExchange((volatile long*)(lock_ptr), 0)
+#define SPINLOCK_YIELD() (void)SwitchToThread()
+#else
+#define COUNTER_ADD(counter_ptr, val) (void)__atomic_fetch_add((counter_ptr), (uint64_t)(val), __ATOMIC_RELAXED)
+#define COUNTER_LOAD(counter_ptr) __atomic_load_n((counter_ptr), __ATOMIC_RELAXED)
+#define COUNTER_STORE(counter_ptr, val) __atomic_store_n((counter_ptr), (uint64_t)(val), __ATOMIC_RELAXED)
+#define SLOT_LOAD(field_ptr) __atomic_load_n((field_ptr), __ATOMIC_ACQUIRE)
+#define SLOT_STORE(field_ptr, val) __atomic_store_n((field_ptr), (val), __ATOMIC_RELEASE)
+#define SPINLOCK_TRY_ACQUIRE(lock_ptr) (__atomic_exchange_n((lock_ptr), 1L, __ATOMIC_ACQUIRE) == 0)
+#define SPINLOCK_RELEASE(lock_ptr) __atomic_store_n((lock_ptr), 0L, __ATOMIC_RELEASE)
+#define SPINLOCK_YIELD() (void)sched_yield()
+#endif
+
+// States of a tracked socket slot. Slots are found by linear probing from the socket's hash, and a
+// lookup ends at the first unused slot, so released slots keep a distinct state until no lookup can
+// need to probe past them (see etcpal_socket_stats_untrack()).
+#define SLOT_UNUSED 0L
+#define SLOT_ACTIVE 1L
+#define SLOT_RELEASED 2L
+
+/****************************** Private types ********************************/
+
+typedef struct TrackedSocket
+{
+  long              state;
+  etcpal_socket_t   socket;
+  EtcPalSocketStats stats;
+} TrackedSocket;
+
+/**************************** Private variables ******************************/
+
+static EtcPalSocketStats global_stats;
+static EtcPalPollStats   poll_stats;
+static TrackedSocket     tracked_sockets[ETCPAL_SOCKET_STATS_MAX_TRACKED];
+static long              num_tracked;
+static long              tracked_lock;
+
+/*********************** Private function prototypes *************************/
+
+static void           lock_tracked(void);
+static void           unlock_tracked(void);
+static TrackedSocket* find_tracked(etcpal_socket_t id);
+static void           release_tracked(TrackedSocket* slot);
+static void           add_recv(EtcPalSocketStats* stats, int res, size_t num_bytes, size_t num_truncated);
+static void           add_send(EtcPalSocketStats* stats, int res, size_t num_bytes);
+static void           load_stats(const EtcPalSocketStats* src, EtcPalSocketStats* dest);
+static void           clear_stats(EtcPalSocketStats* stats);
+
+#endif  // ETCPAL_SOCKET_STATS
+
+/*************************** Function definitions ****************************/
+
+/**
+ * @brief Get the global socket counters.
+ *
+ * @param[out] stats Filled in with the counters, totalled across all sockets.
+ * @return #kEtcPalErrOk: Counters filled in.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return #kEtcPalErrNotImpl: EtcPal was built without socket statistics.
+ */
+etcpal_error_t etcpal_socket_stats_snapshot(EtcPalSocketStats* stats)
+{
+#if ETCPAL_SOCKET_STATS
+  if (!stats)
+    return kEtcPalErrInvalid;
+
+  load_stats(&global_stats, stats);
+  return kEtcPalErrOk;
+#else
+  ETCPAL_UNUSED_ARG(stats);
+  return kEtcPalErrNotImpl;
+#endif
+}
+
+/**
+ * @brief Get the counters of a socket tracked with etcpal_socket_stats_track().
+ *
+ * @param[in] id Socket for which to get counters.
+ * @param[out] stats Filled in with the counters of I/O on the socket since it was tracked (or since
+ *                   the last etcpal_socket_stats_reset()).
+ * @return #kEtcPalErrOk: Counters filled in.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return #kEtcPalErrNotFound: The socket is not tracked.
+ * @return #kEtcPalErrNotImpl: EtcPal was built without socket statistics.
+ */
+etcpal_error_t etcpal_socket_stats_snapshot_socket(etcpal_socket_t id, EtcPalSocketStats* stats)
+{
+#if ETCPAL_SOCKET_STATS
+  if (id == ETCPAL_SOCKET_INVALID || !stats)
+    return kEtcPalErrInvalid;
+
+  const TrackedSocket* tracked = find_tracked(id);
+  if (!tracked)
+    return kEtcPalErrNotFound;
+
+  load_stats(&tracked->stats, stats);
+  return kEtcPalErrOk;
+#else
+  ETCPAL_UNUSED_ARG(id);
+  ETCPAL_UNUSED_ARG(stats);
+  return kEtcPalErrNotImpl;
+#endif
+}
+
+/**
+ * @brief Get the poll wait counters.
+ *
+ * @param[out] stats Filled in with the counters, totalled across all poll contexts.
+ * @return #kEtcPalErrOk: Counters filled in.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return #kEtcPalErrNotImpl: EtcPal was built without socket statistics.
+ */
+etcpal_error_t etcpal_poll_stats_snapshot(EtcPalPollStats* stats)
+{
+#if ETCPAL_SOCKET_STATS
+  if (!stats)
+    return kEtcPalErrInvalid;
+
+  stats->waits = COUNTER_LOAD(&poll_stats.waits);
+  stats->events = COUNTER_LOAD(&poll_stats.events);
+  stats->timeouts = COUNTER_LOAD(&poll_stats.timeouts);
+  for (size_t i = 0; i < ETCPAL_POLL_STATS_HIST_BUCKETS; ++i)
+    stats->wait_time_hist[i] = COUNTER_LOAD(&poll_stats.wait_time_hist[i]);
+  return kEtcPalErrOk;
+#else
+  ETCPAL_UNUSED_ARG(stats);
+  return kEtcPalErrNotImpl;
+#endif
+}
+
+/**
+ * @brief Start keeping separate counters for a socket.
+ *
+ * The counters start at 0. A socket should be untracked with etcpal_socket_stats_untrack() before
+ * it is closed, since the platform may reuse its handle for a new socket.
+ *
+ * @param[in] id Socket to track.
+ * @return #kEtcPalErrOk: Socket tracked.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return #kEtcPalErrExists: The socket is already tracked.
+ * @return #kEtcPalErrNoMem: ETCPAL_SOCKET_STATS_MAX_TRACKED sockets are already tracked.
+ * @return #kEtcPalErrNotImpl: EtcPal was built without socket statistics.
+ */
+etcpal_error_t etcpal_socket_stats_track(etcpal_socket_t id)
+{
+#if ETCPAL_SOCKET_STATS
+  if (id == ETCPAL_SOCKET_INVALID)
+    return kEtcPalErrInvalid;
+
+  etcpal_error_t res = kEtcPalErrNoMem;
+  lock_tracked();
+  if (find_tracked(id))
+  {
+    res = kEtcPalErrExists;
+  }
+  else
+  {
+    size_t start = (size_t)id % ETCPAL_SOCKET_STATS_MAX_TRACKED;
+    for (size_t i = 0; i < ETCPAL_SOCKET_STATS_MAX_TRACKED; ++i)
+    {
+      TrackedSocket* slot = &tracked_sockets[(start + i) % ETCPAL_SOCKET_STATS_MAX_TRACKED];
+      if (slot->state != SLOT_ACTIVE)
+      {
+        // Lookups ignore the slot until it is marked active, after its contents are written.
+        clear_stats(&slot->stats);
+        slot->socket = id;
+        SLOT_STORE(&slot->state, SLOT_ACTIVE);
+        SLOT_STORE(&num_tracked, num_tracked + 1);
+        res = kEtcPalErrOk;
+        break;
+      }
+    }
+  }
+  unlock_tracked();
+  return res;
+#else
+  ETCPAL_UNUSED_ARG(id);
+  return kEtcPalErrNotImpl;
+#endif
+}
+
+/**
+ * @brief Stop keeping separate counters for a socket.
+ *
+ * @param[in] id Socket to stop tracking.
+ * @return #kEtcPalErrOk: Socket untracked.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return #kEtcPalErrNotFound: The socket is not tracked.
+ * @return #kEtcPalErrNotImpl: EtcPal was built without socket statistics.
+ */
+etcpal_error_t etcpal_socket_stats_untrack(etcpal_socket_t id)
+{
+#if ETCPAL_SOCKET_STATS
+  if (id == ETCPAL_SOCKET_INVALID)
+    return kEtcPalErrInvalid;
+
+  etcpal_error_t res = kEtcPalErrNotFound;
+  lock_tracked();
+  TrackedSocket* tracked = find_tracked(id);
+  if (tracked)
+  {
+    release_tracked(tracked);
+    res = kEtcPalErrOk;
+  }
+  unlock_tracked();
+  return res;
+#else
+  ETCPAL_UNUSED_ARG(id);
+  return kEtcPalErrNotImpl;
+#endif
+}
+
+/**
+ * @brief Reset all counters to 0.
+ *
+ * Resets the global counters, the poll wait counters and the counters of all tracked sockets.
+ * Sockets stay tracked. Does nothing if EtcPal was built without socket statistics.
+ */
+void etcpal_socket_stats_reset(void)
+{
+#if ETCPAL_SOCKET_STATS
+  clear_stats(&global_stats);
+
+  COUNTER_STORE(&poll_stats.waits, 0);
+  COUNTER_STORE(&poll_stats.events, 0);
+  COUNTER_STORE(&poll_stats.timeouts, 0);
+  for (size_t i = 0; i < ETCPAL_POLL_STATS_HIST_BUCKETS; ++i)
+    COUNTER_STORE(&poll_stats.wait_time_hist[i], 0);
+
+  lock_tracked();
+  for (TrackedSocket* slot = tracked_sockets; slot < tracked_sockets + ETCPAL_SOCKET_STATS_MAX_TRACKED; ++slot)
+  {
+    if (slot->state == SLOT_ACTIVE)
+      clear_stats(&slot->stats);
+  }
+  unlock_tracked();
+#endif
+}
+
+#if ETCPAL_SOCKET_STATS
+
+void etcpal_socket_stats_record_recv(etcpal_socket_t id, int res, size_t num_bytes, size_t num_truncated)
+{
+  add_recv(&global_stats, res, num_bytes, num_truncated);
+
+  TrackedSocket* tracked = find_tracked(id);
+  if (tracked)
+    add_recv(&tracked->stats, res, num_bytes, num_truncated);
+}
+
+void etcpal_socket_stats_record_send(etcpal_socket_t id, int res, size_t num_bytes)
+{
+  add_send(&global_stats, res, num_bytes);
+
+  TrackedSocket* tracked = find_tracked(id);
+  if (tracked)
+    add_send(&tracked->stats, res, num_bytes);
+}
+
+void etcpal_socket_stats_record_poll_wait(uint64_t start_us, int res)
+{
+  COUNTER_ADD(&poll_stats.waits, 1);
+  if (res > 0)
+    COUNTER_ADD(&poll_stats.events, res);
+  else if (res == (int)kEtcPalErrTimedOut)
+    COUNTER_ADD(&poll_stats.timeouts, 1);
+
+  // The bucket index is the number of significant bits in the elapsed time.
+  uint64_t elapsed_us = etcpal_socket_stats_now_us() - start_us;
+  size_t   bucket = 0;
+  while (elapsed_us > 0 && bucket < ETCPAL_POLL_STATS_HIST_BUCKETS - 1)
+  {
+    elapsed_us >>= 1;
+    ++bucket;
+  }
+  COUNTER_ADD(&poll_stats.wait_time_hist[bucket], 1);
+}
+
+uint64_t etcpal_socket_stats_now_us(void)
+{
+#if defined(_WIN32)
+  LARGE_INTEGER count;
+  LARGE_INTEGER freq;
+  QueryPerformanceCounter(&count);
+  QueryPerformanceFrequency(&freq);
+  return (uint64_t)(count.QuadPart / freq.QuadPart) * 1000000 +
+         (uint64_t)(count.QuadPart % freq.QuadPart) * 1000000 / (uint64_t)freq.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+#else
+  return (uint64_t)etcpal_getms() * 1000;
+#endif
+}
+
+void lock_tracked(void)
+{
+  while (!SPINLOCK_TRY_ACQUIRE(&tracked_lock))
+    SPINLOCK_YIELD();
+}
+
+void unlock_tracked(void)
+{
+  SPINLOCK_RELEASE(&tracked_lock);
+}
+
+TrackedSocket* find_tracked(etcpal_socket_t id)
+{
+  // Skip the lookup entirely in the common case of no tracked sockets.
+  if (SLOT_LOAD(&num_tracked) == 0)
+    return NULL;
+
+  size_t start = (size_t)id % ETCPAL_SOCKET_STATS_MAX_TRACKED;
+  for (size_t i = 0; i < ETCPAL_SOCKET_STATS_MAX_TRACKED; ++i)
+  {
+    TrackedSocket* slot = &tracked_sockets[(start + i) % ETCPAL_SOCKET_STATS_MAX_TRACKED];
+    long           state = SLOT_LOAD(&slot->state);
+    if (state == SLOT_UNUSED)
+      break;
+    if (state == SLOT_ACTIVE && slot->socket == id)
+      return slot;
+  }
+  return NULL;
+}
+
+// Release a tracked slot with the lock held. Released slots which end a probe sequence (i.e. are
+// followed by an unused slot) are returned to unused, so that churn does not leave lookups scanning
+// a table full of released slots.
+void release_tracked(TrackedSocket* slot)
+{
+  SLOT_STORE(&slot->state, SLOT_RELEASED);
+  SLOT_STORE(&num_tracked, num_tracked - 1);
+
+  if (num_tracked == 0)
+  {
+    for (TrackedSocket* cur = tracked_sockets; cur < tracked_sockets + ETCPAL_SOCKET_STATS_MAX_TRACKED; ++cur)
+      SLOT_STORE(&cur->state, SLOT_UNUSED);
+    return;
+  }
+
+  size_t index = (size_t)(slot - tracked_sockets);
+  if (tracked_sockets[(index + 1) % ETCPAL_SOCKET_STATS_MAX_TRACKED].state != SLOT_UNUSED)
+    return;
+
+  // No lookup probes past an unused slot, so the released slots just before one are not needed.
+  while (tracked_sockets[index].state == SLOT_RELEASED)
+  {
+    SLOT_STORE(&tracked_sockets[index].state, SLOT_UNUSED);
+    index = (index + ETCPAL_SOCKET_STATS_MAX_TRACKED - 1) % ETCPAL_SOCKET_STATS_MAX_TRACKED;
+  }
+}
+
+void add_recv(EtcPalSocketStats* stats, int res, size_t num_bytes, size_t num_truncated)
+{
+  if (res >= 0)
+  {
+    COUNTER_ADD(&stats->messages_received, res);
+    COUNTER_ADD(&stats->bytes_received, num_bytes);
+    if (num_truncated > 0)
+      COUNTER_ADD(&stats->recv_truncated, num_truncated);
+  }
+  else if (res == (int)kEtcPalErrWouldBlock)
+  {
+    COUNTER_ADD(&stats->recv_would_block, 1);
+  }
+  else
+  {
+    COUNTER_ADD(&stats->recv_errors, 1);
+  }
+}
+
+void add_send(EtcPalSocketStats* stats, int res, size_t num_bytes)
+{
+  if (res >= 0)
+  {
+    COUNTER_ADD(&stats->messages_sent, res);
+    COUNTER_ADD(&stats->bytes_sent, num_bytes);
+  }
+  else if (res == (int)kEtcPalErrWouldBlock)
+  {
+    COUNTER_ADD(&stats->send_would_block, 1);
+  }
+  else
+  {
+    COUNTER_ADD(&stats->send_errors, 1);
+  }
+}
+
+void load_stats(const EtcPalSocketStats* src, EtcPalSocketStats* dest)
+{
+  dest->messages_received = COUNTER_LOAD(&src->messages_received);
+  dest->bytes_received = COUNTER_LOAD(&src->bytes_received);
+  dest->recv_would_block = COUNTER_LOAD(&src->recv_would_block);
+  dest->recv_truncated = COUNTER_LOAD(&src->recv_truncated);
+  dest->recv_errors = COUNTER_LOAD(&src->recv_errors);
+  dest->messages_sent = COUNTER_LOAD(&src->messages_sent);
+  dest->bytes_sent = COUNTER_LOAD(&src->bytes_sent);
+  dest->send_would_block = COUNTER_LOAD(&src->send_would_block);
+  dest->send_errors = COUNTER_LOAD(&src->send_errors);
+}
+
+void clear_stats(EtcPalSocketStats* stats)
+{
+  COUNTER_STORE(&stats->messages_received, 0);
+  COUNTER_STORE(&stats->bytes_received, 0);
+  COUNTER_STORE(&stats->recv_would_block, 0);
+  COUNTER_STORE(&stats->recv_truncated, 0);
+  COUNTER_STORE(&stats->recv_errors, 0);
+  COUNTER_STORE(&stats->messages_sent, 0);
+  COUNTER_STORE(&stats->bytes_sent, 0);
+  COUNTER_STORE(&stats->send_would_block, 0);
+  COUNTER_STORE(&stats->send_errors, 0);
+}
+
+#endif  // ETCPAL_SOCKET_STATS
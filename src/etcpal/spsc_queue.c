@@ -0,0 +1,428 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+#include "etcpal/spsc_queue.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "etcpal/timer.h"
+
+#if defined(_MSC_VER)
+#include <windows.h>
+#endif
+
+/*************************** Private definitions *****************************/
+
+// The head and tail are free-running counters; an item's slot is its counter masked by the
+// capacity, and the number of items in the queue is head - tail. Each index is written only by its
+// own side, which publishes it with a release store after copying an item, and the other side reads
+// it with an acquire load. Each side also keeps a private copy of the other side's index, and only
+// reloads it when the copy says the queue is full (or empty), so the shared line is read rarely.
+#if defined(_MSC_VER)
+#define INDEX_LOAD_RELAXED(index_ptr) (*(volatile const size_t*)(index_ptr))
+#define FLAG_LOAD(flag_ptr) (*(volatile const int*)(flag_ptr))
+#define FLAG_STORE(flag_ptr, val) (*(volatile int*)(flag_ptr) = (val))
+#define FULL_FENCE() MemoryBarrier()
+#else
+#define INDEX_LOAD_RELAXED(index_ptr) __atomic_load_n((index_ptr), __ATOMIC_RELAXED)
+#define FLAG_LOAD(flag_ptr) __atomic_load_n((flag_ptr), __ATOMIC_RELAXED)
+#define FLAG_STORE(flag_ptr, val) __atomic_store_n((flag_ptr), (val), __ATOMIC_RELAXED)
+#define FULL_FENCE() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
+
+/*********************** Private function prototypes *************************/
+
+static size_t index_load_acquire(const size_t* index);
+static void   index_store_release(size_t* index, size_t val);
+
+static bool push(EtcPalSpscQueue* queue, const void* data);
+static bool pop(EtcPalSpscQueue* queue, void* data);
+static void wake_consumer(EtcPalSpscQueue* queue);
+static void wake_producer(EtcPalSpscQueue* queue);
+static int  remaining_timeout(const EtcPalTimer* timer, int timeout_ms);
+
+/*************************** Function definitions ****************************/
+
+/**
+ * @brief Create a new SPSC queue.
+ *
+ * @param[out] queue Queue to initialize.
+ * @param[in] size The minimum number of items the queue must hold. Rounded up to the next power of
+ *                 two.
+ * @param[in] element_size The size in bytes of each item.
+ * @param[in] blocking Whether the queue supports waiting with etcpal_spsc_queue_send(),
+ *                     etcpal_spsc_queue_receive() and their timed variants.
+ * @return true: The queue was created.
+ * @return false: Invalid argument, or a failure to allocate the queue's memory or signals.
+ */
+bool etcpal_spsc_queue_create(EtcPalSpscQueue* queue, size_t size, size_t element_size, bool blocking)
+{
+  if (!queue || size == 0 || element_size == 0 || size > (SIZE_MAX / 2) + 1)
+    return false;
+
+  size_t capacity = 1;
+  while (capacity < size)
+    capacity <<= 1;
+  if (capacity > SIZE_MAX / element_size)
+    return false;
+
+  memset(queue, 0, sizeof(EtcPalSpscQueue));
+  queue->buf = (uint8_t*)malloc(capacity * element_size);
+  if (!queue->buf)
+    return false;
+
+  if (blocking)
+  {
+    if (!etcpal_signal_create(&queue->data_available))
+    {
+      free(queue->buf);
+      queue->buf = NULL;
+      return false;
+    }
+    if (!etcpal_signal_create(&queue->space_available))
+    {
+      etcpal_signal_destroy(&queue->data_available);
+      free(queue->buf);
+      queue->buf = NULL;
+      return false;
+    }
+  }
+
+  queue->capacity = capacity;
+  queue->mask = capacity - 1;
+  queue->element_size = element_size;
+  queue->blocking = blocking;
+  return true;
+}
+
+/**
+ * @brief Destroy an SPSC queue.
+ *
+ * Any items still in the queue are discarded. Neither the producer nor the consumer may be using
+ * the queue.
+ *
+ * @param[in] queue Queue to destroy.
+ */
+void etcpal_spsc_queue_destroy(EtcPalSpscQueue* queue)
+{
+  if (!queue || !queue->buf)
+    return;
+
+  if (queue->blocking)
+  {
+    etcpal_signal_destroy(&queue->data_available);
+    etcpal_signal_destroy(&queue->space_available);
+  }
+  free(queue->buf);
+  queue->buf = NULL;
+}
+
+/**
+ * @brief Add an item to an SPSC queue if there is room for it.
+ *
+ * Must only be called from the producer thread.
+ *
+ * @param[in] queue Queue to add to.
+ * @param[in] data The item to copy into the queue, which is element_size bytes long.
+ * @return true: The item was added.
+ * @return false: The queue is full, or invalid argument.
+ */
+bool etcpal_spsc_queue_try_send(EtcPalSpscQueue* queue, const void* data)
+{
+  if (!queue || !data)
+    return false;
+
+  if (!push(queue, data))
+    return false;
+  wake_consumer(queue);
+  return true;
+}
+
+/**
+ * @brief Add an item to an SPSC queue, waiting for room if it is full.
+ *
+ * Must only be called from the producer thread. See etcpal_spsc_queue_timed_send().
+ *
+ * @param[in] queue Queue to add to.
+ * @param[in] data The item to copy into the queue, which is element_size bytes long.
+ * @return true: The item was added.
+ * @return false: The queue is full and was created without blocking support, or invalid argument.
+ */
+bool etcpal_spsc_queue_send(EtcPalSpscQueue* queue, const void* data)
+{
+  return etcpal_spsc_queue_timed_send(queue, data, ETCPAL_WAIT_FOREVER);
+}
+
+/**
+ * @brief Add an item to an SPSC queue, waiting up to a timeout for room if it is full.
+ *
+ * Must only be called from the producer thread. If the queue was created without blocking support,
+ * this returns immediately like etcpal_spsc_queue_try_send().
+ *
+ * The timeout is only honored on platforms where #ETCPAL_SPSC_QUEUE_HAS_TIMED_FUNCTIONS is 1; on
+ * other platforms any timeout other than 0 waits indefinitely.
+ *
+ * @param[in] queue Queue to add to.
+ * @param[in] data The item to copy into the queue, which is element_size bytes long.
+ * @param[in] timeout_ms How long to wait for room in the queue, in milliseconds. 0 means return
+ *                       immediately; #ETCPAL_WAIT_FOREVER means wait indefinitely.
+ * @return true: The item was added.
+ * @return false: The timeout expired, or invalid argument.
+ */
+bool etcpal_spsc_queue_timed_send(EtcPalSpscQueue* queue, const void* data, int timeout_ms)
+{
+  if (!queue || !data)
+    return false;
+
+  bool sent = push(queue, data);
+  if (!sent && queue->blocking && timeout_ms != 0)
+  {
+    EtcPalTimer timer = {0};
+    if (timeout_ms > 0)
+      etcpal_timer_start(&timer, (uint32_t)timeout_ms);
+
+    while (!sent)
+    {
+      // Announce the wait before checking again. Either this check sees the consumer's latest
+      // receive, or the consumer sees the flag after that receive and posts the signal.
+      FLAG_STORE(&queue->producer_waiting, 1);
+      FULL_FENCE();
+      sent = push(queue, data);
+      if (!sent && !etcpal_signal_timed_wait(&queue->space_available, remaining_timeout(&timer, timeout_ms)))
+        break;
+    }
+    FLAG_STORE(&queue->producer_waiting, 0);
+  }
+
+  if (sent)
+    wake_consumer(queue);
+  return sent;
+}
+
+/**
+ * @brief Remove the oldest item from an SPSC queue if there is one.
+ *
+ * Must only be called from the consumer thread.
+ *
+ * @param[in] queue Queue to remove from.
+ * @param[out] data Filled in with the item, which is element_size bytes long.
+ * @return true: An item was removed.
+ * @return false: The queue is empty, or invalid argument.
+ */
+bool etcpal_spsc_queue_try_receive(EtcPalSpscQueue* queue, void* data)
+{
+  if (!queue || !data)
+    return false;
+
+  if (!pop(queue, data))
+    return false;
+  wake_producer(queue);
+  return true;
+}
+
+/**
+ * @brief Remove the oldest item from an SPSC queue, waiting for one if it is empty.
+ *
+ * Must only be called from the consumer thread. See etcpal_spsc_queue_timed_receive().
+ *
+ * @param[in] queue Queue to remove from.
+ * @param[out] data Filled in with the item, which is element_size bytes long.
+ * @return true: An item was removed.
+ * @return false: The queue is empty and was created without blocking support, or invalid argument.
+ */
+bool etcpal_spsc_queue_receive(EtcPalSpscQueue* queue, void* data)
+{
+  return etcpal_spsc_queue_timed_receive(queue, data, ETCPAL_WAIT_FOREVER);
+}
+
+/**
+ * @brief Remove the oldest item from an SPSC queue, waiting up to a timeout for one if it is empty.
+ *
+ * Must only be called from the consumer thread. If the queue was created without blocking support,
+ * this returns immediately like etcpal_spsc_queue_try_receive().
+ *
+ * The consumer only waits on the queue's signal, and the producer only posts it, when the queue is
+ * empty; while items are flowing, no system calls are made.
+ *
+ * The timeout is only honored on platforms where #ETCPAL_SPSC_QUEUE_HAS_TIMED_FUNCTIONS is 1; on
+ * other platforms any timeout other than 0 waits indefinitely.
+ *
+ * @param[in] queue Queue to remove from.
+ * @param[out] data Filled in with the item, which is element_size bytes long.
+ * @param[in] timeout_ms How long to wait for an item, in milliseconds. 0 means return immediately;
+ *                       #ETCPAL_WAIT_FOREVER means wait indefinitely.
+ * @return true: An item was removed.
+ * @return false: The timeout expired, or invalid argument.
+ */
+bool etcpal_spsc_queue_timed_receive(EtcPalSpscQueue* queue, void* data, int timeout_ms)
+{
+  if (!queue || !data)
+    return false;
+
+  bool received = pop(queue, data);
+  if (!received && queue->blocking && timeout_ms != 0)
+  {
+    EtcPalTimer timer = {0};
+    if (timeout_ms > 0)
+      etcpal_timer_start(&timer, (uint32_t)timeout_ms);
+
+    while (!received)
+    {
+      // Announce the wait before checking again. Either this check sees the producer's latest
+      // send, or the producer sees the flag after that send and posts the signal.
+      FLAG_STORE(&queue->consumer_waiting, 1);
+      FULL_FENCE();
+      received = pop(queue, data);
+      if (!received && !etcpal_signal_timed_wait(&queue->data_available, remaining_timeout(&timer, timeout_ms)))
+        break;
+    }
+    FLAG_STORE(&queue->consumer_waiting, 0);
+  }
+
+  if (received)
+    wake_producer(queue);
+  return received;
+}
+
+/**
+ * @brief Get the number of items an SPSC queue can hold.
+ *
+ * @param[in] queue Queue to check.
+ * @return The capacity of the queue, which is the size it was created with rounded up to a power of
+ *         two, or 0 if the queue is invalid.
+ */
+size_t etcpal_spsc_queue_capacity(const EtcPalSpscQueue* queue)
+{
+  return (queue ? queue->capacity : 0);
+}
+
+/**
+ * @brief Get the number of items in an SPSC queue.
+ *
+ * When called from a thread other than the producer or consumer, the result may already be out of
+ * date by the time it is returned.
+ *
+ * @param[in] queue Queue to check.
+ * @return The number of items in the queue, or 0 if the queue is invalid.
+ */
+size_t etcpal_spsc_queue_slots_used(const EtcPalSpscQueue* queue)
+{
+  if (!queue)
+    return 0;
+
+  // Read the tail first, so that a concurrent receive can only make the result too large, and clamp
+  // it in case a concurrent send and receive leave it beyond the capacity.
+  size_t tail = index_load_acquire(&queue->tail);
+  size_t head = index_load_acquire(&queue->head);
+  size_t used = head - tail;
+  return (used > queue->capacity ? queue->capacity : used);
+}
+
+/**
+ * @brief Check whether an SPSC queue is empty.
+ *
+ * @param[in] queue Queue to check.
+ * @return Whether the queue holds no items. Invalid queues are considered empty.
+ */
+bool etcpal_spsc_queue_is_empty(const EtcPalSpscQueue* queue)
+{
+  return (etcpal_spsc_queue_slots_used(queue) == 0);
+}
+
+size_t index_load_acquire(const size_t* index)
+{
+#if defined(_MSC_VER)
+  size_t val = *(volatile const size_t*)index;
+  MemoryBarrier();
+  return val;
+#else
+  return __atomic_load_n(index, __ATOMIC_ACQUIRE);
+#endif
+}
+
+void index_store_release(size_t* index, size_t val)
+{
+#if defined(_MSC_VER)
+  MemoryBarrier();
+  *(volatile size_t*)index = val;
+#else
+  __atomic_store_n(index, val, __ATOMIC_RELEASE);
+#endif
+}
+
+bool push(EtcPalSpscQueue* queue, const void* data)
+{
+  size_t head = INDEX_LOAD_RELAXED(&queue->head);
+  if (head - queue->cached_tail == queue->capacity)
+  {
+    queue->cached_tail = index_load_acquire(&queue->tail);
+    if (head - queue->cached_tail == queue->capacity)
+      return false;
+  }
+
+  memcpy(&queue->buf[(head & queue->mask) * queue->element_size], data, queue->element_size);
+  index_store_release(&queue->head, head + 1);
+  return true;
+}
+
+bool pop(EtcPalSpscQueue* queue, void* data)
+{
+  size_t tail = INDEX_LOAD_RELAXED(&queue->tail);
+  if (tail == queue->cached_head)
+  {
+    queue->cached_head = index_load_acquire(&queue->head);
+    if (tail == queue->cached_head)
+      return false;
+  }
+
+  memcpy(data, &queue->buf[(tail & queue->mask) * queue->element_size], queue->element_size);
+  index_store_release(&queue->tail, tail + 1);
+  return true;
+}
+
+// Called by the producer after a send. The fence orders the new head before the read of the flag,
+// pairing with the fence in etcpal_spsc_queue_timed_receive().
+void wake_consumer(EtcPalSpscQueue* queue)
+{
+  if (queue->blocking)
+  {
+    FULL_FENCE();
+    if (FLAG_LOAD(&queue->consumer_waiting))
+      etcpal_signal_post(&queue->data_available);
+  }
+}
+
+// Called by the consumer after a receive; the mirror image of wake_consumer().
+void wake_producer(EtcPalSpscQueue* queue)
+{
+  if (queue->blocking)
+  {
+    FULL_FENCE();
+    if (FLAG_LOAD(&queue->producer_waiting))
+      etcpal_signal_post(&queue->space_available);
+  }
+}
+
+int remaining_timeout(const EtcPalTimer* timer, int timeout_ms)
+{
+  if (timeout_ms < 0)
+    return ETCPAL_WAIT_FOREVER;
+  return (int)etcpal_timer_remaining(timer);
+}
@@ -0,0 +1,334 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+#include "etcpal/udp_receiver.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**************************** Private constants ******************************/
+
+/* The maximum number of datagrams retrieved by each etcpal_recvmmsg() call. */
+#define UDP_RECEIVER_BATCH_SIZE 16
+
+/* How often a shard's thread checks for shutdown, on platforms where etcpal_poll_context_wake() is
+ * not available. */
+#define UDP_RECEIVER_SHUTDOWN_POLL_INTERVAL_MS 100
+
+/* How long a shard's thread waits before polling again after an unexpected error from
+ * etcpal_poll_wait(), so that a persistent error does not keep it spinning. */
+#define UDP_RECEIVER_ERROR_BACKOFF_MS 10
+
+/* Long enough for the generated thread names, and within the limit of every platform that honors
+ * thread names. */
+#define UDP_RECEIVER_THREAD_NAME_SIZE 16
+
+/****************************** Private types ********************************/
+
+typedef struct UdpReceiverShard
+{
+  const EtcPalUdpReceiverConfig* config;
+  size_t                         index;
+
+  etcpal_socket_t   socket;
+  EtcPalPollContext poll_context;
+  bool              poll_context_valid;
+  int               wait_timeout_ms;
+  etcpal_thread_t   thread;
+  bool              thread_running;
+
+  uint8_t*       buffers;
+  EtcPalSockAddr addrs[UDP_RECEIVER_BATCH_SIZE];
+  EtcPalMmsgHdr  msgs[UDP_RECEIVER_BATCH_SIZE];
+} UdpReceiverShard;
+
+struct EtcPalUdpReceiver
+{
+  EtcPalUdpReceiverConfig config;
+  uint16_t                port;
+  UdpReceiverShard*       shards;
+};
+
+/*********************** Private function prototypes *************************/
+
+static etcpal_error_t open_shard_socket(UdpReceiverShard* shard, const EtcPalSockAddr* bind_addr);
+static etcpal_error_t start_shard(UdpReceiverShard* shard);
+static void           stop_shard(UdpReceiverShard* shard);
+static void           shard_thread(void* arg);
+static void           receive_datagrams(UdpReceiverShard* shard);
+
+/*************************** Function definitions ****************************/
+
+/**
+ * @brief Create a new UDP receiver.
+ *
+ * Opens and binds the configured number of sockets and starts a thread to service each one.
+ * Datagrams are delivered to the callback as soon as this function returns successfully (and
+ * possibly before).
+ *
+ * @param[in] config Configuration for the new receiver.
+ * @param[out] receiver Filled in with the new receiver on success.
+ * @return #kEtcPalErrOk: Receiver created successfully.
+ * @return #kEtcPalErrInvalid: Invalid argument, or a CPU requested with pin_threads does not exist.
+ * @return #kEtcPalErrNoMem: Couldn't allocate memory for the receiver.
+ * @return #kEtcPalErrNotImpl: More than one shard was requested on a platform which does not
+ *         support #ETCPAL_SO_REUSEPORT.
+ * @return Other codes translated from system error codes are possible.
+ */
+etcpal_error_t etcpal_udp_receiver_create(const EtcPalUdpReceiverConfig* config, EtcPalUdpReceiver** receiver)
+{
+  if (!config || !receiver || !config->callback || config->num_shards == 0 || config->max_datagram_size == 0 ||
+      (!ETCPAL_IP_IS_V4(&config->bind_addr.ip) && !ETCPAL_IP_IS_V6(&config->bind_addr.ip)))
+  {
+    return kEtcPalErrInvalid;
+  }
+
+  EtcPalUdpReceiver* new_receiver = (EtcPalUdpReceiver*)calloc(1, sizeof(EtcPalUdpReceiver));
+  if (!new_receiver)
+    return kEtcPalErrNoMem;
+  new_receiver->config = *config;
+
+  new_receiver->shards = (UdpReceiverShard*)calloc(config->num_shards, sizeof(UdpReceiverShard));
+  if (!new_receiver->shards)
+  {
+    free(new_receiver);
+    return kEtcPalErrNoMem;
+  }
+
+  etcpal_error_t res = kEtcPalErrOk;
+  EtcPalSockAddr bind_addr = config->bind_addr;
+  for (size_t i = 0; i < config->num_shards; ++i)
+  {
+    UdpReceiverShard* shard = &new_receiver->shards[i];
+    shard->config = &new_receiver->config;
+    shard->index = i;
+    shard->socket = ETCPAL_SOCKET_INVALID;
+  }
+
+  for (size_t i = 0; i < config->num_shards && res == kEtcPalErrOk; ++i)
+  {
+    UdpReceiverShard* shard = &new_receiver->shards[i];
+    res = open_shard_socket(shard, &bind_addr);
+
+    // If the system chose the port, the remaining shards must bind to the same one.
+    if (res == kEtcPalErrOk && i == 0)
+    {
+      EtcPalSockAddr bound_addr;
+      res = etcpal_getsockname(shard->socket, &bound_addr);
+      bind_addr.port = bound_addr.port;
+      new_receiver->port = bound_addr.port;
+    }
+  }
+
+  for (size_t i = 0; i < config->num_shards && res == kEtcPalErrOk; ++i)
+    res = start_shard(&new_receiver->shards[i]);
+
+  if (res != kEtcPalErrOk)
+  {
+    etcpal_udp_receiver_destroy(new_receiver);
+    return res;
+  }
+
+  *receiver = new_receiver;
+  return kEtcPalErrOk;
+}
+
+/**
+ * @brief Destroy a UDP receiver.
+ *
+ * Stops and joins each shard's thread and closes its socket. The callback is not called after
+ * this function returns. Must not be called from the receiver's callback.
+ *
+ * @param[in] receiver Receiver to destroy.
+ */
+void etcpal_udp_receiver_destroy(EtcPalUdpReceiver* receiver)
+{
+  if (!receiver)
+    return;
+
+  for (size_t i = 0; i < receiver->config.num_shards; ++i)
+    stop_shard(&receiver->shards[i]);
+
+  free(receiver->shards);
+  free(receiver);
+}
+
+/**
+ * @brief Get the port on which a UDP receiver is receiving.
+ *
+ * This is the port from the configuration, or the port chosen by the system if the configuration
+ * specified port 0.
+ *
+ * @param[in] receiver Receiver for which to get the port.
+ * @return The port, or 0 if receiver is NULL.
+ */
+uint16_t etcpal_udp_receiver_get_port(const EtcPalUdpReceiver* receiver)
+{
+  return (receiver ? receiver->port : 0);
+}
+
+/**
+ * @brief Get the socket used by one of a UDP receiver's shards.
+ *
+ * The socket can be used to set additional options, e.g. to join multicast groups. It is owned by
+ * the receiver and must not be closed, and must not be read from outside the receiver's callback.
+ *
+ * @param[in] receiver Receiver which owns the socket.
+ * @param[in] shard Index of the shard, from 0 to EtcPalUdpReceiverConfig::num_shards - 1.
+ * @return The socket, or #ETCPAL_SOCKET_INVALID if an argument was invalid.
+ */
+etcpal_socket_t etcpal_udp_receiver_get_socket(const EtcPalUdpReceiver* receiver, size_t shard)
+{
+  if (!receiver || shard >= receiver->config.num_shards)
+    return ETCPAL_SOCKET_INVALID;
+  return receiver->shards[shard].socket;
+}
+
+etcpal_error_t open_shard_socket(UdpReceiverShard* shard, const EtcPalSockAddr* bind_addr)
+{
+  unsigned int   family = (ETCPAL_IP_IS_V6(&bind_addr->ip) ? ETCPAL_AF_INET6 : ETCPAL_AF_INET);
+  etcpal_error_t res = etcpal_socket(family, ETCPAL_SOCK_DGRAM, &shard->socket);
+  if (res != kEtcPalErrOk)
+  {
+    shard->socket = ETCPAL_SOCKET_INVALID;
+    return res;
+  }
+
+  if (shard->config->num_shards > 1)
+  {
+    int value = 1;
+    if (etcpal_setsockopt(shard->socket, ETCPAL_SOL_SOCKET, ETCPAL_SO_REUSEPORT, &value, sizeof value) != kEtcPalErrOk)
+      return kEtcPalErrNotImpl;
+  }
+
+  res = etcpal_bind(shard->socket, bind_addr);
+  if (res == kEtcPalErrOk)
+    res = etcpal_setblocking(shard->socket, false);
+  return res;
+}
+
+etcpal_error_t start_shard(UdpReceiverShard* shard)
+{
+  const EtcPalUdpReceiverConfig* config = shard->config;
+
+  shard->buffers = (uint8_t*)malloc(UDP_RECEIVER_BATCH_SIZE * config->max_datagram_size);
+  if (!shard->buffers)
+    return kEtcPalErrNoMem;
+  for (size_t i = 0; i < UDP_RECEIVER_BATCH_SIZE; ++i)
+    shard->msgs[i].buf = &shard->buffers[i * config->max_datagram_size];
+
+  etcpal_error_t res = etcpal_poll_context_init(&shard->poll_context);
+  if (res != kEtcPalErrOk)
+    return res;
+  shard->poll_context_valid = true;
+
+  res = etcpal_poll_add_socket(&shard->poll_context, shard->socket, ETCPAL_POLL_IN, NULL);
+  if (res != kEtcPalErrOk)
+    return res;
+
+  // Shutdown is signaled by removing the socket and waking the thread. Where wakeups are not
+  // available, the thread waits with a timeout instead so that it notices the removal.
+  // Testing for support leaves a wakeup pending, which the thread discards.
+  if (etcpal_poll_context_wake(&shard->poll_context) == kEtcPalErrOk)
+    shard->wait_timeout_ms = ETCPAL_WAIT_FOREVER;
+  else
+    shard->wait_timeout_ms = UDP_RECEIVER_SHUTDOWN_POLL_INTERVAL_MS;
+
+  char thread_name[UDP_RECEIVER_THREAD_NAME_SIZE];
+  snprintf(thread_name, sizeof thread_name, "udp_recv_%u", (unsigned int)shard->index);
+
+  EtcPalThreadParams params = ETCPAL_THREAD_PARAMS_INIT;
+  params.priority = config->thread_priority;
+  params.stack_size = config->thread_stack_size;
+  params.thread_name = thread_name;
+
+  res = etcpal_thread_create(&shard->thread, &params, shard_thread, shard);
+  if (res != kEtcPalErrOk)
+    return res;
+  shard->thread_running = true;
+
+  if (config->pin_threads)
+  {
+    res = etcpal_thread_set_affinity(&shard->thread, config->first_cpu + (unsigned int)shard->index);
+    if (res == kEtcPalErrNotImpl)
+      res = kEtcPalErrOk;
+  }
+  return res;
+}
+
+void stop_shard(UdpReceiverShard* shard)
+{
+  if (shard->thread_running)
+  {
+    etcpal_poll_remove_socket(&shard->poll_context, shard->socket);
+    etcpal_poll_context_wake(&shard->poll_context);
+    etcpal_thread_join(&shard->thread);
+  }
+  if (shard->poll_context_valid)
+    etcpal_poll_context_deinit(&shard->poll_context);
+  if (shard->socket != ETCPAL_SOCKET_INVALID)
+    etcpal_close(shard->socket);
+  if (shard->buffers)
+    free(shard->buffers);
+}
+
+void shard_thread(void* arg)
+{
+  UdpReceiverShard* shard = (UdpReceiverShard*)arg;
+
+  // The thread runs until its socket is removed from the poll context.
+  EtcPalPollEvent event;
+  etcpal_error_t  res = kEtcPalErrOk;
+  while (res != kEtcPalErrNoSockets && res != kEtcPalErrInvalid)
+  {
+    res = etcpal_poll_wait(&shard->poll_context, &event, shard->wait_timeout_ms);
+    if (res == kEtcPalErrOk)
+    {
+      // Receiving also reports and clears a pending socket error, which would otherwise be
+      // reported again by every wait.
+      if (event.events & (ETCPAL_POLL_IN | ETCPAL_POLL_ERR))
+        receive_datagrams(shard);
+    }
+    else if (res != kEtcPalErrTimedOut && res != kEtcPalErrWoken && res != kEtcPalErrNoSockets &&
+             res != kEtcPalErrInvalid)
+    {
+      etcpal_thread_sleep(UDP_RECEIVER_ERROR_BACKOFF_MS);
+    }
+  }
+}
+
+void receive_datagrams(UdpReceiverShard* shard)
+{
+  const EtcPalUdpReceiverConfig* config = shard->config;
+
+  for (size_t i = 0; i < UDP_RECEIVER_BATCH_SIZE; ++i)
+  {
+    shard->msgs[i].len = config->max_datagram_size;
+    shard->msgs[i].addr = &shard->addrs[i];
+  }
+
+  // Errors (including kEtcPalErrWouldBlock) are not fatal; the socket is polled again.
+  int num_msgs = etcpal_recvmmsg(shard->socket, shard->msgs, UDP_RECEIVER_BATCH_SIZE, 0);
+  for (int i = 0; i < num_msgs; ++i)
+  {
+    config->callback((const uint8_t*)shard->msgs[i].buf, shard->msgs[i].msg_len, &shard->addrs[i], shard->index,
+                     config->context);
+  }
+}
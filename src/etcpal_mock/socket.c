@@ -29,16 +29,37 @@ DEFINE_FAKE_VALUE_FUNC(etcpal_error_t, etcpal_getsockopt, etcpal_socket_t, int,
 DEFINE_FAKE_VALUE_FUNC(etcpal_error_t, etcpal_listen, etcpal_socket_t, int);
 DEFINE_FAKE_VALUE_FUNC(int, etcpal_recv, etcpal_socket_t, void*, size_t, int);
 DEFINE_FAKE_VALUE_FUNC(int, etcpal_recvfrom, etcpal_socket_t, void*, size_t, int, EtcPalSockAddr*);
+DEFINE_FAKE_VALUE_FUNC(int, etcpal_recvmmsg, etcpal_socket_t, EtcPalMmsgHdr*, size_t, int);
+DEFINE_FAKE_VALUE_FUNC(int, etcpal_recvmsg, etcpal_socket_t, EtcPalMsgHdr*, int);
 DEFINE_FAKE_VALUE_FUNC(int, etcpal_send, etcpal_socket_t, const void*, size_t, int);
+DEFINE_FAKE_VALUE_FUNC(int, etcpal_sendmmsg, etcpal_socket_t, EtcPalMmsgHdr*, size_t, int);
+DEFINE_FAKE_VALUE_FUNC(int, etcpal_sendmsg, etcpal_socket_t, const EtcPalMsgHdr*, int);
 DEFINE_FAKE_VALUE_FUNC(int, etcpal_sendto, etcpal_socket_t, const void*, size_t, int, const EtcPalSockAddr*);
+DEFINE_FAKE_VALUE_FUNC(int,
+                       etcpal_sendto_segmented,
+                       etcpal_socket_t,
+                       const void*,
+                       size_t,
+                       size_t,
+                       int,
+                       const EtcPalSockAddr*);
 DEFINE_FAKE_VALUE_FUNC(etcpal_error_t, etcpal_setsockopt, etcpal_socket_t, int, int, const void*, size_t);
 DEFINE_FAKE_VALUE_FUNC(etcpal_error_t, etcpal_shutdown, etcpal_socket_t, int);
 DEFINE_FAKE_VALUE_FUNC(etcpal_error_t, etcpal_socket, unsigned int, unsigned int, etcpal_socket_t*);
 
+DEFINE_FAKE_VALUE_FUNC(bool, etcpal_cmsg_firsthdr, EtcPalMsgHdr*, EtcPalCMsgHdr*);
+DEFINE_FAKE_VALUE_FUNC(bool, etcpal_cmsg_nxthdr, EtcPalMsgHdr*, const EtcPalCMsgHdr*, EtcPalCMsgHdr*);
+DEFINE_FAKE_VALUE_FUNC(bool, etcpal_cmsg_to_pktinfo, const EtcPalCMsgHdr*, EtcPalPktInfo*);
+DEFINE_FAKE_VALUE_FUNC(bool, etcpal_cmsg_to_timestamp, const EtcPalCMsgHdr*, EtcPalRecvTimestamp*);
+DEFINE_FAKE_VALUE_FUNC(bool, etcpal_cmsg_to_udp_gro, const EtcPalCMsgHdr*, size_t*);
+DEFINE_FAKE_VALUE_FUNC(int, etcpal_read_zerocopy_completions, etcpal_socket_t, EtcPalZerocopyCompletion*, size_t);
+
 DEFINE_FAKE_VALUE_FUNC(etcpal_error_t, etcpal_setblocking, etcpal_socket_t, bool);
 
 DEFINE_FAKE_VALUE_FUNC(etcpal_error_t, etcpal_poll_context_init, EtcPalPollContext*);
 DEFINE_FAKE_VOID_FUNC(etcpal_poll_context_deinit, EtcPalPollContext*);
+DEFINE_FAKE_VALUE_FUNC(etcpal_error_t, etcpal_poll_context_wake, EtcPalPollContext*);
+DEFINE_FAKE_VALUE_FUNC(etcpal_error_t, etcpal_poll_context_set_spin_time, EtcPalPollContext*, unsigned int);
 DEFINE_FAKE_VALUE_FUNC(etcpal_error_t,
                        etcpal_poll_add_socket,
                        EtcPalPollContext*,
@@ -53,6 +74,7 @@ DEFINE_FAKE_VALUE_FUNC(etcpal_error_t,
                        void*);
 DEFINE_FAKE_VOID_FUNC(etcpal_poll_remove_socket, EtcPalPollContext*, etcpal_socket_t);
 DEFINE_FAKE_VALUE_FUNC(etcpal_error_t, etcpal_poll_wait, EtcPalPollContext*, EtcPalPollEvent*, int);
+DEFINE_FAKE_VALUE_FUNC(int, etcpal_poll_wait_many, EtcPalPollContext*, EtcPalPollEvent*, size_t, int);
 
 DEFINE_FAKE_VALUE_FUNC(etcpal_error_t,
                        etcpal_getaddrinfo,
@@ -75,18 +97,32 @@ void etcpal_socket_reset_all_fakes(void)
   RESET_FAKE(etcpal_listen);
   RESET_FAKE(etcpal_recv);
   RESET_FAKE(etcpal_recvfrom);
+  RESET_FAKE(etcpal_recvmmsg);
+  RESET_FAKE(etcpal_recvmsg);
   RESET_FAKE(etcpal_send);
+  RESET_FAKE(etcpal_sendmmsg);
+  RESET_FAKE(etcpal_sendmsg);
   RESET_FAKE(etcpal_sendto);
+  RESET_FAKE(etcpal_sendto_segmented);
   RESET_FAKE(etcpal_setsockopt);
   RESET_FAKE(etcpal_shutdown);
   RESET_FAKE(etcpal_socket);
+  RESET_FAKE(etcpal_cmsg_firsthdr);
+  RESET_FAKE(etcpal_cmsg_nxthdr);
+  RESET_FAKE(etcpal_cmsg_to_pktinfo);
+  RESET_FAKE(etcpal_cmsg_to_timestamp);
+  RESET_FAKE(etcpal_cmsg_to_udp_gro);
+  RESET_FAKE(etcpal_read_zerocopy_completions);
   RESET_FAKE(etcpal_setblocking);
   RESET_FAKE(etcpal_poll_context_init);
   RESET_FAKE(etcpal_poll_context_deinit);
+  RESET_FAKE(etcpal_poll_context_wake);
+  RESET_FAKE(etcpal_poll_context_set_spin_time);
   RESET_FAKE(etcpal_poll_add_socket);
   RESET_FAKE(etcpal_poll_modify_socket);
   RESET_FAKE(etcpal_poll_remove_socket);
   RESET_FAKE(etcpal_poll_wait);
+  RESET_FAKE(etcpal_poll_wait_many);
   RESET_FAKE(etcpal_getaddrinfo);
   RESET_FAKE(etcpal_nextaddr);
   RESET_FAKE(etcpal_freeaddrinfo);
@@ -19,6 +19,8 @@
 
 #include "etcpal/queue.h"
 
+#include <stdint.h>
+
 /*************************** Function definitions ****************************/
 
 bool etcpal_queue_create(etcpal_queue_t* id, size_t size, size_t item_size)
@@ -59,6 +61,25 @@ bool etcpal_queue_timed_send(etcpal_queue_t* id, const void* data, int timeout_m
   return false;
 }
 
+size_t etcpal_queue_send_many(etcpal_queue_t* id, const void* data, size_t num_items, int timeout_ms)
+{
+  size_t num_sent = 0;
+  if (id && data)
+  {
+    // FreeRTOS has no batch API, so send the items one at a time. Only the first one waits.
+    const uint8_t* item = (const uint8_t*)data;
+    size_t         item_size = (size_t)uxQueueGetQueueItemSize(*id);
+    TickType_t     ticks_to_wait = pdMS_TO_TICKS(timeout_ms);
+    while (num_sent < num_items && xQueueSendToBack(*id, item, ticks_to_wait) == pdPASS)
+    {
+      ++num_sent;
+      item += item_size;
+      ticks_to_wait = 0;
+    }
+  }
+  return num_sent;
+}
+
 bool etcpal_queue_send_from_isr(etcpal_queue_t* id, const void* data)
 {
   if (id)
@@ -91,6 +112,25 @@ bool etcpal_queue_timed_receive(etcpal_queue_t* id, void* data, int timeout_ms)
   return false;
 }
 
+size_t etcpal_queue_receive_many(etcpal_queue_t* id, void* data, size_t max_items, int timeout_ms)
+{
+  size_t num_received = 0;
+  if (id && data)
+  {
+    // FreeRTOS has no batch API, so receive the items one at a time. Only the first one waits.
+    uint8_t*   item = (uint8_t*)data;
+    size_t     item_size = (size_t)uxQueueGetQueueItemSize(*id);
+    TickType_t ticks_to_wait = pdMS_TO_TICKS(timeout_ms);
+    while (num_received < max_items && xQueueReceive(*id, item, ticks_to_wait) == pdPASS)
+    {
+      ++num_received;
+      item += item_size;
+      ticks_to_wait = 0;
+    }
+  }
+  return num_received;
+}
+
 bool etcpal_queue_receive_from_isr(etcpal_queue_t* id, void* data)
 {
   BaseType_t higherPrioTaskWoken = pdFALSE;
@@ -106,6 +146,40 @@ bool etcpal_queue_receive_from_isr(etcpal_queue_t* id, void* data)
   return false;
 }
 
+// FreeRTOS queues copy items in and out and do not expose their storage, so the in-place functions
+// are not available.
+void* etcpal_queue_reserve(etcpal_queue_t* id, int timeout_ms)
+{
+  ETCPAL_UNUSED_ARG(id);
+  ETCPAL_UNUSED_ARG(timeout_ms);
+  return NULL;
+}
+
+void etcpal_queue_commit(etcpal_queue_t* id, void* slot)
+{
+  ETCPAL_UNUSED_ARG(id);
+  ETCPAL_UNUSED_ARG(slot);
+}
+
+void etcpal_queue_abort(etcpal_queue_t* id, void* slot)
+{
+  ETCPAL_UNUSED_ARG(id);
+  ETCPAL_UNUSED_ARG(slot);
+}
+
+void* etcpal_queue_peek(etcpal_queue_t* id, int timeout_ms)
+{
+  ETCPAL_UNUSED_ARG(id);
+  ETCPAL_UNUSED_ARG(timeout_ms);
+  return NULL;
+}
+
+void etcpal_queue_release(etcpal_queue_t* id, const void* item)
+{
+  ETCPAL_UNUSED_ARG(id);
+  ETCPAL_UNUSED_ARG(item);
+}
+
 bool etcpal_queue_reset(etcpal_queue_t* id)
 {
   if (id)
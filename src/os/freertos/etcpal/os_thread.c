@@ -19,6 +19,8 @@
 
 #include "etcpal/thread.h"
 
+#include "etcpal/common.h"
+
 #if !defined(ETCPAL_BUILDING_MOCK_LIB)
 
 static void thread_func_internal(void* pvParameters)
@@ -103,6 +105,14 @@ etcpal_error_t etcpal_thread_terminate(etcpal_thread_t* id)
   return kEtcPalErrOk;
 }
 
+etcpal_error_t etcpal_thread_set_affinity(etcpal_thread_t* id, unsigned int cpu)
+{
+  ETCPAL_UNUSED_ARG(cpu);
+  if (!id)
+    return kEtcPalErrInvalid;
+  return kEtcPalErrNotImpl;
+}
+
 etcpal_thread_os_handle_t etcpal_thread_get_os_handle(etcpal_thread_t* id)
 {
   return (id ? id->tid : ETCPAL_THREAD_OS_HANDLE_INVALID);
@@ -0,0 +1,700 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+#include "etcpal/io_ring.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "etcpal/common.h"
+#include "os_error.h"
+
+/**************************** Private constants ******************************/
+
+/* The low bit of a submission's user_data is set for the ring's internal timeout operations, and
+ * clear for requests made by the application (in which case the rest of the value is the index of
+ * the request in the request table). */
+#define TIMEOUT_USER_DATA_FLAG 1u
+
+/* Submission queue entries reserved for a wait timeout and its removal. */
+#define NUM_RESERVED_SQES 2
+
+/****************************** Private types ********************************/
+
+typedef struct IoRingRequest
+{
+  etcpal_socket_t socket;
+  int             op;
+  int             buffer_index;
+  void*           user_data;
+  int             next_free;
+} IoRingRequest;
+
+struct EtcPalIoRing
+{
+  int  ring_fd;
+  bool sq_poll;
+
+  // Submission queue, shared with the kernel
+  void*                sq_ring;
+  size_t               sq_ring_size;
+  unsigned*            sq_head;
+  unsigned*            sq_tail;
+  unsigned*            sq_ring_mask;
+  unsigned*            sq_ring_entries;
+  unsigned*            sq_flags;
+  unsigned*            sq_array;
+  struct io_uring_sqe* sqes;
+  size_t               sqes_size;
+  unsigned             sq_local_tail;  // Includes entries not yet made visible to the kernel
+
+  // Completion queue, shared with the kernel
+  void*                cq_ring;
+  size_t               cq_ring_size;
+  unsigned*            cq_head;
+  unsigned*            cq_tail;
+  unsigned*            cq_ring_mask;
+  struct io_uring_cqe* cqes;
+
+  // Outstanding application requests
+  IoRingRequest* requests;
+  int            num_requests;
+  int            num_outstanding;
+  int            free_request;
+
+  // Registered buffers
+  uint8_t* buffers;
+  size_t   num_buffers;
+  size_t   buffer_size;
+
+  // Wait timeout state. The timespec must stay valid until the kernel has consumed the timeout
+  // submission, which is asynchronous when the submission queue is polled.
+  struct __kernel_timespec timeout_ts;
+  uint64_t                 timeout_seq;
+};
+
+/*********************** Private function prototypes *************************/
+
+static etcpal_error_t map_rings(EtcPalIoRing* ring, const struct io_uring_params* params);
+static void           unmap_rings(EtcPalIoRing* ring);
+static etcpal_error_t register_buffers(EtcPalIoRing* ring, size_t num_buffers, size_t buffer_size);
+
+static struct io_uring_sqe* get_sqe(EtcPalIoRing* ring);
+static unsigned             flush_sq(EtcPalIoRing* ring);
+static etcpal_error_t       start_request(EtcPalIoRing*   ring,
+                                          uint8_t         opcode,
+                                          int             op,
+                                          etcpal_socket_t socket,
+                                          const void*     buf,
+                                          size_t          len,
+                                          int             buffer_index,
+                                          void*           user_data);
+static size_t               reap_completions(EtcPalIoRing*       ring,
+                                             EtcPalIoCompletion* completions,
+                                             size_t              max_completions,
+                                             uint64_t            timeout_user_data,
+                                             bool*               timed_out);
+
+static int io_uring_setup(unsigned int entries, struct io_uring_params* params);
+static int io_uring_enter(int ring_fd, unsigned int to_submit, unsigned int min_complete, unsigned int flags);
+static int io_uring_register(int ring_fd, unsigned int opcode, const void* arg, unsigned int nr_args);
+
+/*************************** Function definitions ****************************/
+
+/**
+ * @brief Create a new io ring.
+ *
+ * Sets up an io_uring instance with room for config->queue_depth outstanding operations, and
+ * allocates and registers the buffers requested by the configuration.
+ *
+ * @param[in] config Configuration for the new ring.
+ * @param[out] ring Filled in with the new ring on success.
+ * @return #kEtcPalErrOk: Ring created successfully.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return #kEtcPalErrNoMem: Couldn't allocate memory for the ring or its buffers.
+ * @return #kEtcPalErrNotImpl: The running kernel does not support io_uring.
+ * @return Other codes translated from system error codes are possible.
+ */
+etcpal_error_t etcpal_io_ring_create(const EtcPalIoRingConfig* config, EtcPalIoRing** ring)
+{
+  if (!config || !ring || config->queue_depth == 0 || config->num_buffers > INT_MAX ||
+      (config->num_buffers > 0 && config->buffer_size == 0))
+  {
+    return kEtcPalErrInvalid;
+  }
+
+  EtcPalIoRing* new_ring = (EtcPalIoRing*)calloc(1, sizeof(EtcPalIoRing));
+  if (!new_ring)
+    return kEtcPalErrNoMem;
+
+  struct io_uring_params params;
+  memset(&params, 0, sizeof params);
+  if (config->sq_poll_idle_ms > 0)
+  {
+    params.flags |= IORING_SETUP_SQPOLL;
+    params.sq_thread_idle = config->sq_poll_idle_ms;
+  }
+
+  // Make room for the submissions used internally to implement wait timeouts.
+  new_ring->ring_fd = io_uring_setup(config->queue_depth + NUM_RESERVED_SQES, &params);
+  if (new_ring->ring_fd < 0)
+  {
+    etcpal_error_t res = (errno == ENOSYS ? kEtcPalErrNotImpl : errno_os_to_etcpal(errno));
+    free(new_ring);
+    return res;
+  }
+  new_ring->sq_poll = ((params.flags & IORING_SETUP_SQPOLL) != 0);
+
+  etcpal_error_t res = map_rings(new_ring, &params);
+  if (res == kEtcPalErrOk)
+  {
+    new_ring->num_requests = (int)(params.sq_entries - NUM_RESERVED_SQES);
+    new_ring->requests = (IoRingRequest*)calloc((size_t)new_ring->num_requests, sizeof(IoRingRequest));
+    if (new_ring->requests)
+    {
+      for (int i = 0; i < new_ring->num_requests; ++i)
+        new_ring->requests[i].next_free = i + 1;
+      new_ring->requests[new_ring->num_requests - 1].next_free = -1;
+      new_ring->free_request = 0;
+    }
+    else
+    {
+      res = kEtcPalErrNoMem;
+    }
+  }
+  if (res == kEtcPalErrOk && config->num_buffers > 0)
+    res = register_buffers(new_ring, config->num_buffers, config->buffer_size);
+
+  if (res != kEtcPalErrOk)
+  {
+    etcpal_io_ring_destroy(new_ring);
+    return res;
+  }
+
+  *ring = new_ring;
+  return kEtcPalErrOk;
+}
+
+/**
+ * @brief Destroy an io ring.
+ *
+ * Any operations still outstanding are canceled, and their completions are not reported. The
+ * ring's registered buffers are freed.
+ *
+ * @param[in] ring Ring to destroy.
+ */
+void etcpal_io_ring_destroy(EtcPalIoRing* ring)
+{
+  if (!ring)
+    return;
+
+  if (ring->ring_fd >= 0)
+  {
+    unmap_rings(ring);
+    close(ring->ring_fd);
+  }
+  if (ring->buffers)
+    free(ring->buffers);
+  if (ring->requests)
+    free(ring->requests);
+  free(ring);
+}
+
+/**
+ * @brief Get one of the buffers registered with an io ring.
+ *
+ * @param[in] ring Ring which owns the buffer.
+ * @param[in] buffer_index Index of the buffer, from 0 to EtcPalIoRingConfig::num_buffers - 1.
+ * @return Pointer to the buffer, which is EtcPalIoRingConfig::buffer_size bytes long, or NULL if
+ *         an argument was invalid.
+ */
+void* etcpal_io_ring_buffer(EtcPalIoRing* ring, int buffer_index)
+{
+  if (!ring || buffer_index < 0 || (size_t)buffer_index >= ring->num_buffers)
+    return NULL;
+  return &ring->buffers[(size_t)buffer_index * ring->buffer_size];
+}
+
+/**
+ * @brief Start receiving data on a socket into an application buffer.
+ *
+ * The operation is queued and is submitted to the kernel by the next call to
+ * etcpal_io_ring_submit() or etcpal_io_ring_wait(). The buffer must remain valid until the
+ * operation's completion has been retrieved. The receive completes as soon as any data is
+ * available, similarly to etcpal_recv().
+ *
+ * @param[in] ring Ring on which to start the operation.
+ * @param[in] socket Socket on which to receive.
+ * @param[out] buf Buffer into which to receive.
+ * @param[in] len Size in bytes of buf.
+ * @param[in] user_data Pointer which will be passed back in the operation's completion.
+ * @return #kEtcPalErrOk: Operation queued successfully.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return #kEtcPalErrNoMem: The maximum number of operations (EtcPalIoRingConfig::queue_depth) is
+ *         already outstanding.
+ */
+etcpal_error_t etcpal_io_ring_recv(EtcPalIoRing* ring, etcpal_socket_t socket, void* buf, size_t len, void* user_data)
+{
+  if (!buf)
+    return kEtcPalErrInvalid;
+  return start_request(ring, IORING_OP_RECV, ETCPAL_IO_OP_RECV, socket, buf, len, -1, user_data);
+}
+
+/**
+ * @brief Start sending data from an application buffer on a socket.
+ *
+ * The operation is queued and is submitted to the kernel by the next call to
+ * etcpal_io_ring_submit() or etcpal_io_ring_wait(). The buffer must remain valid until the
+ * operation's completion has been retrieved. As with etcpal_send(), the operation may complete
+ * having sent fewer bytes than requested on a stream socket.
+ *
+ * @param[in] ring Ring on which to start the operation.
+ * @param[in] socket Socket on which to send.
+ * @param[in] buf Data to send.
+ * @param[in] len Size in bytes of buf.
+ * @param[in] user_data Pointer which will be passed back in the operation's completion.
+ * @return #kEtcPalErrOk: Operation queued successfully.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return #kEtcPalErrNoMem: The maximum number of operations (EtcPalIoRingConfig::queue_depth) is
+ *         already outstanding.
+ */
+etcpal_error_t etcpal_io_ring_send(EtcPalIoRing*   ring,
+                                   etcpal_socket_t socket,
+                                   const void*     buf,
+                                   size_t          len,
+                                   void*           user_data)
+{
+  if (!buf)
+    return kEtcPalErrInvalid;
+  return start_request(ring, IORING_OP_SEND, ETCPAL_IO_OP_SEND, socket, buf, len, -1, user_data);
+}
+
+/**
+ * @brief Start receiving data on a socket into one of the ring's registered buffers.
+ *
+ * Like etcpal_io_ring_recv(), but the kernel does not need to map the buffer for each operation.
+ * Use etcpal_io_ring_buffer() to access the data once the operation completes.
+ *
+ * @param[in] ring Ring on which to start the operation.
+ * @param[in] socket Socket on which to receive.
+ * @param[in] buffer_index Registered buffer into which to receive.
+ * @param[in] len Maximum number of bytes to receive; must not exceed
+ *                EtcPalIoRingConfig::buffer_size.
+ * @param[in] user_data Pointer which will be passed back in the operation's completion.
+ * @return #kEtcPalErrOk: Operation queued successfully.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return #kEtcPalErrNoMem: The maximum number of operations (EtcPalIoRingConfig::queue_depth) is
+ *         already outstanding.
+ */
+etcpal_error_t etcpal_io_ring_recv_fixed(EtcPalIoRing*   ring,
+                                         etcpal_socket_t socket,
+                                         int             buffer_index,
+                                         size_t          len,
+                                         void*           user_data)
+{
+  void* buf = etcpal_io_ring_buffer(ring, buffer_index);
+  if (!buf || len > ring->buffer_size)
+    return kEtcPalErrInvalid;
+  return start_request(ring, IORING_OP_READ_FIXED, ETCPAL_IO_OP_RECV, socket, buf, len, buffer_index, user_data);
+}
+
+/**
+ * @brief Start sending data on a socket from one of the ring's registered buffers.
+ *
+ * Like etcpal_io_ring_send(), but the kernel does not need to map the buffer for each operation.
+ * Use etcpal_io_ring_buffer() to fill in the data before starting the operation.
+ *
+ * @param[in] ring Ring on which to start the operation.
+ * @param[in] socket Socket on which to send.
+ * @param[in] buffer_index Registered buffer containing the data to send.
+ * @param[in] len Number of bytes to send; must not exceed EtcPalIoRingConfig::buffer_size.
+ * @param[in] user_data Pointer which will be passed back in the operation's completion.
+ * @return #kEtcPalErrOk: Operation queued successfully.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return #kEtcPalErrNoMem: The maximum number of operations (EtcPalIoRingConfig::queue_depth) is
+ *         already outstanding.
+ */
+etcpal_error_t etcpal_io_ring_send_fixed(EtcPalIoRing*   ring,
+                                         etcpal_socket_t socket,
+                                         int             buffer_index,
+                                         size_t          len,
+                                         void*           user_data)
+{
+  void* buf = etcpal_io_ring_buffer(ring, buffer_index);
+  if (!buf || len > ring->buffer_size)
+    return kEtcPalErrInvalid;
+  return start_request(ring, IORING_OP_WRITE_FIXED, ETCPAL_IO_OP_SEND, socket, buf, len, buffer_index, user_data);
+}
+
+/**
+ * @brief Submit queued operations to the kernel without waiting for any to complete.
+ *
+ * etcpal_io_ring_wait() also submits queued operations, so this only needs to be called to start
+ * operations earlier than the next wait. When submission queue polling is enabled, this does not
+ * make a system call unless the kernel's polling thread has gone idle.
+ *
+ * @param[in] ring Ring on which to submit operations.
+ * @return The number of operations submitted (success) or #etcpal_error_t code from system (error
+ *         occurred).
+ */
+int etcpal_io_ring_submit(EtcPalIoRing* ring)
+{
+  if (!ring)
+    return (int)kEtcPalErrInvalid;
+
+  unsigned to_submit = flush_sq(ring);
+  if (to_submit == 0)
+    return 0;
+
+  if (ring->sq_poll)
+  {
+    if (__atomic_load_n(ring->sq_flags, __ATOMIC_RELAXED) & IORING_SQ_NEED_WAKEUP)
+      io_uring_enter(ring->ring_fd, 0, 0, IORING_ENTER_SQ_WAKEUP);
+    return (int)to_submit;
+  }
+
+  int res = io_uring_enter(ring->ring_fd, to_submit, 0, 0);
+  return (res >= 0 ? res : (int)errno_os_to_etcpal(errno));
+}
+
+/**
+ * @brief Wait for operations on an io ring to complete.
+ *
+ * Submits any queued operations, then retrieves up to max_completions completed operations,
+ * waiting up to timeout_ms for at least one to complete. Completions which are already available
+ * are retrieved without a system call. Each completed operation is reported exactly once.
+ *
+ * @param[in] ring Ring on which to wait.
+ * @param[out] completions Array to fill in with the completed operations.
+ * @param[in] max_completions Size of the completions array.
+ * @param[in] timeout_ms How long to wait for an operation to complete, in milliseconds. Use
+ *                       #ETCPAL_WAIT_FOREVER to wait indefinitely.
+ * @return The number of completions filled in (success).
+ * @return #kEtcPalErrTimedOut: No operations completed before the timeout expired.
+ * @return #kEtcPalErrNoData: There are no operations outstanding on the ring.
+ * @return #kEtcPalErrInvalid: Invalid argument.
+ * @return Other codes translated from system error codes are possible.
+ */
+int etcpal_io_ring_wait(EtcPalIoRing* ring, EtcPalIoCompletion* completions, size_t max_completions, int timeout_ms)
+{
+  if (!ring || !completions || max_completions == 0)
+    return (int)kEtcPalErrInvalid;
+
+  size_t num_completions = reap_completions(ring, completions, max_completions, 0, NULL);
+  if (num_completions > 0 || timeout_ms == 0)
+  {
+    int submit_res = etcpal_io_ring_submit(ring);
+    if (num_completions > 0)
+      return (int)num_completions;
+    if (submit_res < 0)
+      return submit_res;
+
+    num_completions = reap_completions(ring, completions, max_completions, 0, NULL);
+    if (num_completions > 0)
+      return (int)num_completions;
+    return (ring->num_outstanding == 0 ? (int)kEtcPalErrNoData : (int)kEtcPalErrTimedOut);
+  }
+
+  if (ring->num_outstanding == 0)
+    return (int)kEtcPalErrNoData;
+
+  uint64_t timeout_user_data = 0;
+  if (timeout_ms > 0)
+  {
+    struct io_uring_sqe* sqe = get_sqe(ring);
+    if (sqe)
+    {
+      ring->timeout_ts.tv_sec = timeout_ms / 1000;
+      ring->timeout_ts.tv_nsec = (long long)(timeout_ms % 1000) * 1000000;
+      timeout_user_data = (++ring->timeout_seq << 1) | TIMEOUT_USER_DATA_FLAG;
+
+      sqe->opcode = IORING_OP_TIMEOUT;
+      sqe->fd = -1;
+      sqe->addr = (uint64_t)(uintptr_t)&ring->timeout_ts;
+      sqe->len = 1;
+      sqe->user_data = timeout_user_data;
+    }
+  }
+
+  bool timed_out = false;
+  while (num_completions == 0 && !timed_out)
+  {
+    unsigned to_submit = flush_sq(ring);
+    unsigned flags = IORING_ENTER_GETEVENTS;
+    if (ring->sq_poll)
+    {
+      if (__atomic_load_n(ring->sq_flags, __ATOMIC_RELAXED) & IORING_SQ_NEED_WAKEUP)
+        flags |= IORING_ENTER_SQ_WAKEUP;
+      to_submit = 0;
+    }
+
+    if (io_uring_enter(ring->ring_fd, to_submit, 1, flags) < 0 && errno != EINTR)
+      return (int)errno_os_to_etcpal(errno);
+
+    num_completions = reap_completions(ring, completions, max_completions, timeout_user_data, &timed_out);
+  }
+
+  // Cancel the timeout if it is still pending, so that timers don't accumulate in the kernel. The
+  // removal is submitted along with the next batch of operations.
+  if (timeout_user_data != 0 && !timed_out)
+  {
+    struct io_uring_sqe* sqe = get_sqe(ring);
+    if (sqe)
+    {
+      sqe->opcode = IORING_OP_TIMEOUT_REMOVE;
+      sqe->fd = -1;
+      sqe->addr = timeout_user_data;
+      sqe->user_data = TIMEOUT_USER_DATA_FLAG;
+    }
+  }
+
+  return (num_completions > 0 ? (int)num_completions : (int)kEtcPalErrTimedOut);
+}
+
+etcpal_error_t map_rings(EtcPalIoRing* ring, const struct io_uring_params* params)
+{
+  ring->sq_ring_size = params->sq_off.array + params->sq_entries * sizeof(unsigned);
+  ring->cq_ring_size = params->cq_off.cqes + params->cq_entries * sizeof(struct io_uring_cqe);
+
+  // Newer kernels allow the submission and completion rings to share a single mapping.
+  bool single_mmap = ((params->features & IORING_FEAT_SINGLE_MMAP) != 0);
+  if (single_mmap)
+  {
+    if (ring->cq_ring_size > ring->sq_ring_size)
+      ring->sq_ring_size = ring->cq_ring_size;
+    ring->cq_ring_size = ring->sq_ring_size;
+  }
+
+  ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->ring_fd,
+                       IORING_OFF_SQ_RING);
+  if (ring->sq_ring == MAP_FAILED)
+  {
+    ring->sq_ring = NULL;
+    return errno_os_to_etcpal(errno);
+  }
+
+  if (single_mmap)
+  {
+    ring->cq_ring = ring->sq_ring;
+  }
+  else
+  {
+    ring->cq_ring = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->ring_fd,
+                         IORING_OFF_CQ_RING);
+    if (ring->cq_ring == MAP_FAILED)
+    {
+      ring->cq_ring = NULL;
+      return errno_os_to_etcpal(errno);
+    }
+  }
+
+  ring->sqes_size = params->sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes = (struct io_uring_sqe*)mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                          ring->ring_fd, IORING_OFF_SQES);
+  if (ring->sqes == MAP_FAILED)
+  {
+    ring->sqes = NULL;
+    return errno_os_to_etcpal(errno);
+  }
+
+  uint8_t* sq = (uint8_t*)ring->sq_ring;
+  ring->sq_head = (unsigned*)(sq + params->sq_off.head);
+  ring->sq_tail = (unsigned*)(sq + params->sq_off.tail);
+  ring->sq_ring_mask = (unsigned*)(sq + params->sq_off.ring_mask);
+  ring->sq_ring_entries = (unsigned*)(sq + params->sq_off.ring_entries);
+  ring->sq_flags = (unsigned*)(sq + params->sq_off.flags);
+  ring->sq_array = (unsigned*)(sq + params->sq_off.array);
+  ring->sq_local_tail = *ring->sq_tail;
+
+  uint8_t* cq = (uint8_t*)ring->cq_ring;
+  ring->cq_head = (unsigned*)(cq + params->cq_off.head);
+  ring->cq_tail = (unsigned*)(cq + params->cq_off.tail);
+  ring->cq_ring_mask = (unsigned*)(cq + params->cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe*)(cq + params->cq_off.cqes);
+  return kEtcPalErrOk;
+}
+
+void unmap_rings(EtcPalIoRing* ring)
+{
+  if (ring->sqes)
+    munmap(ring->sqes, ring->sqes_size);
+  if (ring->cq_ring && ring->cq_ring != ring->sq_ring)
+    munmap(ring->cq_ring, ring->cq_ring_size);
+  if (ring->sq_ring)
+    munmap(ring->sq_ring, ring->sq_ring_size);
+}
+
+etcpal_error_t register_buffers(EtcPalIoRing* ring, size_t num_buffers, size_t buffer_size)
+{
+  struct iovec* iovs = (struct iovec*)calloc(num_buffers, sizeof(struct iovec));
+  if (!iovs)
+    return kEtcPalErrNoMem;
+
+  void* buffers = NULL;
+  if (posix_memalign(&buffers, (size_t)sysconf(_SC_PAGESIZE), num_buffers * buffer_size) != 0)
+  {
+    free(iovs);
+    return kEtcPalErrNoMem;
+  }
+  ring->buffers = (uint8_t*)buffers;
+  ring->num_buffers = num_buffers;
+  ring->buffer_size = buffer_size;
+
+  for (size_t i = 0; i < num_buffers; ++i)
+  {
+    iovs[i].iov_base = &ring->buffers[i * buffer_size];
+    iovs[i].iov_len = buffer_size;
+  }
+
+  int res = io_uring_register(ring->ring_fd, IORING_REGISTER_BUFFERS, iovs, (unsigned int)num_buffers);
+  free(iovs);
+  return (res == 0 ? kEtcPalErrOk : errno_os_to_etcpal(errno));
+}
+
+// Get the next free submission queue entry, or NULL if the queue is full.
+struct io_uring_sqe* get_sqe(EtcPalIoRing* ring)
+{
+  unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+  if (ring->sq_local_tail - head >= *ring->sq_ring_entries)
+    return NULL;
+
+  unsigned             index = ring->sq_local_tail & *ring->sq_ring_mask;
+  struct io_uring_sqe* sqe = &ring->sqes[index];
+  memset(sqe, 0, sizeof(struct io_uring_sqe));
+  ring->sq_array[index] = index;
+  ++ring->sq_local_tail;
+  return sqe;
+}
+
+// Make any new submission queue entries visible to the kernel. Returns the number of entries which
+// the kernel has not yet consumed.
+unsigned flush_sq(EtcPalIoRing* ring)
+{
+  __atomic_store_n(ring->sq_tail, ring->sq_local_tail, __ATOMIC_RELEASE);
+  if (ring->sq_poll)
+  {
+    // The kernel thread only sets IORING_SQ_NEED_WAKEUP after checking the tail, so the tail store
+    // must be ordered before the caller's check of the flags.
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  }
+  return ring->sq_local_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+}
+
+etcpal_error_t start_request(EtcPalIoRing*   ring,
+                             uint8_t         opcode,
+                             int             op,
+                             etcpal_socket_t socket,
+                             const void*     buf,
+                             size_t          len,
+                             int             buffer_index,
+                             void*           user_data)
+{
+  if (!ring || socket == ETCPAL_SOCKET_INVALID || len > INT_MAX)
+    return kEtcPalErrInvalid;
+  if (ring->free_request < 0)
+    return kEtcPalErrNoMem;
+
+  struct io_uring_sqe* sqe = get_sqe(ring);
+  if (!sqe)
+    return kEtcPalErrNoMem;
+
+  int            request_index = ring->free_request;
+  IoRingRequest* request = &ring->requests[request_index];
+  ring->free_request = request->next_free;
+  ++ring->num_outstanding;
+
+  request->socket = socket;
+  request->op = op;
+  request->buffer_index = buffer_index;
+  request->user_data = user_data;
+
+  sqe->opcode = opcode;
+  sqe->fd = socket;
+  sqe->addr = (uint64_t)(uintptr_t)buf;
+  sqe->len = (uint32_t)len;
+  if (buffer_index >= 0)
+    sqe->buf_index = (uint16_t)buffer_index;
+  sqe->user_data = (uint64_t)request_index << 1;
+  return kEtcPalErrOk;
+}
+
+// Retrieve available completions of application requests. Completions of the ring's internal
+// timeouts are consumed without being reported; timed_out is set if the one identified by
+// timeout_user_data is found.
+size_t reap_completions(EtcPalIoRing*       ring,
+                        EtcPalIoCompletion* completions,
+                        size_t              max_completions,
+                        uint64_t            timeout_user_data,
+                        bool*               timed_out)
+{
+  unsigned head = *ring->cq_head;
+  unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+  size_t   num_completions = 0;
+
+  for (; head != tail && num_completions < max_completions; ++head)
+  {
+    const struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_ring_mask];
+    if (cqe->user_data & TIMEOUT_USER_DATA_FLAG)
+    {
+      if (timeout_user_data != 0 && cqe->user_data == timeout_user_data)
+        *timed_out = true;
+      continue;
+    }
+
+    int                 request_index = (int)(cqe->user_data >> 1);
+    IoRingRequest*      request = &ring->requests[request_index];
+    EtcPalIoCompletion* completion = &completions[num_completions++];
+    completion->socket = request->socket;
+    completion->op = request->op;
+    completion->result = (cqe->res >= 0 ? cqe->res : (int)errno_os_to_etcpal(-cqe->res));
+    completion->buffer_index = request->buffer_index;
+    completion->user_data = request->user_data;
+
+    request->next_free = ring->free_request;
+    ring->free_request = request_index;
+    --ring->num_outstanding;
+  }
+
+  __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+  return num_completions;
+}
+
+int io_uring_setup(unsigned int entries, struct io_uring_params* params)
+{
+  return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+int io_uring_enter(int ring_fd, unsigned int to_submit, unsigned int min_complete, unsigned int flags)
+{
+  return (int)syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+int io_uring_register(int ring_fd, unsigned int opcode, const void* arg, unsigned int nr_args)
+{
+  return (int)syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args);
+}
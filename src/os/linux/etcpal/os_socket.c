@@ -17,23 +17,34 @@
  * https://github.com/ETCLabs/EtcPal
  ******************************************************************************/
 
+#define _GNU_SOURCE  // for recvmmsg() and sendmmsg() - this is a Linux-specific file
+
 #include "etcpal/socket.h"
 
 #include <errno.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include <arpa/inet.h>
 #include <fcntl.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
 #include <net/if.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <netinet/udp.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #include "etcpal/common.h"
+#include "etcpal/private/socket.h"
+#include "etcpal/timer.h"
+#include "etcpal/private/socket_stats.h"
 #include "os_error.h"
 
 /**************************** Private constants ******************************/
@@ -42,17 +53,46 @@
  * Here is a random number. */
 #define EPOLL_CREATE_SIZE 1024
 
+/* The maximum number of events that will be retrieved from one call to epoll_wait(). Bounds the
+ * stack usage of etcpal_poll_wait_many(). */
+#define ETCPAL_POLL_MAX_EVENTS_PER_WAIT 64
+
+/* The maximum number of datagrams passed to one call to recvmmsg() or sendmmsg(). Bounds the stack
+ * usage of etcpal_recvmmsg() and etcpal_sendmmsg(). */
+#define ETCPAL_MMSG_MAX_BATCH_SIZE 32
+
+/* Each poll context's socket table is indexed by file descriptor and allocated in chunks of this
+ * many entries, which never move once allocated. */
+#define ETCPAL_POLL_SOCKET_CHUNK_SIZE 256
+
+/* The initial number of chunks which can be referenced by a poll context's socket table. The
+ * directory of chunks is grown as needed to accommodate larger descriptors. */
+#define ETCPAL_POLL_INITIAL_NUM_CHUNKS 4
+
+/* The maximum number of segments the kernel accepts in one UDP_SEGMENT send, and the maximum
+ * payload of the resulting super-datagram. */
+#define UDP_GSO_MAX_SEGMENTS 64
+#define UDP_GSO_MAX_PAYLOAD  65507
+
+/* Older C library headers may not define the UDP offload options. */
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+
 /****************************** Private types ********************************/
 
-/* A struct to track sockets being polled by the etcpal_poll() API */
-typedef struct EtcPalPollSocket
+/* The socket table of a poll context: a directory of chunks of EtcPalPollSocket entries, indexed by
+ * file descriptor. The wait functions read the table without taking the context lock, so neither
+ * chunks nor outgrown directories are freed until the context is deinitialized. */
+typedef struct EtcPalPollSocketTable
 {
-  // 'sock' must always remain as the first member in the struct to facilitate an EtcPalRbTree lookup
-  // shortcut
-  etcpal_socket_t      sock;
-  etcpal_poll_events_t events;
-  void*                user_data;
-} EtcPalPollSocket;
+  struct EtcPalPollSocketTable* prev;  // The outgrown directory this one replaced, if any
+  size_t                        num_chunks;
+  EtcPalPollSocket**            chunks;
+} EtcPalPollSocketTable;
 
 /**************************** Private variables ******************************/
 
@@ -116,13 +156,41 @@ static const int kAiProtMap[ETCPAL_NUM_IPPROTO] =
 
 /* clang-format on */
 
+// Whether the running kernel supports UDP_SEGMENT. Determined in etcpal_socket_init().
+static bool udp_segment_supported;
+
 /*********************** Private function prototypes *************************/
 
+// Helpers for etcpal_sendmsg() and etcpal_recvmsg()
+static void iovecs_etcpal_to_os(const EtcPalMsgHdr* msg, struct iovec* iovs);
+static int  send_flags_etcpal_to_os(int flags);
+
+// Helpers for the control message API
+static void init_control_msghdr(const EtcPalMsgHdr* msgh, struct msghdr* os_msgh);
+static bool cmsg_os_to_etcpal(struct cmsghdr* os_cmsg, EtcPalCMsgHdr* cmsg);
+
+// Helpers for etcpal_sendto_segmented()
+static bool probe_udp_segment_support(void);
+static int  sendto_gso(etcpal_socket_t                id,
+                       const uint8_t*                 buf,
+                       size_t                         length,
+                       size_t                         segment_size,
+                       const struct sockaddr_storage* destaddr,
+                       socklen_t                      destaddr_len,
+                       int                            os_flags,
+                       size_t*                        num_sent);
+
+// Helpers for etcpal_read_zerocopy_completions()
+#ifdef SO_EE_ORIGIN_ZEROCOPY
+static int read_extended_err(etcpal_socket_t id, int flags, struct sock_extended_err* ee);
+#endif
+
 // Helpers for etcpal_setsockopt()
 static void ms_to_timeval(int ms, struct timeval* tv);
 static int  setsockopt_socket(etcpal_socket_t id, int option_name, const void* option_value, size_t option_len);
 static int  setsockopt_ip(etcpal_socket_t id, int option_name, const void* option_value, size_t option_len);
 static int  setsockopt_ip6(etcpal_socket_t id, int option_name, const void* option_value, size_t option_len);
+static int  setsockopt_udp(etcpal_socket_t id, int option_name, const void* option_value, size_t option_len);
 
 // Helpers for etcpal_poll API
 static void events_etcpal_to_epoll(etcpal_poll_events_t events, struct epoll_event* epoll_evt);
@@ -130,15 +198,27 @@ static void events_epoll_to_etcpal(const struct epoll_event* epoll_evt,
                                    const EtcPalPollSocket*   sock_desc,
                                    etcpal_poll_events_t*     events);
 
-static int           poll_socket_compare(const EtcPalRbTree* tree, const void* value_a, const void* value_b);
-static EtcPalRbNode* poll_socket_alloc(void);
-static void          poll_socket_free(EtcPalRbNode* node);
+static int handle_epoll_result(EtcPalPollContext*        context,
+                               const struct epoll_event* epoll_evts,
+                               int                       num_epoll_evts,
+                               EtcPalPollEvent*          events);
+static int wait_epoll(EtcPalPollContext* context, EtcPalPollEvent* events, size_t max_events, int timeout_ms);
+static int spin_epoll_wait(int epoll_fd, struct epoll_event* epoll_evts, int max_epoll_evts, uint64_t spin_us);
+
+static EtcPalPollSocketTable* alloc_poll_socket_table(size_t num_chunks, EtcPalPollSocketTable* prev);
+static void                   free_poll_socket_table(EtcPalPollSocketTable* table);
+static EtcPalPollSocket*      get_poll_socket_entry(EtcPalPollContext* context, etcpal_socket_t socket, bool create);
+static void                   write_poll_socket_entry(EtcPalPollSocket*    entry,
+                                                      etcpal_socket_t      socket,
+                                                      etcpal_poll_events_t events,
+                                                      void*                user_data);
+static bool read_poll_socket_entry(const EtcPalPollContext* context, etcpal_socket_t socket, EtcPalPollSocket* result);
 
 /*************************** Function definitions ****************************/
 
 etcpal_error_t etcpal_socket_init(void)
 {
-  // No initialization necessary on this platform
+  udp_segment_supported = probe_udp_segment_support();
   return kEtcPalErrOk;
 }
 
@@ -253,7 +333,11 @@ int etcpal_recv(etcpal_socket_t id, void* buffer, size_t length, int flags)
 
   int impl_flags = (flags & ETCPAL_MSG_PEEK) ? MSG_PEEK : 0;
   int res = (int)recv(id, buffer, length, impl_flags);
-  return (res >= 0 ? res : (int)errno_os_to_etcpal(errno));
+  if (res < 0)
+    res = (int)errno_os_to_etcpal(errno);
+
+  ETCPAL_SOCKET_STATS_RECV(id, res);
+  return res;
 }
 
 int etcpal_recvfrom(etcpal_socket_t id, void* buffer, size_t length, int flags, EtcPalSockAddr* address)
@@ -265,34 +349,266 @@ int etcpal_recvfrom(etcpal_socket_t id, void* buffer, size_t length, int flags,
   socklen_t               fromlen = sizeof fromaddr;
   int                     impl_flags = (flags & ETCPAL_MSG_PEEK) ? MSG_PEEK : 0;
   int                     res = (int)recvfrom(id, buffer, length, impl_flags, (struct sockaddr*)&fromaddr, &fromlen);
+  if (res < 0)
+    res = (int)errno_os_to_etcpal(errno);
+
+  ETCPAL_SOCKET_STATS_RECV(id, res);
+  if (res >= 0 && address && fromlen > 0)
+  {
+    if (!sockaddr_os_to_etcpal((etcpal_os_sockaddr_t*)&fromaddr, address))
+      return kEtcPalErrSys;
+  }
+  return res;
+}
 
-  if (res >= 0)
+int etcpal_recvmmsg(etcpal_socket_t id, EtcPalMmsgHdr* msgs, size_t num_msgs, int flags)
+{
+  if (!msgs || num_msgs == 0)
+    return (int)kEtcPalErrInvalid;
+
+  struct mmsghdr          os_msgs[ETCPAL_MMSG_MAX_BATCH_SIZE];
+  struct iovec            iovs[ETCPAL_MMSG_MAX_BATCH_SIZE];
+  struct sockaddr_storage fromaddrs[ETCPAL_MMSG_MAX_BATCH_SIZE];
+
+  // Every message of a peeking batch would be filled with the same datagram at the head of the
+  // queue, so only peek at one.
+  if (flags & ETCPAL_MSG_PEEK)
+    num_msgs = 1;
+
+  int    impl_flags = ((flags & ETCPAL_MSG_PEEK) ? MSG_PEEK : 0) | MSG_WAITFORONE;
+  size_t num_received = 0;
+#if ETCPAL_SOCKET_STATS
+  size_t num_bytes = 0;
+  size_t num_truncated = 0;
+#endif
+
+  // Keep receiving in batches until the socket has no more datagrams queued. Only the first call
+  // may block.
+  while (num_received < num_msgs)
   {
-    if (address && fromlen > 0)
+    EtcPalMmsgHdr* batch = &msgs[num_received];
+    size_t         batch_size = num_msgs - num_received;
+    if (batch_size > ETCPAL_MMSG_MAX_BATCH_SIZE)
+      batch_size = ETCPAL_MMSG_MAX_BATCH_SIZE;
+
+    for (size_t i = 0; i < batch_size; ++i)
+    {
+      if (!batch[i].buf)
+        return (num_received > 0 ? (int)num_received : (int)kEtcPalErrInvalid);
+
+      iovs[i].iov_base = batch[i].buf;
+      iovs[i].iov_len = batch[i].len;
+      memset(&os_msgs[i].msg_hdr, 0, sizeof(struct msghdr));
+      os_msgs[i].msg_hdr.msg_name = &fromaddrs[i];
+      os_msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+      os_msgs[i].msg_hdr.msg_iov = &iovs[i];
+      os_msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int res = recvmmsg(id, os_msgs, (unsigned int)batch_size, impl_flags, NULL);
+    if (res < 0)
     {
-      if (!sockaddr_os_to_etcpal((etcpal_os_sockaddr_t*)&fromaddr, address))
-        return kEtcPalErrSys;
+      if (num_received > 0)
+        break;
+      res = (int)errno_os_to_etcpal(errno);
+      ETCPAL_SOCKET_STATS_RECV_BATCH(id, res, 0, 0);
+      return res;
     }
+
+    int num_filled = res;
+    for (int i = 0; i < res; ++i)
+    {
+      if (batch[i].addr && os_msgs[i].msg_hdr.msg_namelen > 0)
+      {
+        if (!sockaddr_os_to_etcpal((etcpal_os_sockaddr_t*)&fromaddrs[i], batch[i].addr))
+        {
+          num_filled = i;
+          break;
+        }
+      }
+      batch[i].msg_len = os_msgs[i].msg_len;
+#if ETCPAL_SOCKET_STATS
+      num_bytes += os_msgs[i].msg_len;
+      if (os_msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+        ++num_truncated;
+#endif
+    }
+
+    num_received += (size_t)num_filled;
+    if (num_filled < res)
+    {
+      // The kernel has already dequeued the whole batch; hand back the datagrams that were filled in
+      // rather than losing them behind an error.
+      if (num_received == 0)
+      {
+        ETCPAL_SOCKET_STATS_RECV_BATCH(id, (int)kEtcPalErrSys, 0, 0);
+        return (int)kEtcPalErrSys;
+      }
+      break;
+    }
+    if ((size_t)res < batch_size)
+      break;
+    impl_flags |= MSG_DONTWAIT;
+  }
+
+  ETCPAL_SOCKET_STATS_RECV_BATCH(id, (int)num_received, num_bytes, num_truncated);
+  return (int)num_received;
+}
+
+int etcpal_recvmsg(etcpal_socket_t id, EtcPalMsgHdr* msg, int flags)
+{
+  if (!msg || !msg->iov || msg->iovlen == 0 || msg->iovlen > ETCPAL_MSG_MAX_IOV)
+    return (int)kEtcPalErrInvalid;
+
+  struct iovec iovs[ETCPAL_MSG_MAX_IOV];
+  iovecs_etcpal_to_os(msg, iovs);
+
+  struct sockaddr_storage fromaddr;
+  struct msghdr           os_msg;
+  memset(&os_msg, 0, sizeof os_msg);
+  os_msg.msg_name = &fromaddr;
+  os_msg.msg_namelen = sizeof fromaddr;
+  os_msg.msg_iov = iovs;
+  os_msg.msg_iovlen = msg->iovlen;
+  os_msg.msg_control = msg->control;
+  os_msg.msg_controllen = (msg->control ? msg->controllen : 0);
+
+  int impl_flags = (flags & ETCPAL_MSG_PEEK) ? MSG_PEEK : 0;
+  int res = (int)recvmsg(id, &os_msg, impl_flags);
+  if (res < 0)
+  {
+    res = (int)errno_os_to_etcpal(errno);
+    ETCPAL_SOCKET_STATS_RECV(id, res);
     return res;
   }
-  return (int)errno_os_to_etcpal(errno);
+  ETCPAL_SOCKET_STATS_RECV_BATCH(id, 1, (size_t)res, ((os_msg.msg_flags & MSG_TRUNC) ? 1 : 0));
+
+  msg->controllen = (size_t)os_msg.msg_controllen;
+  msg->flags = 0;
+  if (os_msg.msg_flags & MSG_TRUNC)
+    msg->flags |= ETCPAL_MSG_TRUNC;
+  if (os_msg.msg_flags & MSG_CTRUNC)
+    msg->flags |= ETCPAL_MSG_CTRUNC;
+  if (msg->name && os_msg.msg_namelen > 0)
+  {
+    if (!sockaddr_os_to_etcpal((etcpal_os_sockaddr_t*)&fromaddr, msg->name))
+      return (int)kEtcPalErrSys;
+  }
+  return res;
 }
 
 int etcpal_send(etcpal_socket_t id, const void* message, size_t length, int flags)
 {
-  ETCPAL_UNUSED_ARG(flags);
-
   if (!message)
     return (int)kEtcPalErrInvalid;
 
-  int res = (int)send(id, message, length, 0);
-  return (res >= 0 ? res : (int)errno_os_to_etcpal(errno));
+  int res = (int)send(id, message, length, send_flags_etcpal_to_os(flags));
+  if (res < 0)
+    res = (int)errno_os_to_etcpal(errno);
+
+  ETCPAL_SOCKET_STATS_SEND(id, res);
+  return res;
 }
 
-int etcpal_sendto(etcpal_socket_t id, const void* message, size_t length, int flags, const EtcPalSockAddr* dest_addr)
+int etcpal_sendmmsg(etcpal_socket_t id, EtcPalMmsgHdr* msgs, size_t num_msgs, int flags)
 {
-  ETCPAL_UNUSED_ARG(flags);
+  if (!msgs || num_msgs == 0)
+    return (int)kEtcPalErrInvalid;
+
+  struct mmsghdr          os_msgs[ETCPAL_MMSG_MAX_BATCH_SIZE];
+  struct iovec            iovs[ETCPAL_MMSG_MAX_BATCH_SIZE];
+  struct sockaddr_storage destaddrs[ETCPAL_MMSG_MAX_BATCH_SIZE];
+
+  size_t num_sent = 0;
+#if ETCPAL_SOCKET_STATS
+  size_t num_bytes = 0;
+#endif
+  while (num_sent < num_msgs)
+  {
+    EtcPalMmsgHdr* batch = &msgs[num_sent];
+    size_t         batch_size = num_msgs - num_sent;
+    if (batch_size > ETCPAL_MMSG_MAX_BATCH_SIZE)
+      batch_size = ETCPAL_MMSG_MAX_BATCH_SIZE;
+
+    for (size_t i = 0; i < batch_size; ++i)
+    {
+      if (!batch[i].buf)
+        return (num_sent > 0 ? (int)num_sent : (int)kEtcPalErrInvalid);
+
+      iovs[i].iov_base = batch[i].buf;
+      iovs[i].iov_len = batch[i].len;
+      memset(&os_msgs[i].msg_hdr, 0, sizeof(struct msghdr));
+      if (batch[i].addr)
+      {
+        socklen_t ss_size = (socklen_t)sockaddr_etcpal_to_os(batch[i].addr, (etcpal_os_sockaddr_t*)&destaddrs[i]);
+        if (ss_size == 0)
+          return (num_sent > 0 ? (int)num_sent : (int)kEtcPalErrSys);
+        os_msgs[i].msg_hdr.msg_name = &destaddrs[i];
+        os_msgs[i].msg_hdr.msg_namelen = ss_size;
+      }
+      os_msgs[i].msg_hdr.msg_iov = &iovs[i];
+      os_msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int res = sendmmsg(id, os_msgs, (unsigned int)batch_size, send_flags_etcpal_to_os(flags));
+    if (res < 0)
+    {
+      if (num_sent > 0)
+        break;
+      res = (int)errno_os_to_etcpal(errno);
+      ETCPAL_SOCKET_STATS_SEND_BATCH(id, res, 0);
+      return res;
+    }
+
+    for (int i = 0; i < res; ++i)
+    {
+      batch[i].msg_len = os_msgs[i].msg_len;
+#if ETCPAL_SOCKET_STATS
+      num_bytes += os_msgs[i].msg_len;
+#endif
+    }
+
+    num_sent += (size_t)res;
+    if ((size_t)res < batch_size)
+      break;
+  }
+
+  ETCPAL_SOCKET_STATS_SEND_BATCH(id, (int)num_sent, num_bytes);
+  return (int)num_sent;
+}
+
+int etcpal_sendmsg(etcpal_socket_t id, const EtcPalMsgHdr* msg, int flags)
+{
+  if (!msg || !msg->iov || msg->iovlen == 0 || msg->iovlen > ETCPAL_MSG_MAX_IOV)
+    return (int)kEtcPalErrInvalid;
+
+  struct iovec iovs[ETCPAL_MSG_MAX_IOV];
+  iovecs_etcpal_to_os(msg, iovs);
+
+  struct sockaddr_storage destaddr;
+  struct msghdr           os_msg;
+  memset(&os_msg, 0, sizeof os_msg);
+  if (msg->name)
+  {
+    socklen_t ss_size = (socklen_t)sockaddr_etcpal_to_os(msg->name, (etcpal_os_sockaddr_t*)&destaddr);
+    if (ss_size == 0)
+      return (int)kEtcPalErrSys;
+    os_msg.msg_name = &destaddr;
+    os_msg.msg_namelen = ss_size;
+  }
+  os_msg.msg_iov = iovs;
+  os_msg.msg_iovlen = msg->iovlen;
+
+  int res = (int)sendmsg(id, &os_msg, send_flags_etcpal_to_os(flags));
+  if (res < 0)
+    res = (int)errno_os_to_etcpal(errno);
+
+  ETCPAL_SOCKET_STATS_SEND(id, res);
+  return res;
+}
 
+int etcpal_sendto(etcpal_socket_t id, const void* message, size_t length, int flags, const EtcPalSockAddr* dest_addr)
+{
   if (!dest_addr || !message)
     return (int)kEtcPalErrInvalid;
 
@@ -301,9 +617,49 @@ int etcpal_sendto(etcpal_socket_t id, const void* message, size_t length, int fl
   if (ss_size == 0)
     return (int)kEtcPalErrSys;
 
-  int res = (int)sendto(id, message, length, 0, (struct sockaddr*)&ss, ss_size);
+  int res = (int)sendto(id, message, length, send_flags_etcpal_to_os(flags), (struct sockaddr*)&ss, ss_size);
+  if (res < 0)
+    res = (int)errno_os_to_etcpal(errno);
+
+  ETCPAL_SOCKET_STATS_SEND(id, res);
+  return res;
+}
+
+int etcpal_sendto_segmented(etcpal_socket_t       id,
+                            const void*           message,
+                            size_t                length,
+                            size_t                segment_size,
+                            int                   flags,
+                            const EtcPalSockAddr* dest_addr)
+{
+  if (!message || length == 0 || segment_size == 0)
+    return (int)kEtcPalErrInvalid;
+
+  size_t num_sent = 0;
+  if (udp_segment_supported && length > segment_size && segment_size <= UDP_GSO_MAX_PAYLOAD / 2)
+  {
+    struct sockaddr_storage destaddr;
+    socklen_t               destaddr_len = 0;
+    if (dest_addr)
+    {
+      destaddr_len = (socklen_t)sockaddr_etcpal_to_os(dest_addr, (etcpal_os_sockaddr_t*)&destaddr);
+      if (destaddr_len == 0)
+        return (int)kEtcPalErrSys;
+    }
+
+    int err = sendto_gso(id, (const uint8_t*)message, length, segment_size, (dest_addr ? &destaddr : NULL),
+                         destaddr_len, send_flags_etcpal_to_os(flags), &num_sent);
+    if (err == 0)
+      return (int)num_sent;
+
+    // EIO indicates that the outgoing interface can't offload the checksums of the segments; fall
+    // back to sending the rest of the datagrams individually.
+    if (err != EIO)
+      return (num_sent > 0 ? (int)num_sent : (int)errno_os_to_etcpal(err));
+  }
 
-  return (res >= 0 ? res : (int)errno_os_to_etcpal(errno));
+  return etcpal_sendto_segments_fallback(id, (const uint8_t*)message, length, segment_size, flags, dest_addr,
+                                         num_sent);
 }
 
 etcpal_error_t etcpal_setsockopt(etcpal_socket_t id,
@@ -329,12 +685,153 @@ etcpal_error_t etcpal_setsockopt(etcpal_socket_t id,
     case ETCPAL_IPPROTO_IPV6:
       res = setsockopt_ip6(id, option_name, option_value, option_len);
       break;
+    case ETCPAL_IPPROTO_UDP:
+      res = setsockopt_udp(id, option_name, option_value, option_len);
+      break;
     default:
       return kEtcPalErrInvalid;
   }
   return (res == 0 ? kEtcPalErrOk : errno_os_to_etcpal(errno));
 }
 
+int send_flags_etcpal_to_os(int flags)
+{
+  int os_flags = 0;
+#ifdef MSG_ZEROCOPY
+  // Without SO_ZEROCOPY set on the socket, the kernel ignores this flag and copies the data.
+  if (flags & ETCPAL_MSG_ZEROCOPY)
+    os_flags |= MSG_ZEROCOPY;
+#else
+  ETCPAL_UNUSED_ARG(flags);
+#endif
+  return os_flags;
+}
+
+void iovecs_etcpal_to_os(const EtcPalMsgHdr* msg, struct iovec* iovs)
+{
+  for (size_t i = 0; i < msg->iovlen; ++i)
+  {
+    iovs[i].iov_base = msg->iov[i].base;
+    iovs[i].iov_len = msg->iov[i].len;
+  }
+}
+
+void init_control_msghdr(const EtcPalMsgHdr* msgh, struct msghdr* os_msgh)
+{
+  memset(os_msgh, 0, sizeof(struct msghdr));
+  os_msgh->msg_control = msgh->control;
+  os_msgh->msg_controllen = (msgh->control ? msgh->controllen : 0);
+}
+
+bool cmsg_os_to_etcpal(struct cmsghdr* os_cmsg, EtcPalCMsgHdr* cmsg)
+{
+  if (!os_cmsg || os_cmsg->cmsg_len < CMSG_LEN(0))
+    return false;
+
+  cmsg->len = (size_t)(os_cmsg->cmsg_len - CMSG_LEN(0));
+  cmsg->level = -1;
+  cmsg->type = -1;
+  if (os_cmsg->cmsg_level == SOL_SOCKET && os_cmsg->cmsg_type == SCM_TIMESTAMPNS)
+  {
+    cmsg->level = ETCPAL_SOL_SOCKET;
+    cmsg->type = ETCPAL_SO_TIMESTAMP;
+  }
+  else if (os_cmsg->cmsg_level == SOL_SOCKET && os_cmsg->cmsg_type == SCM_TIMESTAMPING)
+  {
+    cmsg->level = ETCPAL_SOL_SOCKET;
+    cmsg->type = ETCPAL_SO_TIMESTAMP_HW;
+  }
+  else if (os_cmsg->cmsg_level == IPPROTO_IP && os_cmsg->cmsg_type == IP_PKTINFO)
+  {
+    cmsg->level = ETCPAL_IPPROTO_IP;
+    cmsg->type = ETCPAL_IP_PKTINFO;
+  }
+  else if (os_cmsg->cmsg_level == IPPROTO_IPV6 && os_cmsg->cmsg_type == IPV6_PKTINFO)
+  {
+    cmsg->level = ETCPAL_IPPROTO_IPV6;
+    cmsg->type = ETCPAL_IP_PKTINFO;
+  }
+  else if (os_cmsg->cmsg_level == SOL_UDP && os_cmsg->cmsg_type == UDP_GRO)
+  {
+    cmsg->level = ETCPAL_IPPROTO_UDP;
+    cmsg->type = ETCPAL_UDP_GRO;
+  }
+  cmsg->pd = os_cmsg;
+  return true;
+}
+
+bool probe_udp_segment_support(void)
+{
+  // Kernels without UDP_SEGMENT silently ignore the control message on send, so support must be
+  // detected up front. The socket option was added at the same time as the control message.
+  int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (sock < 0)
+    return false;
+
+  int       val = 0;
+  socklen_t val_len = sizeof val;
+  bool      supported = (getsockopt(sock, SOL_UDP, UDP_SEGMENT, &val, &val_len) == 0);
+  close(sock);
+  return supported;
+}
+
+// Returns 0 on success or an errno value on failure. num_sent is updated with the number of bytes
+// sent either way.
+int sendto_gso(etcpal_socket_t                id,
+               const uint8_t*                 buf,
+               size_t                         length,
+               size_t                         segment_size,
+               const struct sockaddr_storage* destaddr,
+               socklen_t                      destaddr_len,
+               int                            os_flags,
+               size_t*                        num_sent)
+{
+  size_t segs_per_send = UDP_GSO_MAX_PAYLOAD / segment_size;
+  if (segs_per_send > UDP_GSO_MAX_SEGMENTS)
+    segs_per_send = UDP_GSO_MAX_SEGMENTS;
+  size_t max_send_len = segs_per_send * segment_size;
+
+  union
+  {
+    char           buf[CMSG_SPACE(sizeof(uint16_t))];
+    struct cmsghdr align;
+  } control;
+
+  while (*num_sent < length)
+  {
+    struct iovec iov;
+    iov.iov_base = (void*)&buf[*num_sent];
+    iov.iov_len = (length - *num_sent < max_send_len ? length - *num_sent : max_send_len);
+
+    struct msghdr os_msg;
+    memset(&os_msg, 0, sizeof os_msg);
+    os_msg.msg_name = (void*)destaddr;
+    os_msg.msg_namelen = destaddr_len;
+    os_msg.msg_iov = &iov;
+    os_msg.msg_iovlen = 1;
+    os_msg.msg_control = control.buf;
+    os_msg.msg_controllen = sizeof control.buf;
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&os_msg);
+    cmsg->cmsg_level = SOL_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+    uint16_t gso_size = (uint16_t)segment_size;
+    memcpy(CMSG_DATA(cmsg), &gso_size, sizeof gso_size);
+
+    ssize_t res = sendmsg(id, &os_msg, os_flags);
+    if (res < 0)
+    {
+      int err = errno;
+      ETCPAL_SOCKET_STATS_SEND(id, (int)errno_os_to_etcpal(err));
+      return err;
+    }
+    ETCPAL_SOCKET_STATS_SEND_BATCH(id, (int)(((size_t)res + segment_size - 1) / segment_size), (size_t)res);
+    *num_sent += (size_t)res;
+  }
+  return 0;
+}
+
 int setsockopt_socket(etcpal_socket_t id, int option_name, const void* option_value, size_t option_len)
 {
   switch (option_name)
@@ -379,6 +876,31 @@ int setsockopt_socket(etcpal_socket_t id, int option_name, const void* option_va
         return setsockopt(id, SOL_SOCKET, SO_LINGER, &val, sizeof val);
       }
       break;
+    case ETCPAL_SO_TIMESTAMP:
+      return setsockopt(id, SOL_SOCKET, SO_TIMESTAMPNS, option_value, (socklen_t)option_len);
+    case ETCPAL_SO_TIMESTAMP_HW:
+      if (option_len == sizeof(int))
+      {
+        // Software timestamps are requested as well, as a fallback for interfaces which cannot
+        // generate hardware timestamps.
+        int val = (*(int*)option_value ? (SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE |
+                                          SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE)
+                                       : 0);
+        return setsockopt(id, SOL_SOCKET, SO_TIMESTAMPING, &val, sizeof val);
+      }
+      break;
+#ifdef SO_BUSY_POLL
+    case ETCPAL_SO_BUSY_POLL:
+      return setsockopt(id, SOL_SOCKET, SO_BUSY_POLL, option_value, (socklen_t)option_len);
+#endif
+#ifdef SO_PREFER_BUSY_POLL
+    case ETCPAL_SO_PREFER_BUSY_POLL:
+      return setsockopt(id, SOL_SOCKET, SO_PREFER_BUSY_POLL, option_value, (socklen_t)option_len);
+#endif
+#ifdef SO_ZEROCOPY
+    case ETCPAL_SO_ZEROCOPY:
+      return setsockopt(id, SOL_SOCKET, SO_ZEROCOPY, option_value, (socklen_t)option_len);
+#endif
     case ETCPAL_SO_ERROR:  // Set not supported
     case ETCPAL_SO_TYPE:   // Set not supported
     default:
@@ -489,6 +1011,8 @@ int setsockopt_ip(etcpal_socket_t id, int option_name, const void* option_value,
       return setsockopt(id, IPPROTO_IP, IP_MULTICAST_TTL, option_value, (socklen_t)option_len);
     case ETCPAL_IP_MULTICAST_LOOP:
       return setsockopt(id, IPPROTO_IP, IP_MULTICAST_LOOP, option_value, (socklen_t)option_len);
+    case ETCPAL_IP_PKTINFO:
+      return setsockopt(id, IPPROTO_IP, IP_PKTINFO, option_value, (socklen_t)option_len);
     default:
       break;
   }
@@ -543,6 +1067,8 @@ int setsockopt_ip6(etcpal_socket_t id, int option_name, const void* option_value
       return setsockopt(id, IPPROTO_IPV6, IPV6_MULTICAST_LOOP, option_value, (socklen_t)option_len);
     case ETCPAL_IPV6_V6ONLY:
       return setsockopt(id, IPPROTO_IPV6, IPV6_V6ONLY, option_value, (socklen_t)option_len);
+    case ETCPAL_IP_PKTINFO:
+      return setsockopt(id, IPPROTO_IPV6, IPV6_RECVPKTINFO, option_value, (socklen_t)option_len);
     default: /* Other IPv6 options TODO on linux. */
       break;
   }
@@ -551,6 +1077,22 @@ int setsockopt_ip6(etcpal_socket_t id, int option_name, const void* option_value
   return -1;
 }
 
+int setsockopt_udp(etcpal_socket_t id, int option_name, const void* option_value, size_t option_len)
+{
+  switch (option_name)
+  {
+    case ETCPAL_UDP_SEGMENT:
+      return setsockopt(id, SOL_UDP, UDP_SEGMENT, option_value, (socklen_t)option_len);
+    case ETCPAL_UDP_GRO:
+      return setsockopt(id, SOL_UDP, UDP_GRO, option_value, (socklen_t)option_len);
+    default:
+      break;
+  }
+  // If we got here, something was invalid. Set errno accordingly
+  errno = EINVAL;
+  return -1;
+}
+
 void ms_to_timeval(int ms, struct timeval* tv)
 {
   tv->tv_sec = ms / 1000;
@@ -589,6 +1131,190 @@ etcpal_error_t etcpal_socket(unsigned int family, unsigned int type, etcpal_sock
   return kEtcPalErrOk;
 }
 
+bool etcpal_cmsg_firsthdr(EtcPalMsgHdr* msgh, EtcPalCMsgHdr* firsthdr)
+{
+  if (!msgh || !firsthdr)
+    return false;
+
+  struct msghdr os_msgh;
+  init_control_msghdr(msgh, &os_msgh);
+  return cmsg_os_to_etcpal(CMSG_FIRSTHDR(&os_msgh), firsthdr);
+}
+
+bool etcpal_cmsg_nxthdr(EtcPalMsgHdr* msgh, const EtcPalCMsgHdr* cmsg, EtcPalCMsgHdr* nxthdr)
+{
+  if (!msgh || !cmsg || !cmsg->pd || !nxthdr)
+    return false;
+
+  struct msghdr os_msgh;
+  init_control_msghdr(msgh, &os_msgh);
+  return cmsg_os_to_etcpal(CMSG_NXTHDR(&os_msgh, (struct cmsghdr*)cmsg->pd), nxthdr);
+}
+
+bool etcpal_cmsg_to_pktinfo(const EtcPalCMsgHdr* cmsg, EtcPalPktInfo* pktinfo)
+{
+  if (!cmsg || !cmsg->pd || !pktinfo)
+    return false;
+
+  const struct cmsghdr* os_cmsg = (const struct cmsghdr*)cmsg->pd;
+  if (os_cmsg->cmsg_level == IPPROTO_IP && os_cmsg->cmsg_type == IP_PKTINFO &&
+      os_cmsg->cmsg_len >= CMSG_LEN(sizeof(struct in_pktinfo)))
+  {
+    struct in_pktinfo info;
+    memcpy(&info, CMSG_DATA(os_cmsg), sizeof info);
+    ETCPAL_IP_SET_V4_ADDRESS(&pktinfo->addr, ntohl(info.ipi_addr.s_addr));
+    pktinfo->ifindex = (unsigned int)info.ipi_ifindex;
+    return true;
+  }
+  if (os_cmsg->cmsg_level == IPPROTO_IPV6 && os_cmsg->cmsg_type == IPV6_PKTINFO &&
+      os_cmsg->cmsg_len >= CMSG_LEN(sizeof(struct in6_pktinfo)))
+  {
+    struct in6_pktinfo info;
+    memcpy(&info, CMSG_DATA(os_cmsg), sizeof info);
+    ETCPAL_IP_SET_V6_ADDRESS(&pktinfo->addr, info.ipi6_addr.s6_addr);
+    pktinfo->ifindex = (unsigned int)info.ipi6_ifindex;
+    return true;
+  }
+  return false;
+}
+
+bool etcpal_cmsg_to_timestamp(const EtcPalCMsgHdr* cmsg, EtcPalRecvTimestamp* timestamp)
+{
+  if (!cmsg || !cmsg->pd || !timestamp)
+    return false;
+
+  const struct cmsghdr* os_cmsg = (const struct cmsghdr*)cmsg->pd;
+  if (os_cmsg->cmsg_level != SOL_SOCKET)
+    return false;
+
+  if (os_cmsg->cmsg_type == SCM_TIMESTAMPNS && os_cmsg->cmsg_len >= CMSG_LEN(sizeof(struct timespec)))
+  {
+    struct timespec ts;
+    memcpy(&ts, CMSG_DATA(os_cmsg), sizeof ts);
+    timestamp->seconds = (int64_t)ts.tv_sec;
+    timestamp->nanoseconds = (uint32_t)ts.tv_nsec;
+    timestamp->hardware = false;
+    return true;
+  }
+  if (os_cmsg->cmsg_type == SCM_TIMESTAMPING && os_cmsg->cmsg_len >= CMSG_LEN(3 * sizeof(struct timespec)))
+  {
+    // The payload is struct scm_timestamping: a software timestamp, a deprecated slot and a raw
+    // hardware timestamp. Unavailable timestamps are zeroed.
+    struct timespec ts[3];
+    memcpy(ts, CMSG_DATA(os_cmsg), sizeof ts);
+    bool hardware = (ts[2].tv_sec != 0 || ts[2].tv_nsec != 0);
+    timestamp->seconds = (int64_t)ts[hardware ? 2 : 0].tv_sec;
+    timestamp->nanoseconds = (uint32_t)ts[hardware ? 2 : 0].tv_nsec;
+    timestamp->hardware = hardware;
+    return true;
+  }
+  return false;
+}
+
+bool etcpal_cmsg_to_udp_gro(const EtcPalCMsgHdr* cmsg, size_t* segment_size)
+{
+  if (!cmsg || !cmsg->pd || !segment_size)
+    return false;
+
+  const struct cmsghdr* os_cmsg = (const struct cmsghdr*)cmsg->pd;
+  if (os_cmsg->cmsg_level == SOL_UDP && os_cmsg->cmsg_type == UDP_GRO && os_cmsg->cmsg_len >= CMSG_LEN(sizeof(int)))
+  {
+    int gso_size;
+    memcpy(&gso_size, CMSG_DATA(os_cmsg), sizeof gso_size);
+    *segment_size = (size_t)gso_size;
+    return true;
+  }
+  return false;
+}
+
+int etcpal_read_zerocopy_completions(etcpal_socket_t           id,
+                                     EtcPalZerocopyCompletion* completions,
+                                     size_t                    max_completions)
+{
+  if (id < 0 || !completions || max_completions == 0)
+    return (int)kEtcPalErrInvalid;
+
+#ifdef SO_EE_ORIGIN_ZEROCOPY
+  size_t num_completions = 0;
+  while (num_completions < max_completions)
+  {
+    // Once some completions have been read, the next message is peeked at first, so that an error
+    // which is not a completion can be left queued for the next call.
+    struct sock_extended_err ee;
+    int                      peek_flag = (num_completions > 0 ? MSG_PEEK : 0);
+    int                      read_res = read_extended_err(id, peek_flag, &ee);
+    if (read_res < 0)
+    {
+      // An empty error queue ends the read; errors after some completions were read are reported
+      // by the next call.
+      if (read_res == (int)kEtcPalErrWouldBlock || num_completions > 0)
+        break;
+      return read_res;
+    }
+    if (read_res == 0)
+    {
+      // A message without an extended error carries nothing to report.
+      if (peek_flag)
+        read_extended_err(id, 0, &ee);
+      continue;
+    }
+
+    if (ee.ee_origin != SO_EE_ORIGIN_ZEROCOPY || ee.ee_errno != 0)
+    {
+      // Some other error, e.g. an ICMP error on a socket with IP_RECVERR enabled. It is returned
+      // on its own, after any completions which were read before it.
+      if (peek_flag)
+        break;
+      return (ee.ee_errno != 0 ? (int)errno_os_to_etcpal((int)ee.ee_errno) : (int)kEtcPalErrSys);
+    }
+    if (peek_flag)
+      read_extended_err(id, 0, &ee);
+
+    EtcPalZerocopyCompletion* completion = &completions[num_completions++];
+    completion->first = ee.ee_info;
+    completion->last = ee.ee_data;
+    completion->copied = ((ee.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0);
+  }
+  return (int)num_completions;
+#else
+  return (int)kEtcPalErrNotImpl;
+#endif
+}
+
+#ifdef SO_EE_ORIGIN_ZEROCOPY
+// Read (or peek at, with MSG_PEEK in flags) the next message on a socket's error queue. Returns 1 if
+// it holds an extended error, which is copied to ee, 0 if it does not, or an error code.
+int read_extended_err(etcpal_socket_t id, int flags, struct sock_extended_err* ee)
+{
+  // Each error queue message holds one extended error, followed by the address of its origin.
+  union
+  {
+    struct cmsghdr align;
+    uint8_t        buf[CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in6))];
+  } control;
+
+  struct msghdr os_msg;
+  memset(&os_msg, 0, sizeof os_msg);
+  os_msg.msg_control = control.buf;
+  os_msg.msg_controllen = sizeof control.buf;
+
+  if (recvmsg(id, &os_msg, MSG_ERRQUEUE | MSG_DONTWAIT | flags) < 0)
+    return (int)errno_os_to_etcpal(errno);
+
+  for (struct cmsghdr* os_cmsg = CMSG_FIRSTHDR(&os_msg); os_cmsg; os_cmsg = CMSG_NXTHDR(&os_msg, os_cmsg))
+  {
+    if (((os_cmsg->cmsg_level == SOL_IP && os_cmsg->cmsg_type == IP_RECVERR) ||
+         (os_cmsg->cmsg_level == SOL_IPV6 && os_cmsg->cmsg_type == IPV6_RECVERR)) &&
+        os_cmsg->cmsg_len >= CMSG_LEN(sizeof(struct sock_extended_err)))
+    {
+      memcpy(ee, CMSG_DATA(os_cmsg), sizeof *ee);
+      return 1;
+    }
+  }
+  return 0;
+}
+#endif
+
 etcpal_error_t etcpal_setblocking(etcpal_socket_t id, bool blocking)
 {
   int val = fcntl(id, F_GETFL, 0);
@@ -617,60 +1343,124 @@ etcpal_error_t etcpal_poll_context_init(EtcPalPollContext* context)
   if (!context)
     return kEtcPalErrInvalid;
 
+  context->socket_table = alloc_poll_socket_table(ETCPAL_POLL_INITIAL_NUM_CHUNKS, NULL);
+  if (!context->socket_table)
+    return kEtcPalErrNoMem;
+
+  if (!etcpal_mutex_create(&context->lock))
+  {
+    free_poll_socket_table(context->socket_table);
+    return kEtcPalErrSys;
+  }
+
   context->epoll_fd = epoll_create(EPOLL_CREATE_SIZE);
   if (context->epoll_fd >= 0)
   {
-    etcpal_rbtree_init(&context->sockets, poll_socket_compare, poll_socket_alloc, poll_socket_free);
-    context->valid = true;
-    return kEtcPalErrOk;
+    // The wake eventfd is monitored alongside the sockets; it is distinguished from them by its
+    // descriptor, which can never also be the descriptor of a monitored socket.
+    context->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (context->wake_fd >= 0)
+    {
+      struct epoll_event ep_evt;
+      ep_evt.events = EPOLLIN;
+      ep_evt.data.fd = context->wake_fd;
+      if (epoll_ctl(context->epoll_fd, EPOLL_CTL_ADD, context->wake_fd, &ep_evt) == 0)
+      {
+        context->wake_deferred = false;
+        context->num_valid_sockets = 0;
+        context->spin_us = 0;
+        context->valid = true;
+        return kEtcPalErrOk;
+      }
+      close(context->wake_fd);
+    }
+    close(context->epoll_fd);
   }
-  return errno_os_to_etcpal(errno);
+
+  etcpal_error_t res = errno_os_to_etcpal(errno);
+  etcpal_mutex_destroy(&context->lock);
+  free_poll_socket_table(context->socket_table);
+  return res;
 }
 
 void etcpal_poll_context_deinit(EtcPalPollContext* context)
 {
   if (context && context->valid)
   {
-    etcpal_rbtree_clear(&context->sockets);
+    free_poll_socket_table(context->socket_table);
+    context->socket_table = NULL;
+    context->num_valid_sockets = 0;
+    close(context->wake_fd);
     close(context->epoll_fd);
+    etcpal_mutex_destroy(&context->lock);
     context->valid = false;
   }
 }
 
+etcpal_error_t etcpal_poll_context_wake(EtcPalPollContext* context)
+{
+  if (!context || !context->valid)
+    return kEtcPalErrInvalid;
+
+  uint64_t val = 1;
+  if (write(context->wake_fd, &val, sizeof val) == (ssize_t)sizeof val)
+    return kEtcPalErrOk;
+  // EAGAIN means the counter is saturated, so a wakeup is already pending.
+  return (errno == EAGAIN ? kEtcPalErrOk : errno_os_to_etcpal(errno));
+}
+
+etcpal_error_t etcpal_poll_context_set_spin_time(EtcPalPollContext* context, unsigned int spin_us)
+{
+  if (!context || !context->valid)
+    return kEtcPalErrInvalid;
+
+  __atomic_store_n(&context->spin_us, spin_us, __ATOMIC_RELAXED);
+  return kEtcPalErrOk;
+}
+
 etcpal_error_t etcpal_poll_add_socket(EtcPalPollContext*   context,
                                       etcpal_socket_t      socket,
                                       etcpal_poll_events_t events,
                                       void*                user_data)
 {
-  if (!context || !context->valid || socket == ETCPAL_SOCKET_INVALID || !(events & ETCPAL_POLL_VALID_INPUT_EVENT_MASK))
+  if (!context || !context->valid || socket < 0 || !(events & ETCPAL_POLL_VALID_INPUT_EVENT_MASK))
     return kEtcPalErrInvalid;
 
-  EtcPalPollSocket* sock_desc = (EtcPalPollSocket*)malloc(sizeof(EtcPalPollSocket));
-  if (!sock_desc)
-    return kEtcPalErrNoMem;
+  if (!etcpal_mutex_lock(&context->lock))
+    return kEtcPalErrSys;
 
-  sock_desc->sock = socket;
-  sock_desc->events = events;
-  sock_desc->user_data = user_data;
-  etcpal_error_t insert_res = etcpal_rbtree_insert(&context->sockets, sock_desc);
-  if (insert_res != kEtcPalErrOk)
+  etcpal_error_t    res = kEtcPalErrOk;
+  EtcPalPollSocket* entry = get_poll_socket_entry(context, socket, true);
+  if (!entry)
   {
-    free(sock_desc);
-    return insert_res;
+    res = kEtcPalErrNoMem;
   }
+  else if (entry->sock != ETCPAL_SOCKET_INVALID)
+  {
+    res = kEtcPalErrExists;
+  }
+  else
+  {
+    // The entry must be valid before epoll can report events for the socket.
+    write_poll_socket_entry(entry, socket, events, user_data);
 
-  struct epoll_event ep_evt;
-  events_etcpal_to_epoll(events, &ep_evt);
-  ep_evt.data.fd = socket;
+    struct epoll_event ep_evt;
+    events_etcpal_to_epoll(events, &ep_evt);
+    ep_evt.data.fd = socket;
 
-  int res = epoll_ctl(context->epoll_fd, EPOLL_CTL_ADD, socket, &ep_evt);
-  if (res != 0)
-  {
-    // Our node dealloc function also deallocates sock_desc, so no need to free it here.
-    etcpal_rbtree_remove(&context->sockets, sock_desc);
-    return errno_os_to_etcpal(errno);
+    if (epoll_ctl(context->epoll_fd, EPOLL_CTL_ADD, socket, &ep_evt) == 0)
+    {
+      __atomic_store_n(&context->num_valid_sockets, context->num_valid_sockets + 1, __ATOMIC_RELAXED);
+    }
+    else
+    {
+      res = errno_os_to_etcpal(errno);
+      write_poll_socket_entry(entry, ETCPAL_SOCKET_INVALID, 0, NULL);
+    }
   }
-  return kEtcPalErrOk;
+
+  etcpal_mutex_unlock(&context->lock);
+  return res;
 }
 
 etcpal_error_t etcpal_poll_modify_socket(EtcPalPollContext*   context,
@@ -684,74 +1474,199 @@ etcpal_error_t etcpal_poll_modify_socket(EtcPalPollContext*   context,
     return kEtcPalErrInvalid;
   }
 
-  EtcPalPollSocket* sock_desc = (EtcPalPollSocket*)etcpal_rbtree_find(&context->sockets, &socket);
-  if (!sock_desc)
-    return kEtcPalErrNotFound;
+  if (!etcpal_mutex_lock(&context->lock))
+    return kEtcPalErrSys;
 
-  struct epoll_event ep_evt;
-  events_etcpal_to_epoll(new_events, &ep_evt);
-  ep_evt.data.fd = socket;
+  etcpal_error_t    res = kEtcPalErrOk;
+  EtcPalPollSocket* entry = get_poll_socket_entry(context, socket, false);
+  if (!entry || entry->sock != socket)
+  {
+    res = kEtcPalErrNotFound;
+  }
+  else
+  {
+    struct epoll_event ep_evt;
+    events_etcpal_to_epoll(new_events, &ep_evt);
+    ep_evt.data.fd = socket;
 
-  int res = epoll_ctl(context->epoll_fd, EPOLL_CTL_MOD, socket, &ep_evt);
-  if (res != 0)
-    return errno_os_to_etcpal(errno);
+    if (epoll_ctl(context->epoll_fd, EPOLL_CTL_MOD, socket, &ep_evt) == 0)
+      write_poll_socket_entry(entry, socket, new_events, new_user_data);
+    else
+      res = errno_os_to_etcpal(errno);
+  }
 
-  sock_desc->events = new_events;
-  sock_desc->user_data = new_user_data;
-  return kEtcPalErrOk;
+  etcpal_mutex_unlock(&context->lock);
+  return res;
 }
 
 void etcpal_poll_remove_socket(EtcPalPollContext* context, etcpal_socket_t socket)
 {
-  if (context && context->valid)
+  if (!context || !context->valid || !etcpal_mutex_lock(&context->lock))
+    return;
+
+  EtcPalPollSocket* entry = get_poll_socket_entry(context, socket, false);
+  if (entry && entry->sock == socket)
   {
     // Need a dummy struct for portability - some versions require event to always be non-NULL
     // even though it is ignored
     struct epoll_event ep_evt;
     epoll_ctl(context->epoll_fd, EPOLL_CTL_DEL, socket, &ep_evt);
-    etcpal_rbtree_remove(&context->sockets, &socket);
+
+    // A wait in progress may still hold an event for this socket; invalidating the entry causes the
+    // event to be discarded.
+    write_poll_socket_entry(entry, ETCPAL_SOCKET_INVALID, 0, NULL);
+    __atomic_store_n(&context->num_valid_sockets, context->num_valid_sockets - 1, __ATOMIC_RELAXED);
   }
+
+  etcpal_mutex_unlock(&context->lock);
 }
 
 etcpal_error_t etcpal_poll_wait(EtcPalPollContext* context, EtcPalPollEvent* event, int timeout_ms)
 {
-  if (!context || !context->valid || !event)
-    return kEtcPalErrInvalid;
+  int res = etcpal_poll_wait_many(context, event, 1, timeout_ms);
+  return (res > 0 ? kEtcPalErrOk : (etcpal_error_t)res);
+}
+
+int etcpal_poll_wait_many(EtcPalPollContext* context, EtcPalPollEvent* events, size_t max_events, int timeout_ms)
+{
+  if (!context || !context->valid || !events || max_events == 0)
+    return (int)kEtcPalErrInvalid;
 
-  if (etcpal_rbtree_size(&context->sockets) == 0)
-    return kEtcPalErrNoSockets;
+  if (__atomic_load_n(&context->num_valid_sockets, __ATOMIC_RELAXED) == 0)
+    return (int)kEtcPalErrNoSockets;
 
+  ETCPAL_SOCKET_STATS_POLL_START(stats_start_us);
+  int res = wait_epoll(context, events, max_events, timeout_ms);
+  ETCPAL_SOCKET_STATS_POLL_DONE(stats_start_us, res);
+  return res;
+}
+
+// Wait for events on a validated, non-empty poll context. Returns the number of events or an
+// error code.
+int wait_epoll(EtcPalPollContext* context, EtcPalPollEvent* events, size_t max_events, int timeout_ms)
+{
+  if (__atomic_exchange_n(&context->wake_deferred, false, __ATOMIC_ACQ_REL))
+    return (int)kEtcPalErrWoken;
+
+  EtcPalTimer timer;
+  if (timeout_ms != ETCPAL_WAIT_FOREVER)
+    etcpal_timer_start(&timer, (uint32_t)timeout_ms);
   int sys_timeout = (timeout_ms == ETCPAL_WAIT_FOREVER ? -1 : timeout_ms);
 
-  struct epoll_event epoll_evt;
-  int                wait_res = epoll_wait(context->epoll_fd, &epoll_evt, 1, sys_timeout);
-  if (wait_res == 0)
-    return kEtcPalErrTimedOut;
-  if (wait_res < 0)
-    return errno_os_to_etcpal(errno);
+  // The spin is limited to the timeout, and only done once per call.
+  uint64_t spin_us = __atomic_load_n(&context->spin_us, __ATOMIC_RELAXED);
+  if (timeout_ms != ETCPAL_WAIT_FOREVER && spin_us > (uint64_t)timeout_ms * 1000)
+    spin_us = (uint64_t)timeout_ms * 1000;
 
-  EtcPalPollSocket* sock_desc = (EtcPalPollSocket*)etcpal_rbtree_find(&context->sockets, &epoll_evt.data.fd);
-  if (!sock_desc)
-    return kEtcPalErrSys;
+  struct epoll_event epoll_evts[ETCPAL_POLL_MAX_EVENTS_PER_WAIT];
+  int max_epoll_evts =
+      (max_events < ETCPAL_POLL_MAX_EVENTS_PER_WAIT ? (int)max_events : ETCPAL_POLL_MAX_EVENTS_PER_WAIT);
 
-  event->socket = sock_desc->sock;
-  events_epoll_to_etcpal(&epoll_evt, sock_desc, &event->events);
-  event->err = kEtcPalErrOk;
-  event->user_data = sock_desc->user_data;
+  while (true)
+  {
+    int wait_res = 0;
+    if (spin_us > 0)
+    {
+      wait_res = spin_epoll_wait(context->epoll_fd, epoll_evts, max_epoll_evts, spin_us);
+      spin_us = 0;
+      if (wait_res == 0 && timeout_ms != ETCPAL_WAIT_FOREVER)
+        sys_timeout = (int)etcpal_timer_remaining(&timer);
+    }
+    if (wait_res == 0)
+      wait_res = epoll_wait(context->epoll_fd, epoll_evts, max_epoll_evts, sys_timeout);
+    if (wait_res == 0)
+      return (int)kEtcPalErrTimedOut;
+    if (wait_res < 0)
+      return (int)errno_os_to_etcpal(errno);
+
+    int res = handle_epoll_result(context, epoll_evts, wait_res, events);
+    if (res != 0)
+      return res;
+
+    // All of the events were for sockets removed during the wait; wait out the rest of the timeout.
+    if (timeout_ms != ETCPAL_WAIT_FOREVER)
+      sys_timeout = (int)etcpal_timer_remaining(&timer);
+  }
+}
+
+// Poll the epoll instance without blocking until it reports events or spin_us microseconds have
+// elapsed. Returns the result of the last epoll_wait() call.
+int spin_epoll_wait(int epoll_fd, struct epoll_event* epoll_evts, int max_epoll_evts, uint64_t spin_us)
+{
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  while (true)
+  {
+    int wait_res = epoll_wait(epoll_fd, epoll_evts, max_epoll_evts, 0);
+    if (wait_res != 0)
+      return wait_res;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t elapsed_ns = (int64_t)(now.tv_sec - start.tv_sec) * 1000000000 + (now.tv_nsec - start.tv_nsec);
+    if (elapsed_ns >= (int64_t)spin_us * 1000)
+      return 0;
+  }
+}
 
-  // Check for errors
-  int       error = 0;
-  socklen_t error_size = sizeof error;
-  if (getsockopt(sock_desc->sock, SOL_SOCKET, SO_ERROR, &error, &error_size) == 0)
+// Translate the events returned by epoll_wait(). Returns the number of events, #kEtcPalErrWoken, or
+// 0 if none of the events could be matched to a socket in the context.
+int handle_epoll_result(EtcPalPollContext*        context,
+                        const struct epoll_event* epoll_evts,
+                        int                       num_epoll_evts,
+                        EtcPalPollEvent*          events)
+{
+  int  num_events = 0;
+  bool woken = false;
+  for (const struct epoll_event* epoll_evt = epoll_evts; epoll_evt < epoll_evts + num_epoll_evts; ++epoll_evt)
   {
-    if (error != 0)
+    if (epoll_evt->data.fd == context->wake_fd)
     {
-      event->events |= ETCPAL_POLL_ERR;
-      event->err = errno_os_to_etcpal(error);
+      woken = true;
+      continue;
+    }
+
+    EtcPalPollSocket sock_desc;
+    if (!read_poll_socket_entry(context, epoll_evt->data.fd, &sock_desc))
+      continue;
+
+    EtcPalPollEvent* event = &events[num_events++];
+    event->socket = sock_desc.sock;
+    events_epoll_to_etcpal(epoll_evt, &sock_desc, &event->events);
+    event->err = kEtcPalErrOk;
+    event->user_data = sock_desc.user_data;
+
+    // Only query the pending socket error if epoll has indicated one, or if we're waiting on a
+    // connect; this saves a system call for the common case of plain readable/writable events.
+    if ((epoll_evt->events & (EPOLLERR | EPOLLHUP)) || (sock_desc.events & ETCPAL_POLL_CONNECT))
+    {
+      int       error = 0;
+      socklen_t error_size = sizeof error;
+      if (getsockopt(sock_desc.sock, SOL_SOCKET, SO_ERROR, &error, &error_size) == 0)
+      {
+        if (error != 0)
+        {
+          event->events |= ETCPAL_POLL_ERR;
+          event->err = errno_os_to_etcpal(error);
+        }
+      }
     }
   }
 
-  return kEtcPalErrOk;
+  if (!woken)
+    return num_events;
+
+  uint64_t val;
+  ssize_t  read_res = read(context->wake_fd, &val, sizeof val);
+  ETCPAL_UNUSED_ARG(read_res);
+  if (num_events == 0)
+    return (int)kEtcPalErrWoken;
+
+  // Socket events take priority over a wakeup, which is then reported by the next wait. It is
+  // consumed from the eventfd here, since the sockets may stay ready and keep coming back with it.
+  __atomic_store_n(&context->wake_deferred, true, __ATOMIC_RELEASE);
+  return num_events;
 }
 
 void events_etcpal_to_epoll(etcpal_poll_events_t events, struct epoll_event* epoll_evt)
@@ -763,6 +1678,10 @@ void events_etcpal_to_epoll(etcpal_poll_events_t events, struct epoll_event* epo
     epoll_evt->events |= EPOLLOUT;
   if (events & ETCPAL_POLL_OOB)
     epoll_evt->events |= EPOLLPRI;
+  if (events & ETCPAL_POLL_EDGE)
+    epoll_evt->events |= EPOLLET;
+  if (events & ETCPAL_POLL_ONESHOT)
+    epoll_evt->events |= EPOLLONESHOT;
 }
 
 void events_epoll_to_etcpal(const struct epoll_event* epoll_evt,
@@ -782,29 +1701,139 @@ void events_epoll_to_etcpal(const struct epoll_event* epoll_evt,
   if (epoll_evt->events & EPOLLPRI)
     *events_out |= (ETCPAL_POLL_OOB);
   if (epoll_evt->events & EPOLLERR)
-    *events_out |= (ETCPAL_POLL_ERR);
+  {
+    // Zero-copy send completions are queued on the socket's error queue, which epoll reports as an
+    // error. A pending socket error is still reported with ETCPAL_POLL_ERR by handle_epoll_result().
+    if (sock_desc->events & ETCPAL_POLL_ZEROCOPY)
+      *events_out |= ETCPAL_POLL_ZEROCOPY;
+    else
+      *events_out |= (ETCPAL_POLL_ERR);
+  }
 }
 
-int poll_socket_compare(const EtcPalRbTree* tree, const void* value_a, const void* value_b)
+// Allocate a socket table directory with room for num_chunks chunks, taking over the chunks of the
+// outgrown directory prev, if given.
+EtcPalPollSocketTable* alloc_poll_socket_table(size_t num_chunks, EtcPalPollSocketTable* prev)
 {
-  const EtcPalPollSocket* a = (const EtcPalPollSocket*)value_a;
-  const EtcPalPollSocket* b = (const EtcPalPollSocket*)value_b;
-
-  return (a->sock > b->sock) - (a->sock < b->sock);
+  EtcPalPollSocketTable* table =
+      (EtcPalPollSocketTable*)malloc(sizeof(EtcPalPollSocketTable) + num_chunks * sizeof(EtcPalPollSocket*));
+  if (!table)
+    return NULL;
+
+  table->prev = prev;
+  table->num_chunks = num_chunks;
+  table->chunks = (EtcPalPollSocket**)(table + 1);
+  size_t num_prev_chunks = (prev ? prev->num_chunks : 0);
+  for (size_t i = 0; i < num_chunks; ++i)
+    table->chunks[i] = (i < num_prev_chunks ? prev->chunks[i] : NULL);
+  return table;
 }
 
-EtcPalRbNode* poll_socket_alloc(void)
+// Free a socket table, along with all of its chunks and outgrown directories.
+void free_poll_socket_table(EtcPalPollSocketTable* table)
 {
-  return (EtcPalRbNode*)malloc(sizeof(EtcPalRbNode));
+  if (!table)
+    return;
+
+  for (size_t i = 0; i < table->num_chunks; ++i)
+    free(table->chunks[i]);
+
+  while (table)
+  {
+    EtcPalPollSocketTable* prev = table->prev;
+    free(table);
+    table = prev;
+  }
 }
 
-void poll_socket_free(EtcPalRbNode* node)
+// Get the socket table entry for a descriptor, or NULL if there is none. If create is true, the
+// table is grown as necessary to make room for the entry. Must be called with the context lock held.
+EtcPalPollSocket* get_poll_socket_entry(EtcPalPollContext* context, etcpal_socket_t socket, bool create)
 {
-  if (node)
+  if (socket < 0)
+    return NULL;
+
+  size_t                 chunk_index = (size_t)socket / ETCPAL_POLL_SOCKET_CHUNK_SIZE;
+  EtcPalPollSocketTable* table = context->socket_table;
+  if (chunk_index >= table->num_chunks)
   {
-    free(node->value);
-    free(node);
+    if (!create)
+      return NULL;
+
+    size_t new_num_chunks = table->num_chunks * 2;
+    if (new_num_chunks <= chunk_index)
+      new_num_chunks = chunk_index + 1;
+
+    table = alloc_poll_socket_table(new_num_chunks, table);
+    if (!table)
+      return NULL;
+    __atomic_store_n(&context->socket_table, table, __ATOMIC_RELEASE);
   }
+
+  EtcPalPollSocket* chunk = table->chunks[chunk_index];
+  if (!chunk)
+  {
+    if (!create)
+      return NULL;
+
+    chunk = (EtcPalPollSocket*)malloc(ETCPAL_POLL_SOCKET_CHUNK_SIZE * sizeof(EtcPalPollSocket));
+    if (!chunk)
+      return NULL;
+    for (size_t i = 0; i < ETCPAL_POLL_SOCKET_CHUNK_SIZE; ++i)
+    {
+      chunk[i].seq = 0;
+      chunk[i].sock = ETCPAL_SOCKET_INVALID;
+    }
+    __atomic_store_n(&table->chunks[chunk_index], chunk, __ATOMIC_RELEASE);
+  }
+
+  return &chunk[(size_t)socket % ETCPAL_POLL_SOCKET_CHUNK_SIZE];
+}
+
+// Update a socket table entry so that it can be read consistently by read_poll_socket_entry()
+// without locking (a sequence lock). Must be called with the context lock held.
+void write_poll_socket_entry(EtcPalPollSocket*    entry,
+                             etcpal_socket_t      socket,
+                             etcpal_poll_events_t events,
+                             void*                user_data)
+{
+  unsigned int seq = entry->seq;
+  __atomic_store_n(&entry->seq, seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  __atomic_store_n(&entry->sock, socket, __ATOMIC_RELAXED);
+  __atomic_store_n(&entry->events, events, __ATOMIC_RELAXED);
+  __atomic_store_n(&entry->user_data, user_data, __ATOMIC_RELAXED);
+  __atomic_store_n(&entry->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+// Get a consistent copy of the socket table entry for a descriptor without locking. Returns false
+// if the descriptor is not currently in the context.
+bool read_poll_socket_entry(const EtcPalPollContext* context, etcpal_socket_t socket, EtcPalPollSocket* result)
+{
+  if (socket < 0)
+    return false;
+
+  size_t                       chunk_index = (size_t)socket / ETCPAL_POLL_SOCKET_CHUNK_SIZE;
+  const EtcPalPollSocketTable* table = __atomic_load_n(&context->socket_table, __ATOMIC_ACQUIRE);
+  if (chunk_index >= table->num_chunks)
+    return false;
+
+  const EtcPalPollSocket* chunk = __atomic_load_n(&table->chunks[chunk_index], __ATOMIC_ACQUIRE);
+  if (!chunk)
+    return false;
+
+  const EtcPalPollSocket* entry = &chunk[(size_t)socket % ETCPAL_POLL_SOCKET_CHUNK_SIZE];
+  unsigned int            seq;
+  do
+  {
+    seq = __atomic_load_n(&entry->seq, __ATOMIC_ACQUIRE);
+    result->sock = __atomic_load_n(&entry->sock, __ATOMIC_RELAXED);
+    result->events = __atomic_load_n(&entry->events, __ATOMIC_RELAXED);
+    result->user_data = __atomic_load_n(&entry->user_data, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  } while ((seq & 1) || seq != __atomic_load_n(&entry->seq, __ATOMIC_RELAXED));
+
+  return (result->sock == socket);
 }
 
 etcpal_error_t etcpal_getaddrinfo(const char*           hostname,
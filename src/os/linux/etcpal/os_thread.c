@@ -101,6 +101,20 @@ etcpal_error_t etcpal_thread_terminate(etcpal_thread_t* id)
   return kEtcPalErrOk;
 }
 
+etcpal_error_t etcpal_thread_set_affinity(etcpal_thread_t* id, unsigned int cpu)
+{
+  if (!id || cpu >= CPU_SETSIZE)
+    return kEtcPalErrInvalid;
+
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(cpu, &cpu_set);
+
+  // pthread functions return the error code rather than setting errno.
+  int res = pthread_setaffinity_np(id->handle, sizeof cpu_set, &cpu_set);
+  return (res == 0 ? kEtcPalErrOk : errno_os_to_etcpal(res));
+}
+
 void* thread_func_internal(void* arg)
 {
   etcpal_thread_t* thread_data = (etcpal_thread_t*)arg;
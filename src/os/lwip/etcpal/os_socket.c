@@ -26,6 +26,8 @@
 #include <lwip/tcpip.h>
 
 #include "etcpal/common.h"
+#include "etcpal/private/socket.h"
+#include "etcpal/timer.h"
 #include "os_error.h"
 
 /***************************** Private macros ********************************/
@@ -117,6 +119,9 @@ static const int aiprotmap[ETCPAL_NUM_IPPROTO] =
 
 /*********************** Private function prototypes *************************/
 
+// Helpers for etcpal_sendmsg() and etcpal_recvmsg()
+static void iovecs_etcpal_to_os(const EtcPalMsgHdr* msg, struct iovec* iovs);
+
 // Helpers for etcpal_setsockopt()
 static void ms_to_timeval(int ms, struct timeval* tv);
 static int  setsockopt_socket(etcpal_socket_t id, int option_name, const void* option_value, size_t option_len);
@@ -133,8 +138,9 @@ static EtcPalPollSocket* find_socket(EtcPalPollContext* context, etcpal_socket_t
 static EtcPalPollSocket* find_hole(EtcPalPollContext* context);
 static void              set_in_fd_sets(EtcPalPollContext* context, const EtcPalPollSocket* sock);
 static void              clear_in_fd_sets(EtcPalPollContext* context, const EtcPalPollSocket* sock);
-static etcpal_error_t    handle_select_result(EtcPalPollContext* context,
-                                              EtcPalPollEvent*   event,
+static int               handle_select_result(EtcPalPollContext* context,
+                                              EtcPalPollEvent*   events,
+                                              size_t             max_events,
                                               const fd_set*      readfds,
                                               const fd_set*      writefds,
                                               const fd_set*      exceptfds);
@@ -282,6 +288,56 @@ int etcpal_recvfrom(etcpal_socket_t id, void* buffer, size_t length, int flags,
   return (int)errno_lwip_to_etcpal(errno);
 }
 
+int etcpal_recvmmsg(etcpal_socket_t id, EtcPalMmsgHdr* msgs, size_t num_msgs, int flags)
+{
+  if (!msgs || num_msgs == 0)
+    return (int)kEtcPalErrInvalid;
+
+  // No native batch receive on this platform; receive a single datagram.
+  int res = etcpal_recvfrom(id, msgs[0].buf, msgs[0].len, flags, msgs[0].addr);
+  if (res < 0)
+    return res;
+
+  msgs[0].msg_len = (size_t)res;
+  return 1;
+}
+
+int etcpal_recvmsg(etcpal_socket_t id, EtcPalMsgHdr* msg, int flags)
+{
+  if (!msg || !msg->iov || msg->iovlen == 0 || msg->iovlen > ETCPAL_MSG_MAX_IOV)
+    return (int)kEtcPalErrInvalid;
+
+  struct iovec iovs[ETCPAL_MSG_MAX_IOV];
+  iovecs_etcpal_to_os(msg, iovs);
+
+  struct sockaddr_storage fromaddr;
+  struct msghdr           os_msg;
+  memset(&os_msg, 0, sizeof os_msg);
+  os_msg.msg_name = &fromaddr;
+  os_msg.msg_namelen = sizeof fromaddr;
+  os_msg.msg_iov = iovs;
+  os_msg.msg_iovlen = (int)msg->iovlen;
+
+  int impl_flags = (flags & ETCPAL_MSG_PEEK) ? MSG_PEEK : 0;
+  int res = (int)lwip_recvmsg(id, &os_msg, impl_flags);
+  if (res < 0)
+    return (int)errno_lwip_to_etcpal(errno);
+
+  // Control data is not supported by lwIP.
+  msg->controllen = 0;
+  msg->flags = 0;
+#ifdef MSG_TRUNC
+  if (os_msg.msg_flags & MSG_TRUNC)
+    msg->flags |= ETCPAL_MSG_TRUNC;
+#endif
+  if (msg->name && os_msg.msg_namelen > 0)
+  {
+    if (!sockaddr_os_to_etcpal((etcpal_os_sockaddr_t*)&fromaddr, msg->name))
+      return (int)kEtcPalErrSys;
+  }
+  return res;
+}
+
 int etcpal_send(etcpal_socket_t id, const void* message, size_t length, int flags)
 {
   ETCPAL_UNUSED_ARG(flags);
@@ -293,6 +349,54 @@ int etcpal_send(etcpal_socket_t id, const void* message, size_t length, int flag
   return (res >= 0 ? res : (int)errno_lwip_to_etcpal(errno));
 }
 
+int etcpal_sendmmsg(etcpal_socket_t id, EtcPalMmsgHdr* msgs, size_t num_msgs, int flags)
+{
+  if (!msgs || num_msgs == 0)
+    return (int)kEtcPalErrInvalid;
+
+  // No native batch send on this platform; send the datagrams one at a time.
+  size_t num_sent = 0;
+  for (; num_sent < num_msgs; ++num_sent)
+  {
+    EtcPalMmsgHdr* msg = &msgs[num_sent];
+
+    int res = (msg->addr ? etcpal_sendto(id, msg->buf, msg->len, flags, msg->addr)
+                         : etcpal_send(id, msg->buf, msg->len, flags));
+    if (res < 0)
+      return (num_sent > 0 ? (int)num_sent : res);
+    msg->msg_len = (size_t)res;
+  }
+  return (int)num_sent;
+}
+
+int etcpal_sendmsg(etcpal_socket_t id, const EtcPalMsgHdr* msg, int flags)
+{
+  ETCPAL_UNUSED_ARG(flags);
+
+  if (!msg || !msg->iov || msg->iovlen == 0 || msg->iovlen > ETCPAL_MSG_MAX_IOV)
+    return (int)kEtcPalErrInvalid;
+
+  struct iovec iovs[ETCPAL_MSG_MAX_IOV];
+  iovecs_etcpal_to_os(msg, iovs);
+
+  struct sockaddr_storage destaddr;
+  struct msghdr           os_msg;
+  memset(&os_msg, 0, sizeof os_msg);
+  if (msg->name)
+  {
+    socklen_t ss_size = (socklen_t)sockaddr_etcpal_to_os(msg->name, (etcpal_os_sockaddr_t*)&destaddr);
+    if (ss_size == 0)
+      return (int)kEtcPalErrSys;
+    os_msg.msg_name = &destaddr;
+    os_msg.msg_namelen = ss_size;
+  }
+  os_msg.msg_iov = iovs;
+  os_msg.msg_iovlen = (int)msg->iovlen;
+
+  int res = (int)lwip_sendmsg(id, &os_msg, 0);
+  return (res >= 0 ? res : (int)errno_lwip_to_etcpal(errno));
+}
+
 int etcpal_sendto(etcpal_socket_t id, const void* message, size_t length, int flags, const EtcPalSockAddr* dest_addr)
 {
   ETCPAL_UNUSED_ARG(flags);
@@ -309,6 +413,20 @@ int etcpal_sendto(etcpal_socket_t id, const void* message, size_t length, int fl
   return (res >= 0 ? res : (int)errno_lwip_to_etcpal(errno));
 }
 
+int etcpal_sendto_segmented(etcpal_socket_t       id,
+                            const void*           message,
+                            size_t                length,
+                            size_t                segment_size,
+                            int                   flags,
+                            const EtcPalSockAddr* dest_addr)
+{
+  if (!message || length == 0 || segment_size == 0)
+    return (int)kEtcPalErrInvalid;
+
+  // No segmentation offload on this platform; send the datagrams individually.
+  return etcpal_sendto_segments_fallback(id, (const uint8_t*)message, length, segment_size, flags, dest_addr, 0);
+}
+
 etcpal_error_t etcpal_setsockopt(etcpal_socket_t id,
                                  int             level,
                                  int             option_name,
@@ -346,6 +464,16 @@ etcpal_error_t etcpal_setsockopt(etcpal_socket_t id,
   return (res == 0 ? kEtcPalErrOk : errno_lwip_to_etcpal(errno));
 }
 
+
+void iovecs_etcpal_to_os(const EtcPalMsgHdr* msg, struct iovec* iovs)
+{
+  for (size_t i = 0; i < msg->iovlen; ++i)
+  {
+    iovs[i].iov_base = msg->iov[i].base;
+    iovs[i].iov_len = msg->iov[i].len;
+  }
+}
+
 int setsockopt_socket(etcpal_socket_t id, int option_name, const void* option_value, size_t option_len)
 {
   switch (option_name)
@@ -585,6 +713,52 @@ etcpal_error_t etcpal_socket(unsigned int family, unsigned int type, etcpal_sock
   return kEtcPalErrInvalid;
 }
 
+bool etcpal_cmsg_firsthdr(EtcPalMsgHdr* msgh, EtcPalCMsgHdr* firsthdr)
+{
+  ETCPAL_UNUSED_ARG(msgh);
+  ETCPAL_UNUSED_ARG(firsthdr);
+  return false;
+}
+
+bool etcpal_cmsg_nxthdr(EtcPalMsgHdr* msgh, const EtcPalCMsgHdr* cmsg, EtcPalCMsgHdr* nxthdr)
+{
+  ETCPAL_UNUSED_ARG(msgh);
+  ETCPAL_UNUSED_ARG(cmsg);
+  ETCPAL_UNUSED_ARG(nxthdr);
+  return false;
+}
+
+bool etcpal_cmsg_to_pktinfo(const EtcPalCMsgHdr* cmsg, EtcPalPktInfo* pktinfo)
+{
+  ETCPAL_UNUSED_ARG(cmsg);
+  ETCPAL_UNUSED_ARG(pktinfo);
+  return false;
+}
+
+bool etcpal_cmsg_to_timestamp(const EtcPalCMsgHdr* cmsg, EtcPalRecvTimestamp* timestamp)
+{
+  ETCPAL_UNUSED_ARG(cmsg);
+  ETCPAL_UNUSED_ARG(timestamp);
+  return false;
+}
+
+bool etcpal_cmsg_to_udp_gro(const EtcPalCMsgHdr* cmsg, size_t* segment_size)
+{
+  ETCPAL_UNUSED_ARG(cmsg);
+  ETCPAL_UNUSED_ARG(segment_size);
+  return false;
+}
+
+int etcpal_read_zerocopy_completions(etcpal_socket_t           id,
+                                     EtcPalZerocopyCompletion* completions,
+                                     size_t                    max_completions)
+{
+  ETCPAL_UNUSED_ARG(id);
+  ETCPAL_UNUSED_ARG(completions);
+  ETCPAL_UNUSED_ARG(max_completions);
+  return (int)kEtcPalErrNotImpl;
+}
+
 etcpal_error_t etcpal_setblocking(etcpal_socket_t id, bool blocking)
 {
   int val = lwip_fcntl(id, F_GETFL, 0);
@@ -615,6 +789,9 @@ etcpal_error_t etcpal_poll_context_init(EtcPalPollContext* context)
   if (!context)
     return kEtcPalErrInvalid;
 
+  if (!etcpal_mutex_create(&context->lock))
+    return kEtcPalErrSys;
+
   init_context_socket_array(context);
   context->max_fd = -1;
   ETCPAL_FD_ZERO(&context->readfds);
@@ -626,11 +803,27 @@ etcpal_error_t etcpal_poll_context_init(EtcPalPollContext* context)
 
 void etcpal_poll_context_deinit(EtcPalPollContext* context)
 {
-  if (!context)
+  if (!context || !context->valid)
     return;
+  etcpal_mutex_destroy(&context->lock);
   context->valid = false;
 }
 
+etcpal_error_t etcpal_poll_context_wake(EtcPalPollContext* context)
+{
+  if (!context || !context->valid)
+    return kEtcPalErrInvalid;
+  return kEtcPalErrNotImpl;
+}
+
+etcpal_error_t etcpal_poll_context_set_spin_time(EtcPalPollContext* context, unsigned int spin_us)
+{
+  ETCPAL_UNUSED_ARG(spin_us);
+  if (!context || !context->valid)
+    return kEtcPalErrInvalid;
+  return kEtcPalErrNotImpl;
+}
+
 etcpal_error_t etcpal_poll_add_socket(EtcPalPollContext*   context,
                                       etcpal_socket_t      socket,
                                       etcpal_poll_events_t events,
@@ -638,28 +831,34 @@ etcpal_error_t etcpal_poll_add_socket(EtcPalPollContext*   context,
 {
   if (!context || !context->valid || socket == ETCPAL_SOCKET_INVALID || !(events & ETCPAL_POLL_VALID_INPUT_EVENT_MASK))
     return kEtcPalErrInvalid;
+  if (events & ETCPAL_POLL_MODE_MASK)
+    return kEtcPalErrNotImpl;
+
+  if (!etcpal_mutex_lock(&context->lock))
+    return kEtcPalErrSys;
 
-  if (context->num_valid_sockets >= ETCPAL_SOCKET_MAX_POLL_SIZE)
+  etcpal_error_t    res = kEtcPalErrOk;
+  EtcPalPollSocket* new_sock = NULL;
+  if (context->num_valid_sockets < ETCPAL_SOCKET_MAX_POLL_SIZE)
+    new_sock = find_hole(context);
+
+  if (new_sock)
   {
-    return kEtcPalErrNoMem;
+    new_sock->sock = socket;
+    new_sock->events = events;
+    new_sock->user_data = user_data;
+    set_in_fd_sets(context, new_sock);
+    context->num_valid_sockets++;
+    if (socket > context->max_fd)
+      context->max_fd = socket;
   }
   else
   {
-    EtcPalPollSocket* new_sock = find_hole(context);
-    if (new_sock)
-    {
-      new_sock->sock = socket;
-      new_sock->events = events;
-      new_sock->user_data = user_data;
-      set_in_fd_sets(context, new_sock);
-      context->num_valid_sockets++;
-      if (socket > context->max_fd)
-        context->max_fd = socket;
-
-      return kEtcPalErrOk;
-    }
-    return kEtcPalErrNoMem;
+    res = kEtcPalErrNoMem;
   }
+
+  etcpal_mutex_unlock(&context->lock);
+  return res;
 }
 
 etcpal_error_t etcpal_poll_modify_socket(EtcPalPollContext*   context,
@@ -670,7 +869,13 @@ etcpal_error_t etcpal_poll_modify_socket(EtcPalPollContext*   context,
   if (!context || !context->valid || socket == ETCPAL_SOCKET_INVALID ||
       !(new_events & ETCPAL_POLL_VALID_INPUT_EVENT_MASK))
     return kEtcPalErrInvalid;
+  if (new_events & ETCPAL_POLL_MODE_MASK)
+    return kEtcPalErrNotImpl;
+
+  if (!etcpal_mutex_lock(&context->lock))
+    return kEtcPalErrSys;
 
+  etcpal_error_t    res = kEtcPalErrOk;
   EtcPalPollSocket* sock_desc = find_socket(context, socket);
   if (sock_desc)
   {
@@ -678,17 +883,19 @@ etcpal_error_t etcpal_poll_modify_socket(EtcPalPollContext*   context,
     sock_desc->events = new_events;
     sock_desc->user_data = new_user_data;
     set_in_fd_sets(context, sock_desc);
-    return kEtcPalErrOk;
   }
   else
   {
-    return kEtcPalErrNotFound;
+    res = kEtcPalErrNotFound;
   }
+
+  etcpal_mutex_unlock(&context->lock);
+  return res;
 }
 
 void etcpal_poll_remove_socket(EtcPalPollContext* context, etcpal_socket_t socket)
 {
-  if (!context || !context->valid || socket == ETCPAL_SOCKET_INVALID)
+  if (!context || !context->valid || socket == ETCPAL_SOCKET_INVALID || !etcpal_mutex_lock(&context->lock))
     return;
 
   EtcPalPollSocket* sock_desc = find_socket(context, socket);
@@ -707,62 +914,86 @@ void etcpal_poll_remove_socket(EtcPalPollContext* context, etcpal_socket_t socke
       }
     }
   }
+
+  etcpal_mutex_unlock(&context->lock);
 }
 
 etcpal_error_t etcpal_poll_wait(EtcPalPollContext* context, EtcPalPollEvent* event, int timeout_ms)
 {
-  if (!context || !context->valid || !event)
-    return kEtcPalErrInvalid;
+  int res = etcpal_poll_wait_many(context, event, 1, timeout_ms);
+  return (res > 0 ? kEtcPalErrOk : (etcpal_error_t)res);
+}
+
+int etcpal_poll_wait_many(EtcPalPollContext* context, EtcPalPollEvent* events, size_t max_events, int timeout_ms)
+{
+  if (!context || !context->valid || !events || max_events == 0)
+    return (int)kEtcPalErrInvalid;
+
+  EtcPalTimer timer;
+  if (timeout_ms != ETCPAL_WAIT_FOREVER)
+    etcpal_timer_start(&timer, (uint32_t)timeout_ms);
 
-  if (context->readfds.count == 0 && context->writefds.count == 0 && context->exceptfds.count == 0)
+  // The lock is only held while copying the socket sets and translating the result, never during
+  // select(); changes to the socket set take effect the next time select() is called.
+  while (true)
   {
-    // No valid sockets are currently added to the context.
-    return kEtcPalErrNoSockets;
-  }
+    EtcPalPollFdSet readfds, writefds, exceptfds;
+    int             max_fd = -1;
+    ETCPAL_FD_ZERO(&readfds);
+    ETCPAL_FD_ZERO(&writefds);
+    ETCPAL_FD_ZERO(&exceptfds);
+    if (etcpal_mutex_lock(&context->lock))
+    {
+      readfds = context->readfds;
+      writefds = context->writefds;
+      exceptfds = context->exceptfds;
+      max_fd = context->max_fd;
+      etcpal_mutex_unlock(&context->lock);
+    }
+
+    if (readfds.count == 0 && writefds.count == 0 && exceptfds.count == 0)
+    {
+      // No valid sockets are currently added to the context.
+      return (int)kEtcPalErrNoSockets;
+    }
 
-  fd_set readfds = context->readfds.set;
-  fd_set writefds = context->writefds.set;
-  fd_set exceptfds = context->exceptfds.set;
+    struct timeval os_timeout;
+    if (timeout_ms != ETCPAL_WAIT_FOREVER)
+      ms_to_timeval((int)etcpal_timer_remaining(&timer), &os_timeout);
 
-  struct timeval os_timeout;
-  if (timeout_ms != ETCPAL_WAIT_FOREVER)
-    ms_to_timeval(timeout_ms, &os_timeout);
+    int sel_res = lwip_select(max_fd + 1, readfds.count ? &readfds.set : NULL, writefds.count ? &writefds.set : NULL,
+                              exceptfds.count ? &exceptfds.set : NULL,
+                              timeout_ms == ETCPAL_WAIT_FOREVER ? NULL : &os_timeout);
 
-  int sel_res = lwip_select(context->max_fd + 1, context->readfds.count ? &readfds : NULL,
-                            context->writefds.count ? &writefds : NULL, context->exceptfds.count ? &exceptfds : NULL,
-                            timeout_ms == ETCPAL_WAIT_FOREVER ? NULL : &os_timeout);
+    if (sel_res < 0)
+      return (int)errno_lwip_to_etcpal(errno);
+    if (sel_res == 0)
+      return (int)kEtcPalErrTimedOut;
 
-  if (sel_res < 0)
-  {
-    return errno_lwip_to_etcpal(errno);
-  }
-  else if (sel_res == 0)
-  {
-    return kEtcPalErrTimedOut;
-  }
-  else
-  {
-    return handle_select_result(context, event, &readfds, &writefds, &exceptfds);
+    int res = (int)kEtcPalErrSys;
+    if (etcpal_mutex_lock(&context->lock))
+    {
+      res = handle_select_result(context, events, max_events, &readfds.set, &writefds.set, &exceptfds.set);
+      etcpal_mutex_unlock(&context->lock);
+    }
+
+    // A result of 0 means that every socket with activity was removed during the select().
+    if (res != 0)
+      return res;
   }
 }
 
-etcpal_error_t handle_select_result(EtcPalPollContext* context,
-                                    EtcPalPollEvent*   event,
-                                    const fd_set*      readfds,
-                                    const fd_set*      writefds,
-                                    const fd_set*      exceptfds)
+int handle_select_result(EtcPalPollContext* context,
+                         EtcPalPollEvent*   events,
+                         size_t             max_events,
+                         const fd_set*      readfds,
+                         const fd_set*      writefds,
+                         const fd_set*      exceptfds)
 {
-  // Init the event data.
-  event->socket = ETCPAL_SOCKET_INVALID;
-  event->events = 0;
-  event->err = kEtcPalErrOk;
+  size_t num_events = 0;
 
-  // The default return; if we don't find any sockets set that we passed to select(), something has
-  // gone wrong.
-  etcpal_error_t res = kEtcPalErrSys;
-
-  for (EtcPalPollSocket* sock_desc = context->sockets; sock_desc < context->sockets + ETCPAL_SOCKET_MAX_POLL_SIZE;
-       ++sock_desc)
+  for (EtcPalPollSocket* sock_desc = context->sockets;
+       sock_desc < context->sockets + ETCPAL_SOCKET_MAX_POLL_SIZE && num_events < max_events; ++sock_desc)
   {
     if (sock_desc->sock == ETCPAL_SOCKET_INVALID)
       continue;
@@ -770,8 +1001,11 @@ etcpal_error_t handle_select_result(EtcPalPollContext* context,
     if (FD_ISSET(sock_desc->sock, readfds) || FD_ISSET(sock_desc->sock, writefds) ||
         FD_ISSET(sock_desc->sock, exceptfds))
     {
-      res = kEtcPalErrOk;
+      // Init the event data.
+      EtcPalPollEvent* event = &events[num_events++];
       event->socket = sock_desc->sock;
+      event->events = 0;
+      event->err = kEtcPalErrOk;
       event->user_data = sock_desc->user_data;
 
       if (FD_ISSET(sock_desc->sock, readfds))
@@ -796,11 +1030,12 @@ etcpal_error_t handle_select_result(EtcPalPollContext* context,
         else
           event->err = kEtcPalErrSys;
       }
-
-      break;  // We handle one event at a time.
     }
   }
-  return res;
+
+  // If none of the sockets that were set are still in the context, they were all removed while the
+  // select() was in progress.
+  return (int)num_events;
 }
 
 void init_context_socket_array(EtcPalPollContext* context)
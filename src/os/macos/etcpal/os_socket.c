@@ -17,11 +17,16 @@
  * https://github.com/ETCLabs/EtcPal
  ******************************************************************************/
 
+// Needed for the RFC 3542 IPv6 socket options (IPV6_RECVPKTINFO, etc.) on Darwin
+#define __APPLE_USE_RFC_3542
+
 #include "etcpal/socket.h"
 #include "etcpal/private/socket.h"
 
 #include <errno.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include <arpa/inet.h>
 #include <fcntl.h>
@@ -31,10 +36,13 @@
 #include <sys/event.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <sys/time.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #include "etcpal/common.h"
+#include "etcpal/timer.h"
+#include "etcpal/private/socket_stats.h"
 #include "os_error.h"
 
 /**************************** Private constants ******************************/
@@ -42,17 +50,43 @@
 /* The maximum number of kevents that can be added in one call to an etcpal_poll API function. */
 #define ETCPAL_SOCKET_MAX_KEVENTS 3
 
+/* The maximum number of kevents that will be retrieved from one call to kevent() in
+ * etcpal_poll_wait_many(). Bounds the stack usage of that function. */
+#define ETCPAL_POLL_MAX_EVENTS_PER_WAIT 64
+
+/* The identifier of the EVFILT_USER event used to implement etcpal_poll_context_wake(). User
+ * events have their own identifier namespace, so this cannot collide with a socket descriptor. */
+#define ETCPAL_POLL_WAKE_IDENT 0
+
+/* Each poll context's socket table is indexed by file descriptor and allocated in chunks of this
+ * many entries, which never move once allocated. */
+#define ETCPAL_POLL_SOCKET_CHUNK_SIZE 256
+
+/* The initial number of chunks which can be referenced by a poll context's socket table. The
+ * directory of chunks is grown as needed to accommodate larger descriptors. */
+#define ETCPAL_POLL_INITIAL_NUM_CHUNKS 4
+
 /****************************** Private types ********************************/
 
 /* A struct to track sockets being polled by the etcpal_poll() API */
 typedef struct EtcPalPollSocket
 {
-  // 'sock' must always remain as the first member in the struct to facilitate an EtcPalRbTree lookup
-  // shortcut
+  unsigned int         seq;  // Odd while the entry is being changed
   etcpal_socket_t      sock;
   etcpal_poll_events_t events;
+  void*                user_data;
 } EtcPalPollSocket;
 
+/* The socket table of a poll context: a directory of chunks of EtcPalPollSocket entries, indexed by
+ * file descriptor. The wait functions read the table without taking the context lock, so neither
+ * chunks nor outgrown directories are freed until the context is deinitialized. */
+typedef struct EtcPalPollSocketTable
+{
+  struct EtcPalPollSocketTable* prev;  // The outgrown directory this one replaced, if any
+  size_t                        num_chunks;
+  EtcPalPollSocket**            chunks;
+} EtcPalPollSocketTable;
+
 /**************************** Private variables ******************************/
 
 #if !defined(ETCPAL_BUILDING_MOCK_LIB)
@@ -117,6 +151,13 @@ static const int aiprotmap[ETCPAL_NUM_IPPROTO] =
 
 /*********************** Private function prototypes *************************/
 
+// Helpers for etcpal_sendmsg() and etcpal_recvmsg()
+static void iovecs_etcpal_to_os(const EtcPalMsgHdr* msg, struct iovec* iovs);
+
+// Helpers for the control message API
+static void init_control_msghdr(const EtcPalMsgHdr* msgh, struct msghdr* os_msgh);
+static bool cmsg_os_to_etcpal(struct cmsghdr* os_cmsg, EtcPalCMsgHdr* cmsg);
+
 // Helpers for etcpal_setsockopt()
 static void ms_to_timeval(int ms, struct timeval* tv);
 static int  setsockopt_socket(etcpal_socket_t id, int option_name, const void* option_value, size_t option_len);
@@ -130,10 +171,22 @@ static int                  events_etcpal_to_kqueue(etcpal_socket_t      socket,
                                                     void*                user_data,
                                                     struct kevent*       events);
 static etcpal_poll_events_t events_kqueue_to_etcpal(const struct kevent* kevent, const EtcPalPollSocket* sock_desc);
-
-static int           poll_socket_compare(const EtcPalRbTree* tree, const void* value_a, const void* value_b);
-static EtcPalRbNode* poll_socket_alloc(void);
-static void          poll_socket_free(EtcPalRbNode* node);
+static EtcPalPollEvent*     find_poll_event(EtcPalPollEvent* events, size_t num_events, etcpal_socket_t socket);
+static int                  handle_kqueue_result(EtcPalPollContext*   context,
+                                                 const struct kevent* kevts,
+                                                 int                  num_kevts,
+                                                 EtcPalPollEvent*     events);
+static int spin_kevent(int kq_fd, struct kevent* kevts, int max_kevts, uint64_t spin_us);
+static int wait_kqueue(EtcPalPollContext* context, EtcPalPollEvent* events, size_t max_events, int timeout_ms);
+
+static EtcPalPollSocketTable* alloc_poll_socket_table(size_t num_chunks, EtcPalPollSocketTable* prev);
+static void                   free_poll_socket_table(EtcPalPollSocketTable* table);
+static EtcPalPollSocket*      get_poll_socket_entry(EtcPalPollContext* context, etcpal_socket_t socket, bool create);
+static void                   write_poll_socket_entry(EtcPalPollSocket*    entry,
+                                                      etcpal_socket_t      socket,
+                                                      etcpal_poll_events_t events,
+                                                      void*                user_data);
+static bool read_poll_socket_entry(const EtcPalPollContext* context, etcpal_socket_t socket, EtcPalPollSocket* result);
 
 /*************************** Function definitions ****************************/
 
@@ -253,7 +306,11 @@ int etcpal_recv(etcpal_socket_t id, void* buffer, size_t length, int flags)
 
   int impl_flags = (flags & ETCPAL_MSG_PEEK) ? MSG_PEEK : 0;
   int res = (int)recv(id, buffer, length, impl_flags);
-  return (res >= 0 ? res : (int)errno_os_to_etcpal(errno));
+  if (res < 0)
+    res = (int)errno_os_to_etcpal(errno);
+
+  ETCPAL_SOCKET_STATS_RECV(id, res);
+  return res;
 }
 
 int etcpal_recvfrom(etcpal_socket_t id, void* buffer, size_t length, int flags, EtcPalSockAddr* address)
@@ -265,17 +322,72 @@ int etcpal_recvfrom(etcpal_socket_t id, void* buffer, size_t length, int flags,
   socklen_t               fromlen = sizeof fromaddr;
   int                     impl_flags = (flags & ETCPAL_MSG_PEEK) ? MSG_PEEK : 0;
   int                     res = (int)recvfrom(id, buffer, length, impl_flags, (struct sockaddr*)&fromaddr, &fromlen);
+  if (res < 0)
+    res = (int)errno_os_to_etcpal(errno);
 
-  if (res >= 0)
+  ETCPAL_SOCKET_STATS_RECV(id, res);
+  if (res >= 0 && address && fromlen > 0)
   {
-    if (address && fromlen > 0)
-    {
-      if (!sockaddr_os_to_etcpal((etcpal_os_sockaddr_t*)&fromaddr, address))
-        return kEtcPalErrSys;
-    }
+    if (!sockaddr_os_to_etcpal((etcpal_os_sockaddr_t*)&fromaddr, address))
+      return kEtcPalErrSys;
+  }
+  return res;
+}
+
+int etcpal_recvmmsg(etcpal_socket_t id, EtcPalMmsgHdr* msgs, size_t num_msgs, int flags)
+{
+  if (!msgs || num_msgs == 0)
+    return (int)kEtcPalErrInvalid;
+
+  // No native batch receive on this platform; receive a single datagram.
+  int res = etcpal_recvfrom(id, msgs[0].buf, msgs[0].len, flags, msgs[0].addr);
+  if (res < 0)
     return res;
+
+  msgs[0].msg_len = (size_t)res;
+  return 1;
+}
+
+int etcpal_recvmsg(etcpal_socket_t id, EtcPalMsgHdr* msg, int flags)
+{
+  if (!msg || !msg->iov || msg->iovlen == 0 || msg->iovlen > ETCPAL_MSG_MAX_IOV)
+    return (int)kEtcPalErrInvalid;
+
+  struct iovec iovs[ETCPAL_MSG_MAX_IOV];
+  iovecs_etcpal_to_os(msg, iovs);
+
+  struct sockaddr_storage fromaddr;
+  struct msghdr           os_msg;
+  memset(&os_msg, 0, sizeof os_msg);
+  os_msg.msg_name = &fromaddr;
+  os_msg.msg_namelen = sizeof fromaddr;
+  os_msg.msg_iov = iovs;
+  os_msg.msg_iovlen = (int)msg->iovlen;
+  os_msg.msg_control = msg->control;
+  os_msg.msg_controllen = (msg->control ? (socklen_t)msg->controllen : 0);
+
+  int impl_flags = (flags & ETCPAL_MSG_PEEK) ? MSG_PEEK : 0;
+  int res = (int)recvmsg(id, &os_msg, impl_flags);
+  if (res < 0)
+  {
+    res = (int)errno_os_to_etcpal(errno);
+    ETCPAL_SOCKET_STATS_RECV(id, res);
+    return res;
+  }
+  ETCPAL_SOCKET_STATS_RECV_BATCH(id, 1, (size_t)res, ((os_msg.msg_flags & MSG_TRUNC) ? 1 : 0));
+
+  msg->controllen = (size_t)os_msg.msg_controllen;
+  msg->flags = 0;
+  if (os_msg.msg_flags & MSG_TRUNC)
+    msg->flags |= ETCPAL_MSG_TRUNC;
+  if (os_msg.msg_flags & MSG_CTRUNC)
+    msg->flags |= ETCPAL_MSG_CTRUNC;
+  if (msg->name && os_msg.msg_namelen > 0)
+  {
+    if (!sockaddr_os_to_etcpal((etcpal_os_sockaddr_t*)&fromaddr, msg->name))
+      return (int)kEtcPalErrSys;
   }
-  return (int)errno_os_to_etcpal(errno);
+  return res;
 }
 
 int etcpal_send(etcpal_socket_t id, const void* message, size_t length, int flags)
@@ -286,7 +398,63 @@ int etcpal_send(etcpal_socket_t id, const void* message, size_t length, int flag
     return (int)kEtcPalErrInvalid;
 
   int res = (int)send(id, message, length, 0);
-  return (res >= 0 ? res : (int)errno_os_to_etcpal(errno));
+  if (res < 0)
+    res = (int)errno_os_to_etcpal(errno);
+
+  ETCPAL_SOCKET_STATS_SEND(id, res);
+  return res;
+}
+
+int etcpal_sendmmsg(etcpal_socket_t id, EtcPalMmsgHdr* msgs, size_t num_msgs, int flags)
+{
+  if (!msgs || num_msgs == 0)
+    return (int)kEtcPalErrInvalid;
+
+  // No native batch send on this platform; send the datagrams one at a time.
+  size_t num_sent = 0;
+  for (; num_sent < num_msgs; ++num_sent)
+  {
+    EtcPalMmsgHdr* msg = &msgs[num_sent];
+
+    int res = (msg->addr ? etcpal_sendto(id, msg->buf, msg->len, flags, msg->addr)
+                         : etcpal_send(id, msg->buf, msg->len, flags));
+    if (res < 0)
+      return (num_sent > 0 ? (int)num_sent : res);
+    msg->msg_len = (size_t)res;
+  }
+  return (int)num_sent;
+}
+
+int etcpal_sendmsg(etcpal_socket_t id, const EtcPalMsgHdr* msg, int flags)
+{
+  ETCPAL_UNUSED_ARG(flags);
+
+  if (!msg || !msg->iov || msg->iovlen == 0 || msg->iovlen > ETCPAL_MSG_MAX_IOV)
+    return (int)kEtcPalErrInvalid;
+
+  struct iovec iovs[ETCPAL_MSG_MAX_IOV];
+  iovecs_etcpal_to_os(msg, iovs);
+
+  struct sockaddr_storage destaddr;
+  struct msghdr           os_msg;
+  memset(&os_msg, 0, sizeof os_msg);
+  if (msg->name)
+  {
+    socklen_t ss_size = (socklen_t)sockaddr_etcpal_to_os(msg->name, (etcpal_os_sockaddr_t*)&destaddr);
+    if (ss_size == 0)
+      return (int)kEtcPalErrSys;
+    os_msg.msg_name = &destaddr;
+    os_msg.msg_namelen = ss_size;
+  }
+  os_msg.msg_iov = iovs;
+  os_msg.msg_iovlen = (int)msg->iovlen;
+
+  int res = (int)sendmsg(id, &os_msg, 0);
+  if (res < 0)
+    res = (int)errno_os_to_etcpal(errno);
+
+  ETCPAL_SOCKET_STATS_SEND(id, res);
+  return res;
 }
 
 int etcpal_sendto(etcpal_socket_t id, const void* message, size_t length, int flags, const EtcPalSockAddr* dest_addr)
@@ -302,8 +470,25 @@ int etcpal_sendto(etcpal_socket_t id, const void* message, size_t length, int fl
     return (int)kEtcPalErrSys;
 
   int res = (int)sendto(id, message, length, 0, (struct sockaddr*)&ss, ss_size);
+  if (res < 0)
+    res = (int)errno_os_to_etcpal(errno);
+
+  ETCPAL_SOCKET_STATS_SEND(id, res);
+  return res;
+}
+
+int etcpal_sendto_segmented(etcpal_socket_t       id,
+                            const void*           message,
+                            size_t                length,
+                            size_t                segment_size,
+                            int                   flags,
+                            const EtcPalSockAddr* dest_addr)
+{
+  if (!message || length == 0 || segment_size == 0)
+    return (int)kEtcPalErrInvalid;
 
-  return (res >= 0 ? res : (int)errno_os_to_etcpal(errno));
+  // No segmentation offload on this platform; send the datagrams individually.
+  return etcpal_sendto_segments_fallback(id, (const uint8_t*)message, length, segment_size, flags, dest_addr, 0);
 }
 
 etcpal_error_t etcpal_setsockopt(etcpal_socket_t id,
@@ -335,6 +520,50 @@ etcpal_error_t etcpal_setsockopt(etcpal_socket_t id,
   return (res == 0 ? kEtcPalErrOk : errno_os_to_etcpal(errno));
 }
 
+void iovecs_etcpal_to_os(const EtcPalMsgHdr* msg, struct iovec* iovs)
+{
+  for (size_t i = 0; i < msg->iovlen; ++i)
+  {
+    iovs[i].iov_base = msg->iov[i].base;
+    iovs[i].iov_len = msg->iov[i].len;
+  }
+}
+
+void init_control_msghdr(const EtcPalMsgHdr* msgh, struct msghdr* os_msgh)
+{
+  memset(os_msgh, 0, sizeof(struct msghdr));
+  os_msgh->msg_control = msgh->control;
+  os_msgh->msg_controllen = (msgh->control ? (socklen_t)msgh->controllen : 0);
+}
+
+bool cmsg_os_to_etcpal(struct cmsghdr* os_cmsg, EtcPalCMsgHdr* cmsg)
+{
+  if (!os_cmsg || os_cmsg->cmsg_len < CMSG_LEN(0))
+    return false;
+
+  cmsg->len = (size_t)(os_cmsg->cmsg_len - CMSG_LEN(0));
+  cmsg->level = -1;
+  cmsg->type = -1;
+  if (os_cmsg->cmsg_level == SOL_SOCKET && os_cmsg->cmsg_type == SCM_TIMESTAMP)
+  {
+    cmsg->level = ETCPAL_SOL_SOCKET;
+    cmsg->type = ETCPAL_SO_TIMESTAMP;
+  }
+  else if (os_cmsg->cmsg_level == IPPROTO_IP && os_cmsg->cmsg_type == IP_PKTINFO)
+  {
+    cmsg->level = ETCPAL_IPPROTO_IP;
+    cmsg->type = ETCPAL_IP_PKTINFO;
+  }
+  else if (os_cmsg->cmsg_level == IPPROTO_IPV6 && os_cmsg->cmsg_type == IPV6_PKTINFO)
+  {
+    cmsg->level = ETCPAL_IPPROTO_IPV6;
+    cmsg->type = ETCPAL_IP_PKTINFO;
+  }
+  cmsg->pd = os_cmsg;
+  return true;
+}
+
+
 int setsockopt_socket(etcpal_socket_t id, int option_name, const void* option_value, size_t option_len)
 {
   switch (option_name)
@@ -379,6 +608,8 @@ int setsockopt_socket(etcpal_socket_t id, int option_name, const void* option_va
         return setsockopt(id, SOL_SOCKET, SO_LINGER, &val, sizeof val);
       }
       break;
+    case ETCPAL_SO_TIMESTAMP:
+      return setsockopt(id, SOL_SOCKET, SO_TIMESTAMP, option_value, (socklen_t)option_len);
     case ETCPAL_SO_ERROR:  // Set not supported
     case ETCPAL_SO_TYPE:   // Set not supported
     default:
@@ -485,6 +716,8 @@ int setsockopt_ip(etcpal_socket_t id, int option_name, const void* option_value,
       return setsockopt(id, IPPROTO_IP, IP_MULTICAST_TTL, option_value, (socklen_t)option_len);
     case ETCPAL_IP_MULTICAST_LOOP:
       return setsockopt(id, IPPROTO_IP, IP_MULTICAST_LOOP, option_value, (socklen_t)option_len);
+    case ETCPAL_IP_PKTINFO:
+      return setsockopt(id, IPPROTO_IP, IP_RECVPKTINFO, option_value, (socklen_t)option_len);
     default:
       break;
   }
@@ -531,6 +764,8 @@ int setsockopt_ip6(etcpal_socket_t id, int option_name, const void* option_value
       return setsockopt(id, IPPROTO_IPV6, IPV6_MULTICAST_LOOP, option_value, (socklen_t)option_len);
     case ETCPAL_IPV6_V6ONLY:
       return setsockopt(id, IPPROTO_IPV6, IPV6_V6ONLY, option_value, (socklen_t)option_len);
+    case ETCPAL_IP_PKTINFO:
+      return setsockopt(id, IPPROTO_IPV6, IPV6_RECVPKTINFO, option_value, (socklen_t)option_len);
     default: /* Other IPv6 options TODO on macOS. */
       break;
   }
@@ -581,6 +816,89 @@ etcpal_error_t etcpal_socket(unsigned int family, unsigned int type, etcpal_sock
   return kEtcPalErrInvalid;
 }
 
+bool etcpal_cmsg_firsthdr(EtcPalMsgHdr* msgh, EtcPalCMsgHdr* firsthdr)
+{
+  if (!msgh || !firsthdr)
+    return false;
+
+  struct msghdr os_msgh;
+  init_control_msghdr(msgh, &os_msgh);
+  return cmsg_os_to_etcpal(CMSG_FIRSTHDR(&os_msgh), firsthdr);
+}
+
+bool etcpal_cmsg_nxthdr(EtcPalMsgHdr* msgh, const EtcPalCMsgHdr* cmsg, EtcPalCMsgHdr* nxthdr)
+{
+  if (!msgh || !cmsg || !cmsg->pd || !nxthdr)
+    return false;
+
+  struct msghdr os_msgh;
+  init_control_msghdr(msgh, &os_msgh);
+  return cmsg_os_to_etcpal(CMSG_NXTHDR(&os_msgh, (struct cmsghdr*)cmsg->pd), nxthdr);
+}
+
+bool etcpal_cmsg_to_pktinfo(const EtcPalCMsgHdr* cmsg, EtcPalPktInfo* pktinfo)
+{
+  if (!cmsg || !cmsg->pd || !pktinfo)
+    return false;
+
+  const struct cmsghdr* os_cmsg = (const struct cmsghdr*)cmsg->pd;
+  if (os_cmsg->cmsg_level == IPPROTO_IP && os_cmsg->cmsg_type == IP_PKTINFO &&
+      os_cmsg->cmsg_len >= CMSG_LEN(sizeof(struct in_pktinfo)))
+  {
+    struct in_pktinfo info;
+    memcpy(&info, CMSG_DATA(os_cmsg), sizeof info);
+    ETCPAL_IP_SET_V4_ADDRESS(&pktinfo->addr, ntohl(info.ipi_addr.s_addr));
+    pktinfo->ifindex = (unsigned int)info.ipi_ifindex;
+    return true;
+  }
+  if (os_cmsg->cmsg_level == IPPROTO_IPV6 && os_cmsg->cmsg_type == IPV6_PKTINFO &&
+      os_cmsg->cmsg_len >= CMSG_LEN(sizeof(struct in6_pktinfo)))
+  {
+    struct in6_pktinfo info;
+    memcpy(&info, CMSG_DATA(os_cmsg), sizeof info);
+    ETCPAL_IP_SET_V6_ADDRESS(&pktinfo->addr, info.ipi6_addr.s6_addr);
+    pktinfo->ifindex = (unsigned int)info.ipi6_ifindex;
+    return true;
+  }
+  return false;
+}
+
+bool etcpal_cmsg_to_timestamp(const EtcPalCMsgHdr* cmsg, EtcPalRecvTimestamp* timestamp)
+{
+  if (!cmsg || !cmsg->pd || !timestamp)
+    return false;
+
+  const struct cmsghdr* os_cmsg = (const struct cmsghdr*)cmsg->pd;
+  if (os_cmsg->cmsg_level == SOL_SOCKET && os_cmsg->cmsg_type == SCM_TIMESTAMP &&
+      os_cmsg->cmsg_len >= CMSG_LEN(sizeof(struct timeval)))
+  {
+    struct timeval tv;
+    memcpy(&tv, CMSG_DATA(os_cmsg), sizeof tv);
+    timestamp->seconds = (int64_t)tv.tv_sec;
+    timestamp->nanoseconds = (uint32_t)tv.tv_usec * 1000u;
+    timestamp->hardware = false;
+    return true;
+  }
+  return false;
+}
+
+bool etcpal_cmsg_to_udp_gro(const EtcPalCMsgHdr* cmsg, size_t* segment_size)
+{
+  ETCPAL_UNUSED_ARG(cmsg);
+  ETCPAL_UNUSED_ARG(segment_size);
+  return false;
+}
+
+int etcpal_read_zerocopy_completions(etcpal_socket_t           id,
+                                     EtcPalZerocopyCompletion* completions,
+                                     size_t                    max_completions)
+{
+  ETCPAL_UNUSED_ARG(id);
+  ETCPAL_UNUSED_ARG(completions);
+  ETCPAL_UNUSED_ARG(max_completions);
+  return (int)kEtcPalErrNotImpl;
+}
+
 etcpal_error_t etcpal_setblocking(etcpal_socket_t id, bool blocking)
 {
   int val = fcntl(id, F_GETFL, 0);
@@ -611,74 +929,115 @@ etcpal_error_t etcpal_poll_context_init(EtcPalPollContext* context)
   if (!context)
     return kEtcPalErrInvalid;
 
-  context->kq_fd = kqueue();
-  if (context->kq_fd >= 0)
+  context->socket_table = alloc_poll_socket_table(ETCPAL_POLL_INITIAL_NUM_CHUNKS, NULL);
+  if (!context->socket_table)
+    return kEtcPalErrNoMem;
+
+  if (!etcpal_mutex_create(&context->lock))
   {
-    etcpal_rbtree_init(&context->sockets, poll_socket_compare, poll_socket_alloc, poll_socket_free);
-    context->valid = true;
-    return kEtcPalErrOk;
+    free_poll_socket_table(context->socket_table);
+    return kEtcPalErrSys;
   }
-  else
+
+  context->kq_fd = kqueue();
+  if (context->kq_fd >= 0)
   {
-    return errno_os_to_etcpal(errno);
+    // EV_CLEAR resets the wake event each time it is retrieved.
+    struct kevent wake_kevt;
+    EV_SET(&wake_kevt, ETCPAL_POLL_WAKE_IDENT, EVFILT_USER, EV_ADD | EV_CLEAR, 0, 0, NULL);
+    if (kevent(context->kq_fd, &wake_kevt, 1, NULL, 0, NULL) == 0)
+    {
+      context->wake_deferred = false;
+      context->num_valid_sockets = 0;
+      context->spin_us = 0;
+      context->valid = true;
+      return kEtcPalErrOk;
+    }
+    close(context->kq_fd);
   }
+
+  etcpal_error_t res = errno_os_to_etcpal(errno);
+  etcpal_mutex_destroy(&context->lock);
+  free_poll_socket_table(context->socket_table);
+  return res;
 }
 
 void etcpal_poll_context_deinit(EtcPalPollContext* context)
 {
   if (context && context->valid)
   {
-    etcpal_rbtree_clear(&context->sockets);
+    free_poll_socket_table(context->socket_table);
+    context->socket_table = NULL;
+    context->num_valid_sockets = 0;
     close(context->kq_fd);
+    etcpal_mutex_destroy(&context->lock);
     context->valid = false;
   }
 }
 
+etcpal_error_t etcpal_poll_context_wake(EtcPalPollContext* context)
+{
+  if (!context || !context->valid)
+    return kEtcPalErrInvalid;
+
+  struct kevent wake_kevt;
+  EV_SET(&wake_kevt, ETCPAL_POLL_WAKE_IDENT, EVFILT_USER, 0, NOTE_TRIGGER, 0, NULL);
+  if (kevent(context->kq_fd, &wake_kevt, 1, NULL, 0, NULL) != 0)
+    return errno_os_to_etcpal(errno);
+  return kEtcPalErrOk;
+}
+
+etcpal_error_t etcpal_poll_context_set_spin_time(EtcPalPollContext* context, unsigned int spin_us)
+{
+  if (!context || !context->valid)
+    return kEtcPalErrInvalid;
+
+  __atomic_store_n(&context->spin_us, spin_us, __ATOMIC_RELAXED);
+  return kEtcPalErrOk;
+}
+
 etcpal_error_t etcpal_poll_add_socket(EtcPalPollContext*   context,
                                       etcpal_socket_t      socket,
                                       etcpal_poll_events_t events,
                                       void*                user_data)
 {
-  if (context && context->valid && socket != ETCPAL_SOCKET_INVALID && (events & ETCPAL_POLL_VALID_INPUT_EVENT_MASK))
+  if (!context || !context->valid || socket < 0 || !(events & ETCPAL_POLL_VALID_INPUT_EVENT_MASK))
+    return kEtcPalErrInvalid;
+
+  if (!etcpal_mutex_lock(&context->lock))
+    return kEtcPalErrSys;
+
+  etcpal_error_t    res = kEtcPalErrOk;
+  EtcPalPollSocket* entry = get_poll_socket_entry(context, socket, true);
+  if (!entry)
   {
-    EtcPalPollSocket* sock_desc = (EtcPalPollSocket*)malloc(sizeof(EtcPalPollSocket));
-    if (sock_desc)
-    {
-      sock_desc->sock = socket;
-      sock_desc->events = events;
-      etcpal_error_t insert_res = etcpal_rbtree_insert(&context->sockets, sock_desc);
-      if (insert_res == kEtcPalErrOk)
-      {
-        struct kevent os_events[ETCPAL_SOCKET_MAX_KEVENTS];
-        int           num_events = events_etcpal_to_kqueue(socket, 0, events, user_data, os_events);
+    res = kEtcPalErrNoMem;
+  }
+  else if (entry->sock != ETCPAL_SOCKET_INVALID)
+  {
+    res = kEtcPalErrExists;
+  }
+  else
+  {
+    // The entry must be valid before kqueue can report events for the socket.
+    write_poll_socket_entry(entry, socket, events, user_data);
 
-        int res = kevent(context->kq_fd, os_events, num_events, NULL, 0, NULL);
-        if (res == 0)
-        {
-          return kEtcPalErrOk;
-        }
-        else
-        {
-          // Our node dealloc function also deallocates sock_desc, so no need to free it here.
-          etcpal_rbtree_remove(&context->sockets, sock_desc);
-          return errno_os_to_etcpal(errno);
-        }
-      }
-      else
-      {
-        free(sock_desc);
-        return insert_res;
-      }
+    struct kevent os_events[ETCPAL_SOCKET_MAX_KEVENTS];
+    int           num_events = events_etcpal_to_kqueue(socket, 0, events, user_data, os_events);
+
+    if (kevent(context->kq_fd, os_events, num_events, NULL, 0, NULL) == 0)
+    {
+      __atomic_store_n(&context->num_valid_sockets, context->num_valid_sockets + 1, __ATOMIC_RELAXED);
     }
     else
     {
-      return kEtcPalErrNoMem;
+      res = errno_os_to_etcpal(errno);
+      write_poll_socket_entry(entry, ETCPAL_SOCKET_INVALID, 0, NULL);
     }
   }
-  else
-  {
-    return kEtcPalErrInvalid;
-  }
+
+  etcpal_mutex_unlock(&context->lock);
+  return res;
 }
 
 etcpal_error_t etcpal_poll_modify_socket(EtcPalPollContext*   context,
@@ -686,121 +1045,222 @@ etcpal_error_t etcpal_poll_modify_socket(EtcPalPollContext*   context,
                                          etcpal_poll_events_t new_events,
                                          void*                new_user_data)
 {
-  if (context && context->valid && socket != ETCPAL_SOCKET_INVALID && (new_events & ETCPAL_POLL_VALID_INPUT_EVENT_MASK))
+  if (!context || !context->valid || socket == ETCPAL_SOCKET_INVALID ||
+      !(new_events & ETCPAL_POLL_VALID_INPUT_EVENT_MASK))
   {
-    EtcPalPollSocket* sock_desc = (EtcPalPollSocket*)etcpal_rbtree_find(&context->sockets, &socket);
-    if (sock_desc)
-    {
-      struct kevent os_events[ETCPAL_SOCKET_MAX_KEVENTS];
-      int num_events = events_etcpal_to_kqueue(socket, sock_desc->events, new_events, new_user_data, os_events);
+    return kEtcPalErrInvalid;
+  }
 
-      int res = kevent(context->kq_fd, os_events, num_events, NULL, 0, NULL);
-      if (res == 0)
-      {
-        sock_desc->events = new_events;
-        return kEtcPalErrOk;
-      }
-      else
-      {
-        return errno_os_to_etcpal(errno);
-      }
-    }
-    else
-    {
-      return kEtcPalErrNotFound;
-    }
+  if (!etcpal_mutex_lock(&context->lock))
+    return kEtcPalErrSys;
+
+  etcpal_error_t    res = kEtcPalErrOk;
+  EtcPalPollSocket* entry = get_poll_socket_entry(context, socket, false);
+  if (!entry || entry->sock != socket)
+  {
+    res = kEtcPalErrNotFound;
   }
   else
   {
-    return kEtcPalErrInvalid;
+    struct kevent os_events[ETCPAL_SOCKET_MAX_KEVENTS];
+    int num_events = events_etcpal_to_kqueue(socket, entry->events, new_events, new_user_data, os_events);
+
+    if (kevent(context->kq_fd, os_events, num_events, NULL, 0, NULL) == 0)
+      write_poll_socket_entry(entry, socket, new_events, new_user_data);
+    else
+      res = errno_os_to_etcpal(errno);
   }
+
+  etcpal_mutex_unlock(&context->lock);
+  return res;
 }
 
 void etcpal_poll_remove_socket(EtcPalPollContext* context, etcpal_socket_t socket)
 {
-  if (context && context->valid)
+  if (!context || !context->valid || !etcpal_mutex_lock(&context->lock))
+    return;
+
+  EtcPalPollSocket* entry = get_poll_socket_entry(context, socket, false);
+  if (entry && entry->sock == socket)
   {
-    EtcPalPollSocket* sock_desc = (EtcPalPollSocket*)etcpal_rbtree_find(&context->sockets, &socket);
-    if (sock_desc)
+    struct kevent os_events[ETCPAL_SOCKET_MAX_KEVENTS];
+    int           num_events = events_etcpal_to_kqueue(socket, entry->events, 0, NULL, os_events);
+    kevent(context->kq_fd, os_events, num_events, NULL, 0, NULL);
+
+    // A wait in progress may still hold an event for this socket; invalidating the entry causes the
+    // event to be discarded.
+    write_poll_socket_entry(entry, ETCPAL_SOCKET_INVALID, 0, NULL);
+    __atomic_store_n(&context->num_valid_sockets, context->num_valid_sockets - 1, __ATOMIC_RELAXED);
+  }
+
+  etcpal_mutex_unlock(&context->lock);
+}
+
+etcpal_error_t etcpal_poll_wait(EtcPalPollContext* context, EtcPalPollEvent* event, int timeout_ms)
+{
+  int res = etcpal_poll_wait_many(context, event, 1, timeout_ms);
+  return (res > 0 ? kEtcPalErrOk : (etcpal_error_t)res);
+}
+
+int etcpal_poll_wait_many(EtcPalPollContext* context, EtcPalPollEvent* events, size_t max_events, int timeout_ms)
+{
+  if (!context || !context->valid || !events || max_events == 0)
+    return (int)kEtcPalErrInvalid;
+
+  if (__atomic_load_n(&context->num_valid_sockets, __ATOMIC_RELAXED) == 0)
+    return (int)kEtcPalErrNoSockets;
+
+  ETCPAL_SOCKET_STATS_POLL_START(stats_start_us);
+  int res = wait_kqueue(context, events, max_events, timeout_ms);
+  ETCPAL_SOCKET_STATS_POLL_DONE(stats_start_us, res);
+  return res;
+}
+
+// Wait for events on a validated, non-empty poll context. Returns the number of events or an
+// error code.
+int wait_kqueue(EtcPalPollContext* context, EtcPalPollEvent* events, size_t max_events, int timeout_ms)
+{
+  if (__atomic_exchange_n(&context->wake_deferred, false, __ATOMIC_ACQ_REL))
+    return (int)kEtcPalErrWoken;
+
+  EtcPalTimer timer;
+  if (timeout_ms != ETCPAL_WAIT_FOREVER)
+    etcpal_timer_start(&timer, (uint32_t)timeout_ms);
+
+  // kqueue reports each filter (read, write, except) as a separate kevent, so a single socket can
+  // generate several kevents. Those are combined into one EtcPalPollEvent below, so we can always
+  // ask for at least max_events kevents.
+  struct kevent kevts[ETCPAL_POLL_MAX_EVENTS_PER_WAIT];
+  int max_kevts =
+      (max_events < ETCPAL_POLL_MAX_EVENTS_PER_WAIT ? (int)max_events : ETCPAL_POLL_MAX_EVENTS_PER_WAIT);
+
+  // The spin is limited to the timeout, and only done once per call.
+  uint64_t spin_us = __atomic_load_n(&context->spin_us, __ATOMIC_RELAXED);
+  if (timeout_ms != ETCPAL_WAIT_FOREVER && spin_us > (uint64_t)timeout_ms * 1000)
+    spin_us = (uint64_t)timeout_ms * 1000;
+
+  while (true)
+  {
+    int wait_res = 0;
+    if (spin_us > 0)
     {
-      struct kevent os_events[ETCPAL_SOCKET_MAX_KEVENTS];
-      int           num_events = events_etcpal_to_kqueue(socket, sock_desc->events, 0, NULL, os_events);
+      wait_res = spin_kevent(context->kq_fd, kevts, max_kevts, spin_us);
+      spin_us = 0;
+    }
 
-      kevent(context->kq_fd, os_events, num_events, NULL, 0, NULL);
-      etcpal_rbtree_remove(&context->sockets, sock_desc);
+    struct timespec  os_timeout;
+    struct timespec* os_timeout_ptr = NULL;
+    if (timeout_ms != ETCPAL_WAIT_FOREVER)
+    {
+      uint32_t remaining = etcpal_timer_remaining(&timer);
+      os_timeout.tv_sec = remaining / 1000;
+      os_timeout.tv_nsec = (remaining % 1000) * 1000000;
+      os_timeout_ptr = &os_timeout;
     }
+
+    if (wait_res == 0)
+      wait_res = kevent(context->kq_fd, NULL, 0, kevts, max_kevts, os_timeout_ptr);
+    if (wait_res == 0)
+      return (int)kEtcPalErrTimedOut;
+    if (wait_res < 0)
+      return (int)errno_os_to_etcpal(errno);
+
+    // If all of the kevents were for sockets removed during the wait, wait out the rest of the timeout.
+    int res = handle_kqueue_result(context, kevts, wait_res, events);
+    if (res != 0)
+      return res;
   }
 }
 
-etcpal_error_t etcpal_poll_wait(EtcPalPollContext* context, EtcPalPollEvent* event, int timeout_ms)
+// Poll the kqueue without blocking until it reports events or spin_us microseconds have elapsed.
+// Returns the result of the last kevent() call.
+int spin_kevent(int kq_fd, struct kevent* kevts, int max_kevts, uint64_t spin_us)
 {
-  if (context && context->valid && event)
+  const struct timespec zero_timeout = {0, 0};
+  struct timespec       start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  while (true)
   {
-    if (etcpal_rbtree_size(&context->sockets) > 0)
+    int wait_res = kevent(kq_fd, NULL, 0, kevts, max_kevts, &zero_timeout);
+    if (wait_res != 0)
+      return wait_res;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t elapsed_ns = (int64_t)(now.tv_sec - start.tv_sec) * 1000000000 + (now.tv_nsec - start.tv_nsec);
+    if (elapsed_ns >= (int64_t)spin_us * 1000)
+      return 0;
+  }
+}
+
+// Translate the kevents returned by kevent(). Returns the number of events, #kEtcPalErrWoken, or 0
+// if none of the kevents could be matched to a socket in the context.
+int handle_kqueue_result(EtcPalPollContext* context, const struct kevent* kevts, int num_kevts, EtcPalPollEvent* events)
+{
+  size_t num_events = 0;
+  bool   woken = false;
+  for (const struct kevent* kevt = kevts; kevt < kevts + num_kevts; ++kevt)
+  {
+    if (kevt->filter == EVFILT_USER)
     {
-      struct timespec  os_timeout;
-      struct timespec* os_timeout_ptr;
-      if (timeout_ms == ETCPAL_WAIT_FOREVER)
-      {
-        os_timeout_ptr = NULL;
-      }
-      else
-      {
-        os_timeout.tv_sec = timeout_ms / 1000;
-        os_timeout.tv_nsec = (timeout_ms % 1000) * 1000000;
-        os_timeout_ptr = &os_timeout;
-      }
+      woken = true;
+      continue;
+    }
 
-      struct kevent kevt;
-      int           wait_res = kevent(context->kq_fd, NULL, 0, &kevt, 1, os_timeout_ptr);
-      if (wait_res > 0)
+    etcpal_socket_t  sock = (etcpal_socket_t)kevt->ident;
+    EtcPalPollSocket sock_desc;
+    if (!read_poll_socket_entry(context, sock, &sock_desc))
+      continue;
+
+    EtcPalPollEvent* event = find_poll_event(events, num_events, sock);
+    if (!event)
+    {
+      event = &events[num_events++];
+      event->socket = sock_desc.sock;
+      event->events = 0;
+      event->err = kEtcPalErrOk;
+      event->user_data = sock_desc.user_data;
+    }
+    event->events |= events_kqueue_to_etcpal(kevt, &sock_desc);
+
+    // Only query the pending socket error if kqueue has indicated one, or if we're waiting on a
+    // connect; this saves a system call for the common case of plain readable/writable events.
+    if (event->err == kEtcPalErrOk &&
+        ((kevt->flags & (EV_EOF | EV_ERROR)) || (sock_desc.events & ETCPAL_POLL_CONNECT)))
+    {
+      int       error = 0;
+      socklen_t error_size = sizeof error;
+      if (getsockopt(sock_desc.sock, SOL_SOCKET, SO_ERROR, &error, &error_size) == 0)
       {
-        etcpal_socket_t   sock = (etcpal_socket_t)kevt.ident;
-        EtcPalPollSocket* sock_desc = (EtcPalPollSocket*)etcpal_rbtree_find(&context->sockets, &sock);
-        if (sock_desc)
+        if (error != 0)
         {
-          event->socket = sock_desc->sock;
-          event->events = events_kqueue_to_etcpal(&kevt, sock_desc);
-          event->err = kEtcPalErrOk;
-          event->user_data = kevt.udata;
-
-          // Check for errors
-          int       error;
-          socklen_t error_size = sizeof error;
-          if (getsockopt(sock_desc->sock, SOL_SOCKET, SO_ERROR, &error, &error_size) == 0)
-          {
-            if (error != 0)
-            {
-              event->events |= ETCPAL_POLL_ERR;
-              event->err = errno_os_to_etcpal(error);
-            }
-          }
-
-          return kEtcPalErrOk;
+          event->events |= ETCPAL_POLL_ERR;
+          event->err = errno_os_to_etcpal(error);
         }
-        else
-        {
-          return kEtcPalErrSys;
-        }
-      }
-      else if (wait_res == 0)
-      {
-        return kEtcPalErrTimedOut;
-      }
-      else
-      {
-        return errno_os_to_etcpal(errno);
       }
     }
-    else
-    {
-      return kEtcPalErrNoSockets;
-    }
   }
-  else
+
+  if (num_events > 0)
   {
-    return kEtcPalErrInvalid;
+    // Socket events take priority over a wakeup, which is then reported by the next wait.
+    // Retrieving the wake event cleared it, so it is remembered in the context instead.
+    if (woken)
+      __atomic_store_n(&context->wake_deferred, true, __ATOMIC_RELEASE);
+    return (int)num_events;
   }
+  return (woken ? (int)kEtcPalErrWoken : 0);
+}
+
+EtcPalPollEvent* find_poll_event(EtcPalPollEvent* events, size_t num_events, etcpal_socket_t socket)
+{
+  for (EtcPalPollEvent* event = events; event < events + num_events; ++event)
+  {
+    if (event->socket == socket)
+      return event;
+  }
+  return NULL;
 }
 
 int events_etcpal_to_kqueue(etcpal_socket_t      socket,
@@ -811,11 +1271,18 @@ int events_etcpal_to_kqueue(etcpal_socket_t      socket,
 {
   int num_events = 0;
 
+  // EV_DISPATCH disables each filter after it is reported; re-adding it with EV_ENABLE re-arms it.
+  unsigned short add_flags = EV_ADD | EV_ENABLE;
+  if (new_events & ETCPAL_POLL_EDGE)
+    add_flags |= EV_CLEAR;
+  if (new_events & ETCPAL_POLL_ONESHOT)
+    add_flags |= EV_DISPATCH;
+
   // Process EVFILT_READ changes
   if (new_events & ETCPAL_POLL_IN)
   {
     // Re-add the socket even if it was already added before - user data might be modified.
-    EV_SET(&kevents[num_events], socket, EVFILT_READ, EV_ADD, 0, 0, user_data);
+    EV_SET(&kevents[num_events], socket, EVFILT_READ, add_flags, 0, 0, user_data);
     ++num_events;
   }
   else if (prev_events & ETCPAL_POLL_IN)
@@ -828,7 +1295,7 @@ int events_etcpal_to_kqueue(etcpal_socket_t      socket,
   if (new_events & (ETCPAL_POLL_OUT | ETCPAL_POLL_CONNECT))
   {
     // Re-add the socket even if it was already added before - user data might be modified.
-    EV_SET(&kevents[num_events], socket, EVFILT_WRITE, EV_ADD, 0, 0, user_data);
+    EV_SET(&kevents[num_events], socket, EVFILT_WRITE, add_flags, 0, 0, user_data);
     ++num_events;
   }
   else if (prev_events & (ETCPAL_POLL_OUT | ETCPAL_POLL_CONNECT))
@@ -844,7 +1311,7 @@ int events_etcpal_to_kqueue(etcpal_socket_t      socket,
   if (new_events & ETCPAL_POLL_OOB)
   {
     // Re-add the socket even if it was already added before - user data might be modified.
-    EV_SET(&kevents[num_events], socket, EVFILT_EXCEPT, EV_ADD, NOTE_OOB, 0, user_data);
+    EV_SET(&kevents[num_events], socket, EVFILT_EXCEPT, add_flags, NOTE_OOB, 0, user_data);
     ++num_events;
   }
   else if (prev_events & ETCPAL_POLL_OOB)
@@ -889,26 +1356,129 @@ etcpal_poll_events_t events_kqueue_to_etcpal(const struct kevent* kevent, const
   return events_out;
 }
 
-int poll_socket_compare(const EtcPalRbTree* tree, const void* value_a, const void* value_b)
+// Allocate a socket table directory with room for num_chunks chunks, taking over the chunks of the
+// outgrown directory prev, if given.
+EtcPalPollSocketTable* alloc_poll_socket_table(size_t num_chunks, EtcPalPollSocketTable* prev)
 {
-  const EtcPalPollSocket* a = (const EtcPalPollSocket*)value_a;
-  const EtcPalPollSocket* b = (const EtcPalPollSocket*)value_b;
-
-  return (a->sock > b->sock) - (a->sock < b->sock);
+  EtcPalPollSocketTable* table =
+      (EtcPalPollSocketTable*)malloc(sizeof(EtcPalPollSocketTable) + num_chunks * sizeof(EtcPalPollSocket*));
+  if (!table)
+    return NULL;
+
+  table->prev = prev;
+  table->num_chunks = num_chunks;
+  table->chunks = (EtcPalPollSocket**)(table + 1);
+  size_t num_prev_chunks = (prev ? prev->num_chunks : 0);
+  for (size_t i = 0; i < num_chunks; ++i)
+    table->chunks[i] = (i < num_prev_chunks ? prev->chunks[i] : NULL);
+  return table;
 }
 
-EtcPalRbNode* poll_socket_alloc(void)
+// Free a socket table, along with all of its chunks and outgrown directories.
+void free_poll_socket_table(EtcPalPollSocketTable* table)
 {
-  return (EtcPalRbNode*)malloc(sizeof(EtcPalRbNode));
+  if (!table)
+    return;
+
+  for (size_t i = 0; i < table->num_chunks; ++i)
+    free(table->chunks[i]);
+
+  while (table)
+  {
+    EtcPalPollSocketTable* prev = table->prev;
+    free(table);
+    table = prev;
+  }
 }
 
-void poll_socket_free(EtcPalRbNode* node)
+// Get the socket table entry for a descriptor, or NULL if there is none. If create is true, the
+// table is grown as necessary to make room for the entry. Must be called with the context lock held.
+EtcPalPollSocket* get_poll_socket_entry(EtcPalPollContext* context, etcpal_socket_t socket, bool create)
 {
-  if (node)
+  if (socket < 0)
+    return NULL;
+
+  size_t                 chunk_index = (size_t)socket / ETCPAL_POLL_SOCKET_CHUNK_SIZE;
+  EtcPalPollSocketTable* table = context->socket_table;
+  if (chunk_index >= table->num_chunks)
   {
-    free(node->value);
-    free(node);
+    if (!create)
+      return NULL;
+
+    size_t new_num_chunks = table->num_chunks * 2;
+    if (new_num_chunks <= chunk_index)
+      new_num_chunks = chunk_index + 1;
+
+    table = alloc_poll_socket_table(new_num_chunks, table);
+    if (!table)
+      return NULL;
+    __atomic_store_n(&context->socket_table, table, __ATOMIC_RELEASE);
   }
+
+  EtcPalPollSocket* chunk = table->chunks[chunk_index];
+  if (!chunk)
+  {
+    if (!create)
+      return NULL;
+
+    chunk = (EtcPalPollSocket*)malloc(ETCPAL_POLL_SOCKET_CHUNK_SIZE * sizeof(EtcPalPollSocket));
+    if (!chunk)
+      return NULL;
+    for (size_t i = 0; i < ETCPAL_POLL_SOCKET_CHUNK_SIZE; ++i)
+    {
+      chunk[i].seq = 0;
+      chunk[i].sock = ETCPAL_SOCKET_INVALID;
+    }
+    __atomic_store_n(&table->chunks[chunk_index], chunk, __ATOMIC_RELEASE);
+  }
+
+  return &chunk[(size_t)socket % ETCPAL_POLL_SOCKET_CHUNK_SIZE];
+}
+
+// Update a socket table entry so that it can be read consistently by read_poll_socket_entry()
+// without locking (a sequence lock). Must be called with the context lock held.
+void write_poll_socket_entry(EtcPalPollSocket*    entry,
+                             etcpal_socket_t      socket,
+                             etcpal_poll_events_t events,
+                             void*                user_data)
+{
+  unsigned int seq = entry->seq;
+  __atomic_store_n(&entry->seq, seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  __atomic_store_n(&entry->sock, socket, __ATOMIC_RELAXED);
+  __atomic_store_n(&entry->events, events, __ATOMIC_RELAXED);
+  __atomic_store_n(&entry->user_data, user_data, __ATOMIC_RELAXED);
+  __atomic_store_n(&entry->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+// Get a consistent copy of the socket table entry for a descriptor without locking. Returns false
+// if the descriptor is not currently in the context.
+bool read_poll_socket_entry(const EtcPalPollContext* context, etcpal_socket_t socket, EtcPalPollSocket* result)
+{
+  if (socket < 0)
+    return false;
+
+  size_t                       chunk_index = (size_t)socket / ETCPAL_POLL_SOCKET_CHUNK_SIZE;
+  const EtcPalPollSocketTable* table = __atomic_load_n(&context->socket_table, __ATOMIC_ACQUIRE);
+  if (chunk_index >= table->num_chunks)
+    return false;
+
+  const EtcPalPollSocket* chunk = __atomic_load_n(&table->chunks[chunk_index], __ATOMIC_ACQUIRE);
+  if (!chunk)
+    return false;
+
+  const EtcPalPollSocket* entry = &chunk[(size_t)socket % ETCPAL_POLL_SOCKET_CHUNK_SIZE];
+  unsigned int            seq;
+  do
+  {
+    seq = __atomic_load_n(&entry->seq, __ATOMIC_ACQUIRE);
+    result->sock = __atomic_load_n(&entry->sock, __ATOMIC_RELAXED);
+    result->events = __atomic_load_n(&entry->events, __ATOMIC_RELAXED);
+    result->user_data = __atomic_load_n(&entry->user_data, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  } while ((seq & 1) || seq != __atomic_load_n(&entry->seq, __ATOMIC_RELAXED));
+
+  return (result->sock == socket);
 }
 
 etcpal_error_t etcpal_getaddrinfo(const char*           hostname,
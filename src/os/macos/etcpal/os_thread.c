@@ -100,6 +100,15 @@ etcpal_error_t etcpal_thread_terminate(etcpal_thread_t* id)
   return kEtcPalErrOk;
 }
 
+etcpal_error_t etcpal_thread_set_affinity(etcpal_thread_t* id, unsigned int cpu)
+{
+  ETCPAL_UNUSED_ARG(cpu);
+  if (!id)
+    return kEtcPalErrInvalid;
+  // macOS only supports affinity hints between threads (thread_policy_set()), not pinning.
+  return kEtcPalErrNotImpl;
+}
+
 void* thread_func_internal(void* arg)
 {
   etcpal_thread_t* thread_data = (etcpal_thread_t*)arg;
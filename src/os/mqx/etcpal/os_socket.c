@@ -25,6 +25,7 @@
 #include <rtcs.h>
 
 #include "etcpal/private/socket.h"
+#include "etcpal/timer.h"
 
 /***************************** Private macros ********************************/
 
@@ -112,8 +113,9 @@ static EtcPalPollCtxSocket* find_socket(EtcPalPollContext* context, etcpal_socke
 static EtcPalPollCtxSocket* find_hole(EtcPalPollContext* context);
 static void                 set_in_fd_sets(EtcPalPollContext* context, const EtcPalPollCtxSocket* sock);
 static void                 clear_in_fd_sets(EtcPalPollContext* context, const EtcPalPollCtxSocket* sock);
-static etcpal_error_t       handle_select_result(EtcPalPollContext* context,
-                                                 EtcPalPollEvent*   event,
+static int                  handle_select_result(EtcPalPollContext* context,
+                                                 EtcPalPollEvent*   events,
+                                                 size_t             max_events,
                                                  etcpal_error_t     socket_error,
                                                  const rtcs_fd_set* readfds,
                                                  const rtcs_fd_set* writefds);
@@ -278,12 +280,58 @@ int etcpal_recvfrom(etcpal_socket_t id, void* buffer, size_t length, int flags,
   return (res == RTCS_ERROR ? err_os_to_etcpal(RTCS_geterror(id)) : res);
 }
 
+int etcpal_recvmmsg(etcpal_socket_t id, EtcPalMmsgHdr* msgs, size_t num_msgs, int flags)
+{
+  if (!msgs || num_msgs == 0)
+    return (int)kEtcPalErrInvalid;
+
+  // No native batch receive on this platform; receive a single datagram.
+  int res = etcpal_recvfrom(id, msgs[0].buf, msgs[0].len, flags, msgs[0].addr);
+  if (res < 0)
+    return res;
+
+  msgs[0].msg_len = (size_t)res;
+  return 1;
+}
+
+int etcpal_recvmsg(etcpal_socket_t id, EtcPalMsgHdr* msg, int flags)
+{
+  /* TODO */
+  return kEtcPalErrNotImpl;
+}
+
 int etcpal_send(etcpal_socket_t id, const void* message, size_t length, int flags)
 {
   /* TODO */
   return kEtcPalErrNotImpl;
 }
 
+int etcpal_sendmmsg(etcpal_socket_t id, EtcPalMmsgHdr* msgs, size_t num_msgs, int flags)
+{
+  if (!msgs || num_msgs == 0)
+    return (int)kEtcPalErrInvalid;
+
+  // No native batch send on this platform; send the datagrams one at a time.
+  size_t num_sent = 0;
+  for (; num_sent < num_msgs; ++num_sent)
+  {
+    EtcPalMmsgHdr* msg = &msgs[num_sent];
+
+    int res = (msg->addr ? etcpal_sendto(id, msg->buf, msg->len, flags, msg->addr)
+                         : etcpal_send(id, msg->buf, msg->len, flags));
+    if (res < 0)
+      return (num_sent > 0 ? (int)num_sent : res);
+    msg->msg_len = (size_t)res;
+  }
+  return (int)num_sent;
+}
+
+int etcpal_sendmsg(etcpal_socket_t id, const EtcPalMsgHdr* msg, int flags)
+{
+  /* TODO */
+  return kEtcPalErrNotImpl;
+}
+
 int etcpal_sendto(etcpal_socket_t id, const void* message, size_t length, int flags, const EtcPalSockAddr* dest_addr)
 {
   int32_t         res;
@@ -300,6 +348,20 @@ int etcpal_sendto(etcpal_socket_t id, const void* message, size_t length, int fl
   return (res == RTCS_ERROR ? err_os_to_etcpal(RTCS_geterror(id)) : res);
 }
 
+int etcpal_sendto_segmented(etcpal_socket_t       id,
+                            const void*           message,
+                            size_t                length,
+                            size_t                segment_size,
+                            int                   flags,
+                            const EtcPalSockAddr* dest_addr)
+{
+  if (!message || length == 0 || segment_size == 0)
+    return (int)kEtcPalErrInvalid;
+
+  // No segmentation offload on this platform; send the datagrams individually.
+  return etcpal_sendto_segments_fallback(id, (const uint8_t*)message, length, segment_size, flags, dest_addr, 0);
+}
+
 etcpal_error_t etcpal_setsockopt(etcpal_socket_t id,
                                  int             level,
                                  int             option_name,
@@ -523,6 +585,44 @@ etcpal_error_t etcpal_socket(unsigned int family, unsigned int type, etcpal_sock
   return kEtcPalErrInvalid;
 }
 
+bool etcpal_cmsg_firsthdr(EtcPalMsgHdr* msgh, EtcPalCMsgHdr* firsthdr)
+{
+  /* TODO */
+  return false;
+}
+
+bool etcpal_cmsg_nxthdr(EtcPalMsgHdr* msgh, const EtcPalCMsgHdr* cmsg, EtcPalCMsgHdr* nxthdr)
+{
+  /* TODO */
+  return false;
+}
+
+bool etcpal_cmsg_to_pktinfo(const EtcPalCMsgHdr* cmsg, EtcPalPktInfo* pktinfo)
+{
+  /* TODO */
+  return false;
+}
+
+bool etcpal_cmsg_to_timestamp(const EtcPalCMsgHdr* cmsg, EtcPalRecvTimestamp* timestamp)
+{
+  /* TODO */
+  return false;
+}
+
+bool etcpal_cmsg_to_udp_gro(const EtcPalCMsgHdr* cmsg, size_t* segment_size)
+{
+  /* TODO */
+  return false;
+}
+
+int etcpal_read_zerocopy_completions(etcpal_socket_t           id,
+                                     EtcPalZerocopyCompletion* completions,
+                                     size_t                    max_completions)
+{
+  /* TODO */
+  return (int)kEtcPalErrNotImpl;
+}
+
 etcpal_error_t etcpal_setblocking(etcpal_socket_t id, bool blocking)
 {
   uint32_t  sock_type;
@@ -601,6 +701,9 @@ etcpal_error_t etcpal_poll_context_init(EtcPalPollContext* context)
   if (!context)
     return kEtcPalErrInvalid;
 
+  if (!etcpal_mutex_create(&context->lock))
+    return kEtcPalErrSys;
+
   init_context_socket_array(context);
   ETCPAL_FD_ZERO(&context->readfds);
   ETCPAL_FD_ZERO(&context->writefds);
@@ -613,9 +716,25 @@ void etcpal_poll_context_deinit(EtcPalPollContext* context)
   if (!context || !context->valid)
     return;
 
+  etcpal_mutex_destroy(&context->lock);
   context->valid = false;
 }
 
+etcpal_error_t etcpal_poll_context_wake(EtcPalPollContext* context)
+{
+  if (!context || !context->valid)
+    return kEtcPalErrInvalid;
+  return kEtcPalErrNotImpl;
+}
+
+etcpal_error_t etcpal_poll_context_set_spin_time(EtcPalPollContext* context, unsigned int spin_us)
+{
+  ETCPAL_UNUSED_ARG(spin_us);
+  if (!context || !context->valid)
+    return kEtcPalErrInvalid;
+  return kEtcPalErrNotImpl;
+}
+
 etcpal_error_t etcpal_poll_add_socket(EtcPalPollContext*   context,
                                       etcpal_socket_t      socket,
                                       etcpal_poll_events_t events,
@@ -623,25 +742,32 @@ etcpal_error_t etcpal_poll_add_socket(EtcPalPollContext*   context,
 {
   if (!context || !context->valid || socket == ETCPAL_SOCKET_INVALID || !(events & ETCPAL_POLL_VALID_INPUT_EVENT_MASK))
     return kEtcPalErrInvalid;
+  if (events & ETCPAL_POLL_MODE_MASK)
+    return kEtcPalErrNotImpl;
+
+  if (!etcpal_mutex_lock(&context->lock))
+    return kEtcPalErrSys;
+
+  etcpal_error_t       res = kEtcPalErrOk;
+  EtcPalPollCtxSocket* new_sock = NULL;
+  if (context->num_valid_sockets < ETCPAL_SOCKET_MAX_POLL_SIZE)
+    new_sock = find_hole(context);
 
-  if (context->num_valid_sockets >= ETCPAL_SOCKET_MAX_POLL_SIZE)
+  if (new_sock)
   {
-    return kEtcPalErrNoMem;
+    new_sock->socket = socket;
+    new_sock->events = events;
+    new_sock->user_data = user_data;
+    set_in_fd_sets(context, new_sock);
+    context->num_valid_sockets++;
   }
   else
   {
-    EtcPalPollCtxSocket* new_sock = find_hole(context);
-    if (new_sock)
-    {
-      new_sock->socket = socket;
-      new_sock->events = events;
-      new_sock->user_data = user_data;
-      set_in_fd_sets(context, new_sock);
-      context->num_valid_sockets++;
-      return kEtcPalErrOk;
-    }
-    return kEtcPalErrNoMem;
+    res = kEtcPalErrNoMem;
   }
+
+  etcpal_mutex_unlock(&context->lock);
+  return res;
 }
 
 etcpal_error_t etcpal_poll_modify_socket(EtcPalPollContext*   context,
@@ -652,7 +778,13 @@ etcpal_error_t etcpal_poll_modify_socket(EtcPalPollContext*   context,
   if (!context || !context->valid || socket == ETCPAL_SOCKET_INVALID ||
       !(new_events & ETCPAL_POLL_VALID_INPUT_EVENT_MASK))
     return kEtcPalErrInvalid;
+  if (new_events & ETCPAL_POLL_MODE_MASK)
+    return kEtcPalErrNotImpl;
+
+  if (!etcpal_mutex_lock(&context->lock))
+    return kEtcPalErrSys;
 
+  etcpal_error_t       res = kEtcPalErrOk;
   EtcPalPollCtxSocket* sock_desc = find_socket(context, socket);
   if (sock_desc)
   {
@@ -660,17 +792,19 @@ etcpal_error_t etcpal_poll_modify_socket(EtcPalPollContext*   context,
     sock_desc->events = new_events;
     sock_desc->user_data = new_user_data;
     set_in_fd_sets(context, sock_desc);
-    return kEtcPalErrOk;
   }
   else
   {
-    return kEtcPalErrNotFound;
+    res = kEtcPalErrNotFound;
   }
+
+  etcpal_mutex_unlock(&context->lock);
+  return res;
 }
 
 void etcpal_poll_remove_socket(EtcPalPollContext* context, etcpal_socket_t socket)
 {
-  if (!context || !context->valid || socket == ETCPAL_SOCKET_INVALID)
+  if (!context || !context->valid || socket == ETCPAL_SOCKET_INVALID || !etcpal_mutex_lock(&context->lock))
     return;
 
   EtcPalPollCtxSocket* sock_desc = find_socket(context, socket);
@@ -680,81 +814,107 @@ void etcpal_poll_remove_socket(EtcPalPollContext* context, etcpal_socket_t socke
     sock_desc->socket = ETCPAL_SOCKET_INVALID;
     context->num_valid_sockets--;
   }
+
+  etcpal_mutex_unlock(&context->lock);
 }
 
 etcpal_error_t etcpal_poll_wait(EtcPalPollContext* context, EtcPalPollEvent* event, int timeout_ms)
 {
-  if (!context || !context->valid || !event)
-    return kEtcPalErrInvalid;
+  int res = etcpal_poll_wait_many(context, event, 1, timeout_ms);
+  return (res > 0 ? kEtcPalErrOk : (etcpal_error_t)res);
+}
+
+int etcpal_poll_wait_many(EtcPalPollContext* context, EtcPalPollEvent* events, size_t max_events, int timeout_ms)
+{
+  if (!context || !context->valid || !events || max_events == 0)
+    return (int)kEtcPalErrInvalid;
+
+  EtcPalTimer timer;
+  if (timeout_ms != ETCPAL_WAIT_FOREVER)
+    etcpal_timer_start(&timer, (uint32_t)timeout_ms);
 
-  if (context->readfds.count == 0 && context->writefds.count == 0)
+  // The lock is only held while copying the socket sets and translating the result, never during
+  // select(); changes to the socket set take effect the next time select() is called.
+  while (true)
   {
-    // No valid sockets are currently added to the context.
-    return kEtcPalErrNoSockets;
-  }
+    EtcPalPollFdSet readfds, writefds;
+    ETCPAL_FD_ZERO(&readfds);
+    ETCPAL_FD_ZERO(&writefds);
+    if (etcpal_mutex_lock(&context->lock))
+    {
+      readfds = context->readfds;
+      writefds = context->writefds;
+      etcpal_mutex_unlock(&context->lock);
+    }
 
-  rtcs_fd_set readfds = context->readfds.set;
-  rtcs_fd_set writefds = context->writefds.set;
+    if (readfds.count == 0 && writefds.count == 0)
+    {
+      // No valid sockets are currently added to the context.
+      return (int)kEtcPalErrNoSockets;
+    }
 
-  uint32_t os_timeout;
-  if (timeout_ms == ETCPAL_WAIT_FOREVER)
-    os_timeout = 0;
-  else if (timeout_ms == 0)
-    os_timeout = 0xffffffff;
-  else
-    os_timeout = (uint32_t)timeout_ms;
+    uint32_t os_timeout;
+    if (timeout_ms == ETCPAL_WAIT_FOREVER)
+      os_timeout = 0;
+    else if ((os_timeout = etcpal_timer_remaining(&timer)) == 0)
+      os_timeout = 0xffffffff;
 
-  int32_t nfds =
-      (int32_t)((context->readfds.count > context->writefds.count) ? context->readfds.count : context->writefds.count);
-  int32_t sel_res = select(nfds, context->readfds.count ? &readfds : NULL, context->writefds.count ? &writefds : NULL,
-                           NULL, os_timeout);
+    int32_t nfds = (int32_t)((readfds.count > writefds.count) ? readfds.count : writefds.count);
+    int32_t sel_res =
+        select(nfds, readfds.count ? &readfds.set : NULL, writefds.count ? &writefds.set : NULL, NULL, os_timeout);
 
-  if (sel_res == RTCS_ERROR)
-  {
-    // RTCS handles some socket errors by returning them from select().
-    uint32_t rtcs_err = RTCS_get_errno();
-    if (rtcs_err == RTCSERR_SOCK_ESHUTDOWN)
-      return handle_select_result(context, event, kEtcPalErrConnClosed, &readfds, &writefds);
-    else if (rtcs_err == RTCSERR_SOCK_CLOSED)
-      return handle_select_result(context, event, kEtcPalErrNotFound, &readfds, &writefds);
-    else
-      return err_os_to_etcpal(rtcs_err);
-  }
-  else if (sel_res == 0)
-  {
-    return kEtcPalErrTimedOut;
-  }
-  else
-  {
-    return handle_select_result(context, event, kEtcPalErrOk, &readfds, &writefds);
+    etcpal_error_t socket_error = kEtcPalErrOk;
+    if (sel_res == RTCS_ERROR)
+    {
+      // RTCS handles some socket errors by returning them from select().
+      uint32_t rtcs_err = RTCS_get_errno();
+      if (rtcs_err == RTCSERR_SOCK_ESHUTDOWN)
+        socket_error = kEtcPalErrConnClosed;
+      else if (rtcs_err == RTCSERR_SOCK_CLOSED)
+        socket_error = kEtcPalErrNotFound;
+      else
+        return (int)err_os_to_etcpal(rtcs_err);
+    }
+    else if (sel_res == 0)
+    {
+      return (int)kEtcPalErrTimedOut;
+    }
+
+    int res = (int)kEtcPalErrSys;
+    if (etcpal_mutex_lock(&context->lock))
+    {
+      res = handle_select_result(context, events, max_events, socket_error, &readfds.set, &writefds.set);
+      etcpal_mutex_unlock(&context->lock);
+    }
+
+    // A result of 0 means that every socket with activity was removed during the select().
+    if (res != 0)
+      return res;
   }
 }
 
-etcpal_error_t handle_select_result(EtcPalPollContext* context,
-                                    EtcPalPollEvent*   event,
-                                    etcpal_error_t     socket_error,
-                                    const rtcs_fd_set* readfds,
-                                    const rtcs_fd_set* writefds)
+int handle_select_result(EtcPalPollContext* context,
+                         EtcPalPollEvent*   events,
+                         size_t             max_events,
+                         etcpal_error_t     socket_error,
+                         const rtcs_fd_set* readfds,
+                         const rtcs_fd_set* writefds)
 {
-  // Init the event data.
-  event->socket = ETCPAL_SOCKET_INVALID;
-  event->events = 0;
-  event->err = kEtcPalErrOk;
-
-  // The default return; if we don't find any sockets set that we passed to select(), something has
-  // gone wrong.
-  etcpal_error_t res = kEtcPalErrSys;
+  size_t num_events = 0;
 
-  for (EtcPalPollCtxSocket* sock_desc = context->sockets; sock_desc < context->sockets + ETCPAL_SOCKET_MAX_POLL_SIZE;
-       ++sock_desc)
+  for (EtcPalPollCtxSocket* sock_desc = context->sockets;
+       sock_desc < context->sockets + ETCPAL_SOCKET_MAX_POLL_SIZE && num_events < max_events; ++sock_desc)
   {
     if (sock_desc->socket == ETCPAL_SOCKET_INVALID)
       continue;
 
     if (RTCS_FD_ISSET(sock_desc->socket, readfds) || RTCS_FD_ISSET(sock_desc->socket, writefds))
     {
-      res = kEtcPalErrOk;
+      // Init the event data.
+      EtcPalPollEvent* event = &events[num_events++];
       event->socket = sock_desc->socket;
+      event->events = 0;
+      event->err = kEtcPalErrOk;
       event->user_data = sock_desc->user_data;
 
       /* Check for errors */
@@ -777,13 +937,15 @@ etcpal_error_t handle_select_result(EtcPalPollContext* context,
           event->events |= ETCPAL_POLL_OUT;
       }
       // ETCPAL_POLL_OOB/exceptfds is not handled properly on this OS
-
-      break;  // We handle one event at a time.
     }
   }
-  return res;
+
+  // If none of the sockets that were set are still in the context, they were all removed while the
+  // select() was in progress.
+  return (int)num_events;
 }
 
+
 void init_context_socket_array(EtcPalPollContext* context)
 {
   context->num_valid_sockets = 0;
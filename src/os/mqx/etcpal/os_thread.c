@@ -101,6 +101,14 @@ etcpal_error_t etcpal_thread_terminate(etcpal_thread_t* id)
   return kEtcPalErrOk;
 }
 
+etcpal_error_t etcpal_thread_set_affinity(etcpal_thread_t* id, unsigned int cpu)
+{
+  ETCPAL_UNUSED_ARG(cpu);
+  if (!id)
+    return kEtcPalErrInvalid;
+  return kEtcPalErrNotImpl;
+}
+
 etcpal_thread_os_handle_t etcpal_thread_get_os_handle(etcpal_thread_t* id)
 {
   return (id ? id->tid : ETCPAL_THREAD_OS_HANDLE_INVALID);
@@ -23,16 +23,24 @@
 #include <stdlib.h>
 #include <WinSock2.h>
 #include <WS2tcpip.h>
+#include <mswsock.h>
 #include <Windows.h>
 
 #include "etcpal/common.h"
 #include "etcpal/private/socket.h"
+#include "etcpal/timer.h"
+#include "etcpal/private/socket_stats.h"
 #include "os_error.h"
 
 /*************************** Private constants *******************************/
 
 #define POLL_CONTEXT_ARR_CHUNK_SIZE 10
 
+/* The datagrams sent to a poll context's wake socket. A refresh interrupts a wait in progress so
+ * that it picks up changes to the context's socket set, without being reported to the caller. */
+#define POLL_WAKE_BYTE_USER    0
+#define POLL_WAKE_BYTE_REFRESH 1
+
 /****************************** Private types ********************************/
 
 /* A struct to track sockets being polled by the etcpal_poll() API */
@@ -123,17 +131,37 @@ static const int aiprotmap[ETCPAL_NUM_IPPROTO] =
 
 /* clang-format on */
 
+// WSARecvMsg() is an extension function which must be looked up at runtime.
+static LPFN_WSARECVMSG wsa_recvmsg;
+
 /*********************** Private function prototypes *************************/
 
+// Helpers for etcpal_sendmsg() and etcpal_recvmsg()
+static void wsabufs_etcpal_to_os(const EtcPalMsgHdr* msg, WSABUF* bufs);
+static void load_wsa_recvmsg(void);
+
+// Helpers for the control message API
+static void init_control_wsamsg(const EtcPalMsgHdr* msgh, WSAMSG* wsa_msgh);
+static bool cmsg_os_to_etcpal(WSACMSGHDR* os_cmsg, EtcPalCMsgHdr* cmsg);
+
 static int setsockopt_socket(etcpal_socket_t id, int option_name, const void* option_value, size_t option_len);
 static int setsockopt_ip(etcpal_socket_t id, int option_name, const void* option_value, size_t option_len);
 static int setsockopt_ip6(etcpal_socket_t id, int option_name, const void* option_value, size_t option_len);
 
 // Helper functions for the etcpal_poll API
+static etcpal_error_t create_wake_socket(etcpal_socket_t* wake_sock);
+static etcpal_error_t send_wake_byte(const EtcPalPollContext* context, char wake_byte);
+static bool           drain_wake_socket(etcpal_socket_t wake_sock);
+static void           socket_set_changed(EtcPalPollContext* context);
 static void           set_in_fd_sets(EtcPalPollContext* context, const EtcPalPollSocket* sock);
 static void           clear_in_fd_sets(EtcPalPollContext* context, const EtcPalPollSocket* sock);
-static etcpal_error_t handle_select_result(EtcPalPollContext*     context,
-                                           EtcPalPollEvent*       event,
+static int            wait_select(EtcPalPollContext* context,
+                                  EtcPalPollEvent*   events,
+                                  size_t             max_events,
+                                  int                timeout_ms);
+static int            handle_select_result(EtcPalPollContext*     context,
+                                           EtcPalPollEvent*       events,
+                                           size_t                 max_events,
                                            const EtcPalPollFdSet* readfds,
                                            const EtcPalPollFdSet* writefds,
                                            const EtcPalPollFdSet* exceptfds);
@@ -153,6 +181,7 @@ etcpal_error_t etcpal_socket_init(void)
   {
     return err_winsock_to_etcpal(startup_res);
   }
+  load_wsa_recvmsg();
   return kEtcPalErrOk;
 }
 
@@ -278,7 +307,11 @@ int etcpal_recv(etcpal_socket_t id, void* buffer, size_t length, int flags)
     return kEtcPalErrInvalid;
 
   res = recv(id, buffer, (int)length, impl_flags);
-  return (res >= 0 ? res : (int)err_winsock_to_etcpal(WSAGetLastError()));
+  if (res < 0)
+    res = (int)err_winsock_to_etcpal(WSAGetLastError());
+
+  ETCPAL_SOCKET_STATS_RECV(id, res);
+  return res;
 }
 
 int etcpal_recvfrom(etcpal_socket_t id, void* buffer, size_t length, int flags, EtcPalSockAddr* address)
@@ -292,17 +325,92 @@ int etcpal_recvfrom(etcpal_socket_t id, void* buffer, size_t length, int flags,
     return (int)kEtcPalErrInvalid;
 
   res = recvfrom(id, buffer, (int)length, impl_flags, (struct sockaddr*)&fromaddr, &fromlen);
+  if (res < 0)
+    res = (int)err_winsock_to_etcpal(WSAGetLastError());
 
-  if (res >= 0)
+  ETCPAL_SOCKET_STATS_RECV(id, res);
+  if (res >= 0 && address && fromlen > 0)
   {
-    if (address && fromlen > 0)
+    if (!sockaddr_os_to_etcpal((etcpal_os_sockaddr_t*)&fromaddr, address))
+      return kEtcPalErrSys;
+  }
+  return res;
+}
+
+int etcpal_recvmmsg(etcpal_socket_t id, EtcPalMmsgHdr* msgs, size_t num_msgs, int flags)
+{
+  if (!msgs || num_msgs == 0)
+    return (int)kEtcPalErrInvalid;
+
+  // No native batch receive on this platform; receive a single datagram.
+  int res = etcpal_recvfrom(id, msgs[0].buf, msgs[0].len, flags, msgs[0].addr);
+  if (res < 0)
+    return res;
+
+  msgs[0].msg_len = (size_t)res;
+  return 1;
+}
+
+int etcpal_recvmsg(etcpal_socket_t id, EtcPalMsgHdr* msg, int flags)
+{
+  if (!msg || !msg->iov || msg->iovlen == 0 || msg->iovlen > ETCPAL_MSG_MAX_IOV)
+    return (int)kEtcPalErrInvalid;
+
+  WSABUF bufs[ETCPAL_MSG_MAX_IOV];
+  wsabufs_etcpal_to_os(msg, bufs);
+
+  struct sockaddr_storage fromaddr;
+  INT                     fromlen = sizeof fromaddr;
+  DWORD                   num_bytes = 0;
+  DWORD                   impl_flags = (flags & ETCPAL_MSG_PEEK) ? MSG_PEEK : 0;
+
+  if (msg->control)
+  {
+    // Control data can only be retrieved using the WSARecvMsg() extension function.
+    if (!wsa_recvmsg)
+      return (int)kEtcPalErrNotImpl;
+
+    WSAMSG wsa_msg;
+    init_control_wsamsg(msg, &wsa_msg);
+    wsa_msg.name = (LPSOCKADDR)&fromaddr;
+    wsa_msg.namelen = fromlen;
+    wsa_msg.lpBuffers = bufs;
+    wsa_msg.dwBufferCount = (DWORD)msg->iovlen;
+    wsa_msg.dwFlags = impl_flags;
+
+    if (wsa_recvmsg(id, &wsa_msg, &num_bytes, NULL, NULL) != 0)
     {
-      if (!sockaddr_os_to_etcpal((etcpal_os_sockaddr_t*)&fromaddr, address))
-        return kEtcPalErrSys;
+      int res = (int)err_winsock_to_etcpal(WSAGetLastError());
+      ETCPAL_SOCKET_STATS_RECV(id, res);
+      return res;
     }
-    return res;
+
+    fromlen = wsa_msg.namelen;
+    msg->controllen = (size_t)wsa_msg.Control.len;
+    msg->flags = (wsa_msg.dwFlags & MSG_CTRUNC) ? ETCPAL_MSG_CTRUNC : 0;
   }
-  return (int)err_winsock_to_etcpal(WSAGetLastError());
+  else
+  {
+    if (WSARecvFrom(id, bufs, (DWORD)msg->iovlen, &num_bytes, &impl_flags, (struct sockaddr*)&fromaddr, &fromlen, NULL,
+                    NULL) != 0)
+    {
+      int res = (int)err_winsock_to_etcpal(WSAGetLastError());
+      ETCPAL_SOCKET_STATS_RECV(id, res);
+      return res;
+    }
+
+    // Truncated datagrams are reported as WSAEMSGSIZE above, so there are no flags to report.
+    msg->controllen = 0;
+    msg->flags = 0;
+  }
+  ETCPAL_SOCKET_STATS_RECV(id, (int)num_bytes);
+
+  if (msg->name && fromlen > 0)
+  {
+    if (!sockaddr_os_to_etcpal((etcpal_os_sockaddr_t*)&fromaddr, msg->name))
+      return (int)kEtcPalErrSys;
+  }
+  return (int)num_bytes;
 }
 
 int etcpal_send(etcpal_socket_t id, const void* message, size_t length, int flags)
@@ -313,7 +421,66 @@ int etcpal_send(etcpal_socket_t id, const void* message, size_t length, int flag
     return kEtcPalErrInvalid;
 
   int res = send(id, message, (int)length, 0);
-  return (res >= 0 ? res : (int)err_winsock_to_etcpal(WSAGetLastError()));
+  if (res < 0)
+    res = (int)err_winsock_to_etcpal(WSAGetLastError());
+
+  ETCPAL_SOCKET_STATS_SEND(id, res);
+  return res;
+}
+
+int etcpal_sendmmsg(etcpal_socket_t id, EtcPalMmsgHdr* msgs, size_t num_msgs, int flags)
+{
+  if (!msgs || num_msgs == 0)
+    return (int)kEtcPalErrInvalid;
+
+  // No native batch send on this platform; send the datagrams one at a time.
+  size_t num_sent = 0;
+  for (; num_sent < num_msgs; ++num_sent)
+  {
+    EtcPalMmsgHdr* msg = &msgs[num_sent];
+
+    int res = (msg->addr ? etcpal_sendto(id, msg->buf, msg->len, flags, msg->addr)
+                         : etcpal_send(id, msg->buf, msg->len, flags));
+    if (res < 0)
+      return (num_sent > 0 ? (int)num_sent : res);
+    msg->msg_len = (size_t)res;
+  }
+  return (int)num_sent;
+}
+
+int etcpal_sendmsg(etcpal_socket_t id, const EtcPalMsgHdr* msg, int flags)
+{
+  ETCPAL_UNUSED_ARG(flags);
+
+  if (!msg || !msg->iov || msg->iovlen == 0 || msg->iovlen > ETCPAL_MSG_MAX_IOV)
+    return (int)kEtcPalErrInvalid;
+
+  WSABUF bufs[ETCPAL_MSG_MAX_IOV];
+  wsabufs_etcpal_to_os(msg, bufs);
+
+  struct sockaddr_storage destaddr;
+  int                     destaddr_size = 0;
+  if (msg->name)
+  {
+    destaddr_size = (int)sockaddr_etcpal_to_os(msg->name, (etcpal_os_sockaddr_t*)&destaddr);
+    if (destaddr_size == 0)
+      return (int)kEtcPalErrSys;
+  }
+
+  DWORD num_bytes = 0;
+  int   res = 0;
+  if (WSASendTo(id, bufs, (DWORD)msg->iovlen, &num_bytes, 0, msg->name ? (struct sockaddr*)&destaddr : NULL,
+                destaddr_size, NULL, NULL) != 0)
+  {
+    res = (int)err_winsock_to_etcpal(WSAGetLastError());
+  }
+  else
+  {
+    res = (int)num_bytes;
+  }
+
+  ETCPAL_SOCKET_STATS_SEND(id, res);
+  return res;
 }
 
 int etcpal_sendto(etcpal_socket_t id, const void* message, size_t length, int flags, const EtcPalSockAddr* dest_addr)
@@ -328,8 +495,25 @@ int etcpal_sendto(etcpal_socket_t id, const void* message, size_t length, int fl
   size_t                  ss_size = sockaddr_etcpal_to_os(dest_addr, (etcpal_os_sockaddr_t*)&ss);
   if (ss_size > 0)
     res = sendto(id, message, (int)length, 0, (struct sockaddr*)&ss, (int)ss_size);
+  if (res < 0)
+    res = (int)err_winsock_to_etcpal(WSAGetLastError());
 
-  return (res >= 0 ? res : (int)err_winsock_to_etcpal(WSAGetLastError()));
+  ETCPAL_SOCKET_STATS_SEND(id, res);
+  return res;
+}
+
+int etcpal_sendto_segmented(etcpal_socket_t       id,
+                            const void*           message,
+                            size_t                length,
+                            size_t                segment_size,
+                            int                   flags,
+                            const EtcPalSockAddr* dest_addr)
+{
+  if (!message || length == 0 || segment_size == 0)
+    return (int)kEtcPalErrInvalid;
+
+  // No segmentation offload on this platform; send the datagrams individually.
+  return etcpal_sendto_segments_fallback(id, (const uint8_t*)message, length, segment_size, flags, dest_addr, 0);
 }
 
 etcpal_error_t etcpal_setsockopt(etcpal_socket_t id,
@@ -361,6 +545,64 @@ etcpal_error_t etcpal_setsockopt(etcpal_socket_t id,
   return (res == 0 ? kEtcPalErrOk : err_winsock_to_etcpal(WSAGetLastError()));
 }
 
+void wsabufs_etcpal_to_os(const EtcPalMsgHdr* msg, WSABUF* bufs)
+{
+  for (size_t i = 0; i < msg->iovlen; ++i)
+  {
+    bufs[i].buf = (CHAR*)msg->iov[i].base;
+    bufs[i].len = (ULONG)msg->iov[i].len;
+  }
+}
+
+void load_wsa_recvmsg(void)
+{
+  wsa_recvmsg = NULL;
+
+  // The function pointer must be retrieved using a socket, but it is not specific to that socket.
+  SOCKET sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (sock == INVALID_SOCKET)
+    return;
+
+  GUID  guid = WSAID_WSARECVMSG;
+  DWORD num_bytes = 0;
+  if (WSAIoctl(sock, SIO_GET_EXTENSION_FUNCTION_POINTER, &guid, sizeof guid, &wsa_recvmsg, sizeof wsa_recvmsg,
+               &num_bytes, NULL, NULL) != 0)
+  {
+    wsa_recvmsg = NULL;
+  }
+  closesocket(sock);
+}
+
+void init_control_wsamsg(const EtcPalMsgHdr* msgh, WSAMSG* wsa_msgh)
+{
+  memset(wsa_msgh, 0, sizeof(WSAMSG));
+  wsa_msgh->Control.buf = (CHAR*)msgh->control;
+  wsa_msgh->Control.len = (msgh->control ? (ULONG)msgh->controllen : 0);
+}
+
+bool cmsg_os_to_etcpal(WSACMSGHDR* os_cmsg, EtcPalCMsgHdr* cmsg)
+{
+  if (!os_cmsg || os_cmsg->cmsg_len < WSA_CMSG_LEN(0))
+    return false;
+
+  cmsg->len = (size_t)(os_cmsg->cmsg_len - WSA_CMSG_LEN(0));
+  cmsg->level = -1;
+  cmsg->type = -1;
+  if (os_cmsg->cmsg_level == IPPROTO_IP && os_cmsg->cmsg_type == IP_PKTINFO)
+  {
+    cmsg->level = ETCPAL_IPPROTO_IP;
+    cmsg->type = ETCPAL_IP_PKTINFO;
+  }
+  else if (os_cmsg->cmsg_level == IPPROTO_IPV6 && os_cmsg->cmsg_type == IPV6_PKTINFO)
+  {
+    cmsg->level = ETCPAL_IPPROTO_IPV6;
+    cmsg->type = ETCPAL_IP_PKTINFO;
+  }
+  cmsg->pd = os_cmsg;
+  return true;
+}
+
+
 int setsockopt_socket(etcpal_socket_t id, int option_name, const void* option_value, size_t option_len)
 {
   switch (option_name)
@@ -520,6 +762,13 @@ int setsockopt_ip(etcpal_socket_t id, int option_name, const void* option_value,
         return setsockopt(id, IPPROTO_IP, IP_MULTICAST_LOOP, (char*)&val, sizeof val);
       }
       break;
+    case ETCPAL_IP_PKTINFO:
+      if (option_len == sizeof(int))
+      {
+        DWORD val = (DWORD) * (int*)option_value;
+        return setsockopt(id, IPPROTO_IP, IP_PKTINFO, (char*)&val, sizeof val);
+      }
+      break;
     default:
       break;
   }
@@ -594,6 +843,13 @@ int setsockopt_ip6(etcpal_socket_t id, int option_name, const void* option_value
         return setsockopt(id, IPPROTO_IPV6, IPV6_V6ONLY, (char*)&val, sizeof val);
       }
       break;
+    case ETCPAL_IP_PKTINFO:
+      if (option_len == sizeof(int))
+      {
+        DWORD val = (DWORD) * (int*)option_value;
+        return setsockopt(id, IPPROTO_IPV6, IPV6_PKTINFO, (char*)&val, sizeof val);
+      }
+      break;
     default: /* Other IPv6 options TODO on windows. */
       break;
   }
@@ -638,6 +894,78 @@ etcpal_error_t etcpal_socket(unsigned int family, unsigned int type, etcpal_sock
   return kEtcPalErrInvalid;
 }
 
+bool etcpal_cmsg_firsthdr(EtcPalMsgHdr* msgh, EtcPalCMsgHdr* firsthdr)
+{
+  if (!msgh || !firsthdr)
+    return false;
+
+  WSAMSG wsa_msgh;
+  init_control_wsamsg(msgh, &wsa_msgh);
+  return cmsg_os_to_etcpal(WSA_CMSG_FIRSTHDR(&wsa_msgh), firsthdr);
+}
+
+bool etcpal_cmsg_nxthdr(EtcPalMsgHdr* msgh, const EtcPalCMsgHdr* cmsg, EtcPalCMsgHdr* nxthdr)
+{
+  if (!msgh || !cmsg || !cmsg->pd || !nxthdr)
+    return false;
+
+  WSAMSG wsa_msgh;
+  init_control_wsamsg(msgh, &wsa_msgh);
+  return cmsg_os_to_etcpal(WSA_CMSG_NXTHDR(&wsa_msgh, (WSACMSGHDR*)cmsg->pd), nxthdr);
+}
+
+bool etcpal_cmsg_to_pktinfo(const EtcPalCMsgHdr* cmsg, EtcPalPktInfo* pktinfo)
+{
+  if (!cmsg || !cmsg->pd || !pktinfo)
+    return false;
+
+  WSACMSGHDR* os_cmsg = (WSACMSGHDR*)cmsg->pd;
+  if (os_cmsg->cmsg_level == IPPROTO_IP && os_cmsg->cmsg_type == IP_PKTINFO &&
+      os_cmsg->cmsg_len >= WSA_CMSG_LEN(sizeof(IN_PKTINFO)))
+  {
+    IN_PKTINFO info;
+    memcpy(&info, WSA_CMSG_DATA(os_cmsg), sizeof info);
+    ETCPAL_IP_SET_V4_ADDRESS(&pktinfo->addr, ntohl(info.ipi_addr.s_addr));
+    pktinfo->ifindex = (unsigned int)info.ipi_ifindex;
+    return true;
+  }
+  if (os_cmsg->cmsg_level == IPPROTO_IPV6 && os_cmsg->cmsg_type == IPV6_PKTINFO &&
+      os_cmsg->cmsg_len >= WSA_CMSG_LEN(sizeof(IN6_PKTINFO)))
+  {
+    IN6_PKTINFO info;
+    memcpy(&info, WSA_CMSG_DATA(os_cmsg), sizeof info);
+    ETCPAL_IP_SET_V6_ADDRESS(&pktinfo->addr, info.ipi6_addr.s6_addr);
+    pktinfo->ifindex = (unsigned int)info.ipi6_ifindex;
+    return true;
+  }
+  return false;
+}
+
+bool etcpal_cmsg_to_timestamp(const EtcPalCMsgHdr* cmsg, EtcPalRecvTimestamp* timestamp)
+{
+  // Receive timestamps are not currently supported on this platform.
+  ETCPAL_UNUSED_ARG(cmsg);
+  ETCPAL_UNUSED_ARG(timestamp);
+  return false;
+}
+
+bool etcpal_cmsg_to_udp_gro(const EtcPalCMsgHdr* cmsg, size_t* segment_size)
+{
+  ETCPAL_UNUSED_ARG(cmsg);
+  ETCPAL_UNUSED_ARG(segment_size);
+  return false;
+}
+
+int etcpal_read_zerocopy_completions(etcpal_socket_t           id,
+                                     EtcPalZerocopyCompletion* completions,
+                                     size_t                    max_completions)
+{
+  ETCPAL_UNUSED_ARG(id);
+  ETCPAL_UNUSED_ARG(completions);
+  ETCPAL_UNUSED_ARG(max_completions);
+  return (int)kEtcPalErrNotImpl;
+}
+
 etcpal_error_t etcpal_setblocking(etcpal_socket_t id, bool blocking)
 {
   unsigned long val = (blocking ? 0 : 1);
@@ -660,10 +988,19 @@ etcpal_error_t etcpal_poll_context_init(EtcPalPollContext* context)
   if (!etcpal_mutex_create(&context->lock))
     return kEtcPalErrSys;
 
+  etcpal_error_t res = create_wake_socket(&context->wake_sock);
+  if (res != kEtcPalErrOk)
+  {
+    etcpal_mutex_destroy(&context->lock);
+    return res;
+  }
+
   etcpal_rbtree_init(&context->sockets, poll_socket_compare, poll_socket_alloc, poll_socket_free);
   ETCPAL_FD_ZERO(&context->readfds);
   ETCPAL_FD_ZERO(&context->writefds);
   ETCPAL_FD_ZERO(&context->exceptfds);
+  context->generation = 0;
+  context->wake_deferred = false;
   context->valid = true;
   return kEtcPalErrOk;
 }
@@ -674,10 +1011,87 @@ void etcpal_poll_context_deinit(EtcPalPollContext* context)
     return;
 
   etcpal_rbtree_clear(&context->sockets);
+  closesocket(context->wake_sock);
   etcpal_mutex_destroy(&context->lock);
   context->valid = false;
 }
 
+etcpal_error_t etcpal_poll_context_wake(EtcPalPollContext* context)
+{
+  if (!context || !context->valid)
+    return kEtcPalErrInvalid;
+
+  return send_wake_byte(context, POLL_WAKE_BYTE_USER);
+}
+
+etcpal_error_t etcpal_poll_context_set_spin_time(EtcPalPollContext* context, unsigned int spin_us)
+{
+  ETCPAL_UNUSED_ARG(spin_us);
+  if (!context || !context->valid)
+    return kEtcPalErrInvalid;
+  return kEtcPalErrNotImpl;
+}
+
+// Create a nonblocking UDP socket which is bound and connected to itself on the loopback interface,
+// so that sending to it makes it readable.
+etcpal_error_t create_wake_socket(etcpal_socket_t* wake_sock)
+{
+  SOCKET sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (sock == INVALID_SOCKET)
+    return err_winsock_to_etcpal(WSAGetLastError());
+
+  struct sockaddr_in addr;
+  int                addr_len = sizeof addr;
+  memset(&addr, 0, sizeof addr);
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  unsigned long nonblocking = 1;
+  if (bind(sock, (struct sockaddr*)&addr, sizeof addr) == 0 &&
+      getsockname(sock, (struct sockaddr*)&addr, &addr_len) == 0 &&
+      connect(sock, (struct sockaddr*)&addr, sizeof addr) == 0 && ioctlsocket(sock, FIONBIO, &nonblocking) == 0)
+  {
+    *wake_sock = sock;
+    return kEtcPalErrOk;
+  }
+
+  etcpal_error_t res = err_winsock_to_etcpal(WSAGetLastError());
+  closesocket(sock);
+  return res;
+}
+
+etcpal_error_t send_wake_byte(const EtcPalPollContext* context, char wake_byte)
+{
+  if (send(context->wake_sock, &wake_byte, 1, 0) == 1)
+    return kEtcPalErrOk;
+
+  // If the socket's buffer is full, a wakeup is already pending.
+  int err = WSAGetLastError();
+  return (err == WSAEWOULDBLOCK ? kEtcPalErrOk : err_winsock_to_etcpal(err));
+}
+
+// Consume all pending wakeups, so that multiple calls to etcpal_poll_context_wake() are reported
+// as one. Returns whether any of them were from etcpal_poll_context_wake(), as opposed to refreshes.
+bool drain_wake_socket(etcpal_socket_t wake_sock)
+{
+  bool user_wake = false;
+  char wake_byte;
+  while (recv(wake_sock, &wake_byte, 1, 0) > 0)
+  {
+    if (wake_byte == POLL_WAKE_BYTE_USER)
+      user_wake = true;
+  }
+  return user_wake;
+}
+
+// Record a change to the context's socket set and interrupt any wait in progress, so that it
+// selects on the new set. Must be called with the context lock held.
+void socket_set_changed(EtcPalPollContext* context)
+{
+  ++context->generation;
+  send_wake_byte(context, POLL_WAKE_BYTE_REFRESH);
+}
+
 void set_in_fd_sets(EtcPalPollContext* context, const EtcPalPollSocket* sock_desc)
 {
   if (sock_desc->events & ETCPAL_POLL_IN)
@@ -717,11 +1131,14 @@ etcpal_error_t etcpal_poll_add_socket(EtcPalPollContext*   context,
 {
   if (!context || !context->valid || socket == ETCPAL_SOCKET_INVALID || !(events & ETCPAL_POLL_VALID_INPUT_EVENT_MASK))
     return kEtcPalErrInvalid;
+  if (events & ETCPAL_POLL_MODE_MASK)
+    return kEtcPalErrNotImpl;
 
   etcpal_error_t res = kEtcPalErrSys;
   if (etcpal_mutex_lock(&context->lock))
   {
-    if (etcpal_rbtree_size(&context->sockets) >= ETCPAL_SOCKET_MAX_POLL_SIZE)
+    // One slot in the fd_sets is reserved for the wake socket.
+    if (etcpal_rbtree_size(&context->sockets) >= ETCPAL_SOCKET_MAX_POLL_SIZE - 1)
     {
       res = kEtcPalErrNoMem;
     }
@@ -737,6 +1154,7 @@ etcpal_error_t etcpal_poll_add_socket(EtcPalPollContext*   context,
         if (res == kEtcPalErrOk)
         {
           set_in_fd_sets(context, new_sock);
+          socket_set_changed(context);
         }
         else
         {
@@ -761,6 +1179,8 @@ etcpal_error_t etcpal_poll_modify_socket(EtcPalPollContext*   context,
   if (!context || !context->valid || socket == ETCPAL_SOCKET_INVALID ||
       !(new_events & ETCPAL_POLL_VALID_INPUT_EVENT_MASK))
     return kEtcPalErrInvalid;
+  if (new_events & ETCPAL_POLL_MODE_MASK)
+    return kEtcPalErrNotImpl;
 
   etcpal_error_t res = kEtcPalErrSys;
   if (etcpal_mutex_lock(&context->lock))
@@ -772,6 +1192,7 @@ etcpal_error_t etcpal_poll_modify_socket(EtcPalPollContext*   context,
       sock_desc->events = new_events;
       sock_desc->user_data = new_user_data;
       set_in_fd_sets(context, sock_desc);
+      socket_set_changed(context);
       res = kEtcPalErrOk;
     }
     else
@@ -795,6 +1216,7 @@ void etcpal_poll_remove_socket(EtcPalPollContext* context, etcpal_socket_t socke
     {
       clear_in_fd_sets(context, sock_desc);
       etcpal_rbtree_remove(&context->sockets, sock_desc);
+      socket_set_changed(context);
     }
     etcpal_mutex_unlock(&context->lock);
   }
@@ -802,83 +1224,130 @@ void etcpal_poll_remove_socket(EtcPalPollContext* context, etcpal_socket_t socke
 
 etcpal_error_t etcpal_poll_wait(EtcPalPollContext* context, EtcPalPollEvent* event, int timeout_ms)
 {
-  if (!context || !context->valid || !event)
-    return kEtcPalErrInvalid;
+  int res = etcpal_poll_wait_many(context, event, 1, timeout_ms);
+  return (res > 0 ? kEtcPalErrOk : (etcpal_error_t)res);
+}
 
-  // Get the sets of sockets that we will select on.
-  EtcPalPollFdSet readfds, writefds, exceptfds;
-  ETCPAL_FD_ZERO(&readfds);
-  ETCPAL_FD_ZERO(&writefds);
-  ETCPAL_FD_ZERO(&exceptfds);
-  if (etcpal_mutex_lock(&context->lock))
+int etcpal_poll_wait_many(EtcPalPollContext* context, EtcPalPollEvent* events, size_t max_events, int timeout_ms)
+{
+  if (!context || !context->valid || !events || max_events == 0)
+    return (int)kEtcPalErrInvalid;
+
+  ETCPAL_SOCKET_STATS_POLL_START(stats_start_us);
+  int res = wait_select(context, events, max_events, timeout_ms);
+  ETCPAL_SOCKET_STATS_POLL_DONE(stats_start_us, res);
+  return res;
+}
+
+// Wait for events on a validated poll context. Returns the number of events or an error code.
+int wait_select(EtcPalPollContext* context, EtcPalPollEvent* events, size_t max_events, int timeout_ms)
+{
+  EtcPalTimer timer;
+  if (timeout_ms != ETCPAL_WAIT_FOREVER)
+    etcpal_timer_start(&timer, (uint32_t)timeout_ms);
+
+  // The lock is only held while copying the socket sets and translating the result, never during
+  // select(); changes to the socket set wake the select() so that the new set takes effect.
+  while (true)
   {
-    if (etcpal_rbtree_size(&context->sockets) > 0)
+    // Get the sets of sockets that we will select on.
+    EtcPalPollFdSet readfds, writefds, exceptfds;
+    unsigned int    generation = 0;
+    ETCPAL_FD_ZERO(&readfds);
+    ETCPAL_FD_ZERO(&writefds);
+    ETCPAL_FD_ZERO(&exceptfds);
+    if (etcpal_mutex_lock(&context->lock))
     {
-      readfds = context->readfds;
-      writefds = context->writefds;
-      exceptfds = context->exceptfds;
+      if (etcpal_rbtree_size(&context->sockets) > 0)
+      {
+        readfds = context->readfds;
+        writefds = context->writefds;
+        exceptfds = context->exceptfds;
+      }
+      generation = context->generation;
+      etcpal_mutex_unlock(&context->lock);
     }
-    etcpal_mutex_unlock(&context->lock);
-  }
 
-  // No valid sockets are currently added to the context.
-  if (!readfds.count && !writefds.count && !exceptfds.count)
-    return kEtcPalErrNoSockets;
+    // No valid sockets are currently added to the context.
+    if (!readfds.count && !writefds.count && !exceptfds.count)
+      return (int)kEtcPalErrNoSockets;
 
-  struct timeval os_timeout;
-  if (timeout_ms == 0)
-  {
-    os_timeout.tv_sec = 0;
-    os_timeout.tv_usec = 0;
-  }
-  else if (timeout_ms != ETCPAL_WAIT_FOREVER)
-  {
-    os_timeout.tv_sec = timeout_ms / 1000;
-    os_timeout.tv_usec = (timeout_ms % 1000) * 1000;
-  }
+    if (context->wake_deferred)
+    {
+      context->wake_deferred = false;
+      return (int)kEtcPalErrWoken;
+    }
 
-  int sel_res = select(0, readfds.count ? &readfds.set : NULL, writefds.count ? &writefds.set : NULL,
-                       exceptfds.count ? &exceptfds.set : NULL, timeout_ms == ETCPAL_WAIT_FOREVER ? NULL : &os_timeout);
+    ETCPAL_FD_SET(context->wake_sock, &readfds);
 
-  if (sel_res < 0)
-  {
-    return err_winsock_to_etcpal(WSAGetLastError());
-  }
-  else if (sel_res == 0)
-  {
-    return kEtcPalErrTimedOut;
-  }
-  else
-  {
-    etcpal_error_t res = kEtcPalErrSys;
+    struct timeval os_timeout;
+    if (timeout_ms != ETCPAL_WAIT_FOREVER)
+    {
+      uint32_t remaining = etcpal_timer_remaining(&timer);
+      os_timeout.tv_sec = (long)(remaining / 1000);
+      os_timeout.tv_usec = (long)((remaining % 1000) * 1000);
+    }
+
+    int sel_res = select(0, readfds.count ? &readfds.set : NULL, writefds.count ? &writefds.set : NULL,
+                         exceptfds.count ? &exceptfds.set : NULL,
+                         timeout_ms == ETCPAL_WAIT_FOREVER ? NULL : &os_timeout);
+
+    if (sel_res < 0)
+    {
+      // A socket which was removed from the context during the select() may have been closed.
+      int err = WSAGetLastError();
+      if (err == WSAENOTSOCK && generation != context->generation)
+        continue;
+      return (int)err_winsock_to_etcpal(err);
+    }
+    if (sel_res == 0)
+      return (int)kEtcPalErrTimedOut;
+
+    bool woken = false;
+    if (ETCPAL_FD_ISSET(context->wake_sock, &readfds))
+    {
+      woken = drain_wake_socket(context->wake_sock);
+      if (sel_res == 1)
+      {
+        if (woken)
+          return (int)kEtcPalErrWoken;
+        continue;
+      }
+    }
+
+    int res = (int)kEtcPalErrSys;
     if (context->valid && etcpal_mutex_lock(&context->lock))
     {
-      res = handle_select_result(context, event, &readfds, &writefds, &exceptfds);
+      res = handle_select_result(context, events, max_events, &readfds, &writefds, &exceptfds);
       etcpal_mutex_unlock(&context->lock);
     }
-    return res;
+
+    // Socket events take priority over a wakeup, which is then reported by the next wait. It has
+    // been drained from the wake socket, since the sockets may stay ready and keep coming back with it.
+    if (woken && res > 0)
+      context->wake_deferred = true;
+    else if (woken)
+      return (int)kEtcPalErrWoken;
+
+    // If all of the sockets which were set have since been removed, keep waiting.
+    if (res != 0)
+      return res;
   }
 }
 
-etcpal_error_t handle_select_result(EtcPalPollContext*     context,
-                                    EtcPalPollEvent*       event,
-                                    const EtcPalPollFdSet* readfds,
-                                    const EtcPalPollFdSet* writefds,
-                                    const EtcPalPollFdSet* exceptfds)
+int handle_select_result(EtcPalPollContext*     context,
+                         EtcPalPollEvent*       events,
+                         size_t                 max_events,
+                         const EtcPalPollFdSet* readfds,
+                         const EtcPalPollFdSet* writefds,
+                         const EtcPalPollFdSet* exceptfds)
 {
-  // Init the event data.
-  event->socket = ETCPAL_SOCKET_INVALID;
-  event->events = 0;
-  event->err = kEtcPalErrOk;
-
-  // The default return; if we don't find any sockets set that we passed to select(), something has
-  // gone wrong.
-  etcpal_error_t res = kEtcPalErrSys;
+  size_t num_events = 0;
 
   EtcPalRbIter iter;
   etcpal_rbiter_init(&iter);
-  for (EtcPalPollSocket* sock_desc = (EtcPalPollSocket*)etcpal_rbiter_first(&iter, &context->sockets); sock_desc;
-       sock_desc = (EtcPalPollSocket*)etcpal_rbiter_next(&iter))
+  for (EtcPalPollSocket* sock_desc = (EtcPalPollSocket*)etcpal_rbiter_first(&iter, &context->sockets);
+       sock_desc && num_events < max_events; sock_desc = (EtcPalPollSocket*)etcpal_rbiter_next(&iter))
   {
     if (sock_desc->sock == ETCPAL_SOCKET_INVALID)
       continue;
@@ -886,8 +1355,11 @@ etcpal_error_t handle_select_result(EtcPalPollContext*     context,
     if (ETCPAL_FD_ISSET(sock_desc->sock, readfds) || ETCPAL_FD_ISSET(sock_desc->sock, writefds) ||
         ETCPAL_FD_ISSET(sock_desc->sock, exceptfds))
     {
-      res = kEtcPalErrOk;
+      // Init the event data.
+      EtcPalPollEvent* event = &events[num_events];
       event->socket = sock_desc->sock;
+      event->events = 0;
+      event->err = kEtcPalErrOk;
       event->user_data = sock_desc->user_data;
 
       /* Check for errors */
@@ -903,7 +1375,9 @@ etcpal_error_t handle_select_result(EtcPalPollContext*     context,
       }
       else
       {
-        res = err_winsock_to_etcpal(WSAGetLastError());
+        // Report the events gathered so far, if any; otherwise report the error.
+        if (num_events == 0)
+          return (int)err_winsock_to_etcpal(WSAGetLastError());
         break;
       }
       if (ETCPAL_FD_ISSET(sock_desc->sock, readfds))
@@ -925,10 +1399,12 @@ etcpal_error_t handle_select_result(EtcPalPollContext*     context,
         else if (sock_desc->events & ETCPAL_POLL_OOB)
           event->events |= ETCPAL_POLL_OOB;
       }
-      break;  // We handle one event at a time.
+      ++num_events;
     }
   }
-  return res;
+
+  // No sockets are reported if all of the sockets that were set were removed during the select().
+  return (int)num_events;
 }
 
 int poll_socket_compare(const EtcPalRbTree* tree, const void* value_a, const void* value_b)
@@ -160,6 +160,17 @@ etcpal_error_t etcpal_thread_terminate(etcpal_thread_t* id)
   return kEtcPalErrOk;
 }
 
+etcpal_error_t etcpal_thread_set_affinity(etcpal_thread_t* id, unsigned int cpu)
+{
+  if (!id || cpu >= sizeof(DWORD_PTR) * 8)
+    return kEtcPalErrInvalid;
+
+  if (SetThreadAffinityMask(id->tid, (DWORD_PTR)1 << cpu) == 0)
+    return err_os_to_etcpal(GetLastError());
+
+  return kEtcPalErrOk;
+}
+
 etcpal_thread_os_handle_t etcpal_thread_get_os_handle(etcpal_thread_t* id)
 {
   return (id ? GetThreadId(id->tid) : ETCPAL_THREAD_OS_HANDLE_INVALID);
@@ -0,0 +1,281 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+/*
+ * A latency benchmark for UDP over loopback. A datagram is bounced between the main thread and an
+ * echo thread, each of which waits for it with etcpal_poll_wait(), and the round-trip time of each
+ * exchange is recorded. The 50th and 99th percentile round-trip times are reported for three
+ * configurations:
+ *
+ * - "default": blocking poll waits.
+ * - "spin": poll waits which spin before blocking (etcpal_poll_context_set_spin_time()).
+ * - "busy-poll": spinning poll waits on sockets with ETCPAL_SO_BUSY_POLL and
+ *   ETCPAL_SO_PREFER_BUSY_POLL set. Setting ETCPAL_SO_BUSY_POLL above the system default usually
+ *   requires elevated privileges; without them the option is left at the default.
+ *
+ * Configurations that are not supported on the current platform are skipped. Spinning keeps a CPU
+ * busy in each thread, so results are most meaningful on an otherwise idle machine with at least
+ * two CPUs.
+ *
+ * Usage: etcpal_latency_benchmark [num_round_trips] [spin_us]
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "etcpal/common.h"
+#include "etcpal/socket.h"
+#include "etcpal/thread.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#define DEFAULT_NUM_ROUND_TRIPS 20000
+#define DEFAULT_SPIN_US         200
+#define BUSY_POLL_US            50
+#define WAIT_TIMEOUT_MS         1000
+
+typedef enum
+{
+  kModeDefault,
+  kModeSpin,
+  kModeBusyPoll
+} LatencyMode;
+
+typedef struct EchoThreadArgs
+{
+  etcpal_socket_t   sock;
+  EtcPalPollContext context;
+  volatile bool     stop;
+} EchoThreadArgs;
+
+static const char kBenchmarkMessage[] = "benchmark";
+
+static uint64_t get_time_ns(void)
+{
+#ifdef _WIN32
+  LARGE_INTEGER freq;
+  LARGE_INTEGER count;
+  QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&count);
+  return (uint64_t)((double)count.QuadPart * 1000000000.0 / (double)freq.QuadPart);
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+#endif
+}
+
+static int compare_samples(const void* a, const void* b)
+{
+  uint64_t sample_a = *(const uint64_t*)a;
+  uint64_t sample_b = *(const uint64_t*)b;
+  return (sample_a > sample_b) - (sample_a < sample_b);
+}
+
+static void print_result(const char* name, uint64_t* samples, unsigned long num_samples)
+{
+  qsort(samples, num_samples, sizeof(uint64_t), compare_samples);
+  double p50_us = (double)samples[num_samples / 2] / 1000.0;
+  double p99_us = (double)samples[(num_samples * 99) / 100] / 1000.0;
+  printf("%-10s %10lu round trips: p50 %8.1f us, p99 %8.1f us\n", name, num_samples, p50_us, p99_us);
+}
+
+// Create a UDP socket bound to an ephemeral loopback port, configured for the given mode, and add
+// it to a poll context.
+static etcpal_error_t open_socket(LatencyMode         mode,
+                                  unsigned int        spin_us,
+                                  etcpal_socket_t*    sock,
+                                  EtcPalSockAddr*     addr,
+                                  EtcPalPollContext*  context)
+{
+  etcpal_error_t res = etcpal_poll_context_init(context);
+  if (res != kEtcPalErrOk)
+    return res;
+
+  res = etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, sock);
+  if (res != kEtcPalErrOk)
+  {
+    etcpal_poll_context_deinit(context);
+    return res;
+  }
+
+  if (mode == kModeBusyPoll)
+  {
+    // Failures are tolerated; busy polling then stays at the system default.
+    int busy_poll_us = BUSY_POLL_US;
+    int prefer_busy_poll = 1;
+    etcpal_setsockopt(*sock, ETCPAL_SOL_SOCKET, ETCPAL_SO_BUSY_POLL, &busy_poll_us, sizeof busy_poll_us);
+    etcpal_setsockopt(*sock, ETCPAL_SOL_SOCKET, ETCPAL_SO_PREFER_BUSY_POLL, &prefer_busy_poll,
+                      sizeof prefer_busy_poll);
+  }
+  if (mode != kModeDefault)
+    res = etcpal_poll_context_set_spin_time(context, spin_us);
+
+  ETCPAL_IP_SET_V4_ADDRESS(&addr->ip, 0x7f000001);
+  addr->port = 0;
+  if (res == kEtcPalErrOk)
+    res = etcpal_bind(*sock, addr);
+  if (res == kEtcPalErrOk)
+    res = etcpal_getsockname(*sock, addr);
+  if (res == kEtcPalErrOk)
+    res = etcpal_poll_add_socket(context, *sock, ETCPAL_POLL_IN, NULL);
+
+  if (res != kEtcPalErrOk)
+  {
+    etcpal_close(*sock);
+    etcpal_poll_context_deinit(context);
+  }
+  return res;
+}
+
+static void close_socket(etcpal_socket_t sock, EtcPalPollContext* context)
+{
+  etcpal_poll_remove_socket(context, sock);
+  etcpal_close(sock);
+  etcpal_poll_context_deinit(context);
+}
+
+static void echo_thread(void* arg)
+{
+  EchoThreadArgs* args = (EchoThreadArgs*)arg;
+  while (!args->stop)
+  {
+    EtcPalPollEvent event;
+    if (etcpal_poll_wait(&args->context, &event, 100) != kEtcPalErrOk)
+      continue;
+
+    uint8_t        buf[sizeof kBenchmarkMessage];
+    EtcPalSockAddr from;
+    int            recv_res = etcpal_recvfrom(args->sock, buf, sizeof buf, 0, &from);
+    if (recv_res > 0)
+      etcpal_sendto(args->sock, buf, (size_t)recv_res, 0, &from);
+  }
+}
+
+static etcpal_error_t run_latency_benchmark(const char*   name,
+                                            LatencyMode   mode,
+                                            unsigned int  spin_us,
+                                            unsigned long num_round_trips,
+                                            uint64_t*     samples)
+{
+  EchoThreadArgs echo_args;
+  EtcPalSockAddr echo_addr;
+  echo_args.stop = false;
+  etcpal_error_t res = open_socket(mode, spin_us, &echo_args.sock, &echo_addr, &echo_args.context);
+  if (res == kEtcPalErrNotImpl)
+  {
+    printf("%-10s not supported on this platform\n", name);
+    return kEtcPalErrOk;
+  }
+  if (res != kEtcPalErrOk)
+    return res;
+
+  etcpal_socket_t   sock;
+  EtcPalSockAddr    addr;
+  EtcPalPollContext context;
+  res = open_socket(mode, spin_us, &sock, &addr, &context);
+  if (res != kEtcPalErrOk)
+  {
+    close_socket(echo_args.sock, &echo_args.context);
+    return res;
+  }
+
+  EtcPalThreadParams params = ETCPAL_THREAD_PARAMS_INIT;
+  etcpal_thread_t    thread;
+  res = etcpal_thread_create(&thread, &params, echo_thread, &echo_args);
+  if (res == kEtcPalErrOk)
+  {
+    for (unsigned long i = 0; i < num_round_trips; ++i)
+    {
+      uint64_t start = get_time_ns();
+      int      send_res = etcpal_sendto(sock, kBenchmarkMessage, sizeof kBenchmarkMessage, 0, &echo_addr);
+      if (send_res < 0)
+      {
+        res = (etcpal_error_t)send_res;
+        break;
+      }
+
+      EtcPalPollEvent event;
+      res = etcpal_poll_wait(&context, &event, WAIT_TIMEOUT_MS);
+      if (res != kEtcPalErrOk)
+        break;
+
+      uint8_t recv_buf[sizeof kBenchmarkMessage];
+      int     recv_res = etcpal_recvfrom(sock, recv_buf, sizeof recv_buf, 0, NULL);
+      if (recv_res < 0)
+      {
+        res = (etcpal_error_t)recv_res;
+        break;
+      }
+      samples[i] = get_time_ns() - start;
+    }
+
+    echo_args.stop = true;
+    etcpal_thread_join(&thread);
+    if (res == kEtcPalErrOk)
+      print_result(name, samples, num_round_trips);
+  }
+
+  close_socket(sock, &context);
+  close_socket(echo_args.sock, &echo_args.context);
+  return res;
+}
+
+int main(int argc, char* argv[])
+{
+  unsigned long num_round_trips = DEFAULT_NUM_ROUND_TRIPS;
+  unsigned int  spin_us = DEFAULT_SPIN_US;
+  if (argc > 1)
+    num_round_trips = strtoul(argv[1], NULL, 10);
+  if (argc > 2)
+    spin_us = (unsigned int)strtoul(argv[2], NULL, 10);
+  if (num_round_trips == 0)
+    num_round_trips = DEFAULT_NUM_ROUND_TRIPS;
+
+  uint64_t* samples = (uint64_t*)malloc(num_round_trips * sizeof(uint64_t));
+  if (!samples)
+  {
+    printf("Couldn't allocate memory for %lu samples\n", num_round_trips);
+    return 1;
+  }
+
+  etcpal_error_t res = etcpal_init(ETCPAL_FEATURE_SOCKETS);
+  if (res != kEtcPalErrOk)
+  {
+    printf("Couldn't initialize EtcPal: '%s'\n", etcpal_strerror(res));
+    free(samples);
+    return 1;
+  }
+
+  res = run_latency_benchmark("default", kModeDefault, spin_us, num_round_trips, samples);
+  if (res == kEtcPalErrOk)
+    res = run_latency_benchmark("spin", kModeSpin, spin_us, num_round_trips, samples);
+  if (res == kEtcPalErrOk)
+    res = run_latency_benchmark("busy-poll", kModeBusyPoll, spin_us, num_round_trips, samples);
+  if (res != kEtcPalErrOk)
+    printf("Benchmark failed: '%s'\n", etcpal_strerror(res));
+
+  etcpal_deinit(ETCPAL_FEATURE_SOCKETS);
+  free(samples);
+  return (res == kEtcPalErrOk ? 0 : 1);
+}
@@ -0,0 +1,184 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+/*
+ * A microbenchmark for the etcpal_poll_* API. Measures the average time taken to retrieve a single
+ * poll event in two scenarios:
+ *
+ * - "writable": a set of UDP sockets polled for ETCPAL_POLL_OUT. These are always ready, so this
+ *   isolates the overhead of etcpal_poll_wait() itself.
+ * - "readable": a UDP socket polled for ETCPAL_POLL_IN over loopback, with one send and one receive
+ *   per event, approximating a typical receive loop.
+ *
+ * To see the number of system calls made per event, run this program under a syscall tracer (e.g.
+ * `strace -c -f` on Linux) and divide the call counts by the number of events reported.
+ *
+ * Usage: etcpal_poll_benchmark [num_events]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "etcpal/common.h"
+#include "etcpal/socket.h"
+#include "etcpal/timer.h"
+
+#define DEFAULT_NUM_EVENTS 200000
+#define NUM_WRITABLE_SOCKETS 16
+
+static const char kBenchmarkMessage[] = "benchmark";
+
+static void print_result(const char* name, unsigned long num_events, uint32_t elapsed_ms)
+{
+  double ns_per_event = (num_events > 0 ? ((double)elapsed_ms * 1000000.0) / (double)num_events : 0.0);
+  printf("%-10s %10lu events in %6u ms (%8.1f ns/event)\n", name, num_events, (unsigned int)elapsed_ms, ns_per_event);
+}
+
+static etcpal_error_t run_writable_benchmark(unsigned long num_events)
+{
+  EtcPalPollContext context;
+  etcpal_error_t    res = etcpal_poll_context_init(&context);
+  if (res != kEtcPalErrOk)
+    return res;
+
+  etcpal_socket_t socks[NUM_WRITABLE_SOCKETS];
+  size_t          num_socks = 0;
+  for (; num_socks < NUM_WRITABLE_SOCKETS; ++num_socks)
+  {
+    res = etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &socks[num_socks]);
+    if (res != kEtcPalErrOk)
+      break;
+    res = etcpal_poll_add_socket(&context, socks[num_socks], ETCPAL_POLL_OUT, NULL);
+    if (res != kEtcPalErrOk)
+    {
+      etcpal_close(socks[num_socks]);
+      break;
+    }
+  }
+
+  if (res == kEtcPalErrOk)
+  {
+    EtcPalTimer timer;
+    etcpal_timer_start(&timer, 0);
+    for (unsigned long i = 0; i < num_events; ++i)
+    {
+      EtcPalPollEvent event;
+      res = etcpal_poll_wait(&context, &event, 0);
+      if (res != kEtcPalErrOk)
+        break;
+    }
+    if (res == kEtcPalErrOk)
+      print_result("writable", num_events, etcpal_timer_elapsed(&timer));
+  }
+
+  for (size_t i = 0; i < num_socks; ++i)
+  {
+    etcpal_poll_remove_socket(&context, socks[i]);
+    etcpal_close(socks[i]);
+  }
+  etcpal_poll_context_deinit(&context);
+  return res;
+}
+
+static etcpal_error_t run_readable_benchmark(unsigned long num_events)
+{
+  etcpal_socket_t send_sock = ETCPAL_SOCKET_INVALID;
+  etcpal_socket_t recv_sock = ETCPAL_SOCKET_INVALID;
+
+  EtcPalPollContext context;
+  etcpal_error_t    res = etcpal_poll_context_init(&context);
+  if (res != kEtcPalErrOk)
+    return res;
+
+  EtcPalSockAddr addr;
+  ETCPAL_IP_SET_V4_ADDRESS(&addr.ip, 0x7f000001);
+  addr.port = 0;
+
+  res = etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &send_sock);
+  if (res == kEtcPalErrOk)
+    res = etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &recv_sock);
+  if (res == kEtcPalErrOk)
+    res = etcpal_bind(recv_sock, &addr);
+  if (res == kEtcPalErrOk)
+    res = etcpal_getsockname(recv_sock, &addr);
+  if (res == kEtcPalErrOk)
+    res = etcpal_poll_add_socket(&context, recv_sock, ETCPAL_POLL_IN, NULL);
+
+  if (res == kEtcPalErrOk)
+  {
+    EtcPalTimer timer;
+    etcpal_timer_start(&timer, 0);
+    for (unsigned long i = 0; i < num_events; ++i)
+    {
+      int send_res = etcpal_sendto(send_sock, kBenchmarkMessage, sizeof kBenchmarkMessage, 0, &addr);
+      if (send_res < 0)
+      {
+        res = (etcpal_error_t)send_res;
+        break;
+      }
+
+      EtcPalPollEvent event;
+      res = etcpal_poll_wait(&context, &event, 1000);
+      if (res != kEtcPalErrOk)
+        break;
+
+      uint8_t recv_buf[sizeof kBenchmarkMessage];
+      int     recv_res = etcpal_recvfrom(event.socket, recv_buf, sizeof recv_buf, 0, NULL);
+      if (recv_res < 0)
+      {
+        res = (etcpal_error_t)recv_res;
+        break;
+      }
+    }
+    if (res == kEtcPalErrOk)
+      print_result("readable", num_events, etcpal_timer_elapsed(&timer));
+  }
+
+  if (recv_sock != ETCPAL_SOCKET_INVALID)
+  {
+    etcpal_poll_remove_socket(&context, recv_sock);
+    etcpal_close(recv_sock);
+  }
+  if (send_sock != ETCPAL_SOCKET_INVALID)
+    etcpal_close(send_sock);
+  etcpal_poll_context_deinit(&context);
+  return res;
+}
+
+int main(int argc, char* argv[])
+{
+  unsigned long num_events = DEFAULT_NUM_EVENTS;
+  if (argc > 1)
+    num_events = strtoul(argv[1], NULL, 10);
+
+  etcpal_error_t res = etcpal_init(ETCPAL_FEATURE_SOCKETS | ETCPAL_FEATURE_TIMERS);
+  if (res != kEtcPalErrOk)
+  {
+    printf("Couldn't initialize EtcPal: '%s'\n", etcpal_strerror(res));
+    return 1;
+  }
+
+  res = run_writable_benchmark(num_events);
+  if (res == kEtcPalErrOk)
+    res = run_readable_benchmark(num_events);
+  if (res != kEtcPalErrOk)
+    printf("Benchmark failed: '%s'\n", etcpal_strerror(res));
+
+  etcpal_deinit(ETCPAL_FEATURE_SOCKETS | ETCPAL_FEATURE_TIMERS);
+  return (res == kEtcPalErrOk ? 0 : 1);
+}
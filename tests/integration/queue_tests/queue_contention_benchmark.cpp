@@ -0,0 +1,106 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+
+/*
+ * A contention benchmark for the EtcPal queues. A number of producer threads send items as fast as
+ * they can to a number of consumer threads through the same queue, which is measured with:
+ *
+ * - etcpal::Queue, where every send and receive takes the queue's lock.
+ * - etcpal::MpmcQueue, where senders and receivers claim slots with a compare-and-swap.
+ *
+ * The producer counts approximate a set of network threads feeding one processing stage (1
+ * consumer) or a pool of processing threads (4 consumers). The average time per item is reported;
+ * with more producers, time spent contending for the queue shows up as a higher time per item.
+ *
+ * Usage: etcpal_queue_benchmark [items_per_producer]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "etcpal/cpp/queue.h"
+#include "etcpal/cpp/thread.h"
+
+constexpr unsigned long kDefaultItemsPerProducer = 200000;
+constexpr size_t        kQueueSize = 1024;
+
+using LockedQueue = etcpal::Queue<unsigned long>;
+using LockFreeQueue = etcpal::MpmcQueue<unsigned long>;
+
+template <class QueueType>
+static double run_benchmark(unsigned num_producers, unsigned num_consumers, unsigned long items_per_producer)
+{
+  QueueType     queue(kQueueSize);
+  unsigned long total_items = items_per_producer * num_producers;
+
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<etcpal::Thread> threads;
+  threads.reserve(num_producers + num_consumers);
+  for (unsigned i = 0; i < num_consumers; ++i)
+  {
+    // Spread the items across the consumers, giving any remainder to the first one.
+    unsigned long num_to_receive = total_items / num_consumers + (i == 0 ? total_items % num_consumers : 0);
+    threads.emplace_back([&queue, num_to_receive]() {
+      for (unsigned long j = 0; j < num_to_receive; ++j)
+      {
+        unsigned long item = 0;
+        queue.Receive(item);
+      }
+    });
+  }
+  for (unsigned i = 0; i < num_producers; ++i)
+  {
+    threads.emplace_back([&queue, items_per_producer]() {
+      for (unsigned long j = 0; j < items_per_producer; ++j)
+        queue.Send(j);
+    });
+  }
+  for (auto& thread : threads)
+    thread.Join();
+
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / static_cast<double>(total_items);
+}
+
+int main(int argc, char* argv[])
+{
+  unsigned long items_per_producer = kDefaultItemsPerProducer;
+  if (argc > 1)
+    items_per_producer = strtoul(argv[1], nullptr, 10);
+  if (items_per_producer == 0)
+  {
+    printf("Usage: %s [items_per_producer]\n", argv[0]);
+    return 1;
+  }
+
+  printf("%9s %9s %14s %17s\n", "producers", "consumers", "Queue ns/item", "MpmcQueue ns/item");
+  for (unsigned num_consumers : {1u, 4u})
+  {
+    for (unsigned num_producers : {1u, 2u, 4u, 8u})
+    {
+      double locked = run_benchmark<LockedQueue>(num_producers, num_consumers, items_per_producer);
+      double lock_free = run_benchmark<LockFreeQueue>(num_producers, num_consumers, items_per_producer);
+      printf("%9u %9u %14.1f %17.1f\n", num_producers, num_consumers, locked, lock_free);
+    }
+  }
+  return 0;
+}
@@ -37,6 +37,7 @@ extern "C" void run_all_tests(void)  // NOLINT
   RUN_TEST_GROUP(etcpal_cpp_rwlock);
   RUN_TEST_GROUP(etcpal_cpp_sem);
   RUN_TEST_GROUP(etcpal_cpp_signal);
+  RUN_TEST_GROUP(etcpal_cpp_spsc_queue);
   RUN_TEST_GROUP(etcpal_cpp_thread);
   RUN_TEST_GROUP(etcpal_cpp_timer);
 
@@ -47,5 +48,6 @@ extern "C" void run_all_tests(void)  // NOLINT
 #endif
 #if !ETCPAL_NO_NETWORKING_SUPPORT
   RUN_TEST_GROUP(etcpal_cpp_inet);
+  RUN_TEST_GROUP(etcpal_cpp_socket);
 #endif
 }
@@ -19,6 +19,8 @@
 
 #include "etcpal/cpp/queue.h"
 
+#include <memory>
+#include <vector>
 #include "unity_fixture.h"
 
 extern "C" {
@@ -175,6 +177,143 @@ TEST(etcpal_cpp_queue, can_detect_slots_available)
   TEST_ASSERT_TRUE(q.SlotsAvailable() == 1);
 }
 
+TEST(etcpal_cpp_queue, can_reserve_and_peek_in_place)
+{
+#if ETCPAL_QUEUE_HAS_IN_PLACE_FUNCTIONS
+  struct Frame
+  {
+    int           universe;
+    unsigned char levels[8];
+  };
+
+  etcpal::Queue<Frame> q(2);
+
+  Frame* slot = q.Reserve(0);
+  TEST_ASSERT_NOT_NULL(slot);
+  q.Abort(slot);
+  TEST_ASSERT_TRUE(q.IsEmpty());
+
+  slot = q.Reserve(0);
+  TEST_ASSERT_NOT_NULL(slot);
+  slot->universe = 7;
+  slot->levels[0] = 0xFF;
+  q.Commit(slot);
+  TEST_ASSERT_EQUAL_UINT(1u, q.SlotsUsed());
+
+  const Frame* item = q.Peek(0);
+  TEST_ASSERT_NOT_NULL(item);
+  TEST_ASSERT_EQUAL(7, item->universe);
+  TEST_ASSERT_EQUAL(0xFF, item->levels[0]);
+  q.Release(item);
+  TEST_ASSERT_TRUE(q.IsEmpty());
+  TEST_ASSERT_NULL(q.Peek(0));
+#else
+  TEST_IGNORE_MESSAGE("In-place queue functions are not available on this platform.");
+#endif
+}
+
+TEST(etcpal_cpp_queue, can_move_items_through)
+{
+#if ETCPAL_QUEUE_HAS_IN_PLACE_FUNCTIONS
+  etcpal::Queue<std::unique_ptr<int>> q(1);
+
+  std::unique_ptr<int> data(new int(42));
+  TEST_ASSERT_TRUE(q.Send(std::move(data), 0));
+  TEST_ASSERT_NULL(data.get());
+
+  // A failed send leaves the data alone.
+  std::unique_ptr<int> extra(new int(43));
+  TEST_ASSERT_FALSE(q.Send(std::move(extra), 0));
+  TEST_ASSERT_NOT_NULL(extra.get());
+
+  std::unique_ptr<int> received;
+  TEST_ASSERT_TRUE(q.Receive(received, 0));
+  TEST_ASSERT_NOT_NULL(received.get());
+  TEST_ASSERT_EQUAL(42, *received);
+  TEST_ASSERT_TRUE(q.IsEmpty());
+
+  TEST_ASSERT_TRUE(q.Send(std::move(extra), 0));
+  TEST_ASSERT_NULL(extra.get());
+  TEST_ASSERT_TRUE(q.Receive(received, 0));
+  TEST_ASSERT_EQUAL(43, *received);
+#else
+  TEST_IGNORE_MESSAGE("Only trivially copyable items can be queued on this platform.");
+#endif
+}
+
+TEST(etcpal_cpp_queue, can_emplace_items)
+{
+#if ETCPAL_QUEUE_HAS_IN_PLACE_FUNCTIONS
+  etcpal::Queue<std::vector<int>> q(2);
+
+  TEST_ASSERT_TRUE(q.Emplace(3u, 7));
+  TEST_ASSERT_TRUE(q.TimedEmplace(0, 2u, 9));
+  TEST_ASSERT_FALSE(q.TimedEmplace(0, 1u, 1));
+
+  std::vector<int> received;
+  TEST_ASSERT_TRUE(q.Receive(received, std::chrono::milliseconds(0)));
+  TEST_ASSERT_TRUE(received == std::vector<int>(3u, 7));
+  TEST_ASSERT_TRUE(q.Receive(received, 0));
+  TEST_ASSERT_TRUE(received == std::vector<int>(2u, 9));
+  TEST_ASSERT_FALSE(q.Receive(received, 0));
+#else
+  TEST_IGNORE_MESSAGE("Only trivially copyable items can be queued on this platform.");
+#endif
+}
+
+TEST(etcpal_cpp_queue, destroys_remaining_items)
+{
+#if ETCPAL_QUEUE_HAS_IN_PLACE_FUNCTIONS
+  auto item = std::make_shared<int>(1);
+  {
+    etcpal::Queue<std::shared_ptr<int>> q(4);
+    TEST_ASSERT_TRUE(q.Send(item, 0));
+    TEST_ASSERT_TRUE(q.Send(item, 0));
+    TEST_ASSERT_EQUAL(3, item.use_count());
+
+    TEST_ASSERT_TRUE(q.Reset());
+    TEST_ASSERT_TRUE(q.IsEmpty());
+    TEST_ASSERT_EQUAL(1, item.use_count());
+
+    TEST_ASSERT_TRUE(q.Send(item, 0));
+    TEST_ASSERT_EQUAL(2, item.use_count());
+  }
+  TEST_ASSERT_EQUAL(1, item.use_count());
+#else
+  TEST_IGNORE_MESSAGE("Only trivially copyable items can be queued on this platform.");
+#endif
+}
+
+TEST(etcpal_cpp_queue, mpmc_queue_can_send_and_receive)
+{
+  etcpal::MpmcQueue<unsigned char> q(3);
+  TEST_ASSERT_EQUAL_UINT(4u, q.Capacity());
+  TEST_ASSERT_TRUE(q.IsEmpty());
+
+  unsigned char data = 0xDE;
+  TEST_ASSERT_TRUE(q.Send(data));
+  data = 0xAD;
+  TEST_ASSERT_TRUE(q.TrySend(data));
+  TEST_ASSERT_EQUAL_UINT(2u, q.SlotsUsed());
+
+  unsigned char received_data = 0;
+  TEST_ASSERT_TRUE(q.Receive(received_data));
+  TEST_ASSERT_EQUAL(0xDE, received_data);
+  TEST_ASSERT_TRUE(q.TryReceive(received_data));
+  TEST_ASSERT_EQUAL(0xAD, received_data);
+  TEST_ASSERT_FALSE(q.TryReceive(received_data));
+  TEST_ASSERT_FALSE(q.Receive(received_data, std::chrono::milliseconds(0)));
+}
+
+TEST(etcpal_cpp_queue, mpmc_queue_try_send_fails_when_full)
+{
+  etcpal::MpmcQueue<int> q(2, false);
+  TEST_ASSERT_TRUE(q.TrySend(1));
+  TEST_ASSERT_TRUE(q.TrySend(2));
+  TEST_ASSERT_FALSE(q.TrySend(3));
+  TEST_ASSERT_FALSE(q.Send(3));
+}
+
 TEST_GROUP_RUNNER(etcpal_cpp_queue)
 {
   RUN_TEST_CASE(etcpal_cpp_queue, can_send_and_receive);
@@ -185,6 +324,12 @@ TEST_GROUP_RUNNER(etcpal_cpp_queue)
   RUN_TEST_CASE(etcpal_cpp_queue, can_detect_full);
   RUN_TEST_CASE(etcpal_cpp_queue, can_detect_slots_used);
   RUN_TEST_CASE(etcpal_cpp_queue, can_detect_slots_available);
+  RUN_TEST_CASE(etcpal_cpp_queue, can_reserve_and_peek_in_place);
+  RUN_TEST_CASE(etcpal_cpp_queue, can_move_items_through);
+  RUN_TEST_CASE(etcpal_cpp_queue, can_emplace_items);
+  RUN_TEST_CASE(etcpal_cpp_queue, destroys_remaining_items);
+  RUN_TEST_CASE(etcpal_cpp_queue, mpmc_queue_can_send_and_receive);
+  RUN_TEST_CASE(etcpal_cpp_queue, mpmc_queue_try_send_fails_when_full);
 }
 
 }  // extern "C"
@@ -0,0 +1,271 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+#include "etcpal/cpp/socket.h"
+#include "unity_fixture.h"
+
+#include <array>
+#include <string>
+#include <utility>
+#include <vector>
+
+extern "C" {
+
+TEST_GROUP(etcpal_cpp_socket);
+
+TEST_SETUP(etcpal_cpp_socket)
+{
+  etcpal_init(ETCPAL_FEATURE_SOCKETS);
+}
+
+TEST_TEAR_DOWN(etcpal_cpp_socket)
+{
+  etcpal_deinit(ETCPAL_FEATURE_SOCKETS);
+}
+
+TEST(etcpal_cpp_socket, poll_context_reports_no_sockets)
+{
+  etcpal::PollContext context;
+
+  EtcPalPollEvent event{};
+  TEST_ASSERT_EQUAL(kEtcPalErrNoSockets, context.Wait(event, 0).code());
+
+  EtcPalPollEvent events[4];
+  auto            res = context.WaitMany(events, 0);
+  TEST_ASSERT_FALSE(res.has_value());
+  TEST_ASSERT_EQUAL(kEtcPalErrNoSockets, res.error_code());
+}
+
+TEST(etcpal_cpp_socket, poll_context_wait_many_works)
+{
+  etcpal::PollContext context;
+
+  constexpr size_t kNumSockets = 3;
+
+  std::array<etcpal_socket_t, kNumSockets> socks{};
+  for (auto& sock : socks)
+  {
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &sock));
+    // UDP sockets are immediately writable.
+    TEST_ASSERT_TRUE(context.AddSocket(sock, ETCPAL_POLL_OUT, &sock).IsOk());
+  }
+
+  EtcPalPollEvent events[kNumSockets];
+  auto            res = context.WaitMany(events, 100);
+  TEST_ASSERT_TRUE(res.has_value());
+  TEST_ASSERT_EQUAL(kNumSockets, *res);
+  for (size_t i = 0; i < *res; ++i)
+  {
+    TEST_ASSERT_EQUAL(ETCPAL_POLL_OUT, events[i].events);
+    TEST_ASSERT_EQUAL(events[i].socket, *static_cast<etcpal_socket_t*>(events[i].user_data));
+  }
+
+  // Only as many events as requested should be returned.
+  auto single_res = context.WaitMany(events, 1, 100);
+  TEST_ASSERT_TRUE(single_res.has_value());
+  TEST_ASSERT_EQUAL(1u, *single_res);
+
+  for (auto sock : socks)
+  {
+    context.RemoveSocket(sock);
+    etcpal_close(sock);
+  }
+}
+
+TEST(etcpal_cpp_socket, poll_context_wake_works)
+{
+  etcpal::PollContext context;
+
+  etcpal_socket_t sock;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &sock));
+  TEST_ASSERT_TRUE(context.AddSocket(sock, ETCPAL_POLL_IN).IsOk());
+
+  auto wake_res = context.Wake();
+  if (wake_res.code() != kEtcPalErrNotImpl)
+  {
+    TEST_ASSERT_TRUE(wake_res.IsOk());
+    EtcPalPollEvent event{};
+    TEST_ASSERT_EQUAL(kEtcPalErrWoken, context.Wait(event).code());
+  }
+
+  context.RemoveSocket(sock);
+  etcpal_close(sock);
+}
+
+TEST(etcpal_cpp_socket, socket_ownership_works)
+{
+  etcpal::Socket empty;
+  TEST_ASSERT_FALSE(empty.IsValid());
+  TEST_ASSERT_FALSE(empty);
+  TEST_ASSERT_TRUE(empty.Close().IsOk());
+
+  auto sock = etcpal::Socket::Create(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM);
+  TEST_ASSERT_TRUE(sock.has_value());
+  TEST_ASSERT_TRUE(sock->IsValid());
+  etcpal_socket_t handle = sock->get();
+
+  // Moving transfers ownership and leaves the source empty.
+  etcpal::Socket moved(std::move(*sock));
+  TEST_ASSERT_FALSE(sock->IsValid());
+  TEST_ASSERT_EQUAL(handle, moved.get());
+
+  etcpal::Socket assigned;
+  assigned = std::move(moved);
+  TEST_ASSERT_FALSE(moved.IsValid());
+  TEST_ASSERT_EQUAL(handle, assigned.get());
+
+  // Release() gives up ownership without closing.
+  etcpal_socket_t released = assigned.Release();
+  TEST_ASSERT_EQUAL(handle, released);
+  TEST_ASSERT_FALSE(assigned.IsValid());
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(released));
+
+  TEST_ASSERT_FALSE(empty.Bind(etcpal::SockAddr(etcpal::IpAddr::WildcardV4(), 0)).IsOk());
+}
+
+TEST(etcpal_cpp_socket, socket_send_and_receive_work)
+{
+  auto recv_sock = etcpal::Socket::Create(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM);
+  auto send_sock = etcpal::Socket::Create(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM);
+  TEST_ASSERT_TRUE(recv_sock.has_value());
+  TEST_ASSERT_TRUE(send_sock.has_value());
+
+  TEST_ASSERT_TRUE(recv_sock->Bind(etcpal::SockAddr(0x7f000001, 0)).IsOk());
+  auto recv_addr = recv_sock->GetSockName();
+  TEST_ASSERT_TRUE(recv_addr.has_value());
+  TEST_ASSERT_NOT_EQUAL(0, recv_addr->port());
+
+  int timeout_ms = 1000;
+  TEST_ASSERT_TRUE(recv_sock->SetOption(ETCPAL_SOL_SOCKET, ETCPAL_SO_RCVTIMEO, timeout_ms).IsOk());
+
+  // Buffers convert from arrays and contiguous containers.
+  const uint8_t              array_data[] = {1, 2, 3, 4};
+  const std::vector<uint8_t> vector_data = {5, 6, 7};
+  const std::string          string_data = "test";
+  TEST_ASSERT_EQUAL(4u, send_sock->SendTo(array_data, *recv_addr).value());
+  TEST_ASSERT_EQUAL(3u, send_sock->SendTo(vector_data, *recv_addr).value());
+  TEST_ASSERT_EQUAL(4u, send_sock->SendTo(string_data, *recv_addr).value());
+  TEST_ASSERT_EQUAL(2u, send_sock->SendTo(etcpal::ConstBuffer(array_data, 2), *recv_addr).value());
+
+  std::array<uint8_t, 16> recv_buf{};
+  etcpal::SockAddr        from;
+  auto                    res = recv_sock->ReceiveFrom(recv_buf, from);
+  TEST_ASSERT_TRUE(res.has_value());
+  TEST_ASSERT_EQUAL(4u, *res);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(array_data, recv_buf.data(), 4);
+  TEST_ASSERT_TRUE(from.ip() == etcpal::IpAddr(0x7f000001));
+
+  std::vector<uint8_t> recv_vector(16);
+  auto                 vector_res = recv_sock->Receive(recv_vector);
+  TEST_ASSERT_TRUE(vector_res.has_value());
+  TEST_ASSERT_EQUAL(3u, *vector_res);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(vector_data.data(), recv_vector.data(), 3);
+
+  char recv_array[16];
+  auto array_res = recv_sock->Receive(recv_array);
+  TEST_ASSERT_TRUE(array_res.has_value());
+  TEST_ASSERT_EQUAL(4u, *array_res);
+  TEST_ASSERT_EQUAL_MEMORY(string_data.data(), recv_array, 4);
+
+  auto explicit_res = recv_sock->Receive(etcpal::MutableBuffer(recv_array, sizeof recv_array));
+  TEST_ASSERT_TRUE(explicit_res.has_value());
+  TEST_ASSERT_EQUAL(2u, *explicit_res);
+
+  // Receiving on a socket that is not owned fails.
+  etcpal::Socket empty;
+  TEST_ASSERT_FALSE(empty.Receive(recv_array).has_value());
+}
+
+TEST(etcpal_cpp_socket, poll_events_batch_works)
+{
+  etcpal::PollContext context;
+  TEST_ASSERT_TRUE(context.IsValid());
+
+  constexpr size_t kNumSockets = 3;
+
+  std::array<etcpal::Socket, kNumSockets> socks;
+  for (auto& sock : socks)
+  {
+    auto res = etcpal::Socket::Create(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM);
+    TEST_ASSERT_TRUE(res.has_value());
+    sock = std::move(*res);
+    TEST_ASSERT_TRUE(context.AddSocket(sock, ETCPAL_POLL_OUT, &sock).IsOk());
+  }
+
+  etcpal::PollEvents<kNumSockets> events;
+  TEST_ASSERT_TRUE(events.empty());
+  TEST_ASSERT_EQUAL(kNumSockets, events.capacity());
+
+  // The same batch is reused for every wait.
+  for (int i = 0; i < 3; ++i)
+  {
+    TEST_ASSERT_TRUE(context.WaitMany(events, 100).IsOk());
+    TEST_ASSERT_EQUAL(kNumSockets, events.size());
+    size_t num_iterated = 0;
+    for (const EtcPalPollEvent& event : events)
+    {
+      TEST_ASSERT_EQUAL(ETCPAL_POLL_OUT, event.events);
+      TEST_ASSERT_EQUAL(event.socket, static_cast<etcpal::Socket*>(event.user_data)->get());
+      ++num_iterated;
+    }
+    TEST_ASSERT_EQUAL(kNumSockets, num_iterated);
+  }
+
+  for (auto& sock : socks)
+    context.RemoveSocket(sock);
+  TEST_ASSERT_EQUAL(kEtcPalErrNoSockets, context.WaitMany(events, 0).code());
+  TEST_ASSERT_TRUE(events.empty());
+}
+
+TEST(etcpal_cpp_socket, poll_context_move_works)
+{
+  etcpal::PollContext context;
+  auto                sock = etcpal::Socket::Create(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM);
+  TEST_ASSERT_TRUE(sock.has_value());
+  TEST_ASSERT_TRUE(context.AddSocket(*sock, ETCPAL_POLL_OUT).IsOk());
+
+  // The monitored sockets move with the context.
+  etcpal::PollContext moved(std::move(context));
+  TEST_ASSERT_FALSE(context.IsValid());
+  TEST_ASSERT_TRUE(moved.IsValid());
+  EtcPalPollEvent event{};
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, context.Wait(event, 0).code());
+  TEST_ASSERT_TRUE(moved.Wait(event, 100).IsOk());
+  TEST_ASSERT_EQUAL(sock->get(), event.socket);
+
+  etcpal::PollContext assigned;
+  assigned = std::move(moved);
+  TEST_ASSERT_FALSE(moved.IsValid());
+  TEST_ASSERT_TRUE(assigned.Wait(event, 100).IsOk());
+  TEST_ASSERT_EQUAL(sock->get(), event.socket);
+
+  assigned.RemoveSocket(*sock);
+}
+
+TEST_GROUP_RUNNER(etcpal_cpp_socket)
+{
+  RUN_TEST_CASE(etcpal_cpp_socket, poll_context_reports_no_sockets);
+  RUN_TEST_CASE(etcpal_cpp_socket, poll_context_wait_many_works);
+  RUN_TEST_CASE(etcpal_cpp_socket, poll_context_wake_works);
+  RUN_TEST_CASE(etcpal_cpp_socket, socket_ownership_works);
+  RUN_TEST_CASE(etcpal_cpp_socket, socket_send_and_receive_work);
+  RUN_TEST_CASE(etcpal_cpp_socket, poll_events_batch_works);
+  RUN_TEST_CASE(etcpal_cpp_socket, poll_context_move_works);
+}
+}
@@ -0,0 +1,89 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+#include "etcpal/cpp/spsc_queue.h"
+
+#include <chrono>
+#include "etcpal/cpp/thread.h"
+#include "unity_fixture.h"
+
+extern "C" {
+
+TEST_GROUP(etcpal_cpp_spsc_queue);
+
+TEST_SETUP(etcpal_cpp_spsc_queue)
+{
+}
+
+TEST_TEAR_DOWN(etcpal_cpp_spsc_queue)
+{
+}
+
+TEST(etcpal_cpp_spsc_queue, can_send_and_receive)
+{
+  etcpal::SpscQueue<unsigned char> q(3);
+  TEST_ASSERT_EQUAL_UINT(4u, q.Capacity());
+  TEST_ASSERT_TRUE(q.IsEmpty());
+
+  unsigned char data = 0xDE;
+  TEST_ASSERT_TRUE(q.TrySend(data));
+  TEST_ASSERT_EQUAL_UINT(1u, q.SlotsUsed());
+
+  unsigned char received_data = 0;
+  TEST_ASSERT_TRUE(q.Receive(received_data));
+  TEST_ASSERT_EQUAL(data, received_data);
+  TEST_ASSERT_FALSE(q.TryReceive(received_data));
+  TEST_ASSERT_FALSE(q.Receive(received_data, std::chrono::milliseconds(0)));
+}
+
+TEST(etcpal_cpp_spsc_queue, try_send_fails_when_full)
+{
+  etcpal::SpscQueue<int> q(2, false);
+  TEST_ASSERT_TRUE(q.TrySend(1));
+  TEST_ASSERT_TRUE(q.TrySend(2));
+  TEST_ASSERT_FALSE(q.TrySend(3));
+  TEST_ASSERT_FALSE(q.Send(3));
+}
+
+TEST(etcpal_cpp_spsc_queue, handoff_between_threads_works)
+{
+  constexpr int          kNumItems = 10000;
+  etcpal::SpscQueue<int> q(16);
+
+  etcpal::Thread producer([&q]() {
+    for (int i = 0; i < kNumItems; ++i)
+      q.Send(i);
+  });
+
+  for (int i = 0; i < kNumItems; ++i)
+  {
+    int data = -1;
+    TEST_ASSERT_TRUE(q.Receive(data));
+    TEST_ASSERT_EQUAL_INT(i, data);
+  }
+  producer.Join();
+}
+
+TEST_GROUP_RUNNER(etcpal_cpp_spsc_queue)
+{
+  RUN_TEST_CASE(etcpal_cpp_spsc_queue, can_send_and_receive);
+  RUN_TEST_CASE(etcpal_cpp_spsc_queue, try_send_fails_when_full);
+  RUN_TEST_CASE(etcpal_cpp_spsc_queue, handoff_between_threads_works);
+}
+}
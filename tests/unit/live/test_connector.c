@@ -0,0 +1,222 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+#include "etcpal/connector.h"
+
+#include <string.h>
+#include "etcpal/common.h"
+#include "etcpal/timer.h"
+#include "unity_fixture.h"
+
+#define NUM_CONNECTS 16
+
+typedef struct ConnectorResults
+{
+  size_t          num_connects;
+  size_t          num_connect_failures;
+  size_t          num_timeouts;
+  etcpal_error_t  last_connect_result;
+  etcpal_socket_t connected[NUM_CONNECTS];
+  size_t          num_accepts;
+  etcpal_socket_t accepted[NUM_CONNECTS];
+} ConnectorResults;
+
+static EtcPalConnector* connector;
+static etcpal_socket_t  listener;
+static EtcPalSockAddr   listen_addr;
+static ConnectorResults results;
+
+static void handle_connect(etcpal_socket_t socket, etcpal_error_t result, void* context)
+{
+  TEST_ASSERT_EQUAL_PTR(&results, context);
+  results.last_connect_result = result;
+  if (result == kEtcPalErrOk)
+  {
+    TEST_ASSERT_NOT_EQUAL(ETCPAL_SOCKET_INVALID, socket);
+    if (results.num_connects < NUM_CONNECTS)
+      results.connected[results.num_connects] = socket;
+    ++results.num_connects;
+  }
+  else
+  {
+    TEST_ASSERT_EQUAL(ETCPAL_SOCKET_INVALID, socket);
+    ++results.num_connect_failures;
+    if (result == kEtcPalErrTimedOut)
+      ++results.num_timeouts;
+  }
+}
+
+static void handle_accept(etcpal_socket_t listen_sock, etcpal_socket_t conn, const EtcPalSockAddr* remote_addr,
+                          void* context)
+{
+  TEST_ASSERT_EQUAL_PTR(&results, context);
+  TEST_ASSERT_EQUAL(listener, listen_sock);
+  TEST_ASSERT_NOT_NULL(remote_addr);
+  if (results.num_accepts < NUM_CONNECTS)
+    results.accepted[results.num_accepts] = conn;
+  ++results.num_accepts;
+}
+
+static etcpal_socket_t new_tcp_socket(void)
+{
+  etcpal_socket_t sock;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_STREAM, &sock));
+  return sock;
+}
+
+static void process_until(const size_t* count, size_t expected)
+{
+  EtcPalTimer timer;
+  etcpal_timer_start(&timer, 2000);
+  while (*count < expected && !etcpal_timer_is_expired(&timer))
+    etcpal_connector_process(connector, 50);
+}
+
+TEST_GROUP(etcpal_connector);
+
+TEST_SETUP(etcpal_connector)
+{
+  etcpal_init(ETCPAL_FEATURE_SOCKETS);
+  memset(&results, 0, sizeof results);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_connector_create(&connector));
+
+  listener = new_tcp_socket();
+  ETCPAL_IP_SET_V4_ADDRESS(&listen_addr.ip, 0x7f000001);
+  listen_addr.port = 0;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_bind(listener, &listen_addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_getsockname(listener, &listen_addr));
+}
+
+TEST_TEAR_DOWN(etcpal_connector)
+{
+  etcpal_connector_destroy(connector);
+  etcpal_close(listener);
+  for (size_t i = 0; i < results.num_connects && i < NUM_CONNECTS; ++i)
+    etcpal_close(results.connected[i]);
+  for (size_t i = 0; i < results.num_accepts && i < NUM_CONNECTS; ++i)
+    etcpal_close(results.accepted[i]);
+  etcpal_deinit(ETCPAL_FEATURE_SOCKETS);
+}
+
+TEST(etcpal_connector, invalid_calls_fail)
+{
+  etcpal_socket_t sock = new_tcp_socket();
+
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_connector_create(NULL));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_connector_connect(NULL, sock, &listen_addr, 100, handle_connect, NULL));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_connector_connect(connector, ETCPAL_SOCKET_INVALID, &listen_addr, 100,
+                                                                handle_connect, NULL));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_connector_connect(connector, sock, NULL, 100, handle_connect, NULL));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_connector_connect(connector, sock, &listen_addr, 100, NULL, NULL));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid,
+                    etcpal_connector_connect(connector, sock, &listen_addr, -2, handle_connect, NULL));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_connector_add_listener(connector, listener, NULL, NULL));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_connector_process(NULL, 0));
+
+  TEST_ASSERT_EQUAL(kEtcPalErrNotFound, etcpal_connector_cancel(connector, sock));
+  TEST_ASSERT_EQUAL(kEtcPalErrNotFound, etcpal_connector_remove_listener(connector, listener));
+  TEST_ASSERT_EQUAL(kEtcPalErrNoSockets, etcpal_connector_process(connector, 0));
+  TEST_ASSERT_EQUAL(0u, etcpal_connector_num_pending(NULL));
+
+  etcpal_close(sock);
+}
+
+TEST(etcpal_connector, connects_and_accepts)
+{
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_listen(listener, NUM_CONNECTS));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_connector_add_listener(connector, listener, handle_accept, &results));
+  TEST_ASSERT_EQUAL(kEtcPalErrExists, etcpal_connector_add_listener(connector, listener, handle_accept, &results));
+
+  for (int i = 0; i < NUM_CONNECTS; ++i)
+  {
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_connector_connect(connector, new_tcp_socket(), &listen_addr, 2000,
+                                                             handle_connect, &results));
+  }
+  TEST_ASSERT_EQUAL(NUM_CONNECTS, etcpal_connector_num_pending(connector));
+
+  // Connects and accepts are all serviced by the same calls.
+  process_until(&results.num_connects, NUM_CONNECTS);
+  process_until(&results.num_accepts, NUM_CONNECTS);
+  TEST_ASSERT_EQUAL(NUM_CONNECTS, results.num_connects);
+  TEST_ASSERT_EQUAL(NUM_CONNECTS, results.num_accepts);
+  TEST_ASSERT_EQUAL(0u, results.num_connect_failures);
+  TEST_ASSERT_EQUAL(0u, etcpal_connector_num_pending(connector));
+
+  static const char kMessage[] = "connector";
+  TEST_ASSERT_EQUAL((int)sizeof kMessage, etcpal_send(results.connected[0], kMessage, sizeof kMessage, 0));
+
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_connector_remove_listener(connector, listener));
+}
+
+TEST(etcpal_connector, refused_connect_reports_error)
+{
+  // The listener is bound but not listening, so connects to it are refused.
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_connector_connect(connector, new_tcp_socket(), &listen_addr, 2000,
+                                                           handle_connect, &results));
+  process_until(&results.num_connect_failures, 1);
+  TEST_ASSERT_EQUAL(1u, results.num_connect_failures);
+  TEST_ASSERT_EQUAL(0u, results.num_connects);
+  TEST_ASSERT_EQUAL(kEtcPalErrConnRefused, results.last_connect_result);
+  TEST_ASSERT_EQUAL(0u, etcpal_connector_num_pending(connector));
+}
+
+TEST(etcpal_connector, cancelled_connect_is_not_reported)
+{
+  etcpal_socket_t sock = new_tcp_socket();
+  TEST_ASSERT_EQUAL(kEtcPalErrOk,
+                    etcpal_connector_connect(connector, sock, &listen_addr, 2000, handle_connect, &results));
+  TEST_ASSERT_EQUAL(1u, etcpal_connector_num_pending(connector));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_connector_cancel(connector, sock));
+  TEST_ASSERT_EQUAL(0u, etcpal_connector_num_pending(connector));
+  TEST_ASSERT_EQUAL(kEtcPalErrNoSockets, etcpal_connector_process(connector, 10));
+  TEST_ASSERT_EQUAL(0u, results.num_connects + results.num_connect_failures);
+}
+
+TEST(etcpal_connector, unanswered_connect_times_out)
+{
+  // Fill the listener's backlog, after which the network stack leaves new connects unanswered.
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_listen(listener, 0));
+  etcpal_socket_t backlog_socks[4];
+  for (size_t i = 0; i < 4; ++i)
+  {
+    backlog_socks[i] = new_tcp_socket();
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_connector_connect(connector, backlog_socks[i], &listen_addr, 200,
+                                                             handle_connect, &results));
+  }
+
+  EtcPalTimer timer;
+  etcpal_timer_start(&timer, 2000);
+  while (etcpal_connector_num_pending(connector) > 0 && !etcpal_timer_is_expired(&timer))
+    etcpal_connector_process(connector, 50);
+
+  TEST_ASSERT_EQUAL(0u, etcpal_connector_num_pending(connector));
+  TEST_ASSERT_EQUAL(4u, results.num_connects + results.num_connect_failures);
+  if (results.num_timeouts == 0)
+    TEST_IGNORE_MESSAGE("The network stack answered every connect; no timeout occurred.");
+  TEST_ASSERT_EQUAL(results.num_connect_failures, results.num_timeouts);
+}
+
+TEST_GROUP_RUNNER(etcpal_connector)
+{
+  RUN_TEST_CASE(etcpal_connector, invalid_calls_fail);
+  RUN_TEST_CASE(etcpal_connector, connects_and_accepts);
+  RUN_TEST_CASE(etcpal_connector, refused_connect_reports_error);
+  RUN_TEST_CASE(etcpal_connector, cancelled_connect_is_not_reported);
+  RUN_TEST_CASE(etcpal_connector, unanswered_connect_times_out);
+}
@@ -0,0 +1,220 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+#include "etcpal/io_ring.h"
+#include "unity_fixture.h"
+
+#include <string.h>
+
+#define TEST_BUFFER_SIZE 256
+
+static EtcPalIoRing* ring;
+
+static void create_ring(size_t num_buffers)
+{
+  EtcPalIoRingConfig config = ETCPAL_IO_RING_CONFIG_DEFAULT_INIT;
+  config.queue_depth = 8;
+  config.num_buffers = num_buffers;
+  config.buffer_size = TEST_BUFFER_SIZE;
+
+  etcpal_error_t res = etcpal_io_ring_create(&config, &ring);
+  if (res == kEtcPalErrNotImpl || res == kEtcPalErrPerm)
+    TEST_IGNORE_MESSAGE("io_uring is not available on this system.");
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, res);
+}
+
+static void bind_udp_socket(etcpal_socket_t* sock, EtcPalSockAddr* addr)
+{
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, sock));
+  ETCPAL_IP_SET_V4_ADDRESS(&addr->ip, 0x7f000001);
+  addr->port = 0;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_bind(*sock, addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_getsockname(*sock, addr));
+}
+
+TEST_GROUP(etcpal_io_ring);
+
+TEST_SETUP(etcpal_io_ring)
+{
+  etcpal_init(ETCPAL_FEATURE_SOCKETS);
+  ring = NULL;
+}
+
+TEST_TEAR_DOWN(etcpal_io_ring)
+{
+  etcpal_io_ring_destroy(ring);
+  etcpal_deinit(ETCPAL_FEATURE_SOCKETS);
+}
+
+TEST(etcpal_io_ring, invalid_calls_fail)
+{
+  EtcPalIoRingConfig config = ETCPAL_IO_RING_CONFIG_DEFAULT_INIT;
+  TEST_ASSERT_NOT_EQUAL(kEtcPalErrOk, etcpal_io_ring_create(NULL, &ring));
+  TEST_ASSERT_NOT_EQUAL(kEtcPalErrOk, etcpal_io_ring_create(&config, NULL));
+  config.num_buffers = 4;
+  TEST_ASSERT_NOT_EQUAL(kEtcPalErrOk, etcpal_io_ring_create(&config, &ring));
+
+  create_ring(2);
+
+  uint8_t buf[10];
+  TEST_ASSERT_NOT_EQUAL(kEtcPalErrOk, etcpal_io_ring_recv(ring, ETCPAL_SOCKET_INVALID, buf, sizeof buf, NULL));
+  TEST_ASSERT_NOT_EQUAL(kEtcPalErrOk, etcpal_io_ring_recv(ring, 0, NULL, sizeof buf, NULL));
+  TEST_ASSERT_NOT_EQUAL(kEtcPalErrOk, etcpal_io_ring_recv_fixed(ring, 0, 2, TEST_BUFFER_SIZE, NULL));
+  TEST_ASSERT_NOT_EQUAL(kEtcPalErrOk, etcpal_io_ring_recv_fixed(ring, 0, 0, TEST_BUFFER_SIZE + 1, NULL));
+  TEST_ASSERT_NULL(etcpal_io_ring_buffer(ring, 2));
+  TEST_ASSERT_NOT_NULL(etcpal_io_ring_buffer(ring, 1));
+
+  // With nothing outstanding, there is nothing to wait for.
+  EtcPalIoCompletion completion;
+  TEST_ASSERT_EQUAL((int)kEtcPalErrNoData, etcpal_io_ring_wait(ring, &completion, 1, ETCPAL_WAIT_FOREVER));
+  TEST_ASSERT_EQUAL((int)kEtcPalErrNoData, etcpal_io_ring_wait(ring, &completion, 1, 0));
+}
+
+TEST(etcpal_io_ring, wait_times_out)
+{
+  create_ring(0);
+
+  etcpal_socket_t sock;
+  EtcPalSockAddr  addr;
+  bind_udp_socket(&sock, &addr);
+
+  uint8_t buf[10];
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_io_ring_recv(ring, sock, buf, sizeof buf, NULL));
+
+  EtcPalIoCompletion completion;
+  TEST_ASSERT_EQUAL((int)kEtcPalErrTimedOut, etcpal_io_ring_wait(ring, &completion, 1, 0));
+  TEST_ASSERT_EQUAL((int)kEtcPalErrTimedOut, etcpal_io_ring_wait(ring, &completion, 1, 10));
+
+  // Destroying the ring cancels the outstanding receive.
+  etcpal_io_ring_destroy(ring);
+  ring = NULL;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(sock));
+}
+
+TEST(etcpal_io_ring, udp_fixed_buffers_work)
+{
+  create_ring(2);
+
+  etcpal_socket_t send_sock;
+  etcpal_socket_t recv_sock;
+  EtcPalSockAddr  send_addr;
+  EtcPalSockAddr  recv_addr;
+  bind_udp_socket(&send_sock, &send_addr);
+  bind_udp_socket(&recv_sock, &recv_addr);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_connect(send_sock, &recv_addr));
+
+  int user_data = 0;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_io_ring_recv_fixed(ring, recv_sock, 0, TEST_BUFFER_SIZE, &user_data));
+
+  const uint8_t payload[] = {0x01, 0x02, 0x03, 0x04, 0x05};
+  memcpy(etcpal_io_ring_buffer(ring, 1), payload, sizeof payload);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_io_ring_send_fixed(ring, send_sock, 1, sizeof payload, NULL));
+
+  // Collect both completions; they may be reported in either order.
+  EtcPalIoCompletion completions[2];
+  size_t             num_completions = 0;
+  while (num_completions < 2)
+  {
+    int res = etcpal_io_ring_wait(ring, &completions[num_completions], 2 - num_completions, 1000);
+    TEST_ASSERT_GREATER_THAN(0, res);
+    num_completions += (size_t)res;
+  }
+
+  for (size_t i = 0; i < 2; ++i)
+  {
+    TEST_ASSERT_EQUAL((int)sizeof payload, completions[i].result);
+    if (completions[i].op == ETCPAL_IO_OP_RECV)
+    {
+      TEST_ASSERT_EQUAL(recv_sock, completions[i].socket);
+      TEST_ASSERT_EQUAL(0, completions[i].buffer_index);
+      TEST_ASSERT_EQUAL_PTR(&user_data, completions[i].user_data);
+      TEST_ASSERT_EQUAL_UINT8_ARRAY(payload, etcpal_io_ring_buffer(ring, 0), sizeof payload);
+    }
+    else
+    {
+      TEST_ASSERT_EQUAL(ETCPAL_IO_OP_SEND, completions[i].op);
+      TEST_ASSERT_EQUAL(send_sock, completions[i].socket);
+      TEST_ASSERT_EQUAL(1, completions[i].buffer_index);
+    }
+  }
+
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(send_sock));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(recv_sock));
+}
+
+TEST(etcpal_io_ring, tcp_send_and_recv_work)
+{
+  create_ring(0);
+
+  etcpal_socket_t listen_sock;
+  EtcPalSockAddr  listen_addr;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_STREAM, &listen_sock));
+  ETCPAL_IP_SET_V4_ADDRESS(&listen_addr.ip, 0x7f000001);
+  listen_addr.port = 0;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_bind(listen_sock, &listen_addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_getsockname(listen_sock, &listen_addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_listen(listen_sock, 1));
+
+  etcpal_socket_t client_sock;
+  etcpal_socket_t server_sock;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_STREAM, &client_sock));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_connect(client_sock, &listen_addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_accept(listen_sock, NULL, &server_sock));
+
+  uint8_t recv_buf[32];
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_io_ring_recv(ring, server_sock, recv_buf, sizeof recv_buf, NULL));
+  EtcPalIoCompletion completion;
+  TEST_ASSERT_EQUAL((int)kEtcPalErrTimedOut, etcpal_io_ring_wait(ring, &completion, 1, 0));
+
+  const char message[] = "Hello, ring";
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_io_ring_send(ring, client_sock, message, sizeof message, NULL));
+  TEST_ASSERT_GREATER_THAN(0, etcpal_io_ring_submit(ring));
+
+  // Retrieve completions until the receive is reported.
+  do
+  {
+    TEST_ASSERT_EQUAL(1, etcpal_io_ring_wait(ring, &completion, 1, 1000));
+    TEST_ASSERT_EQUAL((int)sizeof message, completion.result);
+  } while (completion.op != ETCPAL_IO_OP_RECV);
+
+  TEST_ASSERT_EQUAL(server_sock, completion.socket);
+  TEST_ASSERT_EQUAL(-1, completion.buffer_index);
+  TEST_ASSERT_EQUAL_STRING(message, (const char*)recv_buf);
+
+  // A receive on a connection closed by the peer completes with 0 bytes.
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_io_ring_recv(ring, server_sock, recv_buf, sizeof recv_buf, NULL));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(client_sock));
+  int res = etcpal_io_ring_wait(ring, &completion, 1, 1000);
+  if (res == 1 && completion.op == ETCPAL_IO_OP_SEND)
+    res = etcpal_io_ring_wait(ring, &completion, 1, 1000);
+  TEST_ASSERT_EQUAL(1, res);
+  TEST_ASSERT_EQUAL(ETCPAL_IO_OP_RECV, completion.op);
+  TEST_ASSERT_EQUAL(0, completion.result);
+
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(server_sock));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(listen_sock));
+}
+
+TEST_GROUP_RUNNER(etcpal_io_ring)
+{
+  RUN_TEST_CASE(etcpal_io_ring, invalid_calls_fail);
+  RUN_TEST_CASE(etcpal_io_ring, wait_times_out);
+  RUN_TEST_CASE(etcpal_io_ring, udp_fixed_buffers_work);
+  RUN_TEST_CASE(etcpal_io_ring, tcp_send_and_recv_work);
+}
@@ -34,6 +34,7 @@ void run_all_tests(void)
 #if !DISABLE_EVENT_GROUP_TESTS
   RUN_TEST_GROUP(etcpal_event_group);
 #endif
+  RUN_TEST_GROUP(etcpal_mpmc_queue);
   RUN_TEST_GROUP(etcpal_mutex);
 #if !DISABLE_RECURSIVE_MUTEX_TESTS
   RUN_TEST_GROUP(etcpal_recursive_mutex);
@@ -41,6 +42,7 @@ void run_all_tests(void)
   RUN_TEST_GROUP(etcpal_rwlock);
   RUN_TEST_GROUP(etcpal_sem);
   RUN_TEST_GROUP(etcpal_signal);
+  RUN_TEST_GROUP(etcpal_spsc_queue);
   RUN_TEST_GROUP(etcpal_thread);
   RUN_TEST_GROUP(etcpal_timer);
 #if !DISABLE_QUEUE_TESTS
@@ -52,5 +54,15 @@ void run_all_tests(void)
   RUN_TEST_GROUP(etcpal_netint);
   RUN_TEST_GROUP(etcpal_inet);
   RUN_TEST_GROUP(etcpal_socket);
+  RUN_TEST_GROUP(etcpal_socket_stats);
+#if !ETCPAL_NO_OS_SUPPORT
+  RUN_TEST_GROUP(etcpal_connector);
+  RUN_TEST_GROUP(etcpal_mcast);
+  RUN_TEST_GROUP(etcpal_resolver);
+  RUN_TEST_GROUP(etcpal_udp_receiver);
+#endif
+#if ETCPAL_LINUX_USE_IO_URING
+  RUN_TEST_GROUP(etcpal_io_ring);
+#endif
 #endif
 }
@@ -0,0 +1,233 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+#include "etcpal/mcast.h"
+
+#include "etcpal/common.h"
+#include "etcpal/netint.h"
+#include "unity_fixture.h"
+
+#define MCAST_TEST_GROUP_BASE         0xefff2a00  // 239.255.42.0
+#define MCAST_TEST_MAX_PENDING_LEAVES 64
+
+static EtcPalMcastManager* manager;
+static etcpal_socket_t     sock;
+static EtcPalGroupReq      test_req;
+
+static EtcPalGroupReq make_req(uint32_t group_offset)
+{
+  EtcPalGroupReq req = test_req;
+  ETCPAL_IP_SET_V4_ADDRESS(&req.group, MCAST_TEST_GROUP_BASE + group_offset);
+  return req;
+}
+
+static EtcPalMcastStats get_stats(void)
+{
+  EtcPalMcastStats stats;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_mcast_get_stats(manager, &stats));
+  return stats;
+}
+
+static void create_manager(size_t max_pending_leaves)
+{
+  EtcPalMcastManagerConfig config = ETCPAL_MCAST_MANAGER_CONFIG_DEFAULT_INIT;
+  config.max_pending_leaves = max_pending_leaves;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_mcast_manager_create(&config, &manager));
+
+  // Multicast may not be available in every test environment.
+  etcpal_error_t join_res = etcpal_mcast_join(manager, sock, &test_req);
+  if (join_res != kEtcPalErrOk)
+    TEST_IGNORE_MESSAGE("Couldn't join a multicast group on the default network interface.");
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_mcast_leave(manager, sock, &test_req));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_mcast_flush_leaves(manager));
+}
+
+TEST_GROUP(etcpal_mcast);
+
+TEST_SETUP(etcpal_mcast)
+{
+  etcpal_init(ETCPAL_FEATURE_SOCKETS | ETCPAL_FEATURE_NETINTS);
+  manager = NULL;
+  sock = ETCPAL_SOCKET_INVALID;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &sock));
+
+  test_req.ifindex = 0;
+  if (etcpal_netint_get_default_interface(kEtcPalIpTypeV4, &test_req.ifindex) != kEtcPalErrOk)
+    TEST_IGNORE_MESSAGE("No default IPv4 network interface is available.");
+  ETCPAL_IP_SET_V4_ADDRESS(&test_req.group, MCAST_TEST_GROUP_BASE);
+}
+
+TEST_TEAR_DOWN(etcpal_mcast)
+{
+  if (manager)
+    etcpal_mcast_manager_destroy(manager);
+  if (sock != ETCPAL_SOCKET_INVALID)
+    etcpal_close(sock);
+  etcpal_deinit(ETCPAL_FEATURE_SOCKETS | ETCPAL_FEATURE_NETINTS);
+}
+
+TEST(etcpal_mcast, invalid_calls_fail)
+{
+  EtcPalMcastManagerConfig config = ETCPAL_MCAST_MANAGER_CONFIG_DEFAULT_INIT;
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_mcast_manager_create(NULL, &manager));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_mcast_manager_create(&config, NULL));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_mcast_manager_create(&config, &manager));
+
+  EtcPalGroupReq unicast_req = test_req;
+  ETCPAL_IP_SET_V4_ADDRESS(&unicast_req.group, 0x7f000001);
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_mcast_join(NULL, sock, &test_req));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_mcast_join(manager, ETCPAL_SOCKET_INVALID, &test_req));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_mcast_join(manager, sock, NULL));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_mcast_join(manager, sock, &unicast_req));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_mcast_join_all_netints(manager, sock, &unicast_req.group, NULL));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_mcast_leave(NULL, sock, &test_req));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_mcast_flush_leaves(NULL));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_mcast_get_stats(manager, NULL));
+
+  // Leaving a group that was never joined through the manager fails.
+  TEST_ASSERT_EQUAL(kEtcPalErrNotFound, etcpal_mcast_leave(manager, sock, &test_req));
+  TEST_ASSERT_EQUAL(kEtcPalErrNotFound, etcpal_mcast_leave_all_netints(manager, sock, &test_req.group));
+}
+
+TEST(etcpal_mcast, joins_are_reference_counted)
+{
+  create_manager(MCAST_TEST_MAX_PENDING_LEAVES);
+  EtcPalMcastStats base = get_stats();
+
+  // Only the first join reaches the network stack.
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_mcast_join(manager, sock, &test_req));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_mcast_join(manager, sock, &test_req));
+  EtcPalMcastStats stats = get_stats();
+  TEST_ASSERT_EQUAL(1u, stats.num_memberships);
+  TEST_ASSERT_EQUAL(2u, stats.num_references);
+  TEST_ASSERT_EQUAL(base.kernel_joins + 1, stats.kernel_joins);
+  TEST_ASSERT_EQUAL(base.deduplicated_joins + 1, stats.deduplicated_joins);
+
+  // Releasing the last reference queues the leave.
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_mcast_leave(manager, sock, &test_req));
+  TEST_ASSERT_EQUAL(0u, get_stats().num_pending_leaves);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_mcast_leave(manager, sock, &test_req));
+  stats = get_stats();
+  TEST_ASSERT_EQUAL(1u, stats.num_memberships);
+  TEST_ASSERT_EQUAL(0u, stats.num_references);
+  TEST_ASSERT_EQUAL(1u, stats.num_pending_leaves);
+  TEST_ASSERT_EQUAL(base.kernel_leaves, stats.kernel_leaves);
+  TEST_ASSERT_EQUAL(kEtcPalErrNotFound, etcpal_mcast_leave(manager, sock, &test_req));
+
+  // Rejoining before the flush cancels the leave.
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_mcast_join(manager, sock, &test_req));
+  stats = get_stats();
+  TEST_ASSERT_EQUAL(0u, stats.num_pending_leaves);
+  TEST_ASSERT_EQUAL(base.kernel_joins + 1, stats.kernel_joins);
+  TEST_ASSERT_EQUAL(base.cancelled_leaves + 1, stats.cancelled_leaves);
+
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_mcast_leave(manager, sock, &test_req));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_mcast_flush_leaves(manager));
+  stats = get_stats();
+  TEST_ASSERT_EQUAL(0u, stats.num_memberships);
+  TEST_ASSERT_EQUAL(0u, stats.num_pending_leaves);
+  TEST_ASSERT_EQUAL(base.kernel_leaves + 1, stats.kernel_leaves);
+  TEST_ASSERT_EQUAL(0u, stats.failed_operations);
+}
+
+TEST(etcpal_mcast, leaves_are_batched)
+{
+  create_manager(2);
+  EtcPalMcastStats base = get_stats();
+
+  for (uint32_t i = 0; i < 4; ++i)
+  {
+    EtcPalGroupReq req = make_req(i + 1);
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_mcast_join(manager, sock, &req));
+  }
+  TEST_ASSERT_EQUAL(4u, get_stats().num_memberships);
+
+  // Up to max_pending_leaves leaves are held back, including exactly max_pending_leaves; one more
+  // issues them all.
+  EtcPalGroupReq req = make_req(1);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_mcast_leave(manager, sock, &req));
+  EtcPalMcastStats stats = get_stats();
+  TEST_ASSERT_EQUAL(1u, stats.num_pending_leaves);
+  TEST_ASSERT_EQUAL(base.kernel_leaves, stats.kernel_leaves);
+
+  req = make_req(2);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_mcast_leave(manager, sock, &req));
+  stats = get_stats();
+  TEST_ASSERT_EQUAL(2u, stats.num_pending_leaves);
+  TEST_ASSERT_EQUAL(base.kernel_leaves, stats.kernel_leaves);
+
+  req = make_req(3);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_mcast_leave(manager, sock, &req));
+  stats = get_stats();
+  TEST_ASSERT_EQUAL(0u, stats.num_pending_leaves);
+  TEST_ASSERT_EQUAL(1u, stats.num_memberships);
+  TEST_ASSERT_EQUAL(base.kernel_leaves + 3, stats.kernel_leaves);
+
+  // The count starts over after a flush.
+  req = make_req(4);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_mcast_leave(manager, sock, &req));
+  stats = get_stats();
+  TEST_ASSERT_EQUAL(1u, stats.num_pending_leaves);
+  TEST_ASSERT_EQUAL(base.kernel_leaves + 3, stats.kernel_leaves);
+}
+
+TEST(etcpal_mcast, leaves_are_immediate_without_batching)
+{
+  create_manager(0);
+  EtcPalMcastStats base = get_stats();
+
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_mcast_join(manager, sock, &test_req));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_mcast_leave(manager, sock, &test_req));
+  EtcPalMcastStats stats = get_stats();
+  TEST_ASSERT_EQUAL(0u, stats.num_memberships);
+  TEST_ASSERT_EQUAL(0u, stats.num_pending_leaves);
+  TEST_ASSERT_EQUAL(base.kernel_leaves + 1, stats.kernel_leaves);
+}
+
+TEST(etcpal_mcast, remove_socket_forgets_memberships)
+{
+  create_manager(MCAST_TEST_MAX_PENDING_LEAVES);
+
+  size_t num_joined = 0;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_mcast_join_all_netints(manager, sock, &test_req.group, &num_joined));
+  TEST_ASSERT_GREATER_OR_EQUAL(1u, num_joined);
+  EtcPalGroupReq req = make_req(1);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_mcast_join(manager, sock, &req));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_mcast_leave(manager, sock, &req));
+
+  EtcPalMcastStats stats = get_stats();
+  TEST_ASSERT_EQUAL(num_joined + 1, stats.num_memberships);
+  TEST_ASSERT_EQUAL(1u, stats.num_pending_leaves);
+
+  etcpal_mcast_remove_socket(manager, sock);
+  stats = get_stats();
+  TEST_ASSERT_EQUAL(0u, stats.num_memberships);
+  TEST_ASSERT_EQUAL(0u, stats.num_references);
+  TEST_ASSERT_EQUAL(0u, stats.num_pending_leaves);
+  TEST_ASSERT_EQUAL(kEtcPalErrNotFound, etcpal_mcast_leave_all_netints(manager, sock, &test_req.group));
+}
+
+TEST_GROUP_RUNNER(etcpal_mcast)
+{
+  RUN_TEST_CASE(etcpal_mcast, invalid_calls_fail);
+  RUN_TEST_CASE(etcpal_mcast, joins_are_reference_counted);
+  RUN_TEST_CASE(etcpal_mcast, leaves_are_batched);
+  RUN_TEST_CASE(etcpal_mcast, leaves_are_immediate_without_batching);
+  RUN_TEST_CASE(etcpal_mcast, remove_socket_forgets_memberships);
+}
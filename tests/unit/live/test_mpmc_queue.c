@@ -0,0 +1,212 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+#include "etcpal/mpmc_queue.h"
+
+#include <stddef.h>
+#include <string.h>
+#include "etcpal/thread.h"
+#include "unity_fixture.h"
+
+#define NUM_PRODUCERS 4
+#define NUM_CONSUMERS 4
+#define ITEMS_PER_PRODUCER 25000
+#define ITEMS_PER_CONSUMER (NUM_PRODUCERS * ITEMS_PER_PRODUCER / NUM_CONSUMERS)
+
+// Items sent by the threaded test: the producer index in the top byte, and a sequence number below.
+#define MAKE_ITEM(producer, seq) (((uint32_t)(producer) << 24) | (uint32_t)(seq))
+#define ITEM_PRODUCER(item) ((item) >> 24)
+#define ITEM_SEQ(item) ((item)&0xffffffu)
+
+typedef struct ConsumerResult
+{
+  uint32_t num_received[NUM_PRODUCERS];
+  bool     out_of_order;
+} ConsumerResult;
+
+static EtcPalMpmcQueue queue;
+static ConsumerResult  consumer_results[NUM_CONSUMERS];
+
+static void send_sequence(void* arg)
+{
+  uint32_t producer = (uint32_t)(uintptr_t)arg;
+  for (uint32_t i = 0; i < ITEMS_PER_PRODUCER; ++i)
+  {
+    uint32_t item = MAKE_ITEM(producer, i);
+    etcpal_mpmc_queue_send(&queue, &item);
+  }
+}
+
+static void receive_items(void* arg)
+{
+  ConsumerResult* result = (ConsumerResult*)arg;
+
+  // Items from each producer are received in the order they were sent, even when they are spread
+  // across several consumers.
+  uint32_t next_min_seq[NUM_PRODUCERS] = {0};
+  for (uint32_t i = 0; i < ITEMS_PER_CONSUMER; ++i)
+  {
+    uint32_t item = 0;
+    if (!etcpal_mpmc_queue_receive(&queue, &item) || ITEM_PRODUCER(item) >= NUM_PRODUCERS)
+    {
+      result->out_of_order = true;
+      return;
+    }
+    uint32_t producer = ITEM_PRODUCER(item);
+    if (ITEM_SEQ(item) < next_min_seq[producer])
+      result->out_of_order = true;
+    next_min_seq[producer] = ITEM_SEQ(item) + 1;
+    ++result->num_received[producer];
+  }
+}
+
+TEST_GROUP(etcpal_mpmc_queue);
+
+TEST_SETUP(etcpal_mpmc_queue)
+{
+}
+
+TEST_TEAR_DOWN(etcpal_mpmc_queue)
+{
+  etcpal_mpmc_queue_destroy(&queue);
+}
+
+TEST(etcpal_mpmc_queue, invalid_calls_fail)
+{
+  TEST_ASSERT_FALSE(etcpal_mpmc_queue_create(NULL, 4, sizeof(int), false));
+  TEST_ASSERT_FALSE(etcpal_mpmc_queue_create(&queue, 0, sizeof(int), false));
+  TEST_ASSERT_FALSE(etcpal_mpmc_queue_create(&queue, 4, 0, false));
+
+  TEST_ASSERT_TRUE(etcpal_mpmc_queue_create(&queue, 4, sizeof(int), false));
+  int data = 0;
+  TEST_ASSERT_FALSE(etcpal_mpmc_queue_try_send(NULL, &data));
+  TEST_ASSERT_FALSE(etcpal_mpmc_queue_try_send(&queue, NULL));
+  TEST_ASSERT_FALSE(etcpal_mpmc_queue_try_receive(NULL, &data));
+  TEST_ASSERT_FALSE(etcpal_mpmc_queue_try_receive(&queue, NULL));
+}
+
+TEST(etcpal_mpmc_queue, capacity_rounds_up_to_power_of_two)
+{
+  TEST_ASSERT_TRUE(etcpal_mpmc_queue_create(&queue, 1, sizeof(int), false));
+  TEST_ASSERT_EQUAL_UINT(2u, etcpal_mpmc_queue_capacity(&queue));
+  etcpal_mpmc_queue_destroy(&queue);
+
+  TEST_ASSERT_TRUE(etcpal_mpmc_queue_create(&queue, 5, sizeof(int), false));
+  TEST_ASSERT_EQUAL_UINT(8u, etcpal_mpmc_queue_capacity(&queue));
+}
+
+TEST(etcpal_mpmc_queue, items_come_out_in_order_across_wraparound)
+{
+  // An odd item size checks that the slots stay aligned.
+  char item[5];
+  TEST_ASSERT_TRUE(etcpal_mpmc_queue_create(&queue, 4, sizeof item, false));
+  TEST_ASSERT_TRUE(etcpal_mpmc_queue_is_empty(&queue));
+
+  char next_sent = 0;
+  char next_received = 0;
+  for (int round = 0; round < 3; ++round)
+  {
+    // Fill the queue, then take out some of the items so that the next round wraps around.
+    memset(item, next_sent, sizeof item);
+    while (etcpal_mpmc_queue_try_send(&queue, item))
+      memset(item, ++next_sent, sizeof item);
+    TEST_ASSERT_EQUAL_UINT(4u, etcpal_mpmc_queue_slots_used(&queue));
+
+    for (int i = 0; i < 3; ++i)
+    {
+      TEST_ASSERT_TRUE(etcpal_mpmc_queue_try_receive(&queue, item));
+      TEST_ASSERT_EACH_EQUAL_INT8(next_received, item, sizeof item);
+      ++next_received;
+    }
+    TEST_ASSERT_EQUAL_UINT(1u, etcpal_mpmc_queue_slots_used(&queue));
+  }
+
+  TEST_ASSERT_TRUE(etcpal_mpmc_queue_try_receive(&queue, item));
+  TEST_ASSERT_EACH_EQUAL_INT8(next_received, item, sizeof item);
+  TEST_ASSERT_FALSE(etcpal_mpmc_queue_try_receive(&queue, item));
+  TEST_ASSERT_TRUE(etcpal_mpmc_queue_is_empty(&queue));
+}
+
+TEST(etcpal_mpmc_queue, non_blocking_queue_does_not_wait)
+{
+  TEST_ASSERT_TRUE(etcpal_mpmc_queue_create(&queue, 2, sizeof(int), false));
+
+  int data = 42;
+  TEST_ASSERT_FALSE(etcpal_mpmc_queue_receive(&queue, &data));
+  TEST_ASSERT_TRUE(etcpal_mpmc_queue_send(&queue, &data));
+  TEST_ASSERT_TRUE(etcpal_mpmc_queue_send(&queue, &data));
+  TEST_ASSERT_FALSE(etcpal_mpmc_queue_send(&queue, &data));
+}
+
+TEST(etcpal_mpmc_queue, zero_timeout_does_not_wait)
+{
+  TEST_ASSERT_TRUE(etcpal_mpmc_queue_create(&queue, 2, sizeof(int), true));
+
+  int data = 42;
+  TEST_ASSERT_FALSE(etcpal_mpmc_queue_timed_receive(&queue, &data, 0));
+  TEST_ASSERT_TRUE(etcpal_mpmc_queue_timed_send(&queue, &data, 0));
+  TEST_ASSERT_TRUE(etcpal_mpmc_queue_timed_send(&queue, &data, 0));
+  TEST_ASSERT_FALSE(etcpal_mpmc_queue_timed_send(&queue, &data, 0));
+#if ETCPAL_MPMC_QUEUE_HAS_TIMED_FUNCTIONS
+  TEST_ASSERT_FALSE(etcpal_mpmc_queue_timed_send(&queue, &data, 10));
+#endif
+}
+
+TEST(etcpal_mpmc_queue, many_producers_and_consumers_work)
+{
+  // A small queue makes both sides wait often: the producers when it is full, and the consumers when
+  // it is empty.
+  TEST_ASSERT_TRUE(etcpal_mpmc_queue_create(&queue, 8, sizeof(uint32_t), true));
+  memset(consumer_results, 0, sizeof consumer_results);
+
+  EtcPalThreadParams params = ETCPAL_THREAD_PARAMS_INIT;
+  etcpal_thread_t    consumers[NUM_CONSUMERS];
+  etcpal_thread_t    producers[NUM_PRODUCERS];
+  for (size_t i = 0; i < NUM_CONSUMERS; ++i)
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_thread_create(&consumers[i], &params, receive_items, &consumer_results[i]));
+  for (size_t i = 0; i < NUM_PRODUCERS; ++i)
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_thread_create(&producers[i], &params, send_sequence, (void*)(uintptr_t)i));
+
+  for (size_t i = 0; i < NUM_PRODUCERS; ++i)
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_thread_join(&producers[i]));
+  for (size_t i = 0; i < NUM_CONSUMERS; ++i)
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_thread_join(&consumers[i]));
+
+  for (size_t producer = 0; producer < NUM_PRODUCERS; ++producer)
+  {
+    uint32_t total = 0;
+    for (size_t consumer = 0; consumer < NUM_CONSUMERS; ++consumer)
+    {
+      TEST_ASSERT_FALSE(consumer_results[consumer].out_of_order);
+      total += consumer_results[consumer].num_received[producer];
+    }
+    TEST_ASSERT_EQUAL_UINT32(ITEMS_PER_PRODUCER, total);
+  }
+  TEST_ASSERT_TRUE(etcpal_mpmc_queue_is_empty(&queue));
+}
+
+TEST_GROUP_RUNNER(etcpal_mpmc_queue)
+{
+  RUN_TEST_CASE(etcpal_mpmc_queue, invalid_calls_fail);
+  RUN_TEST_CASE(etcpal_mpmc_queue, capacity_rounds_up_to_power_of_two);
+  RUN_TEST_CASE(etcpal_mpmc_queue, items_come_out_in_order_across_wraparound);
+  RUN_TEST_CASE(etcpal_mpmc_queue, non_blocking_queue_does_not_wait);
+  RUN_TEST_CASE(etcpal_mpmc_queue, zero_timeout_does_not_wait);
+  RUN_TEST_CASE(etcpal_mpmc_queue, many_producers_and_consumers_work);
+}
@@ -129,10 +129,162 @@ TEST(etcpal_queue, can_detect_empty)
   etcpal_queue_destroy(&queue);
 }
 
+TEST(etcpal_queue, can_send_and_receive_many)
+{
+  etcpal_queue_t queue;
+
+  // Create queue for 5 uint16_ts
+  TEST_ASSERT_TRUE(etcpal_queue_create(&queue, 5, sizeof(uint16_t)));
+
+  const uint16_t items[7] = {0x0102, 0x0304, 0x0506, 0x0708, 0x090a, 0x0b0c, 0x0d0e};
+  uint16_t       received[7] = {0};
+
+  // Only as many items as there is room for are sent.
+  TEST_ASSERT_EQUAL_UINT(3u, etcpal_queue_send_many(&queue, items, 3, 0));
+  TEST_ASSERT_EQUAL_UINT(2u, etcpal_queue_send_many(&queue, &items[3], 4, 0));
+  TEST_ASSERT_EQUAL_UINT(0u, etcpal_queue_send_many(&queue, &items[5], 2, 0));
+  TEST_ASSERT_EQUAL_UINT(5u, etcpal_queue_slots_used(&queue));
+
+  // Free up some room, then send a batch which wraps around the end of the queue's storage.
+  TEST_ASSERT_EQUAL_UINT(4u, etcpal_queue_receive_many(&queue, received, 4, 0));
+  TEST_ASSERT_EQUAL_UINT16_ARRAY(items, received, 4);
+  TEST_ASSERT_EQUAL_UINT(2u, etcpal_queue_send_many(&queue, &items[5], 2, 0));
+
+  // The items come out in order, across the wraparound, and mix with single receives.
+  TEST_ASSERT_EQUAL_UINT(2u, etcpal_queue_receive_many(&queue, received, 2, 0));
+  TEST_ASSERT_EQUAL_UINT16_ARRAY(&items[4], received, 2);
+  uint16_t data = 0;
+  TEST_ASSERT_TRUE(etcpal_queue_timed_receive(&queue, &data, 0));
+  TEST_ASSERT_EQUAL_UINT16(items[6], data);
+
+  TEST_ASSERT_EQUAL_UINT(0u, etcpal_queue_receive_many(&queue, received, 7, 0));
+  TEST_ASSERT_TRUE(etcpal_queue_is_empty(&queue));
+
+  // Invalid arguments
+  TEST_ASSERT_EQUAL_UINT(0u, etcpal_queue_send_many(NULL, items, 1, 0));
+  TEST_ASSERT_EQUAL_UINT(0u, etcpal_queue_send_many(&queue, NULL, 1, 0));
+  TEST_ASSERT_EQUAL_UINT(0u, etcpal_queue_receive_many(NULL, received, 1, 0));
+  TEST_ASSERT_EQUAL_UINT(0u, etcpal_queue_receive_many(&queue, NULL, 1, 0));
+
+  etcpal_queue_destroy(&queue);
+}
+
+TEST(etcpal_queue, can_reserve_and_peek_in_place)
+{
+#if ETCPAL_QUEUE_HAS_IN_PLACE_FUNCTIONS
+  etcpal_queue_t queue;
+
+  // Create queue for 3 uint32_ts
+  TEST_ASSERT_TRUE(etcpal_queue_create(&queue, 3, sizeof(uint32_t)));
+
+  // An aborted reservation does not add an item.
+  uint32_t* slot = (uint32_t*)etcpal_queue_reserve(&queue, 0);
+  TEST_ASSERT_NOT_NULL(slot);
+  etcpal_queue_abort(&queue, slot);
+  TEST_ASSERT_TRUE(etcpal_queue_is_empty(&queue));
+  TEST_ASSERT_NULL(etcpal_queue_peek(&queue, 0));
+
+  // Go around the queue's storage a few times, mixing in-place and copying operations.
+  uint32_t next_sent = 0;
+  uint32_t next_received = 0;
+  for (int round = 0; round < 4; ++round)
+  {
+    for (int i = 0; i < 2; ++i)
+    {
+      slot = (uint32_t*)etcpal_queue_reserve(&queue, 0);
+      TEST_ASSERT_NOT_NULL(slot);
+      *slot = next_sent++;
+      etcpal_queue_commit(&queue, slot);
+    }
+    TEST_ASSERT_TRUE(etcpal_queue_timed_send(&queue, &next_sent, 0));
+    ++next_sent;
+    TEST_ASSERT_TRUE(etcpal_queue_is_full(&queue));
+    TEST_ASSERT_NULL(etcpal_queue_reserve(&queue, 0));
+
+    uint32_t data = 0;
+    TEST_ASSERT_TRUE(etcpal_queue_timed_receive(&queue, &data, 0));
+    TEST_ASSERT_EQUAL_UINT32(next_received++, data);
+    for (int i = 0; i < 2; ++i)
+    {
+      const uint32_t* item = (const uint32_t*)etcpal_queue_peek(&queue, 0);
+      TEST_ASSERT_NOT_NULL(item);
+      TEST_ASSERT_EQUAL_UINT32(next_received++, *item);
+      etcpal_queue_release(&queue, item);
+    }
+    TEST_ASSERT_TRUE(etcpal_queue_is_empty(&queue));
+  }
+
+  // Invalid arguments
+  TEST_ASSERT_NULL(etcpal_queue_reserve(NULL, 0));
+  TEST_ASSERT_NULL(etcpal_queue_peek(NULL, 0));
+
+  etcpal_queue_destroy(&queue);
+#else
+  TEST_IGNORE_MESSAGE("In-place queue functions are not available on this platform.");
+#endif
+}
+
+TEST(etcpal_queue, in_place_access_does_not_block_other_calls)
+{
+#if ETCPAL_QUEUE_HAS_IN_PLACE_FUNCTIONS
+  etcpal_queue_t queue;
+
+  // Create queue for 4 uint32_ts
+  TEST_ASSERT_TRUE(etcpal_queue_create(&queue, 4, sizeof(uint32_t)));
+
+  // Several slots can be reserved at once, and sends carry on while they are outstanding. Items
+  // are received in the order their slots were handed out, so nothing can be received until the
+  // first reservation is done with.
+  uint32_t* first = (uint32_t*)etcpal_queue_reserve(&queue, 0);
+  uint32_t* second = (uint32_t*)etcpal_queue_reserve(&queue, 0);
+  TEST_ASSERT_NOT_NULL(first);
+  TEST_ASSERT_NOT_NULL(second);
+  uint32_t data = 3;
+  TEST_ASSERT_TRUE(etcpal_queue_timed_send(&queue, &data, 0));
+  TEST_ASSERT_EQUAL_UINT(1u, etcpal_queue_slots_available(&queue));
+
+  *second = 2;
+  etcpal_queue_commit(&queue, second);
+  TEST_ASSERT_FALSE(etcpal_queue_timed_receive(&queue, &data, 0));
+  *first = 1;
+  etcpal_queue_commit(&queue, first);
+  TEST_ASSERT_EQUAL_UINT(3u, etcpal_queue_slots_used(&queue));
+
+  // Receives carry on while an item is being read in place.
+  const uint32_t* item = (const uint32_t*)etcpal_queue_peek(&queue, 0);
+  TEST_ASSERT_NOT_NULL(item);
+  TEST_ASSERT_EQUAL_UINT32(1, *item);
+  TEST_ASSERT_TRUE(etcpal_queue_timed_receive(&queue, &data, 0));
+  TEST_ASSERT_EQUAL_UINT32(2, data);
+  etcpal_queue_release(&queue, item);
+
+  // An aborted slot is skipped over, even with later items behind it.
+  first = (uint32_t*)etcpal_queue_reserve(&queue, 0);
+  TEST_ASSERT_NOT_NULL(first);
+  data = 4;
+  TEST_ASSERT_TRUE(etcpal_queue_timed_send(&queue, &data, 0));
+  etcpal_queue_abort(&queue, first);
+
+  uint32_t received[3] = {0};
+  TEST_ASSERT_EQUAL_UINT(2u, etcpal_queue_receive_many(&queue, received, 3, 0));
+  TEST_ASSERT_EQUAL_UINT32(3, received[0]);
+  TEST_ASSERT_EQUAL_UINT32(4, received[1]);
+  TEST_ASSERT_TRUE(etcpal_queue_is_empty(&queue));
+  TEST_ASSERT_EQUAL_UINT(4u, etcpal_queue_slots_available(&queue));
+
+  etcpal_queue_destroy(&queue);
+#else
+  TEST_IGNORE_MESSAGE("In-place queue functions are not available on this platform.");
+#endif
+}
+
 TEST_GROUP_RUNNER(etcpal_queue)
 {
   RUN_TEST_CASE(etcpal_queue, can_send_and_receive);
   RUN_TEST_CASE(etcpal_queue, will_timeout_on_send);
   RUN_TEST_CASE(etcpal_queue, will_timeout_on_receive);
   RUN_TEST_CASE(etcpal_queue, can_detect_empty);
+  RUN_TEST_CASE(etcpal_queue, can_send_and_receive_many);
+  RUN_TEST_CASE(etcpal_queue, can_reserve_and_peek_in_place);
+  RUN_TEST_CASE(etcpal_queue, in_place_access_does_not_block_other_calls);
 }
@@ -0,0 +1,306 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+#include "etcpal/resolver.h"
+
+#include <string.h>
+#include "etcpal/common.h"
+#include "etcpal/mutex.h"
+#include "etcpal/socket.h"
+#include "etcpal/timer.h"
+#include "unity_fixture.h"
+
+#define NUM_ASYNC_LOOKUPS 8
+
+// A stand-in for a hosts file, so that lookups don't depend on the network configuration.
+typedef struct TestHostsEntry
+{
+  etcpal_iptype_t type;
+  const char*     addr;
+  const char*     hostname;
+} TestHostsEntry;
+
+// clang-format off
+static const TestHostsEntry kTestHosts[] = {
+  {kEtcPalIpTypeV4, "10.101.0.1", "broker.test"},
+  {kEtcPalIpTypeV4, "10.101.0.2", "broker.test"},
+  {kEtcPalIpTypeV6, "fd00::1",    "broker.test"},
+  {kEtcPalIpTypeV4, "10.101.1.1", "host1.test"},
+  {kEtcPalIpTypeV4, "10.101.1.2", "host2.test"},
+  {kEtcPalIpTypeV4, "10.101.1.3", "host3.test"},
+};
+// clang-format on
+#define NUM_TEST_HOSTS (sizeof(kTestHosts) / sizeof(kTestHosts[0]))
+
+typedef struct AsyncResults
+{
+  etcpal_mutex_t lock;
+  size_t         num_completed;
+  size_t         num_failed;
+} AsyncResults;
+
+static EtcPalResolver* resolver;
+static etcpal_mutex_t  lookup_lock;
+static size_t          num_lookups;
+static AsyncResults    async_results;
+
+static etcpal_error_t hosts_lookup(const char* hostname, int family, EtcPalResolvedAddrs* addrs, void* context)
+{
+  // Called from the resolver's worker thread for asynchronous lookups, so no assertions here.
+  ETCPAL_UNUSED_ARG(context);
+  if (etcpal_mutex_lock(&lookup_lock))
+  {
+    ++num_lookups;
+    etcpal_mutex_unlock(&lookup_lock);
+  }
+
+  addrs->num_addrs = 0;
+  for (size_t i = 0; i < NUM_TEST_HOSTS && addrs->num_addrs < ETCPAL_RESOLVER_MAX_ADDRS; ++i)
+  {
+    const TestHostsEntry* entry = &kTestHosts[i];
+    if (strcmp(entry->hostname, hostname) != 0)
+      continue;
+    if ((family == ETCPAL_AF_INET && entry->type != kEtcPalIpTypeV4) ||
+        (family == ETCPAL_AF_INET6 && entry->type != kEtcPalIpTypeV6))
+    {
+      continue;
+    }
+    etcpal_string_to_ip(entry->type, entry->addr, &addrs->addrs[addrs->num_addrs++]);
+  }
+  return (addrs->num_addrs > 0 ? kEtcPalErrOk : kEtcPalErrNotFound);
+}
+
+static size_t get_num_lookups(void)
+{
+  size_t result = 0;
+  if (etcpal_mutex_lock(&lookup_lock))
+  {
+    result = num_lookups;
+    etcpal_mutex_unlock(&lookup_lock);
+  }
+  return result;
+}
+
+static void handle_async_result(const char*                hostname,
+                                etcpal_error_t             result,
+                                const EtcPalResolvedAddrs* addrs,
+                                void*                      context)
+{
+  AsyncResults* results = (AsyncResults*)context;
+  if (etcpal_mutex_lock(&results->lock))
+  {
+    if (result == kEtcPalErrOk && strcmp(hostname, "broker.test") == 0 && addrs->num_addrs == 2)
+      ++results->num_completed;
+    else
+      ++results->num_failed;
+    etcpal_mutex_unlock(&results->lock);
+  }
+}
+
+static size_t get_num_async_results(void)
+{
+  size_t result = 0;
+  if (etcpal_mutex_lock(&async_results.lock))
+  {
+    result = async_results.num_completed + async_results.num_failed;
+    etcpal_mutex_unlock(&async_results.lock);
+  }
+  return result;
+}
+
+static void create_resolver(unsigned int ttl_ms, unsigned int negative_ttl_ms, size_t max_entries)
+{
+  EtcPalResolverConfig config = ETCPAL_RESOLVER_CONFIG_DEFAULT_INIT;
+  config.ttl_ms = ttl_ms;
+  config.negative_ttl_ms = negative_ttl_ms;
+  config.max_entries = max_entries;
+  config.lookup_fn = hosts_lookup;
+  config.lookup_context = &num_lookups;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_resolver_create(&config, &resolver));
+}
+
+TEST_GROUP(etcpal_resolver);
+
+TEST_SETUP(etcpal_resolver)
+{
+  etcpal_init(ETCPAL_FEATURE_SOCKETS);
+  resolver = NULL;
+  num_lookups = 0;
+  memset(&async_results, 0, sizeof async_results);
+  TEST_ASSERT_TRUE(etcpal_mutex_create(&lookup_lock));
+  TEST_ASSERT_TRUE(etcpal_mutex_create(&async_results.lock));
+}
+
+TEST_TEAR_DOWN(etcpal_resolver)
+{
+  etcpal_resolver_destroy(resolver);
+  etcpal_mutex_destroy(&async_results.lock);
+  etcpal_mutex_destroy(&lookup_lock);
+  etcpal_deinit(ETCPAL_FEATURE_SOCKETS);
+}
+
+TEST(etcpal_resolver, invalid_calls_fail)
+{
+  EtcPalResolverConfig config = ETCPAL_RESOLVER_CONFIG_DEFAULT_INIT;
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_resolver_create(NULL, &resolver));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_resolver_create(&config, NULL));
+  config.max_entries = 0;
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_resolver_create(&config, &resolver));
+
+  create_resolver(60000, 5000, 16);
+
+  char long_hostname[ETCPAL_RESOLVER_MAX_HOSTNAME_LEN + 1];
+  memset(long_hostname, 'a', sizeof long_hostname);
+  long_hostname[ETCPAL_RESOLVER_MAX_HOSTNAME_LEN] = '\0';
+
+  EtcPalResolvedAddrs addrs;
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_resolver_lookup(NULL, "broker.test", ETCPAL_AF_UNSPEC, &addrs));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_resolver_lookup(resolver, NULL, ETCPAL_AF_UNSPEC, &addrs));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_resolver_lookup(resolver, "", ETCPAL_AF_UNSPEC, &addrs));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_resolver_lookup(resolver, long_hostname, ETCPAL_AF_UNSPEC, &addrs));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_resolver_lookup(resolver, "broker.test", -1, &addrs));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_resolver_lookup(resolver, "broker.test", ETCPAL_AF_UNSPEC, NULL));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_resolver_lookup_cached(resolver, "broker.test", ETCPAL_AF_UNSPEC, NULL));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid,
+                    etcpal_resolver_lookup_async(resolver, "broker.test", ETCPAL_AF_UNSPEC, NULL, NULL));
+  TEST_ASSERT_EQUAL(0u, get_num_lookups());
+}
+
+TEST(etcpal_resolver, results_are_cached)
+{
+  create_resolver(60000, 5000, 16);
+
+  EtcPalResolvedAddrs addrs;
+  TEST_ASSERT_EQUAL(kEtcPalErrNotFound, etcpal_resolver_lookup_cached(resolver, "broker.test", ETCPAL_AF_INET, &addrs));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_resolver_lookup(resolver, "broker.test", ETCPAL_AF_INET, &addrs));
+  TEST_ASSERT_EQUAL(2u, addrs.num_addrs);
+  TEST_ASSERT_EQUAL(1u, get_num_lookups());
+
+  // Repeated lookups are answered from the cache.
+  memset(&addrs, 0, sizeof addrs);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_resolver_lookup(resolver, "broker.test", ETCPAL_AF_INET, &addrs));
+  TEST_ASSERT_EQUAL(2u, addrs.num_addrs);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_resolver_lookup_cached(resolver, "broker.test", ETCPAL_AF_INET, &addrs));
+  TEST_ASSERT_EQUAL(2u, addrs.num_addrs);
+  TEST_ASSERT_EQUAL(1u, get_num_lookups());
+
+  // Each address family is cached separately.
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_resolver_lookup(resolver, "broker.test", ETCPAL_AF_UNSPEC, &addrs));
+  TEST_ASSERT_EQUAL(3u, addrs.num_addrs);
+  TEST_ASSERT_EQUAL(2u, get_num_lookups());
+
+  etcpal_resolver_flush(resolver);
+  TEST_ASSERT_EQUAL(kEtcPalErrNotFound, etcpal_resolver_lookup_cached(resolver, "broker.test", ETCPAL_AF_INET, &addrs));
+}
+
+TEST(etcpal_resolver, entries_expire)
+{
+  create_resolver(50, 5000, 16);
+
+  EtcPalResolvedAddrs addrs;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_resolver_lookup(resolver, "broker.test", ETCPAL_AF_INET, &addrs));
+  etcpal_thread_sleep(100);
+  TEST_ASSERT_EQUAL(kEtcPalErrNotFound, etcpal_resolver_lookup_cached(resolver, "broker.test", ETCPAL_AF_INET, &addrs));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_resolver_lookup(resolver, "broker.test", ETCPAL_AF_INET, &addrs));
+  TEST_ASSERT_EQUAL(2u, get_num_lookups());
+}
+
+TEST(etcpal_resolver, failures_are_cached_separately)
+{
+  create_resolver(60000, 5000, 16);
+
+  EtcPalResolvedAddrs addrs;
+  TEST_ASSERT_EQUAL(kEtcPalErrNotFound, etcpal_resolver_lookup(resolver, "missing.test", ETCPAL_AF_INET, &addrs));
+  TEST_ASSERT_EQUAL(kEtcPalErrNotFound, etcpal_resolver_lookup(resolver, "missing.test", ETCPAL_AF_INET, &addrs));
+  TEST_ASSERT_EQUAL(1u, get_num_lookups());
+
+  // Without negative caching, every failed lookup goes to the lookup function.
+  etcpal_resolver_destroy(resolver);
+  num_lookups = 0;
+  create_resolver(60000, 0, 16);
+  TEST_ASSERT_EQUAL(kEtcPalErrNotFound, etcpal_resolver_lookup(resolver, "missing.test", ETCPAL_AF_INET, &addrs));
+  TEST_ASSERT_EQUAL(kEtcPalErrNotFound, etcpal_resolver_lookup(resolver, "missing.test", ETCPAL_AF_INET, &addrs));
+  TEST_ASSERT_EQUAL(2u, get_num_lookups());
+}
+
+TEST(etcpal_resolver, cache_size_is_bounded)
+{
+  create_resolver(60000, 5000, 2);
+
+  EtcPalResolvedAddrs addrs;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_resolver_lookup(resolver, "host1.test", ETCPAL_AF_INET, &addrs));
+  etcpal_thread_sleep(5);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_resolver_lookup(resolver, "host2.test", ETCPAL_AF_INET, &addrs));
+  etcpal_thread_sleep(5);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_resolver_lookup(resolver, "host3.test", ETCPAL_AF_INET, &addrs));
+
+  // The entry closest to expiry was replaced.
+  TEST_ASSERT_EQUAL(kEtcPalErrNotFound, etcpal_resolver_lookup_cached(resolver, "host1.test", ETCPAL_AF_INET, &addrs));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_resolver_lookup_cached(resolver, "host2.test", ETCPAL_AF_INET, &addrs));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_resolver_lookup_cached(resolver, "host3.test", ETCPAL_AF_INET, &addrs));
+}
+
+TEST(etcpal_resolver, async_lookups_complete)
+{
+  create_resolver(60000, 5000, 16);
+
+  for (int i = 0; i < NUM_ASYNC_LOOKUPS; ++i)
+  {
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_resolver_lookup_async(resolver, "broker.test", ETCPAL_AF_INET,
+                                                                 handle_async_result, &async_results));
+  }
+
+  EtcPalTimer timer;
+  etcpal_timer_start(&timer, 2000);
+  while (get_num_async_results() < NUM_ASYNC_LOOKUPS && !etcpal_timer_is_expired(&timer))
+    etcpal_thread_sleep(5);
+
+  TEST_ASSERT_EQUAL(NUM_ASYNC_LOOKUPS, async_results.num_completed);
+  TEST_ASSERT_EQUAL(0u, async_results.num_failed);
+
+  // Queued lookups of the same name are answered from the cache once the first has completed.
+  TEST_ASSERT_EQUAL(1u, get_num_lookups());
+}
+
+TEST(etcpal_resolver, default_lookup_resolves_localhost)
+{
+  EtcPalResolverConfig config = ETCPAL_RESOLVER_CONFIG_DEFAULT_INIT;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_resolver_create(&config, &resolver));
+
+  EtcPalResolvedAddrs addrs;
+  etcpal_error_t      res = etcpal_resolver_lookup(resolver, "localhost", ETCPAL_AF_INET, &addrs);
+  if (res != kEtcPalErrOk)
+    TEST_IGNORE_MESSAGE("localhost could not be resolved on this system.");
+
+  TEST_ASSERT_GREATER_OR_EQUAL(1u, addrs.num_addrs);
+  TEST_ASSERT_TRUE(ETCPAL_IP_IS_V4(&addrs.addrs[0]));
+  TEST_ASSERT_EQUAL_UINT32(127u, ETCPAL_IP_V4_ADDRESS(&addrs.addrs[0]) >> 24);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_resolver_lookup_cached(resolver, "localhost", ETCPAL_AF_INET, &addrs));
+}
+
+TEST_GROUP_RUNNER(etcpal_resolver)
+{
+  RUN_TEST_CASE(etcpal_resolver, invalid_calls_fail);
+  RUN_TEST_CASE(etcpal_resolver, results_are_cached);
+  RUN_TEST_CASE(etcpal_resolver, entries_expire);
+  RUN_TEST_CASE(etcpal_resolver, failures_are_cached_separately);
+  RUN_TEST_CASE(etcpal_resolver, cache_size_is_bounded);
+  RUN_TEST_CASE(etcpal_resolver, async_lookups_complete);
+  RUN_TEST_CASE(etcpal_resolver, default_lookup_resolves_localhost);
+}
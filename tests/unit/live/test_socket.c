@@ -21,7 +21,15 @@
 #include "unity_fixture.h"
 
 #include "etcpal/netint.h"
+#include "etcpal/thread.h"
+#include "etcpal/timer.h"
 #include <stddef.h>
+#include <string.h>
+#include <time.h>
+#ifdef __linux__
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
 
 // For getaddrinfo
 #if 0
@@ -164,6 +172,41 @@ TEST(etcpal_socket, poll_add_remove_socket_works)
   TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(sock));
 }
 
+#define POLL_MANY_SOCKETS_TEST_NUM_SOCKETS 128
+
+// Test adding and removing a larger number of sockets, as well as adding the same socket twice.
+TEST(etcpal_socket, poll_add_remove_many_sockets_works)
+{
+  EtcPalPollContext context;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_context_init(&context));
+
+  etcpal_socket_t socks[POLL_MANY_SOCKETS_TEST_NUM_SOCKETS];
+  for (size_t i = 0; i < POLL_MANY_SOCKETS_TEST_NUM_SOCKETS; ++i)
+  {
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &socks[i]));
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_add_socket(&context, socks[i], ETCPAL_POLL_OUT, &socks[i]));
+  }
+
+  TEST_ASSERT_EQUAL(kEtcPalErrExists, etcpal_poll_add_socket(&context, socks[0], ETCPAL_POLL_IN, NULL));
+
+  // Remove the sockets one at a time, making sure the remaining ones are still reported correctly.
+  for (size_t i = 0; i < POLL_MANY_SOCKETS_TEST_NUM_SOCKETS; ++i)
+  {
+    EtcPalPollEvent event;
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_wait(&context, &event, 100));
+    TEST_ASSERT_EQUAL(ETCPAL_POLL_OUT, event.events);
+    TEST_ASSERT_EQUAL(event.socket, *(etcpal_socket_t*)event.user_data);
+
+    etcpal_poll_remove_socket(&context, event.socket);
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(event.socket));
+  }
+
+  EtcPalPollEvent event;
+  TEST_ASSERT_EQUAL(kEtcPalErrNoSockets, etcpal_poll_wait(&context, &event, 0));
+
+  etcpal_poll_context_deinit(&context);
+}
+
 TEST(etcpal_socket, poll_user_data_works)
 {
   etcpal_socket_t sock_1 = ETCPAL_SOCKET_INVALID;
@@ -374,6 +417,1012 @@ TEST(etcpal_socket, poll_for_writability_on_udp_sockets_works)
   etcpal_poll_context_deinit(&context);
 }
 
+// Test that a failed non-blocking connect is reported through the poll API along with the socket
+// error.
+TEST(etcpal_socket, poll_for_connect_failure_reports_error)
+{
+  // Get a local port number on which nothing is listening.
+  etcpal_socket_t unused_sock = ETCPAL_SOCKET_INVALID;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_STREAM, &unused_sock));
+
+  EtcPalSockAddr connect_addr;
+  ETCPAL_IP_SET_V4_ADDRESS(&connect_addr.ip, 0x7f000001);
+  connect_addr.port = 0;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_bind(unused_sock, &connect_addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_getsockname(unused_sock, &connect_addr));
+
+  etcpal_socket_t sock = ETCPAL_SOCKET_INVALID;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_STREAM, &sock));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_setblocking(sock, false));
+
+  etcpal_error_t connect_res = etcpal_connect(sock, &connect_addr);
+  if (connect_res == kEtcPalErrInProgress || connect_res == kEtcPalErrWouldBlock)
+  {
+    EtcPalPollContext context;
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_context_init(&context));
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_add_socket(&context, sock, ETCPAL_POLL_CONNECT, NULL));
+
+    EtcPalPollEvent event;
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_wait(&context, &event, 1000));
+    TEST_ASSERT_EQUAL(sock, event.socket);
+    TEST_ASSERT_BITS_HIGH(ETCPAL_POLL_ERR, event.events);
+    TEST_ASSERT_EQUAL(kEtcPalErrConnRefused, event.err);
+
+    etcpal_poll_context_deinit(&context);
+  }
+  else
+  {
+    // Some stacks report the failure immediately on loopback.
+    TEST_ASSERT_EQUAL(kEtcPalErrConnRefused, connect_res);
+  }
+
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(sock));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(unused_sock));
+}
+
+#define POLL_WAIT_MANY_TEST_PORT_BASE 9100
+#define POLL_WAIT_MANY_TEST_NUM_SOCKETS 4
+
+// Test that etcpal_poll_wait_many() reports events on several sockets and respects max_events.
+TEST(etcpal_socket, poll_wait_many_works)
+{
+  etcpal_socket_t send_sock = ETCPAL_SOCKET_INVALID;
+  etcpal_socket_t rcvsocks[POLL_WAIT_MANY_TEST_NUM_SOCKETS];
+
+  EtcPalPollContext context;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_context_init(&context));
+
+  EtcPalPollEvent events[POLL_WAIT_MANY_TEST_NUM_SOCKETS];
+  TEST_ASSERT_EQUAL(kEtcPalErrNoSockets, etcpal_poll_wait_many(&context, events, POLL_WAIT_MANY_TEST_NUM_SOCKETS, 0));
+
+  EtcPalSockAddr bind_addr;
+  etcpal_ip_set_wildcard(kEtcPalIpTypeV4, &bind_addr.ip);
+  for (size_t i = 0; i < POLL_WAIT_MANY_TEST_NUM_SOCKETS; ++i)
+  {
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &rcvsocks[i]));
+    bind_addr.port = (uint16_t)(POLL_WAIT_MANY_TEST_PORT_BASE + i);
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_bind(rcvsocks[i], &bind_addr));
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_add_socket(&context, rcvsocks[i], ETCPAL_POLL_IN, (void*)(i + 1)));
+  }
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &send_sock));
+
+  // Invalid calls
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_poll_wait_many(NULL, events, POLL_WAIT_MANY_TEST_NUM_SOCKETS, 0));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_poll_wait_many(&context, NULL, POLL_WAIT_MANY_TEST_NUM_SOCKETS, 0));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_poll_wait_many(&context, events, 0, 0));
+
+  // Nothing sending - should time out.
+  TEST_ASSERT_EQUAL(kEtcPalErrTimedOut, etcpal_poll_wait_many(&context, events, POLL_WAIT_MANY_TEST_NUM_SOCKETS, 100));
+
+  EtcPalSockAddr send_addr;
+  ETCPAL_IP_SET_V4_ADDRESS(&send_addr.ip, 0x7f000001);
+  for (size_t i = 0; i < POLL_WAIT_MANY_TEST_NUM_SOCKETS; ++i)
+  {
+    send_addr.port = (uint16_t)(POLL_WAIT_MANY_TEST_PORT_BASE + i);
+    etcpal_sendto(send_sock, (const uint8_t*)"test message", sizeof("test message"), 0, &send_addr);
+  }
+
+  // A max_events of 1 must never report more than one event.
+  TEST_ASSERT_EQUAL(1, etcpal_poll_wait_many(&context, events, 1, 1000));
+
+  // Collect the events for every socket; there is no guarantee that all of the datagrams arrive
+  // before the first wait, so wait until each socket has been reported.
+  bool socket_seen[POLL_WAIT_MANY_TEST_NUM_SOCKETS] = {false};
+  for (size_t num_seen = 0; num_seen < POLL_WAIT_MANY_TEST_NUM_SOCKETS;)
+  {
+    int res = etcpal_poll_wait_many(&context, events, POLL_WAIT_MANY_TEST_NUM_SOCKETS, 1000);
+    TEST_ASSERT_GREATER_THAN_INT(0, res);
+    TEST_ASSERT_LESS_OR_EQUAL_INT(POLL_WAIT_MANY_TEST_NUM_SOCKETS, res);
+
+    for (const EtcPalPollEvent* event = events; event < events + res; ++event)
+    {
+      size_t index = (size_t)event->user_data - 1;
+      TEST_ASSERT_LESS_THAN(POLL_WAIT_MANY_TEST_NUM_SOCKETS, index);
+      TEST_ASSERT_EQUAL(rcvsocks[index], event->socket);
+      TEST_ASSERT_EQUAL(ETCPAL_POLL_IN, event->events);
+      TEST_ASSERT_EQUAL(kEtcPalErrOk, event->err);
+
+      // Drain the socket so that it is only reported once.
+      uint8_t recv_buf[sizeof("test message")];
+      int     recv_res = etcpal_recvfrom(event->socket, recv_buf, sizeof recv_buf, 0, NULL);
+      TEST_ASSERT_EQUAL(sizeof("test message"), (size_t)recv_res);
+      TEST_ASSERT_FALSE(socket_seen[index]);
+      socket_seen[index] = true;
+      ++num_seen;
+    }
+  }
+
+  for (size_t i = 0; i < POLL_WAIT_MANY_TEST_NUM_SOCKETS; ++i)
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(rcvsocks[i]));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(send_sock));
+  etcpal_poll_context_deinit(&context);
+}
+
+typedef struct PollWakeTestWaiter
+{
+  EtcPalPollContext* context;
+  etcpal_error_t     result;
+} PollWakeTestWaiter;
+
+static void poll_wake_test_thread(void* arg)
+{
+  PollWakeTestWaiter* waiter = (PollWakeTestWaiter*)arg;
+  EtcPalPollEvent     event;
+  waiter->result = etcpal_poll_wait(waiter->context, &event, ETCPAL_WAIT_FOREVER);
+}
+
+// Test that etcpal_poll_context_wake() interrupts a wait, and that wakeups are reported correctly
+// relative to socket events.
+TEST(etcpal_socket, poll_context_wake_works)
+{
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_poll_context_wake(NULL));
+
+  EtcPalPollContext context;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_context_init(&context));
+
+  etcpal_error_t wake_res = etcpal_poll_context_wake(&context);
+  if (wake_res == kEtcPalErrNotImpl)
+  {
+    etcpal_poll_context_deinit(&context);
+    TEST_IGNORE_MESSAGE("etcpal_poll_context_wake() is not implemented on this platform.");
+  }
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, wake_res);
+
+  // A wait on an empty context does not block, so a wakeup signaled then stays pending until a
+  // socket is added.
+  EtcPalPollEvent event;
+  TEST_ASSERT_EQUAL(kEtcPalErrNoSockets, etcpal_poll_wait(&context, &event, ETCPAL_WAIT_FOREVER));
+
+  etcpal_socket_t sock = ETCPAL_SOCKET_INVALID;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &sock));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_add_socket(&context, sock, ETCPAL_POLL_IN, NULL));
+  TEST_ASSERT_EQUAL(kEtcPalErrWoken, etcpal_poll_wait(&context, &event, 0));
+
+  // A wakeup signaled before the wait is reported immediately, and multiple wakeups are coalesced.
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_context_wake(&context));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_context_wake(&context));
+  TEST_ASSERT_EQUAL(kEtcPalErrWoken, etcpal_poll_wait(&context, &event, ETCPAL_WAIT_FOREVER));
+  TEST_ASSERT_EQUAL(kEtcPalErrTimedOut, etcpal_poll_wait(&context, &event, 0));
+
+  // Socket events are reported before a wakeup that is pending at the same time.
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_modify_socket(&context, sock, ETCPAL_POLL_OUT, NULL));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_context_wake(&context));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_wait(&context, &event, 100));
+  TEST_ASSERT_EQUAL(sock, event.socket);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_modify_socket(&context, sock, ETCPAL_POLL_IN, NULL));
+  TEST_ASSERT_EQUAL(kEtcPalErrWoken, etcpal_poll_wait(&context, &event, 100));
+
+  // A thread blocked indefinitely is woken from another thread.
+  PollWakeTestWaiter waiter = {&context, kEtcPalErrOk};
+  EtcPalThreadParams params = ETCPAL_THREAD_PARAMS_INIT;
+  etcpal_thread_t    thread;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_thread_create(&thread, &params, poll_wake_test_thread, &waiter));
+  etcpal_thread_sleep(50);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_context_wake(&context));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_thread_join(&thread));
+  TEST_ASSERT_EQUAL(kEtcPalErrWoken, waiter.result);
+
+  etcpal_poll_remove_socket(&context, sock);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(sock));
+  etcpal_poll_context_deinit(&context);
+}
+
+// A socket which stays ready must not put off a wakeup indefinitely.
+TEST(etcpal_socket, poll_context_wake_not_starved_by_ready_socket)
+{
+  EtcPalPollContext context;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_context_init(&context));
+
+  etcpal_socket_t sock = ETCPAL_SOCKET_INVALID;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &sock));
+
+  EtcPalSockAddr bind_addr;
+  ETCPAL_IP_SET_V4_ADDRESS(&bind_addr.ip, 0x7f000001);
+  bind_addr.port = 0;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_bind(sock, &bind_addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_getsockname(sock, &bind_addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_add_socket(&context, sock, ETCPAL_POLL_IN, NULL));
+
+  // The datagram is never read, so the socket stays readable for the rest of the test.
+  TEST_ASSERT_EQUAL(4, etcpal_sendto(sock, (const uint8_t*)"test", 4, 0, &bind_addr));
+  EtcPalPollEvent events[4];
+  TEST_ASSERT_EQUAL(1, etcpal_poll_wait_many(&context, events, 4, 1000));
+  TEST_ASSERT_EQUAL(sock, events[0].socket);
+
+  etcpal_error_t wake_res = etcpal_poll_context_wake(&context);
+  if (wake_res == kEtcPalErrNotImpl)
+  {
+    etcpal_poll_remove_socket(&context, sock);
+    etcpal_close(sock);
+    etcpal_poll_context_deinit(&context);
+    TEST_IGNORE_MESSAGE("etcpal_poll_context_wake() is not implemented on this platform.");
+  }
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, wake_res);
+
+  for (int i = 0; i < 10; ++i)
+  {
+    if (i > 0)
+      TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_context_wake(&context));
+
+    // The wakeup is reported by the first wait, or by the second one if the first reports the socket.
+    int res = etcpal_poll_wait_many(&context, events, 4, 1000);
+    if (res != (int)kEtcPalErrWoken)
+    {
+      TEST_ASSERT_EQUAL(1, res);
+      TEST_ASSERT_EQUAL(sock, events[0].socket);
+      TEST_ASSERT_EQUAL(kEtcPalErrWoken, etcpal_poll_wait_many(&context, events, 4, 1000));
+    }
+
+    // The wakeup is only reported once, after which the socket is reported again.
+    TEST_ASSERT_EQUAL(1, etcpal_poll_wait_many(&context, events, 4, 1000));
+    TEST_ASSERT_EQUAL(sock, events[0].socket);
+  }
+
+  etcpal_poll_remove_socket(&context, sock);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(sock));
+  etcpal_poll_context_deinit(&context);
+}
+
+#define POLL_CONCURRENT_TEST_NUM_SOCKETS    8
+#define POLL_CONCURRENT_TEST_NUM_ITERATIONS 200
+
+typedef struct PollConcurrentTestWaiter
+{
+  EtcPalPollContext* context;
+  etcpal_socket_t*   socks;
+  size_t             num_events;
+  size_t             num_errors;
+} PollConcurrentTestWaiter;
+
+static void poll_concurrent_test_thread(void* arg)
+{
+  PollConcurrentTestWaiter* waiter = (PollConcurrentTestWaiter*)arg;
+  EtcPalPollEvent           events[POLL_CONCURRENT_TEST_NUM_SOCKETS];
+  while (true)
+  {
+    int res = etcpal_poll_wait_many(waiter->context, events, POLL_CONCURRENT_TEST_NUM_SOCKETS, ETCPAL_WAIT_FOREVER);
+    if (res == kEtcPalErrWoken)
+      break;
+    if (res == kEtcPalErrNoSockets)
+    {
+      etcpal_thread_sleep(1);
+      continue;
+    }
+    if (res <= 0)
+    {
+      ++waiter->num_errors;
+      break;
+    }
+
+    for (const EtcPalPollEvent* event = events; event < events + res; ++event)
+    {
+      // The user data must always be consistent with the socket it was registered with.
+      size_t index = (size_t)event->user_data - 1;
+      if (index >= POLL_CONCURRENT_TEST_NUM_SOCKETS || waiter->socks[index] != event->socket)
+        ++waiter->num_errors;
+
+      uint8_t recv_buf[8];
+      while (etcpal_recvfrom(event->socket, recv_buf, sizeof recv_buf, 0, NULL) > 0)
+      {
+      }
+      ++waiter->num_events;
+    }
+  }
+}
+
+// Test that sockets can be added to and removed from a poll context while another thread is
+// waiting on it.
+TEST(etcpal_socket, poll_concurrent_modification_works)
+{
+  EtcPalPollContext context;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_context_init(&context));
+
+  // The waiter thread is stopped with a wakeup.
+  if (etcpal_poll_context_wake(&context) == kEtcPalErrNotImpl)
+  {
+    etcpal_poll_context_deinit(&context);
+    TEST_IGNORE_MESSAGE("etcpal_poll_context_wake() is not implemented on this platform.");
+  }
+
+  etcpal_socket_t socks[POLL_CONCURRENT_TEST_NUM_SOCKETS];
+  EtcPalSockAddr  addrs[POLL_CONCURRENT_TEST_NUM_SOCKETS];
+  for (size_t i = 0; i < POLL_CONCURRENT_TEST_NUM_SOCKETS; ++i)
+  {
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &socks[i]));
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_setblocking(socks[i], false));
+    ETCPAL_IP_SET_V4_ADDRESS(&addrs[i].ip, 0x7f000001);
+    addrs[i].port = 0;
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_bind(socks[i], &addrs[i]));
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_getsockname(socks[i], &addrs[i]));
+  }
+  etcpal_socket_t send_sock;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &send_sock));
+
+  // Consume the wakeup from the support check above.
+  EtcPalPollEvent event;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_add_socket(&context, socks[0], ETCPAL_POLL_IN, NULL));
+  TEST_ASSERT_EQUAL(kEtcPalErrWoken, etcpal_poll_wait(&context, &event, 0));
+  etcpal_poll_remove_socket(&context, socks[0]);
+
+  PollConcurrentTestWaiter waiter = {&context, socks, 0, 0};
+  EtcPalThreadParams       params = ETCPAL_THREAD_PARAMS_INIT;
+  etcpal_thread_t          thread;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_thread_create(&thread, &params, poll_concurrent_test_thread, &waiter));
+
+  for (size_t iteration = 0; iteration < POLL_CONCURRENT_TEST_NUM_ITERATIONS; ++iteration)
+  {
+    for (size_t i = 0; i < POLL_CONCURRENT_TEST_NUM_SOCKETS; ++i)
+    {
+      TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_add_socket(&context, socks[i], ETCPAL_POLL_IN, (void*)(i + 1)));
+      etcpal_sendto(send_sock, (const uint8_t*)"test", 4, 0, &addrs[i]);
+    }
+    for (size_t i = 0; i < POLL_CONCURRENT_TEST_NUM_SOCKETS; ++i)
+      etcpal_poll_remove_socket(&context, socks[i]);
+  }
+
+  // Leave one socket in the context so that the waiter blocks until it is woken.
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_add_socket(&context, socks[0], ETCPAL_POLL_IN, (void*)1));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_context_wake(&context));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_thread_join(&thread));
+  TEST_ASSERT_EQUAL(0u, waiter.num_errors);
+
+  for (size_t i = 0; i < POLL_CONCURRENT_TEST_NUM_SOCKETS; ++i)
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(socks[i]));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(send_sock));
+  etcpal_poll_context_deinit(&context);
+}
+
+// Test the edge-triggered and one-shot modes using writability, which persists on an idle UDP
+// socket and would be reported on every wait in the default level-triggered mode.
+TEST(etcpal_socket, poll_edge_and_oneshot_modes_work)
+{
+  EtcPalPollContext context;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_context_init(&context));
+
+  etcpal_socket_t sock = ETCPAL_SOCKET_INVALID;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &sock));
+
+  etcpal_error_t add_res = etcpal_poll_add_socket(&context, sock, ETCPAL_POLL_OUT | ETCPAL_POLL_ONESHOT, NULL);
+  if (add_res == kEtcPalErrNotImpl)
+  {
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(sock));
+    etcpal_poll_context_deinit(&context);
+    TEST_IGNORE_MESSAGE("Edge-triggered and one-shot poll modes are not implemented on this platform.");
+  }
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, add_res);
+
+  // One-shot: the socket is reported once, then not again until it is re-armed.
+  EtcPalPollEvent event;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_wait(&context, &event, 100));
+  TEST_ASSERT_EQUAL(sock, event.socket);
+  TEST_ASSERT_EQUAL(ETCPAL_POLL_OUT, event.events);
+  TEST_ASSERT_EQUAL(kEtcPalErrTimedOut, etcpal_poll_wait(&context, &event, 10));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk,
+                    etcpal_poll_modify_socket(&context, sock, ETCPAL_POLL_OUT | ETCPAL_POLL_ONESHOT, NULL));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_wait(&context, &event, 100));
+  TEST_ASSERT_EQUAL(sock, event.socket);
+  TEST_ASSERT_EQUAL(kEtcPalErrTimedOut, etcpal_poll_wait(&context, &event, 10));
+
+  // Edge-triggered: the socket is reported when it becomes writable, but not again while it stays
+  // writable.
+  etcpal_poll_remove_socket(&context, sock);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_add_socket(&context, sock, ETCPAL_POLL_OUT | ETCPAL_POLL_EDGE, NULL));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_wait(&context, &event, 100));
+  TEST_ASSERT_EQUAL(sock, event.socket);
+  TEST_ASSERT_EQUAL(ETCPAL_POLL_OUT, event.events);
+  TEST_ASSERT_EQUAL(kEtcPalErrTimedOut, etcpal_poll_wait(&context, &event, 10));
+
+  etcpal_poll_remove_socket(&context, sock);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(sock));
+  etcpal_poll_context_deinit(&context);
+}
+
+// Test waiting with a spin time, combined with kernel busy polling where it is available.
+TEST(etcpal_socket, poll_spin_then_block_works)
+{
+  EtcPalPollContext context;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_context_init(&context));
+
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_poll_context_set_spin_time(NULL, 100));
+  etcpal_error_t spin_res = etcpal_poll_context_set_spin_time(&context, 2000);
+  if (spin_res == kEtcPalErrNotImpl)
+  {
+    etcpal_poll_context_deinit(&context);
+    TEST_IGNORE_MESSAGE("Spin-then-block poll waits are not implemented on this platform.");
+  }
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, spin_res);
+
+  etcpal_socket_t sock = ETCPAL_SOCKET_INVALID;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &sock));
+
+  // Busy polling is Linux-only, and raising it above the system default needs extra privileges.
+  int            busy_poll_us = 50;
+  etcpal_error_t sockopt_res =
+      etcpal_setsockopt(sock, ETCPAL_SOL_SOCKET, ETCPAL_SO_BUSY_POLL, &busy_poll_us, sizeof busy_poll_us);
+  TEST_ASSERT_TRUE(sockopt_res == kEtcPalErrOk || sockopt_res == kEtcPalErrPerm || sockopt_res == kEtcPalErrInvalid);
+  int prefer_busy_poll = 1;
+  sockopt_res = etcpal_setsockopt(sock, ETCPAL_SOL_SOCKET, ETCPAL_SO_PREFER_BUSY_POLL, &prefer_busy_poll,
+                                  sizeof prefer_busy_poll);
+  TEST_ASSERT_TRUE(sockopt_res == kEtcPalErrOk || sockopt_res == kEtcPalErrPerm || sockopt_res == kEtcPalErrInvalid);
+
+  EtcPalSockAddr bind_addr;
+  ETCPAL_IP_SET_V4_ADDRESS(&bind_addr.ip, 0x7f000001);
+  bind_addr.port = 0;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_bind(sock, &bind_addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_getsockname(sock, &bind_addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_add_socket(&context, sock, ETCPAL_POLL_IN, NULL));
+
+  // The spin counts toward the timeout, including when it is longer than the timeout.
+  EtcPalPollEvent event;
+  EtcPalTimer     timer;
+  etcpal_timer_start(&timer, 0);
+  TEST_ASSERT_EQUAL(kEtcPalErrTimedOut, etcpal_poll_wait(&context, &event, 20));
+  TEST_ASSERT_LESS_THAN_UINT32(500, etcpal_timer_elapsed(&timer));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_context_set_spin_time(&context, 1000000));
+  etcpal_timer_start(&timer, 0);
+  TEST_ASSERT_EQUAL(kEtcPalErrTimedOut, etcpal_poll_wait(&context, &event, 20));
+  TEST_ASSERT_LESS_THAN_UINT32(500, etcpal_timer_elapsed(&timer));
+
+  // Data which is ready before or during the spin is reported.
+  TEST_ASSERT_EQUAL(4, etcpal_sendto(sock, (const uint8_t*)"test", 4, 0, &bind_addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_wait(&context, &event, 1000));
+  TEST_ASSERT_EQUAL(sock, event.socket);
+  TEST_ASSERT_EQUAL(ETCPAL_POLL_IN, event.events);
+
+  etcpal_poll_remove_socket(&context, sock);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(sock));
+  etcpal_poll_context_deinit(&context);
+}
+
+#define MMSG_TEST_NUM_MSGS 40  // More than one batch on platforms that send/receive in batches
+
+// Test sending and receiving several datagrams at once over loopback.
+TEST(etcpal_socket, sendmmsg_and_recvmmsg_work)
+{
+  etcpal_socket_t send_sock = ETCPAL_SOCKET_INVALID;
+  etcpal_socket_t recv_sock = ETCPAL_SOCKET_INVALID;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &send_sock));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &recv_sock));
+
+  EtcPalSockAddr send_addr;
+  ETCPAL_IP_SET_V4_ADDRESS(&send_addr.ip, 0x7f000001);
+  send_addr.port = 0;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_bind(send_sock, &send_addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_getsockname(send_sock, &send_addr));
+
+  EtcPalSockAddr recv_addr;
+  ETCPAL_IP_SET_V4_ADDRESS(&recv_addr.ip, 0x7f000001);
+  recv_addr.port = 0;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_bind(recv_sock, &recv_addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_getsockname(recv_sock, &recv_addr));
+
+  // Make sure a lost datagram fails the test instead of hanging it.
+  int timeout_ms = 1000;
+  etcpal_error_t sockopt_res =
+      etcpal_setsockopt(recv_sock, ETCPAL_SOL_SOCKET, ETCPAL_SO_RCVTIMEO, &timeout_ms, sizeof timeout_ms);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, sockopt_res);
+
+  uint8_t       send_bufs[MMSG_TEST_NUM_MSGS][4];
+  EtcPalMmsgHdr send_msgs[MMSG_TEST_NUM_MSGS];
+  for (size_t i = 0; i < MMSG_TEST_NUM_MSGS; ++i)
+  {
+    memset(send_bufs[i], (int)i, sizeof send_bufs[i]);
+    send_msgs[i].buf = send_bufs[i];
+    send_msgs[i].len = i % sizeof send_bufs[i] + 1;  // Vary the lengths
+    send_msgs[i].addr = &recv_addr;
+    send_msgs[i].msg_len = 0;
+  }
+
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_sendmmsg(send_sock, NULL, MMSG_TEST_NUM_MSGS, 0));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_sendmmsg(send_sock, send_msgs, 0, 0));
+
+  for (size_t num_sent = 0; num_sent < MMSG_TEST_NUM_MSGS;)
+  {
+    int res = etcpal_sendmmsg(send_sock, &send_msgs[num_sent], MMSG_TEST_NUM_MSGS - num_sent, 0);
+    TEST_ASSERT_GREATER_THAN_INT(0, res);
+    for (size_t i = num_sent; i < num_sent + (size_t)res; ++i)
+      TEST_ASSERT_EQUAL(send_msgs[i].len, send_msgs[i].msg_len);
+    num_sent += (size_t)res;
+  }
+
+  uint8_t        recv_bufs[MMSG_TEST_NUM_MSGS][8];
+  EtcPalSockAddr from_addrs[MMSG_TEST_NUM_MSGS];
+  EtcPalMmsgHdr  recv_msgs[MMSG_TEST_NUM_MSGS];
+  for (size_t i = 0; i < MMSG_TEST_NUM_MSGS; ++i)
+  {
+    recv_msgs[i].buf = recv_bufs[i];
+    recv_msgs[i].len = sizeof recv_bufs[i];
+    recv_msgs[i].addr = &from_addrs[i];
+    recv_msgs[i].msg_len = 0;
+  }
+
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_recvmmsg(recv_sock, NULL, MMSG_TEST_NUM_MSGS, 0));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_recvmmsg(recv_sock, recv_msgs, 0, 0));
+
+  for (size_t num_received = 0; num_received < MMSG_TEST_NUM_MSGS;)
+  {
+    int res = etcpal_recvmmsg(recv_sock, &recv_msgs[num_received], MMSG_TEST_NUM_MSGS - num_received, 0);
+    TEST_ASSERT_GREATER_THAN_INT(0, res);
+    TEST_ASSERT_LESS_OR_EQUAL_INT(MMSG_TEST_NUM_MSGS - num_received, res);
+    num_received += (size_t)res;
+  }
+
+  // Datagrams over loopback are delivered in order.
+  for (size_t i = 0; i < MMSG_TEST_NUM_MSGS; ++i)
+  {
+    TEST_ASSERT_EQUAL(send_msgs[i].len, recv_msgs[i].msg_len);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(send_bufs[i], recv_bufs[i], recv_msgs[i].msg_len);
+    TEST_ASSERT_TRUE(etcpal_ip_and_port_equal(&send_addr, &from_addrs[i]));
+  }
+
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(send_sock));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(recv_sock));
+}
+
+// Test that peeking with etcpal_recvmmsg() returns the datagram at the head of the queue once,
+// rather than filling every message with it, and leaves it queued.
+TEST(etcpal_socket, recvmmsg_peek_returns_one_datagram)
+{
+  etcpal_socket_t sock = ETCPAL_SOCKET_INVALID;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &sock));
+
+  EtcPalSockAddr addr;
+  ETCPAL_IP_SET_V4_ADDRESS(&addr.ip, 0x7f000001);
+  addr.port = 0;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_bind(sock, &addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_getsockname(sock, &addr));
+
+  int timeout_ms = 1000;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk,
+                    etcpal_setsockopt(sock, ETCPAL_SOL_SOCKET, ETCPAL_SO_RCVTIMEO, &timeout_ms, sizeof timeout_ms));
+
+  for (uint8_t i = 0; i < 3; ++i)
+    TEST_ASSERT_EQUAL(1, etcpal_sendto(sock, &i, 1, 0, &addr));
+
+  uint8_t       recv_bufs[3][4];
+  EtcPalMmsgHdr recv_msgs[3];
+  for (size_t i = 0; i < 3; ++i)
+  {
+    recv_msgs[i].buf = recv_bufs[i];
+    recv_msgs[i].len = sizeof recv_bufs[i];
+    recv_msgs[i].addr = NULL;
+    recv_msgs[i].msg_len = 0;
+  }
+
+  TEST_ASSERT_EQUAL(1, etcpal_recvmmsg(sock, recv_msgs, 3, ETCPAL_MSG_PEEK));
+  TEST_ASSERT_EQUAL(1u, recv_msgs[0].msg_len);
+  TEST_ASSERT_EQUAL_UINT8(0, recv_bufs[0][0]);
+
+  // The peeked datagram is still first in line.
+  for (size_t num_received = 0; num_received < 3;)
+  {
+    int res = etcpal_recvmmsg(sock, &recv_msgs[num_received], 3 - num_received, 0);
+    TEST_ASSERT_GREATER_THAN_INT(0, res);
+    num_received += (size_t)res;
+  }
+  for (uint8_t i = 0; i < 3; ++i)
+    TEST_ASSERT_EQUAL_UINT8(i, recv_bufs[i][0]);
+
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(sock));
+}
+
+// Test sending and receiving a datagram made up of several buffer segments over loopback.
+TEST(etcpal_socket, sendmsg_and_recvmsg_work)
+{
+  etcpal_socket_t send_sock = ETCPAL_SOCKET_INVALID;
+  etcpal_socket_t recv_sock = ETCPAL_SOCKET_INVALID;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &send_sock));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &recv_sock));
+
+  EtcPalSockAddr send_addr;
+  ETCPAL_IP_SET_V4_ADDRESS(&send_addr.ip, 0x7f000001);
+  send_addr.port = 0;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_bind(send_sock, &send_addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_getsockname(send_sock, &send_addr));
+
+  EtcPalSockAddr recv_addr;
+  ETCPAL_IP_SET_V4_ADDRESS(&recv_addr.ip, 0x7f000001);
+  recv_addr.port = 0;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_bind(recv_sock, &recv_addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_getsockname(recv_sock, &recv_addr));
+
+  int            timeout_ms = 1000;
+  etcpal_error_t sockopt_res =
+      etcpal_setsockopt(recv_sock, ETCPAL_SOL_SOCKET, ETCPAL_SO_RCVTIMEO, &timeout_ms, sizeof timeout_ms);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, sockopt_res);
+
+  // Send a header and payload from separate buffers as a single datagram.
+  uint8_t header[] = {0x01, 0x02, 0x03};
+  uint8_t payload[] = {0x04, 0x05, 0x06, 0x07, 0x08};
+
+  EtcPalIovec  send_iov[2] = {{header, sizeof header}, {payload, sizeof payload}};
+  EtcPalMsgHdr send_msg;
+  send_msg.name = &recv_addr;
+  send_msg.iov = send_iov;
+  send_msg.iovlen = 2;
+  send_msg.control = NULL;
+  send_msg.controllen = 0;
+  send_msg.flags = 0;
+
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_sendmsg(send_sock, NULL, 0));
+  send_msg.iovlen = 0;
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_sendmsg(send_sock, &send_msg, 0));
+  send_msg.iovlen = ETCPAL_MSG_MAX_IOV + 1;
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_sendmsg(send_sock, &send_msg, 0));
+  send_msg.iovlen = 2;
+
+  TEST_ASSERT_EQUAL((int)(sizeof header + sizeof payload), etcpal_sendmsg(send_sock, &send_msg, 0));
+
+  // Receive it split across two differently-sized buffers.
+  uint8_t        recv_buf_1[4];
+  uint8_t        recv_buf_2[16];
+  EtcPalIovec    recv_iov[2] = {{recv_buf_1, sizeof recv_buf_1}, {recv_buf_2, sizeof recv_buf_2}};
+  EtcPalSockAddr from_addr;
+  EtcPalMsgHdr   recv_msg;
+  recv_msg.name = &from_addr;
+  recv_msg.iov = recv_iov;
+  recv_msg.iovlen = 2;
+  recv_msg.control = NULL;
+  recv_msg.controllen = 0;
+  recv_msg.flags = -1;
+
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_recvmsg(recv_sock, NULL, 0));
+  TEST_ASSERT_EQUAL((int)(sizeof header + sizeof payload), etcpal_recvmsg(recv_sock, &recv_msg, 0));
+  TEST_ASSERT_EQUAL(0, recv_msg.flags);
+  TEST_ASSERT_TRUE(etcpal_ip_and_port_equal(&send_addr, &from_addr));
+
+  const uint8_t expected[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08};
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, recv_buf_1, sizeof recv_buf_1);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(&expected[sizeof recv_buf_1], recv_buf_2, sizeof expected - sizeof recv_buf_1);
+
+#ifndef _WIN32
+  // A datagram larger than the buffer space supplied should be truncated and flagged.
+  TEST_ASSERT_EQUAL((int)(sizeof header + sizeof payload), etcpal_sendmsg(send_sock, &send_msg, 0));
+  recv_msg.iovlen = 1;
+  TEST_ASSERT_EQUAL((int)sizeof recv_buf_1, etcpal_recvmsg(recv_sock, &recv_msg, 0));
+  TEST_ASSERT_BITS_HIGH(ETCPAL_MSG_TRUNC, recv_msg.flags);
+#endif
+
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(send_sock));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(recv_sock));
+}
+
+// Test retrieving the destination address and interface of a received datagram.
+TEST(etcpal_socket, recvmsg_reports_pktinfo)
+{
+  etcpal_socket_t send_sock = ETCPAL_SOCKET_INVALID;
+  etcpal_socket_t recv_sock = ETCPAL_SOCKET_INVALID;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &send_sock));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &recv_sock));
+
+  // Bind to the wildcard address, so that the destination address is not implied by the socket.
+  EtcPalSockAddr recv_addr;
+  etcpal_ip_set_wildcard(kEtcPalIpTypeV4, &recv_addr.ip);
+  recv_addr.port = 0;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_bind(recv_sock, &recv_addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_getsockname(recv_sock, &recv_addr));
+
+  int            value = 1;
+  etcpal_error_t sockopt_res = etcpal_setsockopt(recv_sock, ETCPAL_IPPROTO_IP, ETCPAL_IP_PKTINFO, &value, sizeof value);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, sockopt_res);
+  int timeout_ms = 1000;
+  sockopt_res = etcpal_setsockopt(recv_sock, ETCPAL_SOL_SOCKET, ETCPAL_SO_RCVTIMEO, &timeout_ms, sizeof timeout_ms);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, sockopt_res);
+
+  EtcPalSockAddr dest_addr;
+  ETCPAL_IP_SET_V4_ADDRESS(&dest_addr.ip, 0x7f000001);
+  dest_addr.port = recv_addr.port;
+  uint8_t send_buf[] = {0x01, 0x02, 0x03, 0x04};
+  TEST_ASSERT_EQUAL((int)sizeof send_buf, etcpal_sendto(send_sock, send_buf, sizeof send_buf, 0, &dest_addr));
+
+  uint8_t      recv_buf[16];
+  union
+  {
+    uint8_t buf[ETCPAL_CONTROL_SIZE_IP_PKTINFO];
+    size_t  align;
+  } control;
+  EtcPalIovec  recv_iov = {recv_buf, sizeof recv_buf};
+  EtcPalMsgHdr recv_msg;
+  recv_msg.name = NULL;
+  recv_msg.iov = &recv_iov;
+  recv_msg.iovlen = 1;
+  recv_msg.control = control.buf;
+  recv_msg.controllen = sizeof control.buf;
+  recv_msg.flags = 0;
+
+  TEST_ASSERT_EQUAL((int)sizeof send_buf, etcpal_recvmsg(recv_sock, &recv_msg, 0));
+  TEST_ASSERT_BITS_LOW(ETCPAL_MSG_CTRUNC, recv_msg.flags);
+  TEST_ASSERT_GREATER_THAN(0, recv_msg.controllen);
+
+  bool          found_pktinfo = false;
+  EtcPalCMsgHdr cmsg;
+  EtcPalPktInfo pktinfo;
+  bool          cmsg_valid = etcpal_cmsg_firsthdr(&recv_msg, &cmsg);
+  while (cmsg_valid)
+  {
+    if (cmsg.level == ETCPAL_IPPROTO_IP && cmsg.type == ETCPAL_IP_PKTINFO)
+    {
+      TEST_ASSERT_TRUE(etcpal_cmsg_to_pktinfo(&cmsg, &pktinfo));
+      found_pktinfo = true;
+    }
+    EtcPalCMsgHdr next;
+    cmsg_valid = etcpal_cmsg_nxthdr(&recv_msg, &cmsg, &next);
+    cmsg = next;
+  }
+
+  TEST_ASSERT_TRUE(found_pktinfo);
+  TEST_ASSERT_TRUE(ETCPAL_IP_IS_V4(&pktinfo.addr));
+  TEST_ASSERT_EQUAL_UINT32(0x7f000001, ETCPAL_IP_V4_ADDRESS(&pktinfo.addr));
+  TEST_ASSERT_GREATER_THAN_UINT(0, pktinfo.ifindex);
+
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(send_sock));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(recv_sock));
+}
+
+#ifndef _WIN32
+// Test retrieving the kernel receive timestamp of a datagram.
+TEST(etcpal_socket, recvmsg_reports_timestamp)
+{
+  etcpal_socket_t sock = ETCPAL_SOCKET_INVALID;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &sock));
+
+  EtcPalSockAddr addr;
+  ETCPAL_IP_SET_V4_ADDRESS(&addr.ip, 0x7f000001);
+  addr.port = 0;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_bind(sock, &addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_getsockname(sock, &addr));
+
+  int            value = 1;
+  etcpal_error_t sockopt_res = etcpal_setsockopt(sock, ETCPAL_SOL_SOCKET, ETCPAL_SO_TIMESTAMP, &value, sizeof value);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, sockopt_res);
+  int timeout_ms = 1000;
+  sockopt_res = etcpal_setsockopt(sock, ETCPAL_SOL_SOCKET, ETCPAL_SO_RCVTIMEO, &timeout_ms, sizeof timeout_ms);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, sockopt_res);
+
+  time_t  time_before = time(NULL);
+  uint8_t send_buf[] = {0x01, 0x02, 0x03, 0x04};
+  TEST_ASSERT_EQUAL((int)sizeof send_buf, etcpal_sendto(sock, send_buf, sizeof send_buf, 0, &addr));
+
+  uint8_t      recv_buf[16];
+  union
+  {
+    uint8_t buf[ETCPAL_CONTROL_SIZE_SO_TIMESTAMP];
+    size_t  align;
+  } control;
+  EtcPalIovec  recv_iov = {recv_buf, sizeof recv_buf};
+  EtcPalMsgHdr recv_msg;
+  recv_msg.name = NULL;
+  recv_msg.iov = &recv_iov;
+  recv_msg.iovlen = 1;
+  recv_msg.control = control.buf;
+  recv_msg.controllen = sizeof control.buf;
+  recv_msg.flags = 0;
+
+  TEST_ASSERT_EQUAL((int)sizeof send_buf, etcpal_recvmsg(sock, &recv_msg, 0));
+  TEST_ASSERT_BITS_LOW(ETCPAL_MSG_CTRUNC, recv_msg.flags);
+
+  EtcPalCMsgHdr cmsg;
+  TEST_ASSERT_TRUE(etcpal_cmsg_firsthdr(&recv_msg, &cmsg));
+  TEST_ASSERT_EQUAL(ETCPAL_SOL_SOCKET, cmsg.level);
+  TEST_ASSERT_EQUAL(ETCPAL_SO_TIMESTAMP, cmsg.type);
+
+  EtcPalPktInfo pktinfo;
+  TEST_ASSERT_FALSE(etcpal_cmsg_to_pktinfo(&cmsg, &pktinfo));
+
+  EtcPalRecvTimestamp timestamp;
+  TEST_ASSERT_TRUE(etcpal_cmsg_to_timestamp(&cmsg, &timestamp));
+  TEST_ASSERT_FALSE(timestamp.hardware);
+  TEST_ASSERT_LESS_THAN_UINT32(1000000000u, timestamp.nanoseconds);
+  // The timestamp is wall-clock time at which the datagram arrived.
+  TEST_ASSERT_TRUE(timestamp.seconds >= (int64_t)time_before);
+  TEST_ASSERT_TRUE(timestamp.seconds <= (int64_t)time(NULL));
+
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(sock));
+}
+#endif
+
+#define SEGMENTED_TEST_SEGMENT_SIZE 100
+#define SEGMENTED_TEST_NUM_SEGMENTS 11
+#define SEGMENTED_TEST_LENGTH       (SEGMENTED_TEST_SEGMENT_SIZE * (SEGMENTED_TEST_NUM_SEGMENTS - 1) + 50)
+
+// Test sending a buffer as a series of datagrams, and (on Linux) receiving them coalesced.
+TEST(etcpal_socket, sendto_segmented_works)
+{
+  etcpal_socket_t send_sock = ETCPAL_SOCKET_INVALID;
+  etcpal_socket_t recv_sock = ETCPAL_SOCKET_INVALID;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &send_sock));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &recv_sock));
+
+  EtcPalSockAddr recv_addr;
+  ETCPAL_IP_SET_V4_ADDRESS(&recv_addr.ip, 0x7f000001);
+  recv_addr.port = 0;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_bind(recv_sock, &recv_addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_getsockname(recv_sock, &recv_addr));
+
+  int            timeout_ms = 1000;
+  etcpal_error_t sockopt_res =
+      etcpal_setsockopt(recv_sock, ETCPAL_SOL_SOCKET, ETCPAL_SO_RCVTIMEO, &timeout_ms, sizeof timeout_ms);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, sockopt_res);
+
+  static uint8_t send_buf[SEGMENTED_TEST_LENGTH];
+  for (size_t i = 0; i < SEGMENTED_TEST_LENGTH; ++i)
+    send_buf[i] = (uint8_t)(i / SEGMENTED_TEST_SEGMENT_SIZE);
+
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_sendto_segmented(send_sock, NULL, 10, 1, 0, &recv_addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_sendto_segmented(send_sock, send_buf, 10, 0, 0, &recv_addr));
+
+  int send_res =
+      etcpal_sendto_segmented(send_sock, send_buf, sizeof send_buf, SEGMENTED_TEST_SEGMENT_SIZE, 0, &recv_addr);
+  TEST_ASSERT_EQUAL((int)sizeof send_buf, send_res);
+
+  // Each segment should arrive as a separate datagram.
+  uint8_t recv_buf[SEGMENTED_TEST_LENGTH];
+  for (size_t i = 0; i < SEGMENTED_TEST_NUM_SEGMENTS; ++i)
+  {
+    int expected_len = (i == SEGMENTED_TEST_NUM_SEGMENTS - 1 ? 50 : SEGMENTED_TEST_SEGMENT_SIZE);
+    TEST_ASSERT_EQUAL(expected_len, etcpal_recvfrom(recv_sock, recv_buf, sizeof recv_buf, 0, NULL));
+    TEST_ASSERT_EACH_EQUAL_UINT8((uint8_t)i, recv_buf, expected_len);
+  }
+
+#ifdef __linux__
+  // With UDP_GRO enabled, the datagrams may be delivered coalesced, along with their segment size.
+  int value = 1;
+  sockopt_res = etcpal_setsockopt(recv_sock, ETCPAL_IPPROTO_UDP, ETCPAL_UDP_GRO, &value, sizeof value);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, sockopt_res);
+
+  send_res = etcpal_sendto_segmented(send_sock, send_buf, sizeof send_buf, SEGMENTED_TEST_SEGMENT_SIZE, 0, &recv_addr);
+  TEST_ASSERT_EQUAL((int)sizeof send_buf, send_res);
+
+  size_t total_received = 0;
+  while (total_received < SEGMENTED_TEST_LENGTH)
+  {
+    union
+    {
+      uint8_t buf[ETCPAL_CONTROL_SIZE_UDP_GRO];
+      size_t  align;
+    } control;
+    EtcPalIovec  recv_iov = {&recv_buf[total_received], sizeof recv_buf - total_received};
+    EtcPalMsgHdr recv_msg;
+    recv_msg.name = NULL;
+    recv_msg.iov = &recv_iov;
+    recv_msg.iovlen = 1;
+    recv_msg.control = control.buf;
+    recv_msg.controllen = sizeof control.buf;
+    recv_msg.flags = 0;
+
+    int recv_res = etcpal_recvmsg(recv_sock, &recv_msg, 0);
+    TEST_ASSERT_GREATER_THAN(0, recv_res);
+
+    EtcPalCMsgHdr cmsg;
+    size_t        segment_size = 0;
+    if (etcpal_cmsg_firsthdr(&recv_msg, &cmsg) && etcpal_cmsg_to_udp_gro(&cmsg, &segment_size))
+      TEST_ASSERT_EQUAL(SEGMENTED_TEST_SEGMENT_SIZE, segment_size);
+    total_received += (size_t)recv_res;
+  }
+  TEST_ASSERT_EQUAL(SEGMENTED_TEST_LENGTH, total_received);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(send_buf, recv_buf, SEGMENTED_TEST_LENGTH);
+#endif
+
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(send_sock));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(recv_sock));
+}
+
+#define ZEROCOPY_TEST_LENGTH 65536
+
+// Test zero-copy sends on a TCP connection and the completions they generate (Linux only; elsewhere
+// the sends copy the data).
+TEST(etcpal_socket, zerocopy_send_reports_completions)
+{
+  etcpal_socket_t listen_sock = ETCPAL_SOCKET_INVALID;
+  etcpal_socket_t send_sock = ETCPAL_SOCKET_INVALID;
+  etcpal_socket_t recv_sock = ETCPAL_SOCKET_INVALID;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_STREAM, &listen_sock));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_STREAM, &send_sock));
+
+  EtcPalSockAddr listen_addr;
+  ETCPAL_IP_SET_V4_ADDRESS(&listen_addr.ip, 0x7f000001);
+  listen_addr.port = 0;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_bind(listen_sock, &listen_addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_getsockname(listen_sock, &listen_addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_listen(listen_sock, 1));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_connect(send_sock, &listen_addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_accept(listen_sock, NULL, &recv_sock));
+
+  static uint8_t send_buf[ZEROCOPY_TEST_LENGTH];
+  static uint8_t recv_buf[ZEROCOPY_TEST_LENGTH];
+  for (size_t i = 0; i < ZEROCOPY_TEST_LENGTH; ++i)
+    send_buf[i] = (uint8_t)i;
+
+  EtcPalZerocopyCompletion completions[4];
+  TEST_ASSERT_EQUAL((int)kEtcPalErrInvalid, etcpal_read_zerocopy_completions(send_sock, NULL, 4));
+  TEST_ASSERT_EQUAL((int)kEtcPalErrInvalid, etcpal_read_zerocopy_completions(send_sock, completions, 0));
+
+  int value = 1;
+  if (etcpal_setsockopt(send_sock, ETCPAL_SOL_SOCKET, ETCPAL_SO_ZEROCOPY, &value, sizeof value) != kEtcPalErrOk)
+  {
+    // The flag is ignored and the data copied.
+    TEST_ASSERT_EQUAL(16, etcpal_send(send_sock, send_buf, 16, ETCPAL_MSG_ZEROCOPY));
+    etcpal_close(recv_sock);
+    etcpal_close(send_sock);
+    etcpal_close(listen_sock);
+    TEST_IGNORE_MESSAGE("Zero-copy sends are not supported on this system.");
+  }
+
+  EtcPalPollContext context;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_context_init(&context));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_add_socket(&context, send_sock, ETCPAL_POLL_ZEROCOPY, NULL));
+
+  // No completions are pending before the first send.
+  TEST_ASSERT_EQUAL(0, etcpal_read_zerocopy_completions(send_sock, completions, 4));
+
+  TEST_ASSERT_EQUAL(ZEROCOPY_TEST_LENGTH, etcpal_send(send_sock, send_buf, sizeof send_buf, ETCPAL_MSG_ZEROCOPY));
+
+  size_t total_received = 0;
+  while (total_received < ZEROCOPY_TEST_LENGTH)
+  {
+    int recv_res = etcpal_recv(recv_sock, &recv_buf[total_received], sizeof recv_buf - total_received, 0);
+    TEST_ASSERT_GREATER_THAN(0, recv_res);
+    total_received += (size_t)recv_res;
+  }
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(send_buf, recv_buf, ZEROCOPY_TEST_LENGTH);
+
+  // The send is numbered 0, and its completion is signaled through the poll context.
+  EtcPalPollEvent event;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_wait(&context, &event, 1000));
+  TEST_ASSERT_EQUAL(send_sock, event.socket);
+  TEST_ASSERT_BITS_HIGH(ETCPAL_POLL_ZEROCOPY, event.events);
+  TEST_ASSERT_BITS_LOW(ETCPAL_POLL_ERR, event.events);
+
+  TEST_ASSERT_EQUAL(1, etcpal_read_zerocopy_completions(send_sock, completions, 4));
+  TEST_ASSERT_EQUAL_UINT32(0u, completions[0].first);
+  TEST_ASSERT_EQUAL_UINT32(0u, completions[0].last);
+  TEST_ASSERT_EQUAL(0, etcpal_read_zerocopy_completions(send_sock, completions, 4));
+
+  etcpal_poll_context_deinit(&context);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(recv_sock));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(send_sock));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(listen_sock));
+}
+
+#ifdef __linux__
+// Asynchronous errors share the error queue with zero-copy completions, and must not be dropped.
+TEST(etcpal_socket, zerocopy_completions_report_other_errors)
+{
+  etcpal_socket_t send_sock = ETCPAL_SOCKET_INVALID;
+  etcpal_socket_t closed_sock = ETCPAL_SOCKET_INVALID;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &send_sock));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &closed_sock));
+
+  // Find a port with nothing listening on it, so that a send to it draws an ICMP error.
+  EtcPalSockAddr closed_addr;
+  ETCPAL_IP_SET_V4_ADDRESS(&closed_addr.ip, 0x7f000001);
+  closed_addr.port = 0;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_bind(closed_sock, &closed_addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_getsockname(closed_sock, &closed_addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(closed_sock));
+
+  int value = 1;
+  TEST_ASSERT_EQUAL(0, setsockopt(send_sock, IPPROTO_IP, IP_RECVERR, &value, sizeof value));
+
+  EtcPalPollContext context;
+  EtcPalPollEvent   event;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_context_init(&context));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_add_socket(&context, send_sock, ETCPAL_POLL_IN, NULL));
+
+  uint8_t send_buf[16] = {0};
+  TEST_ASSERT_EQUAL((int)sizeof send_buf, etcpal_sendto(send_sock, send_buf, sizeof send_buf, 0, &closed_addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_wait(&context, &event, 1000));
+  TEST_ASSERT_BITS_HIGH(ETCPAL_POLL_ERR, event.events);
+
+  EtcPalZerocopyCompletion completions[4];
+  TEST_ASSERT_EQUAL((int)kEtcPalErrConnRefused, etcpal_read_zerocopy_completions(send_sock, completions, 4));
+  TEST_ASSERT_EQUAL(0, etcpal_read_zerocopy_completions(send_sock, completions, 4));
+
+  etcpal_poll_context_deinit(&context);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(send_sock));
+}
+#endif
+
 TEST(etcpal_socket, getaddrinfo_works_as_expected)
 {
   EtcPalAddrinfo ai_hints;
@@ -404,9 +1453,29 @@ TEST_GROUP_RUNNER(etcpal_socket)
   RUN_TEST_CASE(etcpal_socket, blocking_state_is_consistent);
   RUN_TEST_CASE(etcpal_socket, poll_invalid_calls_fail);
   RUN_TEST_CASE(etcpal_socket, poll_add_remove_socket_works);
+  RUN_TEST_CASE(etcpal_socket, poll_add_remove_many_sockets_works);
   RUN_TEST_CASE(etcpal_socket, poll_user_data_works);
   RUN_TEST_CASE(etcpal_socket, poll_modify_socket_works);
   RUN_TEST_CASE(etcpal_socket, poll_for_readability_on_udp_sockets_works);
   RUN_TEST_CASE(etcpal_socket, poll_for_writability_on_udp_sockets_works);
+  RUN_TEST_CASE(etcpal_socket, poll_for_connect_failure_reports_error);
+  RUN_TEST_CASE(etcpal_socket, poll_wait_many_works);
+  RUN_TEST_CASE(etcpal_socket, poll_context_wake_works);
+  RUN_TEST_CASE(etcpal_socket, poll_context_wake_not_starved_by_ready_socket);
+  RUN_TEST_CASE(etcpal_socket, poll_concurrent_modification_works);
+  RUN_TEST_CASE(etcpal_socket, poll_edge_and_oneshot_modes_work);
+  RUN_TEST_CASE(etcpal_socket, poll_spin_then_block_works);
+  RUN_TEST_CASE(etcpal_socket, sendmmsg_and_recvmmsg_work);
+  RUN_TEST_CASE(etcpal_socket, recvmmsg_peek_returns_one_datagram);
+  RUN_TEST_CASE(etcpal_socket, sendmsg_and_recvmsg_work);
+  RUN_TEST_CASE(etcpal_socket, recvmsg_reports_pktinfo);
+#ifndef _WIN32
+  RUN_TEST_CASE(etcpal_socket, recvmsg_reports_timestamp);
+#endif
+  RUN_TEST_CASE(etcpal_socket, sendto_segmented_works);
+  RUN_TEST_CASE(etcpal_socket, zerocopy_send_reports_completions);
+#ifdef __linux__
+  RUN_TEST_CASE(etcpal_socket, zerocopy_completions_report_other_errors);
+#endif
   RUN_TEST_CASE(etcpal_socket, getaddrinfo_works_as_expected);
 }
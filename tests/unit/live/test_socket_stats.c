@@ -0,0 +1,248 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+#include "etcpal/socket_stats.h"
+
+#include <string.h>
+#include "etcpal/common.h"
+#include "unity_fixture.h"
+
+#define STATS_TEST_DATAGRAM_SIZE 100
+#define STATS_TEST_NUM_DATAGRAMS 3
+
+static bool            stats_enabled;
+static etcpal_socket_t send_sock;
+static etcpal_socket_t recv_sock;
+static EtcPalSockAddr  recv_addr;
+
+static uint64_t hist_total(const EtcPalPollStats* stats)
+{
+  uint64_t total = 0;
+  for (size_t i = 0; i < ETCPAL_POLL_STATS_HIST_BUCKETS; ++i)
+    total += stats->wait_time_hist[i];
+  return total;
+}
+
+TEST_GROUP(etcpal_socket_stats);
+
+TEST_SETUP(etcpal_socket_stats)
+{
+  EtcPalSocketStats stats;
+  stats_enabled = (etcpal_socket_stats_snapshot(&stats) != kEtcPalErrNotImpl);
+  if (!stats_enabled)
+  {
+    // All of the functions should report the same thing.
+    EtcPalPollStats poll_stats;
+    TEST_ASSERT_EQUAL(kEtcPalErrNotImpl, etcpal_poll_stats_snapshot(&poll_stats));
+    TEST_ASSERT_EQUAL(kEtcPalErrNotImpl, etcpal_socket_stats_track(0));
+    TEST_ASSERT_EQUAL(kEtcPalErrNotImpl, etcpal_socket_stats_untrack(0));
+    TEST_IGNORE_MESSAGE("EtcPal was built without ETCPAL_SOCKET_STATS.");
+  }
+
+  etcpal_init(ETCPAL_FEATURE_SOCKETS);
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &send_sock));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &recv_sock));
+
+  ETCPAL_IP_SET_V4_ADDRESS(&recv_addr.ip, 0x7f000001);
+  recv_addr.port = 0;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_bind(recv_sock, &recv_addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_getsockname(recv_sock, &recv_addr));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_setblocking(recv_sock, false));
+
+  etcpal_socket_stats_reset();
+}
+
+TEST_TEAR_DOWN(etcpal_socket_stats)
+{
+  if (!stats_enabled)
+    return;
+
+  etcpal_socket_stats_untrack(send_sock);
+  etcpal_socket_stats_untrack(recv_sock);
+  etcpal_close(send_sock);
+  etcpal_close(recv_sock);
+  etcpal_deinit(ETCPAL_FEATURE_SOCKETS);
+}
+
+TEST(etcpal_socket_stats, invalid_calls_fail)
+{
+  EtcPalSocketStats stats;
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_socket_stats_snapshot(NULL));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_socket_stats_snapshot_socket(recv_sock, NULL));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_socket_stats_snapshot_socket(ETCPAL_SOCKET_INVALID, &stats));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_poll_stats_snapshot(NULL));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_socket_stats_track(ETCPAL_SOCKET_INVALID));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_socket_stats_untrack(ETCPAL_SOCKET_INVALID));
+}
+
+TEST(etcpal_socket_stats, track_and_untrack_work)
+{
+  EtcPalSocketStats stats;
+  TEST_ASSERT_EQUAL(kEtcPalErrNotFound, etcpal_socket_stats_snapshot_socket(recv_sock, &stats));
+  TEST_ASSERT_EQUAL(kEtcPalErrNotFound, etcpal_socket_stats_untrack(recv_sock));
+
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket_stats_track(recv_sock));
+  TEST_ASSERT_EQUAL(kEtcPalErrExists, etcpal_socket_stats_track(recv_sock));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket_stats_track(send_sock));
+
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket_stats_snapshot_socket(recv_sock, &stats));
+  TEST_ASSERT_EQUAL_UINT64(0u, stats.messages_received);
+
+  // Untracking one socket leaves the other one reachable.
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket_stats_untrack(recv_sock));
+  TEST_ASSERT_EQUAL(kEtcPalErrNotFound, etcpal_socket_stats_snapshot_socket(recv_sock, &stats));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket_stats_snapshot_socket(send_sock, &stats));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket_stats_untrack(send_sock));
+}
+
+TEST(etcpal_socket_stats, untracked_slots_are_reused)
+{
+  // Handles which differ by 4096 share a probe sequence for any power-of-two number of tracked
+  // slots up to 4096. They are never used for I/O.
+  const etcpal_socket_t first = (etcpal_socket_t)1;
+  const etcpal_socket_t second = (etcpal_socket_t)(1 + 4096);
+  const etcpal_socket_t third = (etcpal_socket_t)(1 + 2 * 4096);
+
+  EtcPalSocketStats stats;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket_stats_track(first));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket_stats_track(second));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket_stats_track(third));
+
+  // Releasing slots at the end and the start of the sequence leaves the one in between reachable.
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket_stats_untrack(third));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket_stats_untrack(first));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket_stats_snapshot_socket(second, &stats));
+  TEST_ASSERT_EQUAL(kEtcPalErrNotFound, etcpal_socket_stats_snapshot_socket(first, &stats));
+  TEST_ASSERT_EQUAL(kEtcPalErrNotFound, etcpal_socket_stats_snapshot_socket(third, &stats));
+
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket_stats_track(third));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket_stats_snapshot_socket(second, &stats));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket_stats_snapshot_socket(third, &stats));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket_stats_untrack(second));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket_stats_untrack(third));
+
+  // Many more sockets than there are slots can be tracked and untracked in turn. The handles are
+  // chosen not to clash with recv_sock.
+  for (int i = 0; i < 1000; ++i)
+  {
+    const etcpal_socket_t other = (etcpal_socket_t)(100000 + i);
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket_stats_track(other));
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket_stats_track(recv_sock));
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket_stats_untrack(other));
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket_stats_snapshot_socket(recv_sock, &stats));
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket_stats_untrack(recv_sock));
+  }
+}
+
+#ifdef __linux__
+TEST(etcpal_socket_stats, counts_datagram_traffic)
+{
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket_stats_track(recv_sock));
+
+  uint8_t buf[STATS_TEST_DATAGRAM_SIZE];
+  memset(buf, 0xaa, sizeof buf);
+  for (int i = 0; i < STATS_TEST_NUM_DATAGRAMS; ++i)
+    TEST_ASSERT_EQUAL((int)sizeof buf, etcpal_sendto(send_sock, buf, sizeof buf, 0, &recv_addr));
+
+  // Wait for the datagrams to arrive, which is also counted as a poll wait.
+  EtcPalPollContext context;
+  EtcPalPollEvent   event;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_context_init(&context));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_add_socket(&context, recv_sock, ETCPAL_POLL_IN, NULL));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_wait(&context, &event, 1000));
+
+  for (int i = 0; i < STATS_TEST_NUM_DATAGRAMS - 1; ++i)
+    TEST_ASSERT_EQUAL((int)sizeof buf, etcpal_recvfrom(recv_sock, buf, sizeof buf, 0, NULL));
+
+  // The last datagram is received into a buffer which is too small for it.
+  EtcPalIovec  iov = {buf, STATS_TEST_DATAGRAM_SIZE / 2};
+  EtcPalMsgHdr msg;
+  memset(&msg, 0, sizeof msg);
+  msg.iov = &iov;
+  msg.iovlen = 1;
+  TEST_ASSERT_EQUAL(STATS_TEST_DATAGRAM_SIZE / 2, etcpal_recvmsg(recv_sock, &msg, 0));
+  TEST_ASSERT_BITS_HIGH(ETCPAL_MSG_TRUNC, msg.flags);
+
+  TEST_ASSERT_EQUAL((int)kEtcPalErrWouldBlock, etcpal_recvfrom(recv_sock, buf, sizeof buf, 0, NULL));
+
+  EtcPalSocketStats expected;
+  memset(&expected, 0, sizeof expected);
+  expected.messages_received = STATS_TEST_NUM_DATAGRAMS;
+  expected.bytes_received = (STATS_TEST_NUM_DATAGRAMS - 1) * STATS_TEST_DATAGRAM_SIZE + STATS_TEST_DATAGRAM_SIZE / 2;
+  expected.recv_would_block = 1;
+  expected.recv_truncated = 1;
+
+  EtcPalSocketStats stats;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket_stats_snapshot_socket(recv_sock, &stats));
+  TEST_ASSERT_EQUAL_MEMORY(&expected, &stats, sizeof stats);
+
+  // The global counters include the sends as well.
+  expected.messages_sent = STATS_TEST_NUM_DATAGRAMS;
+  expected.bytes_sent = STATS_TEST_NUM_DATAGRAMS * STATS_TEST_DATAGRAM_SIZE;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket_stats_snapshot(&stats));
+  TEST_ASSERT_EQUAL_MEMORY(&expected, &stats, sizeof stats);
+
+  EtcPalPollStats poll_stats;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_stats_snapshot(&poll_stats));
+  TEST_ASSERT_EQUAL_UINT64(1u, poll_stats.waits);
+  TEST_ASSERT_EQUAL_UINT64(1u, poll_stats.events);
+  TEST_ASSERT_EQUAL_UINT64(0u, poll_stats.timeouts);
+  TEST_ASSERT_EQUAL_UINT64(1u, hist_total(&poll_stats));
+
+  etcpal_poll_context_deinit(&context);
+}
+#endif
+
+TEST(etcpal_socket_stats, counts_poll_timeouts)
+{
+  EtcPalPollContext context;
+  EtcPalPollEvent   event;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_context_init(&context));
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_add_socket(&context, recv_sock, ETCPAL_POLL_IN, NULL));
+  TEST_ASSERT_EQUAL(kEtcPalErrTimedOut, etcpal_poll_wait(&context, &event, 20));
+
+  EtcPalPollStats stats;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_stats_snapshot(&stats));
+  TEST_ASSERT_EQUAL_UINT64(1u, stats.waits);
+  TEST_ASSERT_EQUAL_UINT64(0u, stats.events);
+  TEST_ASSERT_EQUAL_UINT64(1u, stats.timeouts);
+
+  // A 20ms wait lands in the bucket for 16384us - 32767us, or a later one on a busy machine.
+  TEST_ASSERT_EQUAL_UINT64(1u, hist_total(&stats));
+  for (size_t i = 0; i < 15; ++i)
+    TEST_ASSERT_EQUAL_UINT64(0u, stats.wait_time_hist[i]);
+
+  etcpal_socket_stats_reset();
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_poll_stats_snapshot(&stats));
+  TEST_ASSERT_EQUAL_UINT64(0u, stats.waits);
+  TEST_ASSERT_EQUAL_UINT64(0u, hist_total(&stats));
+
+  etcpal_poll_context_deinit(&context);
+}
+
+TEST_GROUP_RUNNER(etcpal_socket_stats)
+{
+  RUN_TEST_CASE(etcpal_socket_stats, invalid_calls_fail);
+  RUN_TEST_CASE(etcpal_socket_stats, track_and_untrack_work);
+  RUN_TEST_CASE(etcpal_socket_stats, untracked_slots_are_reused);
+#ifdef __linux__
+  RUN_TEST_CASE(etcpal_socket_stats, counts_datagram_traffic);
+#endif
+  RUN_TEST_CASE(etcpal_socket_stats, counts_poll_timeouts);
+}
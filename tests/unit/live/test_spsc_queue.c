@@ -0,0 +1,154 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+#include "etcpal/spsc_queue.h"
+
+#include <stddef.h>
+#include "etcpal/thread.h"
+#include "unity_fixture.h"
+
+#define NUM_THREADED_ITEMS 100000
+
+static EtcPalSpscQueue queue;
+
+static void send_sequence(void* arg)
+{
+  (void)arg;
+  for (uint32_t i = 0; i < NUM_THREADED_ITEMS; ++i)
+    etcpal_spsc_queue_send(&queue, &i);
+}
+
+TEST_GROUP(etcpal_spsc_queue);
+
+TEST_SETUP(etcpal_spsc_queue)
+{
+}
+
+TEST_TEAR_DOWN(etcpal_spsc_queue)
+{
+  etcpal_spsc_queue_destroy(&queue);
+}
+
+TEST(etcpal_spsc_queue, invalid_calls_fail)
+{
+  TEST_ASSERT_FALSE(etcpal_spsc_queue_create(NULL, 4, sizeof(int), false));
+  TEST_ASSERT_FALSE(etcpal_spsc_queue_create(&queue, 0, sizeof(int), false));
+  TEST_ASSERT_FALSE(etcpal_spsc_queue_create(&queue, 4, 0, false));
+
+  TEST_ASSERT_TRUE(etcpal_spsc_queue_create(&queue, 4, sizeof(int), false));
+  int data = 0;
+  TEST_ASSERT_FALSE(etcpal_spsc_queue_try_send(NULL, &data));
+  TEST_ASSERT_FALSE(etcpal_spsc_queue_try_send(&queue, NULL));
+  TEST_ASSERT_FALSE(etcpal_spsc_queue_try_receive(NULL, &data));
+  TEST_ASSERT_FALSE(etcpal_spsc_queue_try_receive(&queue, NULL));
+}
+
+TEST(etcpal_spsc_queue, capacity_rounds_up_to_power_of_two)
+{
+  TEST_ASSERT_TRUE(etcpal_spsc_queue_create(&queue, 5, sizeof(int), false));
+  TEST_ASSERT_EQUAL_UINT(8u, etcpal_spsc_queue_capacity(&queue));
+  etcpal_spsc_queue_destroy(&queue);
+
+  TEST_ASSERT_TRUE(etcpal_spsc_queue_create(&queue, 16, sizeof(int), false));
+  TEST_ASSERT_EQUAL_UINT(16u, etcpal_spsc_queue_capacity(&queue));
+}
+
+TEST(etcpal_spsc_queue, items_come_out_in_order_across_wraparound)
+{
+  TEST_ASSERT_TRUE(etcpal_spsc_queue_create(&queue, 4, sizeof(int), false));
+  TEST_ASSERT_TRUE(etcpal_spsc_queue_is_empty(&queue));
+
+  int next_sent = 0;
+  int next_received = 0;
+  for (int round = 0; round < 3; ++round)
+  {
+    // Fill the queue, then take out some of the items so that the next round wraps around.
+    while (etcpal_spsc_queue_try_send(&queue, &next_sent))
+      ++next_sent;
+    TEST_ASSERT_EQUAL_UINT(4u, etcpal_spsc_queue_slots_used(&queue));
+
+    for (int i = 0; i < 3; ++i)
+    {
+      int data = -1;
+      TEST_ASSERT_TRUE(etcpal_spsc_queue_try_receive(&queue, &data));
+      TEST_ASSERT_EQUAL_INT(next_received++, data);
+    }
+    TEST_ASSERT_EQUAL_UINT(1u, etcpal_spsc_queue_slots_used(&queue));
+  }
+
+  int data = -1;
+  TEST_ASSERT_TRUE(etcpal_spsc_queue_try_receive(&queue, &data));
+  TEST_ASSERT_EQUAL_INT(next_received, data);
+  TEST_ASSERT_FALSE(etcpal_spsc_queue_try_receive(&queue, &data));
+  TEST_ASSERT_TRUE(etcpal_spsc_queue_is_empty(&queue));
+}
+
+TEST(etcpal_spsc_queue, non_blocking_queue_does_not_wait)
+{
+  TEST_ASSERT_TRUE(etcpal_spsc_queue_create(&queue, 1, sizeof(int), false));
+
+  int data = 42;
+  TEST_ASSERT_FALSE(etcpal_spsc_queue_receive(&queue, &data));
+  TEST_ASSERT_TRUE(etcpal_spsc_queue_send(&queue, &data));
+  TEST_ASSERT_FALSE(etcpal_spsc_queue_send(&queue, &data));
+}
+
+TEST(etcpal_spsc_queue, zero_timeout_does_not_wait)
+{
+  TEST_ASSERT_TRUE(etcpal_spsc_queue_create(&queue, 1, sizeof(int), true));
+
+  int data = 42;
+  TEST_ASSERT_FALSE(etcpal_spsc_queue_timed_receive(&queue, &data, 0));
+  TEST_ASSERT_TRUE(etcpal_spsc_queue_timed_send(&queue, &data, 0));
+  TEST_ASSERT_FALSE(etcpal_spsc_queue_timed_send(&queue, &data, 0));
+#if ETCPAL_SPSC_QUEUE_HAS_TIMED_FUNCTIONS
+  TEST_ASSERT_FALSE(etcpal_spsc_queue_timed_send(&queue, &data, 10));
+#endif
+}
+
+TEST(etcpal_spsc_queue, blocking_handoff_between_threads_works)
+{
+  // A small queue makes both sides wait often: the producer when it is full, and the consumer when
+  // it is empty.
+  TEST_ASSERT_TRUE(etcpal_spsc_queue_create(&queue, 8, sizeof(uint32_t), true));
+
+  EtcPalThreadParams params = ETCPAL_THREAD_PARAMS_INIT;
+  etcpal_thread_t    producer;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_thread_create(&producer, &params, send_sequence, NULL));
+
+  for (uint32_t i = 0; i < NUM_THREADED_ITEMS; ++i)
+  {
+    uint32_t data = 0;
+    TEST_ASSERT_TRUE(etcpal_spsc_queue_receive(&queue, &data));
+    TEST_ASSERT_EQUAL_UINT32(i, data);
+  }
+
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_thread_join(&producer));
+  TEST_ASSERT_TRUE(etcpal_spsc_queue_is_empty(&queue));
+}
+
+TEST_GROUP_RUNNER(etcpal_spsc_queue)
+{
+  RUN_TEST_CASE(etcpal_spsc_queue, invalid_calls_fail);
+  RUN_TEST_CASE(etcpal_spsc_queue, capacity_rounds_up_to_power_of_two);
+  RUN_TEST_CASE(etcpal_spsc_queue, items_come_out_in_order_across_wraparound);
+  RUN_TEST_CASE(etcpal_spsc_queue, non_blocking_queue_does_not_wait);
+  RUN_TEST_CASE(etcpal_spsc_queue, zero_timeout_does_not_wait);
+  RUN_TEST_CASE(etcpal_spsc_queue, blocking_handoff_between_threads_works);
+}
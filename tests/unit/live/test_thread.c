@@ -166,6 +166,23 @@ TEST(etcpal_thread, get_os_handle_works)
   TEST_ASSERT_TRUE(thread_handle == reported_handle);
 }
 
+TEST(etcpal_thread, set_affinity_works)
+{
+  EtcPalThreadParams params = ETCPAL_THREAD_PARAMS_INIT;
+  etcpal_thread_t    wait_thread;
+  waitthread_run = true;
+  TEST_ASSERT_EQUAL(etcpal_thread_create(&wait_thread, &params, wait_and_exit, NULL), kEtcPalErrOk);
+
+  TEST_ASSERT_EQUAL(etcpal_thread_set_affinity(NULL, 0), kEtcPalErrInvalid);
+
+  // Every system has a CPU 0.
+  etcpal_error_t res = etcpal_thread_set_affinity(&wait_thread, 0);
+  TEST_ASSERT_TRUE(res == kEtcPalErrOk || res == kEtcPalErrNotImpl);
+
+  waitthread_run = false;
+  TEST_ASSERT_EQUAL(etcpal_thread_join(&wait_thread), kEtcPalErrOk);
+}
+
 TEST_GROUP_RUNNER(etcpal_thread)
 {
   RUN_TEST_CASE(etcpal_thread, create_and_destroy_functions_work);
@@ -174,4 +191,5 @@ TEST_GROUP_RUNNER(etcpal_thread)
 #endif
   RUN_TEST_CASE(etcpal_thread, threads_are_time_sliced);
   RUN_TEST_CASE(etcpal_thread, get_os_handle_works);
+  RUN_TEST_CASE(etcpal_thread, set_affinity_works);
 }
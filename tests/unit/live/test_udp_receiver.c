@@ -0,0 +1,207 @@
+/******************************************************************************
+ * Copyright 2021 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *******************************************************************************
+ * This file is a part of EtcPal. For more information, go to:
+ * https://github.com/ETCLabs/EtcPal
+ ******************************************************************************/
+
+#include "etcpal/udp_receiver.h"
+
+#include <string.h>
+#include "etcpal/common.h"
+#include "etcpal/mutex.h"
+#include "etcpal/timer.h"
+#include "unity_fixture.h"
+
+#define NUM_SHARDS            4
+#define NUM_SENDERS           8
+#define DATAGRAMS_PER_SEND    25
+#define RECEIVER_TEST_MESSAGE "udp receiver test"
+
+typedef struct ReceiveCounts
+{
+  etcpal_mutex_t lock;
+  size_t         total;
+  size_t         per_shard[NUM_SHARDS];
+  bool           bad_data;
+} ReceiveCounts;
+
+static ReceiveCounts counts;
+
+static void count_datagram(const uint8_t* data, size_t length, const EtcPalSockAddr* from, size_t shard, void* context)
+{
+  ETCPAL_UNUSED_ARG(from);
+  ReceiveCounts* test_counts = (ReceiveCounts*)context;
+
+  if (etcpal_mutex_lock(&test_counts->lock))
+  {
+    if (length != sizeof(RECEIVER_TEST_MESSAGE) || memcmp(data, RECEIVER_TEST_MESSAGE, length) != 0 ||
+        shard >= NUM_SHARDS)
+    {
+      test_counts->bad_data = true;
+    }
+    else
+    {
+      ++test_counts->per_shard[shard];
+    }
+    ++test_counts->total;
+    etcpal_mutex_unlock(&test_counts->lock);
+  }
+}
+
+static size_t get_total(void)
+{
+  size_t total = 0;
+  if (etcpal_mutex_lock(&counts.lock))
+  {
+    total = counts.total;
+    etcpal_mutex_unlock(&counts.lock);
+  }
+  return total;
+}
+
+static EtcPalUdpReceiverConfig make_config(size_t num_shards)
+{
+  EtcPalUdpReceiverConfig config = ETCPAL_UDP_RECEIVER_CONFIG_DEFAULT_INIT;
+  ETCPAL_IP_SET_V4_ADDRESS(&config.bind_addr.ip, 0x7f000001);
+  config.num_shards = num_shards;
+  config.callback = count_datagram;
+  config.context = &counts;
+  return config;
+}
+
+// Send datagrams to the receiver from several sockets, so that a receiver which distributes by
+// source address sees traffic on more than one shard.
+static void send_datagrams(uint16_t port)
+{
+  EtcPalSockAddr dest;
+  ETCPAL_IP_SET_V4_ADDRESS(&dest.ip, 0x7f000001);
+  dest.port = port;
+
+  for (int i = 0; i < NUM_SENDERS; ++i)
+  {
+    etcpal_socket_t sock;
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &sock));
+    for (int j = 0; j < DATAGRAMS_PER_SEND; ++j)
+    {
+      TEST_ASSERT_EQUAL((int)sizeof(RECEIVER_TEST_MESSAGE),
+                        etcpal_sendto(sock, RECEIVER_TEST_MESSAGE, sizeof(RECEIVER_TEST_MESSAGE), 0, &dest));
+    }
+    TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_close(sock));
+  }
+}
+
+static void wait_for_datagrams(size_t expected)
+{
+  EtcPalTimer timer;
+  etcpal_timer_start(&timer, 2000);
+  while (get_total() < expected && !etcpal_timer_is_expired(&timer))
+    etcpal_thread_sleep(5);
+}
+
+TEST_GROUP(etcpal_udp_receiver);
+
+TEST_SETUP(etcpal_udp_receiver)
+{
+  etcpal_init(ETCPAL_FEATURE_SOCKETS);
+  memset(&counts, 0, sizeof counts);
+  TEST_ASSERT_TRUE(etcpal_mutex_create(&counts.lock));
+}
+
+TEST_TEAR_DOWN(etcpal_udp_receiver)
+{
+  etcpal_mutex_destroy(&counts.lock);
+  etcpal_deinit(ETCPAL_FEATURE_SOCKETS);
+}
+
+TEST(etcpal_udp_receiver, invalid_calls_fail)
+{
+  EtcPalUdpReceiver*      receiver = NULL;
+  EtcPalUdpReceiverConfig config = make_config(1);
+
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_udp_receiver_create(NULL, &receiver));
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_udp_receiver_create(&config, NULL));
+
+  config.num_shards = 0;
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_udp_receiver_create(&config, &receiver));
+  config = make_config(1);
+  config.callback = NULL;
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_udp_receiver_create(&config, &receiver));
+  config = make_config(1);
+  ETCPAL_IP_SET_INVALID(&config.bind_addr.ip);
+  TEST_ASSERT_EQUAL(kEtcPalErrInvalid, etcpal_udp_receiver_create(&config, &receiver));
+
+  TEST_ASSERT_EQUAL(0, etcpal_udp_receiver_get_port(NULL));
+  TEST_ASSERT_EQUAL(ETCPAL_SOCKET_INVALID, etcpal_udp_receiver_get_socket(NULL, 0));
+  etcpal_udp_receiver_destroy(NULL);
+}
+
+TEST(etcpal_udp_receiver, single_shard_receives_datagrams)
+{
+  EtcPalUdpReceiverConfig config = make_config(1);
+  EtcPalUdpReceiver*      receiver = NULL;
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, etcpal_udp_receiver_create(&config, &receiver));
+
+  uint16_t port = etcpal_udp_receiver_get_port(receiver);
+  TEST_ASSERT_NOT_EQUAL(0, port);
+  TEST_ASSERT_NOT_EQUAL(ETCPAL_SOCKET_INVALID, etcpal_udp_receiver_get_socket(receiver, 0));
+  TEST_ASSERT_EQUAL(ETCPAL_SOCKET_INVALID, etcpal_udp_receiver_get_socket(receiver, 1));
+
+  send_datagrams(port);
+  wait_for_datagrams(NUM_SENDERS * DATAGRAMS_PER_SEND);
+  etcpal_udp_receiver_destroy(receiver);
+
+  TEST_ASSERT_FALSE(counts.bad_data);
+  TEST_ASSERT_EQUAL(NUM_SENDERS * DATAGRAMS_PER_SEND, counts.total);
+  TEST_ASSERT_EQUAL(NUM_SENDERS * DATAGRAMS_PER_SEND, counts.per_shard[0]);
+}
+
+TEST(etcpal_udp_receiver, sharded_receiver_receives_datagrams)
+{
+  EtcPalUdpReceiverConfig config = make_config(NUM_SHARDS);
+  config.pin_threads = true;
+
+  EtcPalUdpReceiver* receiver = NULL;
+  etcpal_error_t     res = etcpal_udp_receiver_create(&config, &receiver);
+  if (res == kEtcPalErrNotImpl)
+    TEST_IGNORE_MESSAGE("SO_REUSEPORT is not supported on this platform.");
+  if (res == kEtcPalErrInvalid)
+  {
+    // Fewer CPUs than shards are available to this process.
+    config.pin_threads = false;
+    res = etcpal_udp_receiver_create(&config, &receiver);
+  }
+  TEST_ASSERT_EQUAL(kEtcPalErrOk, res);
+
+  uint16_t port = etcpal_udp_receiver_get_port(receiver);
+  TEST_ASSERT_NOT_EQUAL(0, port);
+  for (size_t i = 0; i < NUM_SHARDS; ++i)
+    TEST_ASSERT_NOT_EQUAL(ETCPAL_SOCKET_INVALID, etcpal_udp_receiver_get_socket(receiver, i));
+
+  // Every datagram is delivered exactly once, regardless of which shard receives it.
+  send_datagrams(port);
+  wait_for_datagrams(NUM_SENDERS * DATAGRAMS_PER_SEND);
+  etcpal_udp_receiver_destroy(receiver);
+
+  TEST_ASSERT_FALSE(counts.bad_data);
+  TEST_ASSERT_EQUAL(NUM_SENDERS * DATAGRAMS_PER_SEND, counts.total);
+}
+
+TEST_GROUP_RUNNER(etcpal_udp_receiver)
+{
+  RUN_TEST_CASE(etcpal_udp_receiver, invalid_calls_fail);
+  RUN_TEST_CASE(etcpal_udp_receiver, single_shard_receives_datagrams);
+  RUN_TEST_CASE(etcpal_udp_receiver, sharded_receiver_receives_datagrams);
+}